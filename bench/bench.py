@@ -0,0 +1,250 @@
+#!/usr/bin/env python3
+
+# Run the workloads in bench/*.neon under each available executor and
+# report the wall clock time of each run. Only the execution step is
+# timed; compiling to bytecode or to native code happens beforehand.
+#
+# Usage:
+#   bench.py [options] [workload...]
+#
+# Options:
+#   --neonx path        neonx executor (default bin/neonx)
+#   --neonc path        neonc compiler (default bin/neonc)
+#   --cnex path         cnex executor (default exec/cnex/cnex)
+#   --cpp-rtl path      C++ runtime description written by the build
+#                       (default bin/neon_rtl_cpp.cmake)
+#   --java path         run the jvm target with this java
+#   --cli               run the cli target with mono
+#   --runner name       only run the named runner (may be repeated)
+#   --runs n            time each workload n times and keep the best (default 3)
+#   --output file       write the results as JSON
+#   --baseline file     compare against results previously written by --output
+#   --threshold pct     report a regression when a workload is slower than
+#                       the baseline by more than pct percent (default 10)
+#
+# With --baseline, the exit status is nonzero if any workload regressed.
+
+import hashlib
+import json
+import os
+import platform
+import subprocess
+import sys
+import time
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+ROOT_DIR = os.path.dirname(BENCH_DIR)
+
+neonx = os.path.join("bin", "neonx")
+neonc = os.path.join("bin", "neonc")
+cnex = os.path.join("exec", "cnex", "cnex")
+cpp_rtl = os.path.join("bin", "neon_rtl_cpp.cmake")
+java = None
+cli = False
+only = []
+runs = 3
+output = None
+baseline = None
+threshold = 10.0
+
+def check_output(args, env=None):
+    p = subprocess.run(args, stdout=subprocess.PIPE, stderr=subprocess.PIPE, env=env)
+    if p.returncode != 0:
+        raise subprocess.CalledProcessError(p.returncode, args, p.stdout, p.stderr)
+    return p.stdout
+
+class Runner:
+    def prepare(self, fullname):
+        # Return the command line (and environment) that runs fullname.
+        raise NotImplementedError()
+
+class NeonRunner(Runner):
+    name = "neonx"
+    def prepare(self, fullname):
+        check_output([neonc, "-q", fullname])
+        return [neonx, fullname + "x"], None
+
+class CnexRunner(Runner):
+    name = "cnex"
+    def prepare(self, fullname):
+        check_output([neonc, "-q", fullname])
+        return [cnex, fullname + "x"], None
+
+class CppRunner(Runner):
+    name = "cpp"
+    def prepare(self, fullname):
+        # neonc writes a CMake project for the workload and every module
+        # it imports, which is built against the runtime from this tree.
+        project = os.path.join("tmp", os.path.basename(fullname).replace(".neon", "-cpp"))
+        build = os.path.join(project, "build")
+        check_output([neonc, "-q", "-t", "cpp", "-o", project, fullname])
+        check_output(["cmake", "-S", project, "-B", build, "-DCMAKE_BUILD_TYPE=Release", "-DNEON_RTL=" + os.path.abspath(cpp_rtl)])
+        check_output(["cmake", "--build", build, "--config", "Release", "--parallel"])
+        exe = os.path.join(build, os.path.basename(fullname).replace(".neon", ""))
+        if sys.platform == "win32":
+            exe += ".exe"
+        return [exe], None
+
+class JvmRunner(Runner):
+    name = "jvm"
+    def prepare(self, fullname):
+        path, name = os.path.split(fullname)
+        check_output([neonc, "-q", "-t", "jvm", fullname])
+        return [java, "-cp", os.pathsep.join([path, "rtl/jvm", "lib"]), name.replace(".neon", "")], None
+
+class CliRunner(Runner):
+    name = "cli"
+    def prepare(self, fullname):
+        check_output([neonc, "-q", "-t", "cli", fullname])
+        env = dict(os.environ)
+        env["MONO_PATH"] = "t"
+        exe = fullname.replace(".neon", ".exe")
+        return ([] if os.name == "nt" else ["mono"]) + [exe], env
+
+def run_workload(runner, fullname):
+    try:
+        args, env = runner.prepare(fullname)
+    except (OSError, subprocess.CalledProcessError) as e:
+        return {"status": "unsupported", "detail": describe_error(e)}
+    times = []
+    out = None
+    for _ in range(runs):
+        start = time.perf_counter()
+        try:
+            out = check_output(args, env)
+        except (OSError, subprocess.CalledProcessError) as e:
+            return {"status": "error", "detail": describe_error(e)}
+        times.append(time.perf_counter() - start)
+    return {
+        "status": "ok",
+        "seconds": min(times),
+        "times": times,
+        "output": hashlib.sha256(out.replace(b"\r\n", b"\n")).hexdigest(),
+    }
+
+def describe_error(e):
+    if isinstance(e, subprocess.CalledProcessError):
+        detail = (e.stderr or b"").decode("utf-8", "replace").strip().split("\n")[-1]
+        return "{} exited with {}: {}".format(os.path.basename(e.cmd[0]), e.returncode, detail)
+    return str(e)
+
+def compare(results, old):
+    previous = {}
+    for r in old["results"]:
+        if r["status"] == "ok":
+            previous[(r["workload"], r["runner"])] = r["seconds"]
+    regressions = 0
+    print()
+    print("{:<16} {:<6} {:>10} {:>10} {:>8}".format("workload", "runner", "baseline", "current", "ratio"))
+    for r in results:
+        key = (r["workload"], r["runner"])
+        if r["status"] != "ok" or key not in previous:
+            continue
+        ratio = r["seconds"] / previous[key]
+        flag = ""
+        if ratio > 1 + threshold / 100:
+            flag = "  REGRESSION"
+            regressions += 1
+        print("{:<16} {:<6} {:>10.3f} {:>10.3f} {:>8.2f}{}".format(r["workload"], r["runner"], previous[key], r["seconds"], ratio, flag))
+    if regressions:
+        print("{} workload(s) more than {}% slower than {}".format(regressions, threshold, baseline))
+    return regressions
+
+def main():
+    global neonx, neonc, cnex, cpp_rtl, java, cli, runs, output, baseline, threshold
+
+    i = 1
+    while i < len(sys.argv):
+        if sys.argv[i] == "--neonx":
+            i += 1
+            neonx = sys.argv[i]
+        elif sys.argv[i] == "--neonc":
+            i += 1
+            neonc = sys.argv[i]
+        elif sys.argv[i] == "--cnex":
+            i += 1
+            cnex = sys.argv[i]
+        elif sys.argv[i] == "--cpp-rtl":
+            i += 1
+            cpp_rtl = sys.argv[i]
+        elif sys.argv[i] == "--java":
+            i += 1
+            java = sys.argv[i]
+        elif sys.argv[i] == "--cli":
+            cli = True
+        elif sys.argv[i] == "--runner":
+            i += 1
+            only.append(sys.argv[i])
+        elif sys.argv[i] == "--runs":
+            i += 1
+            runs = int(sys.argv[i])
+        elif sys.argv[i] == "--output":
+            i += 1
+            output = sys.argv[i]
+        elif sys.argv[i] == "--baseline":
+            i += 1
+            baseline = sys.argv[i]
+        elif sys.argv[i] == "--threshold":
+            i += 1
+            threshold = float(sys.argv[i])
+        elif sys.argv[i].startswith("-"):
+            sys.exit("bench.py: unknown option {}".format(sys.argv[i]))
+        else:
+            break
+        i += 1
+
+    if output:
+        output = os.path.abspath(output)
+    if baseline:
+        baseline = os.path.abspath(baseline)
+    os.chdir(ROOT_DIR)
+    if not os.path.isdir("tmp"):
+        os.mkdir("tmp")
+
+    runners = [NeonRunner(), CnexRunner(), CppRunner()]
+    if java:
+        runners.append(JvmRunner())
+    if cli:
+        runners.append(CliRunner())
+    if only:
+        runners = [r for r in runners if r.name in only]
+
+    names = sys.argv[i:]
+    if not names:
+        names = sorted(os.path.splitext(f)[0] for f in os.listdir(BENCH_DIR) if f.endswith(".neon"))
+
+    results = []
+    print("{:<16} {:<6} {:>10}  {}".format("workload", "runner", "seconds", "status"))
+    for name in names:
+        fullname = os.path.join("bench", name + ".neon")
+        reference = None
+        for runner in runners:
+            r = run_workload(runner, fullname)
+            if r["status"] == "ok":
+                if reference is None:
+                    reference = r["output"]
+                elif r["output"] != reference:
+                    r["status"] = "wrong output"
+            r["workload"] = name
+            r["runner"] = runner.name
+            results.append(r)
+            seconds = "{:.3f}".format(r["seconds"]) if "seconds" in r else "-"
+            print("{:<16} {:<6} {:>10}  {}{}".format(name, runner.name, seconds, r["status"], ": " + r["detail"] if "detail" in r else ""))
+            sys.stdout.flush()
+
+    if output:
+        with open(output, "w") as f:
+            json.dump({
+                "platform": platform.platform(),
+                "runs": runs,
+                "results": results,
+            }, f, indent=2, sort_keys=True)
+            f.write("\n")
+
+    if baseline:
+        with open(baseline) as f:
+            old = json.load(f)
+        if compare(results, old):
+            sys.exit(1)
+
+main()
@@ -39,14 +39,8 @@ static struct tagTString **getstrtable(const unsigned char *obj, unsigned int si
             fatal_error("Could not allocate string table data.");
         }
         unsigned int len = get_vint(obj, size, i);
-        TString *ts = string_newString();
-        ts->length = len;
-        ts->data = malloc(len+1); /* Always add null termination regardless of length. */
-        if (ts->data == NULL) {
-            fatal_error("Could not allocate %d bytes for string index %d in string table.", len + 1, *count);
-        }
-        memcpy(ts->data, &obj[*i], len);
-        ts->data[len] = '\0'; /* Null terminate all strings, regardless of string type. */
+        TString *ts = string_createStringFromData((void *)&obj[*i], len);
+        string_ensureNullTerminated(ts); /* Null terminate all strings, regardless of string type. */
         r[(*count)++] = ts;
         *i += len;
     }
@@ -17,6 +17,7 @@ void cell_ensureAddress(Cell *a)
 {
     if (a->type == cNothing) {
         a->type = cAddress;
+        a->address = NULL;
     }
     assert(a->type == cAddress);
 }
@@ -36,6 +37,7 @@ void cell_ensureBoolean(Cell * b)
 {
     if (b->type == cNothing) {
         b->type = cBoolean;
+        b->boolean = FALSE;
     }
     assert(b->type == cBoolean);
 }
@@ -66,6 +68,7 @@ void cell_ensureNumber(Cell *n)
 {
     if (n->type == cNothing) {
         n->type = cNumber;
+        n->number = number_from_uint32(0);
     }
     assert(n->type == cNumber);
 }
@@ -85,6 +88,7 @@ void cell_ensureOther(Cell *o)
 {
     if (o->type == cNothing) {
         o->type = cOther;
+        o->other = NULL;
     }
     assert(o->type == cOther);
 }
@@ -154,14 +158,7 @@ Cell *cell_fromStringLength(const char *s, int64_t length)
 {
     Cell *x = cell_newCell();
     x->type = cString;
-    x->string = string_newString();
-    x->string->length = length;
-
-    x->string->data = malloc(x->string->length);
-    if (x->string->data == NULL) {
-        fatal_error("Failed to allocate memory for new cell string.");
-    }
-    memcpy(x->string->data, s, x->string->length);
+    x->string = string_createStringFromData((void *)s, length);
     return x;
 }
 
@@ -177,15 +174,8 @@ Cell *cell_fromCString(const char *s)
 {
     Cell *x = cell_newCell();
     x->type = cString;
-    x->string = string_newString();
-
-    x->string->length = strlen(s);
-    x->string->data = malloc(x->string->length+1); // NUL terminate all C Strings.
-    if (!x->string->data) {
-        fatal_error("Failed to allocate memory for new cell C-string.");
-    }
-    memcpy(x->string->data, s, x->string->length);
-    x->string->data[x->string->length] = '\0'; // Add a NUL termination to the string.
+    x->string = string_createCString(s);
+    string_ensureNullTerminated(x->string); // NUL terminate all C Strings.
     return x;
 }
 
@@ -202,107 +192,7 @@ Cell *cell_fromCell(const Cell *c)
     assert(c != NULL);
 
     Cell *x = cell_newCell();
-    x->type = c->type;
-    switch (c->type) {
-        case cAddress:
-            cell_copyCell(x, c);
-            break;
-        case cArray:
-            x->array = array_createArrayFromSize(c->array->size);
-            for (size_t i = 0; i < x->array->size; i++) {
-                cell_copyCell(&x->array->data[i], &c->array->data[i]);
-            }
-            x->boolean = FALSE;
-            x->number = number_from_uint32(0);
-            x->object = NULL;
-            x->string = NULL;
-            x->address = NULL;
-            x->dictionary = NULL;
-            x->other = NULL;
-            break;
-        case cBoolean:
-            x->boolean = c->boolean;
-            x->number = number_from_uint32(0);
-            x->object = NULL;
-            x->string = NULL;
-            x->address = NULL;
-            x->array = NULL;
-            x->dictionary = NULL;
-            x->other = NULL;
-            break;
-        case cBytes:
-            x->string = string_copyString(c->string);
-            x->boolean = FALSE;
-            x->number = number_from_uint32(0);
-            x->object = NULL;
-            x->address = NULL;
-            x->array = NULL;
-            x->dictionary = NULL;
-            break;
-        case cDictionary:
-            x->dictionary = dictionary_copyDictionary(c->dictionary);
-            x->boolean = FALSE;
-            x->number = number_from_uint32(0);
-            x->object = NULL;
-            x->string = NULL;
-            x->address = NULL;
-            x->array = NULL;
-            x->other = NULL;
-            break;
-        case cObject:
-            x->object = c->object;
-            x->object->refcount++;
-            x->boolean = FALSE;
-            x->dictionary = NULL;
-            x->other = NULL;
-            x->number = number_from_uint32(0);
-            x->string = NULL;
-            x->address = NULL;
-            x->array = NULL;
-            break;
-        case cNumber:
-            x->number = c->number;
-            x->object = NULL;
-            x->string = NULL;
-            x->address = NULL;
-            x->boolean = FALSE;
-            x->array = NULL;
-            x->dictionary = NULL;
-            x->other = NULL;
-            break;
-        case cString:
-            x->string = string_copyString(c->string);
-            x->address = NULL;
-            x->number = number_from_uint32(0);
-            x->object = NULL;
-            x->boolean = FALSE;
-            x->array = NULL;
-            x->dictionary = NULL;
-            x->other = NULL;
-            break;
-        case cOther:
-            x->other = c->other;
-            x->string = NULL;
-            x->address = NULL;
-            x->number = number_from_uint32(0);
-            x->boolean = FALSE;
-            x->array = NULL;
-            x->dictionary = NULL;
-            break;
-        case cNothing:
-            assert(c->type == cNothing);
-            break;
-        default:
-            x->number = number_from_uint32(0);
-            x->object = NULL;
-            x->string = NULL;
-            x->address = NULL;
-            x->boolean = FALSE;
-            x->array = NULL;
-            x->dictionary = NULL;
-            x->other = NULL;
-            break;
-    }
+    cell_copyCell(x, c);
     return x;
 }
 
@@ -566,12 +456,7 @@ Cell *cell_createStringCell(size_t length)
     Cell *c = cell_newCell();
 
     c->type = cString;
-    c->string = string_newString();
-    c->string->length = length;
-    c->string->data = malloc(length);
-    if (c->string->data == NULL) {
-        fatal_error("Unable to allocate memory for requested string with length of %ld.", length);
-    }
+    c->string = string_createString(length);
     return c;
 }
 
@@ -580,38 +465,53 @@ void cell_copyCell(Cell *dest, const Cell *source)
     assert(source != NULL);
     assert(dest != NULL);
 
-    cell_clearCell(dest);
-
-    dest->number = source->number;
-    // ToDo: Split strings and bytes into separate entities; once we implement actual UTF8 strings.
-    if ((source->type == cString || source->type == cBytes) && source->string != NULL) {
-        dest->string = string_copyString(source->string);
-    } else {
-        dest->string = NULL;
+    if (dest == source) {
+        return;
     }
+    cell_clearCell(dest);
 
-    if (source->type == cArray && source->array != NULL) {
-        dest->array = array_createArrayFromSize(source->array->size);
-        for (size_t i = 0; i < dest->array->size; i++) {
-            cell_copyCell(&dest->array->data[i], &source->array->data[i]);
-        }
-    } else {
-        dest->array = NULL;
-    }
-    if (source->type == cDictionary && source->dictionary != NULL) {
-        dest->dictionary = dictionary_copyDictionary(source->dictionary);
-    } else {
-        dest->dictionary = NULL;
-    }
-    if (source->type == cObject && source->object != NULL) {
-        dest->object = source->object;
-        dest->object->refcount++;
-    } else {
-        dest->object = NULL;
+    switch (source->type) {
+        case cAddress:
+            dest->address = source->address;
+            break;
+        case cArray:
+            if (source->array != NULL) {
+                dest->array = array_createArrayFromSize(source->array->size);
+                for (size_t i = 0; i < dest->array->size; i++) {
+                    cell_copyCell(&dest->array->data[i], &source->array->data[i]);
+                }
+            }
+            break;
+        case cBoolean:
+            dest->boolean = source->boolean;
+            break;
+        case cBytes:
+        case cString:
+            // ToDo: Split strings and bytes into separate entities; once we implement actual UTF8 strings.
+            if (source->string != NULL) {
+                dest->string = string_copyString(source->string);
+            }
+            break;
+        case cDictionary:
+            if (source->dictionary != NULL) {
+                dest->dictionary = dictionary_copyDictionary(source->dictionary);
+            }
+            break;
+        case cNumber:
+            dest->number = source->number;
+            break;
+        case cObject:
+            dest->object = source->object;
+            if (dest->object != NULL) {
+                dest->object->refcount++;
+            }
+            break;
+        case cOther:
+            dest->other = source->other;
+            break;
+        case cNothing:
+            break;
     }
-    dest->address = source->address;
-    dest->boolean = source->boolean;
-    dest->other = source->other;
     dest->type = source->type;
 }
 
@@ -648,15 +548,7 @@ Cell *cell_newCell(void)
         fatal_error("Could not allocate new cell object.");
     }
 
-    c->number = number_from_uint32(0);
-    c->object = NULL;
-    c->string = NULL;
-    c->address = NULL;
-    c->boolean = FALSE;
-    c->array = NULL;
-    c->dictionary = NULL;
-    c->other = NULL;
-    c->type = cNothing;
+    cell_initCell(c);
     return c;
 }
 
@@ -670,14 +562,8 @@ Cell *cell_newCellType(CellType t)
 
 void cell_initCell(Cell *c)
 {
-    c->number = number_from_uint32(0);
-    c->object = NULL;
-    c->string = NULL;
-    c->array = NULL;
-    c->address = NULL;
-    c->boolean = FALSE;
-    c->dictionary = NULL;
-    c->other = NULL;
+    // Zero every member of the union, whichever is largest.
+    memset(c, 0, sizeof(Cell));
     c->type = cNothing;
 }
 
@@ -18,16 +18,20 @@ typedef enum tagEType {
     cOther,
 } CellType;
 
+// A Cell holds exactly one value, selected by type. Only the union member
+// that matches type is meaningful; a cNothing cell has all members zeroed.
 typedef struct tagTCell {
-    Number number;
-    struct tagTCell *address;
-    struct tagTArray *array;
-    struct tagTDictionary *dictionary;
-    struct tagTObject *object;
-    struct tagTString *string;
+    union {
+        Number number;
+        struct tagTCell *address;
+        struct tagTArray *array;
+        struct tagTDictionary *dictionary;
+        struct tagTObject *object;
+        struct tagTString *string;
+        BOOL boolean;
+        void *other;
+    };
     enum tagEType type;
-    BOOL boolean;
-    void *other;
 } Cell;
 
 Cell *cell_createAddressCell(Cell *a);
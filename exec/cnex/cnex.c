@@ -273,9 +273,7 @@ TExecutor *exec_newExecutor(TModule *object)
     r->debug = gOptions.ExecutorDebugStats;
     r->disassemble = gOptions.ExecutorDisassembly;
     r->framestack = framestack_createFrameStack(r->param_recursion_limit);
-    r->allocations = 0;
-    r->collection_interval = 1000;
-    r->firstObject = NULL;
+    r->heap = heap_createHeap();
 
     // Load and initialize all the module code.  Note that there is always at least
     // one module!  See: runtime$moduleIsMain() call.
@@ -489,28 +487,31 @@ void exec_PUSHB(TExecutor *self)
 {
     BOOL val = self->module->bytecode->code[self->ip+1] != 0;
     self->ip += 2;
-    push(self->stack, cell_fromBoolean(val));
+    pushBoolean(self->stack, val);
 }
 
 void exec_PUSHN(TExecutor *self)
 {
     self->ip++;
     unsigned int val = exec_getOperand(self);
-    push(self->stack, cell_fromNumber(number_from_string(self->module->bytecode->strings[val]->data)));
+    pushNumber(self->stack, number_from_string(self->module->bytecode->strings[val]->data));
 }
 
 void exec_PUSHS(TExecutor *self)
 {
     self->ip++;
     unsigned int val = exec_getOperand(self);
-    push(self->stack, cell_fromStringLength(self->module->bytecode->strings[val]->data, self->module->bytecode->strings[val]->length));
+    // Literals refer to the module's string table until they are modified.
+    cell_setString(pushEmpty(self->stack), string_shareString(self->module->bytecode->strings[val]));
 }
 
 void exec_PUSHY(TExecutor *self)
 {
     self->ip++;
     unsigned int val = exec_getOperand(self);
-    push(self->stack, cell_fromBytes(self->module->bytecode->strings[val]));
+    Cell *c = pushEmpty(self->stack);
+    c->type = cBytes;
+    c->string = string_shareString(self->module->bytecode->strings[val]);
 }
 
 void exec_PUSHPG(TExecutor *self)
@@ -518,7 +519,7 @@ void exec_PUSHPG(TExecutor *self)
     self->ip++;
     unsigned int addr = exec_getOperand(self);
     assert(addr < self->module->bytecode->global_size);
-    push(self->stack, cell_fromAddress(&self->module->globals[addr]));
+    pushAddress(self->stack, &self->module->globals[addr]);
 }
 
 /* push pointer to predefined global */
@@ -528,7 +529,7 @@ void exec_PUSHPPG(TExecutor *self)
     unsigned int addr = exec_getOperand(self);
     const char *var = self->module->bytecode->strings[addr]->data;
 
-    push(self->stack, cell_fromAddress(global_getVariable(var)));
+    pushAddress(self->stack, global_getVariable(var));
 }
 
 void exec_PUSHPMG(TExecutor *self)
@@ -544,7 +545,7 @@ void exec_PUSHPMG(TExecutor *self)
         if (string_compareString(m->bytecode->strings[m->bytecode->variables[v].name], self->module->bytecode->strings[name]) == 0) {
             unsigned int addr = m->bytecode->variables[v].index;
             assert(addr < m->bytecode->global_size);
-            push(self->stack, cell_fromAddress(&m->globals[addr]));
+            pushAddress(self->stack, &m->globals[addr]);
             return;
         }
     }
@@ -556,7 +557,7 @@ void exec_PUSHPL(TExecutor *self)
     self->ip++;
     unsigned int addr = exec_getOperand(self);
     /* push(self->stack, cell_fromAddress(&self->frames[addr])); */
-    push(self->stack, cell_fromAddress(&framestack_topFrame(self->framestack)->locals[addr]));
+    pushAddress(self->stack, &framestack_topFrame(self->framestack)->locals[addr]);
 }
 
 void exec_PUSHPOL(TExecutor *self)
@@ -570,14 +571,14 @@ void exec_PUSHPOL(TExecutor *self)
         back--;
     }
 
-    push(self->stack, cell_fromAddress(&frame->locals[addr]));
+    pushAddress(self->stack, &frame->locals[addr]);
 }
 
 void exec_PUSHI(TExecutor *self)
 {
     self->ip++;
     uint32_t x = exec_getOperand(self);
-    push(self->stack, cell_fromNumber(number_from_uint32(x)));
+    pushNumber(self->stack, number_from_uint32(x));
 }
 
 void exec_LOADB(TExecutor *self)
@@ -585,7 +586,7 @@ void exec_LOADB(TExecutor *self)
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
     cell_ensureBoolean(addr);
-    push(self->stack, cell_fromCell(addr));
+    pushCopy(self->stack, addr);
 }
 
 void exec_LOADN(TExecutor *self)
@@ -593,7 +594,7 @@ void exec_LOADN(TExecutor *self)
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
     cell_ensureNumber(addr);
-    push(self->stack, cell_fromCell(addr));
+    pushCopy(self->stack, addr);
 }
 
 void exec_LOADS(TExecutor *self)
@@ -601,7 +602,7 @@ void exec_LOADS(TExecutor *self)
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
     cell_ensureString(addr);
-    push(self->stack, cell_fromCell(addr));
+    pushCopy(self->stack, addr);
 }
 
 void exec_LOADY(TExecutor *self)
@@ -609,7 +610,7 @@ void exec_LOADY(TExecutor *self)
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
     cell_ensureBytes(addr);
-    push(self->stack, cell_fromCell(addr));
+    pushCopy(self->stack, addr);
 }
 
 void exec_LOADA(TExecutor *self)
@@ -617,7 +618,7 @@ void exec_LOADA(TExecutor *self)
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
     cell_ensureArray(addr);
-    push(self->stack, cell_fromCell(addr));
+    pushCopy(self->stack, addr);
 }
 
 void exec_LOADD(TExecutor *self)
@@ -625,7 +626,15 @@ void exec_LOADD(TExecutor *self)
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
     cell_ensureDictionary(addr);
-    push(self->stack, cell_fromCell(addr));
+    if (self->ip < self->module->bytecode->codelen && self->module->bytecode->code[self->ip] == IND) {
+        // An IN test only looks at the dictionary, so do it here rather than copying it.
+        self->ip++;
+        BOOL v = dictionary_findDictionaryEntry(addr->dictionary, top(self->stack)->string) != NULL;
+        pop(self->stack);
+        pushBoolean(self->stack, v);
+        return;
+    }
+    pushCopy(self->stack, addr);
 }
 
 void exec_LOADP(TExecutor *self)
@@ -633,7 +642,7 @@ void exec_LOADP(TExecutor *self)
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
     cell_ensureAddress(addr);
-    push(self->stack, cell_fromCell(addr));
+    pushCopy(self->stack, addr);
 }
 
 void exec_LOADJ(TExecutor *self)
@@ -641,7 +650,7 @@ void exec_LOADJ(TExecutor *self)
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
     cell_ensureObject(addr);
-    push(self->stack, cell_fromCell(addr));
+    pushCopy(self->stack, addr);
 }
 
 void exec_LOADV(TExecutor *self)
@@ -649,77 +658,77 @@ void exec_LOADV(TExecutor *self)
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
     cell_ensureOther(addr);
-    push(self->stack, cell_fromCell(addr));
+    pushCopy(self->stack, addr);
 }
 
 void exec_STOREB(TExecutor *self)
 {
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
-    cell_copyCell(addr, top(self->stack)); pop(self->stack);
+    popInto(self->stack, addr);
 }
 
 void exec_STOREN(TExecutor *self)
 {
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
-    cell_copyCell(addr, top(self->stack)); pop(self->stack);
+    popInto(self->stack, addr);
 }
 
 void exec_STORES(TExecutor *self)
 {
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
-    cell_copyCell(addr, top(self->stack)); pop(self->stack);
+    popInto(self->stack, addr);
 }
 
 void exec_STOREY(TExecutor *self)
 {
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
-    cell_copyCell(addr, top(self->stack)); pop(self->stack);
+    popInto(self->stack, addr);
 }
 
 void exec_STOREA(TExecutor *self)
 {
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
-    cell_copyCell(addr, top(self->stack)); pop(self->stack);
+    popInto(self->stack, addr);
 }
 
 void exec_STORED(TExecutor *self)
 {
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
-    cell_copyCell(addr, top(self->stack)); pop(self->stack);
+    popInto(self->stack, addr);
 }
 
 void exec_STOREP(TExecutor *self)
 {
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
-    cell_copyCell(addr, top(self->stack)); pop(self->stack);
+    popInto(self->stack, addr);
 }
 
 void exec_STOREJ(TExecutor *self)
 {
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
-    cell_copyCell(addr, top(self->stack)); pop(self->stack);
+    popInto(self->stack, addr);
 }
 
 void exec_STOREV(TExecutor *self)
 {
     self->ip++;
     Cell *addr = top(self->stack)->address; pop(self->stack);
-    cell_copyCell(addr, top(self->stack)); pop(self->stack);
+    popInto(self->stack, addr);
 }
 
 void exec_NEGN(TExecutor *self)
 {
     self->ip++;
     Number x = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromNumber(number_negate(x)));
+    pushNumber(self->stack, number_negate(x));
 }
 
 void exec_ADDN(TExecutor *self)
@@ -727,7 +736,7 @@ void exec_ADDN(TExecutor *self)
     self->ip++;
     Number b = top(self->stack)->number; pop(self->stack);
     Number a = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromNumber(number_add(a, b)));
+    pushNumber(self->stack, number_add(a, b));
 }
 
 void exec_SUBN(TExecutor *self)
@@ -735,7 +744,7 @@ void exec_SUBN(TExecutor *self)
     self->ip++;
     Number b = top(self->stack)->number; pop(self->stack);
     Number a = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromNumber(number_subtract(a, b)));
+    pushNumber(self->stack, number_subtract(a, b));
 }
 
 void exec_MULN(TExecutor *self)
@@ -743,7 +752,7 @@ void exec_MULN(TExecutor *self)
     self->ip++;
     Number b = top(self->stack)->number; pop(self->stack);
     Number a = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromNumber(number_multiply(a, b)));
+    pushNumber(self->stack, number_multiply(a, b));
 }
 
 void exec_DIVN(TExecutor *self)
@@ -755,7 +764,7 @@ void exec_DIVN(TExecutor *self)
         self->rtl_raise(self, "NumberException.DivideByZero", "");
         return;
     }
-    push(self->stack, cell_fromNumber(number_divide(a, b)));
+    pushNumber(self->stack, number_divide(a, b));
 }
 
 void exec_MODN(TExecutor *self)
@@ -767,7 +776,7 @@ void exec_MODN(TExecutor *self)
         self->rtl_raise(self, "NumberException.DivideByZero", "");
         return;
     }
-    push(self->stack, cell_fromNumber(number_modulo(a, b)));
+    pushNumber(self->stack, number_modulo(a, b));
 }
 
 void exec_EXPN(TExecutor *self)
@@ -775,7 +784,7 @@ void exec_EXPN(TExecutor *self)
     self->ip++;
     Number b = top(self->stack)->number; pop(self->stack);
     Number a = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromNumber(number_pow(a, b)));
+    pushNumber(self->stack, number_pow(a, b));
 }
 
 void exec_EQB(TExecutor *self)
@@ -783,7 +792,7 @@ void exec_EQB(TExecutor *self)
     self->ip++;
     BOOL b = top(self->stack)->boolean; pop(self->stack);
     BOOL a = top(self->stack)->boolean; pop(self->stack);
-    push(self->stack, cell_fromBoolean(a == b));
+    pushBoolean(self->stack, a == b);
 }
 
 void exec_NEB(TExecutor *self)
@@ -791,7 +800,7 @@ void exec_NEB(TExecutor *self)
     self->ip++;
     BOOL b = top(self->stack)->boolean; pop(self->stack);
     BOOL a = top(self->stack)->boolean; pop(self->stack);
-    push(self->stack, cell_fromBoolean(a != b));
+    pushBoolean(self->stack, a != b);
 }
 
 void exec_EQN(TExecutor *self)
@@ -799,7 +808,7 @@ void exec_EQN(TExecutor *self)
     self->ip++;
     Number b = top(self->stack)->number; pop(self->stack);
     Number a = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromBoolean(number_is_equal(a, b)));
+    pushBoolean(self->stack, number_is_equal(a, b));
 }
 
 void exec_NEN(TExecutor *self)
@@ -807,7 +816,7 @@ void exec_NEN(TExecutor *self)
     self->ip++;
     Number b = top(self->stack)->number; pop(self->stack);
     Number a = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromBoolean(number_is_not_equal(a, b)));
+    pushBoolean(self->stack, number_is_not_equal(a, b));
 }
 
 void exec_LTN(TExecutor *self)
@@ -815,7 +824,7 @@ void exec_LTN(TExecutor *self)
     self->ip++;
     Number b = top(self->stack)->number; pop(self->stack);
     Number a = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromBoolean(number_is_less(a, b)));
+    pushBoolean(self->stack, number_is_less(a, b));
 }
 
 void exec_GTN(TExecutor *self)
@@ -823,7 +832,7 @@ void exec_GTN(TExecutor *self)
     self->ip++;
     Number b = top(self->stack)->number; pop(self->stack);
     Number a = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromBoolean(number_is_greater(a, b)));
+    pushBoolean(self->stack, number_is_greater(a, b));
 }
 
 void exec_LEN(TExecutor *self)
@@ -831,7 +840,7 @@ void exec_LEN(TExecutor *self)
     self->ip++;
     Number b = top(self->stack)->number; pop(self->stack);
     Number a = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromBoolean(number_is_less_equal(a, b)));
+    pushBoolean(self->stack, number_is_less_equal(a, b));
 }
 
 void exec_GEN(TExecutor *self)
@@ -839,139 +848,139 @@ void exec_GEN(TExecutor *self)
     self->ip++;
     Number b = top(self->stack)->number; pop(self->stack);
     Number a = top(self->stack)->number; pop(self->stack);
-    push(self->stack, cell_fromBoolean(number_is_greater_equal(a, b)));
+    pushBoolean(self->stack, number_is_greater_equal(a, b));
 }
 
 void exec_EQS(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) == 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) == 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_NES(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) != 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) != 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_LTS(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) < 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) < 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_GTS(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) > 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) > 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_LES(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) <= 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) <= 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_GES(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) >= 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) >= 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_EQY(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) == 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) == 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_NEY(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) != 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) != 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_LTY(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) < 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) < 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_GTY(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) > 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) > 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_LEY(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) <= 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) <= 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_GEY(TExecutor *self)
 {
     self->ip++;
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *r = cell_fromBoolean(string_compareString(a->string, b->string) >= 0);
-    cell_freeCell(b);
-    cell_freeCell(a);
-    push(self->stack, r);
+    TString *b = top(self->stack)->string;
+    TString *a = peek(self->stack, 1)->string;
+    BOOL r = string_compareString(a, b) >= 0;
+    pop(self->stack);
+    pop(self->stack);
+    pushBoolean(self->stack, r);
 }
 
 void exec_EQA(TExecutor *self)
@@ -979,10 +988,10 @@ void exec_EQA(TExecutor *self)
     self->ip++;
     Cell *b = top(self->stack);
     Cell *a = peek(self->stack, 1);
-    Cell *r = cell_fromBoolean(array_compareArray(a->array, b->array) != 0);
+    BOOL r = array_compareArray(a->array, b->array) != 0;
     pop(self->stack);
     pop(self->stack);
-    push(self->stack, r);
+    pushBoolean(self->stack, r);
 }
 
 void exec_NEA(TExecutor *self)
@@ -990,10 +999,10 @@ void exec_NEA(TExecutor *self)
     self->ip++;
     Cell *b = top(self->stack);
     Cell *a = peek(self->stack, 1);
-    Cell *r = cell_fromBoolean(array_compareArray(a->array, b->array) == 0);
+    BOOL r = array_compareArray(a->array, b->array) == 0;
     pop(self->stack);
     pop(self->stack);
-    push(self->stack, r);
+    pushBoolean(self->stack, r);
 }
 
 void exec_EQD(TExecutor *self)
@@ -1001,10 +1010,10 @@ void exec_EQD(TExecutor *self)
     self->ip++;
     Cell *b = top(self->stack);
     Cell *a = peek(self->stack, 1);
-    Cell *r = cell_fromBoolean(dictionary_compareDictionary(a->dictionary, b->dictionary) != 0);
+    BOOL r = dictionary_compareDictionary(a->dictionary, b->dictionary) != 0;
     pop(self->stack);
     pop(self->stack);
-    push(self->stack, r);
+    pushBoolean(self->stack, r);
 }
 
 void exec_NED(TExecutor *self)
@@ -1012,10 +1021,10 @@ void exec_NED(TExecutor *self)
     self->ip++;
     Cell *b = top(self->stack);
     Cell *a = peek(self->stack, 1);
-    Cell *r = cell_fromBoolean(dictionary_compareDictionary(a->dictionary, b->dictionary) == 0);
+    BOOL r = dictionary_compareDictionary(a->dictionary, b->dictionary) == 0;
     pop(self->stack);
     pop(self->stack);
-    push(self->stack, r);
+    pushBoolean(self->stack, r);
 }
 
 void exec_EQP(TExecutor *self)
@@ -1023,10 +1032,10 @@ void exec_EQP(TExecutor *self)
     self->ip++;
     Cell *b = peek(self->stack, 0)->address;
     Cell *a = peek(self->stack, 1)->address;
-    Cell *r = cell_fromBoolean(a == b);
+    BOOL r = a == b;
     pop(self->stack);
     pop(self->stack);
-    push(self->stack, r);
+    pushBoolean(self->stack, r);
 }
 
 void exec_NEP(TExecutor *self)
@@ -1034,10 +1043,10 @@ void exec_NEP(TExecutor *self)
     self->ip++;
     Cell *b = peek(self->stack, 0)->address;
     Cell *a = peek(self->stack, 1)->address;
-    Cell *r = cell_fromBoolean(a != b);
+    BOOL r = a != b;
     pop(self->stack);
     pop(self->stack);
-    push(self->stack, r);
+    pushBoolean(self->stack, r);
 }
 
 void exec_EQV(TExecutor *self)
@@ -1045,10 +1054,10 @@ void exec_EQV(TExecutor *self)
     self->ip++;
     Cell *b = peek(self->stack, 0)->other;
     Cell *a = peek(self->stack, 1)->other;
-    Cell *r = cell_fromBoolean(a == b);
+    BOOL r = a == b;
     pop(self->stack);
     pop(self->stack);
-    push(self->stack, r);
+    pushBoolean(self->stack, r);
 }
 
 void exec_NEV(TExecutor *self)
@@ -1056,10 +1065,10 @@ void exec_NEV(TExecutor *self)
     self->ip++;
     Cell *b = peek(self->stack, 0)->other;
     Cell *a = peek(self->stack, 1)->other;
-    Cell *r = cell_fromBoolean(a != b);
+    BOOL r = a != b;
     pop(self->stack);
     pop(self->stack);
-    push(self->stack, r);
+    pushBoolean(self->stack, r);
 }
 
 void exec_ANDB(void)
@@ -1076,7 +1085,7 @@ void exec_NOTB(TExecutor *self)
 {
     self->ip++;
     BOOL x = top(self->stack)->boolean; pop(self->stack);
-    push(self->stack, cell_fromBoolean(!x));
+    pushBoolean(self->stack, !x);
 }
 
 void exec_INDEXAR(TExecutor *self)
@@ -1099,7 +1108,7 @@ void exec_INDEXAR(TExecutor *self)
         self->rtl_raise(self, "ArrayIndexException", number_to_string(number_from_uint64(j)));
         return;
     }
-    push(self->stack, cell_fromAddress(cell_arrayIndexForRead(addr, j)));
+    pushAddress(self->stack, cell_arrayIndexForRead(addr, j));
 }
 
 void exec_INDEXAW(TExecutor *self)
@@ -1118,7 +1127,7 @@ void exec_INDEXAW(TExecutor *self)
         return;
     }
     uint64_t j = (uint64_t)i;
-    push(self->stack, cell_fromAddress(cell_arrayIndexForWrite(addr, j)));
+    pushAddress(self->stack, cell_arrayIndexForWrite(addr, j));
 }
 
 void exec_INDEXAV(TExecutor *self)
@@ -1182,7 +1191,7 @@ void exec_INDEXDR(TExecutor *self)
         string_freeString(index);
         return;
     }
-    push(self->stack, cell_fromAddress(cell_dictionaryIndexForRead(addr, index)));
+    pushAddress(self->stack, cell_dictionaryIndexForRead(addr, index));
     string_freeString(index);
 }
 
@@ -1191,7 +1200,7 @@ void exec_INDEXDW(TExecutor *self)
     self->ip++;
     TString *index = string_fromString(top(self->stack)->string); pop(self->stack);
     Cell *addr = top(self->stack)->address; pop(self->stack);
-    push(self->stack, cell_fromAddress(cell_dictionaryIndexForWrite(addr, index)));
+    pushAddress(self->stack, cell_dictionaryIndexForWrite(addr, index));
     //string_freeString(index);
 }
 
@@ -1219,14 +1228,14 @@ void exec_INDEXDV(TExecutor *self)
 void exec_INA(TExecutor *self)
 {
     self->ip++;
-    Cell *array = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *val = cell_fromCell(top(self->stack)); pop(self->stack);
+    Cell *array = top(self->stack);
+    Cell *val = peek(self->stack, 1);
 
     BOOL v = cell_arrayElementExists(array, val);
-    cell_freeCell(val);
-    cell_freeCell(array);
+    pop(self->stack);
+    pop(self->stack);
 
-    push(self->stack, cell_fromBoolean(v));
+    pushBoolean(self->stack, v);
 }
 
 void exec_IND(TExecutor *self)
@@ -1239,7 +1248,7 @@ void exec_IND(TExecutor *self)
 
     pop(self->stack);
     pop(self->stack);
-    push(self->stack, cell_fromBoolean(v));
+    pushBoolean(self->stack, v);
 }
 
 void exec_CALLP(TExecutor *self)
@@ -1341,17 +1350,18 @@ void exec_JT(TExecutor *self)
 void exec_DUP(TExecutor *self)
 {
     self->ip++;
-    push(self->stack, cell_fromCell(top(self->stack)));
+    pushCopy(self->stack, top(self->stack));
 }
 
 void exec_DUPX1(TExecutor *self)
 {
     self->ip++;
-    Cell *a = cell_fromCell(top(self->stack)); pop(self->stack);
-    Cell *b = cell_fromCell(top(self->stack)); pop(self->stack);
-    push(self->stack, a);
-    push(self->stack, b);
-    push(self->stack, cell_fromCell(a));
+    Cell *a = top(self->stack);
+    Cell *b = peek(self->stack, 1);
+    Cell t = *a;
+    *a = *b;
+    *b = t;
+    pushCopy(self->stack, b);
 }
 
 void exec_DROP(TExecutor *self)
@@ -1413,21 +1423,16 @@ void exec_ALLOC(TExecutor *self)
     self->ip++;
     uint32_t val = exec_getOperand(self);
 
-    Cell *cell = heap_allocObject(self);
-    cell->array = array_createArrayFromSize(val);
-    cell->type = cArray;
-    push(self->stack, cell_fromAddress(cell));
-    self->allocations++;
-    if (self->collection_interval > 0 && self->allocations >= self->collection_interval) {
-        // ToDo: Implement heap sweep and clear
-        //heap_sweepHeap(self, gOptions.ExecutorDebugStats);
-    }
+    Cell *cell = heap_allocObject(self, val);
+    pushAddress(self->stack, cell);
+    // Collect only once the new object is reachable from the stack.
+    heap_collectIfNeeded(self);
 }
 
 void exec_PUSHNIL(TExecutor *self)
 {
     self->ip++;
-    push(self->stack, cell_newCell());
+    pushEmpty(self->stack);
 }
 
 void exec_RESETC(TExecutor *self)
@@ -1505,9 +1510,9 @@ void exec_CALLX(TExecutor *self)
     pop(self->stack);
     switch (r) {
         case Ne_SUCCESS: {
-            push(self->stack, cell_fromCell(retval));
+            pushCopy(self->stack, retval);
             for (size_t i = 0; i < out_params->array->size; i++) {
-                push(self->stack, cell_fromCell(&out_params->array->data[i]));
+                pushCopy(self->stack, &out_params->array->data[i]);
             }
             break;
         }
@@ -1528,7 +1533,7 @@ void exec_SWAP(TExecutor *self)
 {
     self->ip++;
     int top = self->stack->top;
-    Cell *t = self->stack->data[top];
+    Cell t = self->stack->data[top];
     self->stack->data[top] = self->stack->data[top-1];
     self->stack->data[top-1] = t;
 }
@@ -1612,6 +1617,85 @@ void exec_PUSHCI(TExecutor *self)
     fatal_error("cnex: unknown class name %s\n", TCSTR(self->module->bytecode->strings[val]));
 }
 
+void exec_FORN(TExecutor *self)
+{
+    self->ip++;
+    unsigned int val = exec_getOperand(self);
+    unsigned int target = exec_getOperand(self);
+    Cell *bound = top(self->stack)->address; pop(self->stack);
+    Cell *var = top(self->stack)->address; pop(self->stack);
+    TModule *m = self->module;
+    if (m->loop_steps == NULL) {
+        m->loop_steps = malloc(sizeof(Number) * m->bytecode->strtablesize);
+        m->loop_step_loaded = calloc(m->bytecode->strtablesize, sizeof(BOOL));
+        if (m->loop_steps == NULL || m->loop_step_loaded == NULL) {
+            fatal_error("Could not allocate memory for loop steps.");
+        }
+    }
+    if (!m->loop_step_loaded[val]) {
+        m->loop_steps[val] = number_from_string(m->bytecode->strings[val]->data);
+        m->loop_step_loaded[val] = TRUE;
+    }
+    Number step = m->loop_steps[val];
+    cell_setNumber(var, number_add(var->number, step));
+    if (number_is_negative(step) ? !number_is_less(var->number, bound->number) : !number_is_greater(var->number, bound->number)) {
+        self->ip = target;
+    }
+}
+
+void exec_CASEN(TExecutor *self)
+{
+    self->ip++;
+    unsigned int val = exec_getOperand(self);
+    Number n = top(self->stack)->number; pop(self->stack);
+    unsigned int keys = self->ip;
+    unsigned int found = val;
+    unsigned int lo = 0;
+    unsigned int hi = val;
+    while (lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        unsigned int p = keys + 5 * mid;
+        unsigned int k = get_vint(self->module->bytecode->code, self->module->bytecode->codelen, &p);
+        Number key = number_from_string(self->module->bytecode->strings[k]->data);
+        if (number_is_less(n, key)) {
+            hi = mid;
+        } else if (number_is_greater(n, key)) {
+            lo = mid + 1;
+        } else {
+            found = mid;
+            break;
+        }
+    }
+    self->ip = keys + 5 * val + 6 * found;
+}
+
+void exec_CASES(TExecutor *self)
+{
+    self->ip++;
+    unsigned int val = exec_getOperand(self);
+    Cell *s = top(self->stack);
+    unsigned int keys = self->ip;
+    unsigned int found = val;
+    unsigned int lo = 0;
+    unsigned int hi = val;
+    while (lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        unsigned int p = keys + 5 * mid;
+        unsigned int k = get_vint(self->module->bytecode->code, self->module->bytecode->codelen, &p);
+        int c = string_compareString(s->string, self->module->bytecode->strings[k]);
+        if (c < 0) {
+            hi = mid;
+        } else if (c > 0) {
+            lo = mid + 1;
+        } else {
+            found = mid;
+            break;
+        }
+    }
+    pop(self->stack);
+    self->ip = keys + 5 * val + 6 * found;
+}
+
 void invoke(TExecutor *self, TModule *m, int index)
 {
     self->callstacktop++;
@@ -1646,117 +1730,167 @@ void invoke(TExecutor *self, TModule *m, int index)
     self->ip = self->module->bytecode->functions[index].entry;
 }
 
+static inline BOOL exec_running(const TExecutor *self, int64_t min_callstack_depth)
+{
+    return (self->callstacktop + 1) > min_callstack_depth && self->ip < self->module->bytecode->codelen && self->exit_code == 0;
+}
+
+/*
+ * With GCC and Clang, each opcode handler jumps directly to the handler of
+ * the next opcode through a table of label addresses. This replaces the
+ * single shared indirect branch of a switch with one per opcode, which the
+ * branch predictor handles much better. Other compilers use the switch.
+ * Define CNEX_NO_COMPUTED_GOTO to use the switch everywhere.
+ */
+#if defined(__GNUC__) && !defined(CNEX_NO_COMPUTED_GOTO)
+#define CNEX_COMPUTED_GOTO
+#endif
+
+#ifdef CNEX_COMPUTED_GOTO
+#define GENERATE_LABEL(OP)  &&do_##OP,
+#define DISPATCH() \
+    do { \
+        const uint8_t opcode = self->module->bytecode->code[self->ip]; \
+        if (opcode >= sizeof(dispatch_table) / sizeof(dispatch_table[0])) { \
+            goto do_invalid; \
+        } \
+        goto *dispatch_table[opcode]; \
+    } while (0);
+#define TARGET(OP)  do_##OP:
+// Go back to the top of the loop only when it has something to check.
+#define NEXT() \
+    self->diagnostics.total_opcodes++; \
+    if (self->disassemble || !exec_running(self, min_callstack_depth)) { \
+        continue; \
+    } \
+    DISPATCH()
+#define INVALID()   do_invalid:
+#else
+#define DISPATCH()  switch (self->module->bytecode->code[self->ip])
+#define TARGET(OP)  case OP:
+#define NEXT()      self->diagnostics.total_opcodes++; continue;
+#define INVALID()   default:
+#endif
+
 int exec_loop(TExecutor *self, int64_t min_callstack_depth)
 {
-    while ((self->callstacktop +1) > min_callstack_depth && self->ip < self->module->bytecode->codelen && self->exit_code == 0) {
+#ifdef CNEX_COMPUTED_GOTO
+    static const void *const dispatch_table[] = {
+        FOREACH_OPCODE(GENERATE_LABEL)
+    };
+#endif
+    while (exec_running(self, min_callstack_depth)) {
         if (self->disassemble) {
             fprintf(stderr, "mod %s ip %d (%d) %s\n", self->module->name, self->ip, self->stack->top, disasm_disassembleInstruction(self));
         }
-        switch (self->module->bytecode->code[self->ip]) {
-            case PUSHB:   exec_PUSHB(self); break;
-            case PUSHN:   exec_PUSHN(self); break;
-            case PUSHS:   exec_PUSHS(self); break;
-            case PUSHY:   exec_PUSHY(self); break;
-            case PUSHPG:  exec_PUSHPG(self); break;
-            case PUSHPPG: exec_PUSHPPG(self); break;
-            case PUSHPMG: exec_PUSHPMG(self); break;
-            case PUSHPL:  exec_PUSHPL(self); break;
-            case PUSHPOL: exec_PUSHPOL(self); break;
-            case PUSHI:   exec_PUSHI(self); break;
-            case LOADB:   exec_LOADB(self); break;
-            case LOADN:   exec_LOADN(self); break;
-            case LOADS:   exec_LOADS(self); break;
-            case LOADY:   exec_LOADY(self); break;
-            case LOADA:   exec_LOADA(self); break;
-            case LOADD:   exec_LOADD(self); break;
-            case LOADP:   exec_LOADP(self); break;
-            case LOADJ:   exec_LOADJ(self); break;
-            case LOADV:   exec_LOADV(self); break;
-            case STOREB:  exec_STOREB(self); break;
-            case STOREN:  exec_STOREN(self); break;
-            case STORES:  exec_STORES(self); break;
-            case STOREY:  exec_STOREY(self); break;
-            case STOREA:  exec_STOREA(self); break;
-            case STORED:  exec_STORED(self); break;
-            case STOREP:  exec_STOREP(self); break;
-            case STOREJ:  exec_STOREJ(self); break;
-            case STOREV:  exec_STOREV(self); break;
-            case NEGN:    exec_NEGN(self); break;
-            case ADDN:    exec_ADDN(self); break;
-            case SUBN:    exec_SUBN(self); break;
-            case MULN:    exec_MULN(self); break;
-            case DIVN:    exec_DIVN(self); break;
-            case MODN:    exec_MODN(self); break;
-            case EXPN:    exec_EXPN(self); break;
-            case EQB:     exec_EQB(self); break;
-            case NEB:     exec_NEB(self); break;
-            case EQN:     exec_EQN(self); break;
-            case NEN:     exec_NEN(self); break;
-            case LTN:     exec_LTN(self); break;
-            case GTN:     exec_GTN(self); break;
-            case LEN:     exec_LEN(self); break;
-            case GEN:     exec_GEN(self); break;
-            case EQS:     exec_EQS(self); break;
-            case NES:     exec_NES(self); break;
-            case LTS:     exec_LTS(self); break;
-            case GTS:     exec_GTS(self); break;
-            case LES:     exec_LES(self); break;
-            case GES:     exec_GES(self); break;
-            case EQY:     exec_EQY(self); break;
-            case NEY:     exec_NEY(self); break;
-            case LTY:     exec_LTY(self); break;
-            case GTY:     exec_GTY(self); break;
-            case LEY:     exec_LEY(self); break;
-            case GEY:     exec_GEY(self); break;
-            case EQA:     exec_EQA(self); break;
-            case NEA:     exec_NEA(self); break;
-            case EQD:     exec_EQD(self); break;
-            case NED:     exec_NED(self); break;
-            case EQP:     exec_EQP(self); break;
-            case NEP:     exec_NEP(self); break;
-            case EQV:     exec_EQV(self); break;
-            case NEV:     exec_NEV(self); break;
-            case ANDB:    exec_ANDB(); break;
-            case ORB:     exec_ORB(); break;
-            case NOTB:    exec_NOTB(self); break;
-            case INDEXAR: exec_INDEXAR(self); break;
-            case INDEXAW: exec_INDEXAW(self); break;
-            case INDEXAV: exec_INDEXAV(self); break;
-            case INDEXAN: exec_INDEXAN(self); break;
-            case INDEXDR: exec_INDEXDR(self); break;
-            case INDEXDW: exec_INDEXDW(self); break;
-            case INDEXDV: exec_INDEXDV(self); break;
-            case INA:     exec_INA(self); break;
-            case IND:     exec_IND(self); break;
-            case CALLP:   exec_CALLP(self); break;
-            case CALLF:   exec_CALLF(self); break;
-            case CALLMF:  exec_CALLMF(self); break;
-            case CALLI:   exec_CALLI(self); break;
-            case JUMP:    exec_JUMP(self); break;
-            case JF:      exec_JF(self); break;
-            case JT:      exec_JT(self); break;
-            case DUP:     exec_DUP(self); break;
-            case DUPX1:   exec_DUPX1(self); break;
-            case DROP:    exec_DROP(self); break;
-            case RET:     exec_RET(self); break;
-            case CONSA:   exec_CONSA(self); break;
-            case CONSD:   exec_CONSD(self); break;
-            case EXCEPT:  exec_EXCEPT(self); break;
-            case ALLOC:   exec_ALLOC(self); break;
-            case PUSHNIL: exec_PUSHNIL(self); break;
-            case RESETC:  exec_RESETC(self); break;
-            case PUSHPEG: exec_PUSHPEG(); break;
-            case JUMPTBL: exec_JUMPTBL(self); break;
-            case CALLX:   exec_CALLX(self); break;
-            case SWAP:    exec_SWAP(self); break;
-            case DROPN:   exec_DROPN(self); break;
-            case PUSHFP:  exec_PUSHFP(self); break;
-            case CALLV:   exec_CALLV(self); break;
-            case PUSHCI:  exec_PUSHCI(self); break;
-            default:
+        DISPATCH()
+        {
+            TARGET(PUSHB)   exec_PUSHB(self); NEXT();
+            TARGET(PUSHN)   exec_PUSHN(self); NEXT();
+            TARGET(PUSHS)   exec_PUSHS(self); NEXT();
+            TARGET(PUSHY)   exec_PUSHY(self); NEXT();
+            TARGET(PUSHPG)  exec_PUSHPG(self); NEXT();
+            TARGET(PUSHPPG) exec_PUSHPPG(self); NEXT();
+            TARGET(PUSHPMG) exec_PUSHPMG(self); NEXT();
+            TARGET(PUSHPL)  exec_PUSHPL(self); NEXT();
+            TARGET(PUSHPOL) exec_PUSHPOL(self); NEXT();
+            TARGET(PUSHI)   exec_PUSHI(self); NEXT();
+            TARGET(LOADB)   exec_LOADB(self); NEXT();
+            TARGET(LOADN)   exec_LOADN(self); NEXT();
+            TARGET(LOADS)   exec_LOADS(self); NEXT();
+            TARGET(LOADY)   exec_LOADY(self); NEXT();
+            TARGET(LOADA)   exec_LOADA(self); NEXT();
+            TARGET(LOADD)   exec_LOADD(self); NEXT();
+            TARGET(LOADP)   exec_LOADP(self); NEXT();
+            TARGET(LOADJ)   exec_LOADJ(self); NEXT();
+            TARGET(LOADV)   exec_LOADV(self); NEXT();
+            TARGET(STOREB)  exec_STOREB(self); NEXT();
+            TARGET(STOREN)  exec_STOREN(self); NEXT();
+            TARGET(STORES)  exec_STORES(self); NEXT();
+            TARGET(STOREY)  exec_STOREY(self); NEXT();
+            TARGET(STOREA)  exec_STOREA(self); NEXT();
+            TARGET(STORED)  exec_STORED(self); NEXT();
+            TARGET(STOREP)  exec_STOREP(self); NEXT();
+            TARGET(STOREJ)  exec_STOREJ(self); NEXT();
+            TARGET(STOREV)  exec_STOREV(self); NEXT();
+            TARGET(NEGN)    exec_NEGN(self); NEXT();
+            TARGET(ADDN)    exec_ADDN(self); NEXT();
+            TARGET(SUBN)    exec_SUBN(self); NEXT();
+            TARGET(MULN)    exec_MULN(self); NEXT();
+            TARGET(DIVN)    exec_DIVN(self); NEXT();
+            TARGET(MODN)    exec_MODN(self); NEXT();
+            TARGET(EXPN)    exec_EXPN(self); NEXT();
+            TARGET(EQB)     exec_EQB(self); NEXT();
+            TARGET(NEB)     exec_NEB(self); NEXT();
+            TARGET(EQN)     exec_EQN(self); NEXT();
+            TARGET(NEN)     exec_NEN(self); NEXT();
+            TARGET(LTN)     exec_LTN(self); NEXT();
+            TARGET(GTN)     exec_GTN(self); NEXT();
+            TARGET(LEN)     exec_LEN(self); NEXT();
+            TARGET(GEN)     exec_GEN(self); NEXT();
+            TARGET(EQS)     exec_EQS(self); NEXT();
+            TARGET(NES)     exec_NES(self); NEXT();
+            TARGET(LTS)     exec_LTS(self); NEXT();
+            TARGET(GTS)     exec_GTS(self); NEXT();
+            TARGET(LES)     exec_LES(self); NEXT();
+            TARGET(GES)     exec_GES(self); NEXT();
+            TARGET(EQY)     exec_EQY(self); NEXT();
+            TARGET(NEY)     exec_NEY(self); NEXT();
+            TARGET(LTY)     exec_LTY(self); NEXT();
+            TARGET(GTY)     exec_GTY(self); NEXT();
+            TARGET(LEY)     exec_LEY(self); NEXT();
+            TARGET(GEY)     exec_GEY(self); NEXT();
+            TARGET(EQA)     exec_EQA(self); NEXT();
+            TARGET(NEA)     exec_NEA(self); NEXT();
+            TARGET(EQD)     exec_EQD(self); NEXT();
+            TARGET(NED)     exec_NED(self); NEXT();
+            TARGET(EQP)     exec_EQP(self); NEXT();
+            TARGET(NEP)     exec_NEP(self); NEXT();
+            TARGET(EQV)     exec_EQV(self); NEXT();
+            TARGET(NEV)     exec_NEV(self); NEXT();
+            TARGET(ANDB)    exec_ANDB(); NEXT();
+            TARGET(ORB)     exec_ORB(); NEXT();
+            TARGET(NOTB)    exec_NOTB(self); NEXT();
+            TARGET(INDEXAR) exec_INDEXAR(self); NEXT();
+            TARGET(INDEXAW) exec_INDEXAW(self); NEXT();
+            TARGET(INDEXAV) exec_INDEXAV(self); NEXT();
+            TARGET(INDEXAN) exec_INDEXAN(self); NEXT();
+            TARGET(INDEXDR) exec_INDEXDR(self); NEXT();
+            TARGET(INDEXDW) exec_INDEXDW(self); NEXT();
+            TARGET(INDEXDV) exec_INDEXDV(self); NEXT();
+            TARGET(INA)     exec_INA(self); NEXT();
+            TARGET(IND)     exec_IND(self); NEXT();
+            TARGET(CALLP)   exec_CALLP(self); NEXT();
+            TARGET(CALLF)   exec_CALLF(self); NEXT();
+            TARGET(CALLMF)  exec_CALLMF(self); NEXT();
+            TARGET(CALLI)   exec_CALLI(self); NEXT();
+            TARGET(JUMP)    exec_JUMP(self); NEXT();
+            TARGET(JF)      exec_JF(self); NEXT();
+            TARGET(JT)      exec_JT(self); NEXT();
+            TARGET(DUP)     exec_DUP(self); NEXT();
+            TARGET(DUPX1)   exec_DUPX1(self); NEXT();
+            TARGET(DROP)    exec_DROP(self); NEXT();
+            TARGET(RET)     exec_RET(self); NEXT();
+            TARGET(CONSA)   exec_CONSA(self); NEXT();
+            TARGET(CONSD)   exec_CONSD(self); NEXT();
+            TARGET(EXCEPT)  exec_EXCEPT(self); NEXT();
+            TARGET(ALLOC)   exec_ALLOC(self); NEXT();
+            TARGET(PUSHNIL) exec_PUSHNIL(self); NEXT();
+            TARGET(RESETC)  exec_RESETC(self); NEXT();
+            TARGET(PUSHPEG) exec_PUSHPEG(); NEXT();
+            TARGET(JUMPTBL) exec_JUMPTBL(self); NEXT();
+            TARGET(CALLX)   exec_CALLX(self); NEXT();
+            TARGET(SWAP)    exec_SWAP(self); NEXT();
+            TARGET(DROPN)   exec_DROPN(self); NEXT();
+            TARGET(PUSHFP)  exec_PUSHFP(self); NEXT();
+            TARGET(CALLV)   exec_CALLV(self); NEXT();
+            TARGET(PUSHCI)  exec_PUSHCI(self); NEXT();
+            TARGET(FORN)    exec_FORN(self); NEXT();
+            TARGET(CASEN)   exec_CASEN(self); NEXT();
+            TARGET(CASES)   exec_CASES(self); NEXT();
+            INVALID()
                 fatal_error("exec: Unexpected opcode: %d\n", self->module->bytecode->code[self->ip]);
         }
-        self->diagnostics.total_opcodes++;
     }
     return self->exit_code;
 }
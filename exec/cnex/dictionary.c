@@ -12,16 +12,50 @@
 #include "nstring.h"
 #include "util.h"
 
-int64_t dictionary_findIndex(Dictionary *self, struct tagTString *key)
+#define DICTIONARY_DELETED  (-1)
+#define INITIAL_INDEX_SIZE  16
+
+static void dictionary_resizeIndex(Dictionary *self, size_t size)
 {
-    int64_t i;
+    free(self->index);
+    self->index = calloc(size, sizeof(int64_t));
+    if (self->index == NULL) {
+        fatal_error("Could not allocate dictionary index of %zu slots.", size);
+    }
+    self->mask = size - 1;
+    self->used = (size_t)self->len;
+    for (int64_t i = 0; i < self->len; i++) {
+        size_t slot = self->data[i].hash & self->mask;
+        while (self->index[slot] != 0) {
+            slot = (slot + 1) & self->mask;
+        }
+        self->index[slot] = i + 1;
+    }
+}
 
-    for (i = 0; i < self->len; i++) {
-        if (string_compareString(self->data[i].key, key) == 0) {
-            return i;
+// Return the index slot that holds key, or -1 if key is not present.
+static int64_t dictionary_findSlot(Dictionary *self, TString *key, uint32_t hash)
+{
+    size_t slot = hash & self->mask;
+    for (;;) {
+        int64_t n = self->index[slot];
+        if (n == 0) {
+            return -1;
+        }
+        if (n != DICTIONARY_DELETED) {
+            DictionaryEntry *e = &self->data[n-1];
+            if (e->hash == hash && string_compareString(e->key, key) == 0) {
+                return (int64_t)slot;
+            }
         }
+        slot = (slot + 1) & self->mask;
     }
-    return -1;
+}
+
+int64_t dictionary_findIndex(Dictionary *self, struct tagTString *key)
+{
+    int64_t slot = dictionary_findSlot(self, key, string_hashString(key));
+    return slot == -1 ? -1 : self->index[slot] - 1;
 }
 
 struct tagTCell *dictionary_findDictionaryEntry(Dictionary *self, struct tagTString *key)
@@ -34,10 +68,10 @@ struct tagTCell *dictionary_findDictionaryEntry(Dictionary *self, struct tagTStr
 
 int64_t dictionary_addDictionaryEntry(Dictionary *self, struct tagTString *key, struct tagTCell *value)
 {
-    int64_t idx;
-
-    idx = dictionary_findIndex(self, key);
-    if (idx != -1) {
+    const uint32_t hash = string_hashString(key);
+    int64_t slot = dictionary_findSlot(self, key, hash);
+    if (slot != -1) {
+        int64_t idx = self->index[slot] - 1;
         cell_freeCell(self->data[idx].value);
         self->data[idx].value = value;
         return idx;
@@ -51,21 +85,47 @@ int64_t dictionary_addDictionaryEntry(Dictionary *self, struct tagTString *key,
     }
     self->data[self->len].key = key;
     self->data[self->len].value = value;
+    self->data[self->len].hash = hash;
     self->len++;
+    // Keep the index at most two thirds full, counting deleted slots. A
+    // rebuild leaves it at most one third full and drops deleted slots.
+    if ((self->used + 1) * 3 > (self->mask + 1) * 2) {
+        size_t size = INITIAL_INDEX_SIZE;
+        while (size < (size_t)self->len * 3) {
+            size *= 2;
+        }
+        dictionary_resizeIndex(self, size);
+    } else {
+        size_t s = hash & self->mask;
+        while (self->index[s] > 0) {
+            s = (s + 1) & self->mask;
+        }
+        if (self->index[s] == 0) {
+            self->used++;
+        }
+        self->index[s] = self->len;
+    }
     return self->len - 1;
 }
 
 void dictionary_removeDictionaryEntry(Dictionary *self, TString *key)
 {
-    int64_t idx = dictionary_findIndex(self, key);
-    if (idx == -1) {
+    int64_t slot = dictionary_findSlot(self, key, string_hashString(key));
+    if (slot == -1) {
         return;
     }
+    int64_t idx = self->index[slot] - 1;
+    self->index[slot] = DICTIONARY_DELETED;
 
     cell_freeCell(self->data[idx].value);
     string_freeString(self->data[idx].key);
 
-    memmove(&self->data[idx], &self->data[idx+1], sizeof(DictionaryEntry) * self->len-1);
+    // Move the last entry into the hole, and point its slot at its new place.
+    int64_t last = self->len - 1;
+    if (idx != last) {
+        self->index[dictionary_findSlot(self, self->data[last].key, self->data[last].hash)] = idx + 1;
+        self->data[idx] = self->data[last];
+    }
     self->len--;
 }
 
@@ -81,16 +141,36 @@ Dictionary *dictionary_createDictionary(void)
     if (d->data == NULL) {
         fatal_error("Could not allocate space for %d dictionary entries.", d->max);
     }
+    d->index = NULL;
+    dictionary_resizeIndex(d, INITIAL_INDEX_SIZE);
     return d;
 }
 
 Dictionary *dictionary_copyDictionary(Dictionary *self)
 {
-    Dictionary *d = dictionary_createDictionary();
-
+    Dictionary *d = malloc(sizeof(struct tagTDictionary));
+    if (d == NULL) {
+        fatal_error("Could not allocate memory for dictionary.");
+    }
+    d->len = self->len;
+    d->max = self->max;
+    d->data = malloc(d->max * sizeof(struct tagTDictionaryEntry));
+    if (d->data == NULL) {
+        fatal_error("Could not allocate space for %d dictionary entries.", d->max);
+    }
     for (int64_t i = 0; i < self->len; i++) {
-        dictionary_addDictionaryEntry(d, string_copyString(self->data[i].key), cell_fromCell(self->data[i].value));
+        d->data[i].key = string_copyString(self->data[i].key);
+        d->data[i].value = cell_fromCell(self->data[i].value);
+        d->data[i].hash = self->data[i].hash;
+    }
+    // The entries are in the same order, so the index can be copied as is.
+    d->mask = self->mask;
+    d->used = self->used;
+    d->index = malloc((d->mask + 1) * sizeof(int64_t));
+    if (d->index == NULL) {
+        fatal_error("Could not allocate dictionary index of %zu slots.", d->mask + 1);
     }
+    memcpy(d->index, self->index, (d->mask + 1) * sizeof(int64_t));
     return d;
 }
 
@@ -123,6 +203,7 @@ void dictionary_freeDictionary(Dictionary *self)
         string_freeString(self->data[i].key);
     }
     free(self->data);
+    free(self->index);
     free(self);
 }
 
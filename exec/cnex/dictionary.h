@@ -1,16 +1,25 @@
 #ifndef DICTIONARY_H
 #define DICTIONARY_H
+#include <stddef.h>
 #include <stdint.h>
 
 typedef struct tagTDictionaryEntry {
     struct tagTString *key;
     struct tagTCell *value;
+    uint32_t hash;
 } DictionaryEntry;
 
+// Entries are kept densely in data[0..len), in no particular order, so
+// they can be walked directly. index is an open addressing hash table of
+// size mask+1 whose slots hold an entry number plus one, zero for an
+// empty slot, or DICTIONARY_DELETED for a slot whose entry was removed.
 typedef struct tagTDictionary {
     int64_t len;
     int64_t max;
     struct tagTDictionaryEntry *data;
+    int64_t *index;
+    size_t mask;
+    size_t used;
 } Dictionary;
 
 Dictionary *dictionary_createDictionary(void);
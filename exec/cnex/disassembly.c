@@ -676,6 +676,31 @@ void disasm_PUSHCI(TInstructionDisassembler *disasm)
     snprintf(disasm->out, MAX_BUFFER, "PUSHCI \"%s\"", TCSTR(disasm->obj->strings[val]));
 }
 
+void disasm_FORN(TInstructionDisassembler *disasm)
+{
+    disasm->index++;
+    uint32_t val = get_vint(disasm->obj->code, disasm->obj->codelen, &disasm->index);
+    uint32_t addr = get_vint(disasm->obj->code, disasm->obj->codelen, &disasm->index);
+    snprintf(disasm->out, MAX_BUFFER, "FORN %s,%d", TCSTR(disasm->obj->strings[val]), addr);
+}
+
+void disasm_CASEN(TInstructionDisassembler *disasm)
+{
+    disasm->index++;
+    uint32_t val = get_vint(disasm->obj->code, disasm->obj->codelen, &disasm->index);
+    snprintf(disasm->out, MAX_BUFFER, "CASEN %d", val);
+    // Skip over the key table; the JUMP entries that follow are disassembled normally.
+    disasm->index += 5 * val;
+}
+
+void disasm_CASES(TInstructionDisassembler *disasm)
+{
+    disasm->index++;
+    uint32_t val = get_vint(disasm->obj->code, disasm->obj->codelen, &disasm->index);
+    snprintf(disasm->out, MAX_BUFFER, "CASES %d", val);
+    disasm->index += 5 * val;
+}
+
 void disasm_disassemble(TInstructionDisassembler *disasm)
 {
     switch (disasm->obj->code[disasm->index]) {
@@ -779,6 +804,9 @@ void disasm_disassemble(TInstructionDisassembler *disasm)
         case PUSHFP:  disasm_PUSHFP(disasm); break;
         case CALLV:   disasm_CALLV(disasm); break;
         case PUSHCI:  disasm_PUSHCI(disasm); break;
+        case FORN:    disasm_FORN(disasm); break;
+        case CASEN:   disasm_CASEN(disasm); break;
+        case CASES:   disasm_CASES(disasm); break;
         default:
             snprintf(disasm->out, MAX_BUFFER, "Unknown opcode: %d", disasm->obj->code[disasm->index]);
             disasm->index++;
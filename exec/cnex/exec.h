@@ -27,9 +27,7 @@ typedef struct tagTExecutor {
     unsigned int *init_order;
     unsigned int init_count;
     int exit_code;
-    struct tagTAllocationObject *firstObject;
-    size_t allocations;
-    size_t collection_interval;
+    struct tagTHeap *heap;
 
     /* Debug / Diagnostic fields */
     struct {
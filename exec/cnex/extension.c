@@ -216,7 +216,7 @@ void exec_callback(const struct Ne_Cell *callback, const struct Ne_ParameterList
     if (params != NULL) {
         Array *ps = ((Cell*)params)->array;
         for (size_t i = ps->size; i > 0; i--) {
-            push(g_executor->stack, cell_fromCell(&ps->data[i-1]));
+            pushCopy(g_executor->stack, &ps->data[i-1]);
         }
     }
     uint32_t index = number_to_uint32(nindex);
@@ -2,10 +2,14 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
+#include "array.h"
 #include "bytecode.h"
 #include "cell.h"
+#include "dictionary.h"
 #include "exec.h"
 #include "framestack.h"
 #include "module.h"
@@ -13,56 +17,286 @@
 #include "stack.h"
 #include "util.h"
 
+// Do not bother collecting until at least this much has been allocated.
+#define HEAP_MIN_THRESHOLD      (1024 * 1024)
 
 
-Cell *heap_allocObject(TExecutor *exec)
+
+THeap *heap_createHeap(void)
 {
-    TAllocationObject *o = malloc(sizeof(TAllocationObject));
-    if (o == NULL) {
-        fatal_error("Failed to allocate heap object after %ul allocations.", exec->allocations);
+    THeap *h = malloc(sizeof(THeap));
+    if (h == NULL) {
+        fatal_error("Could not allocate heap.");
     }
-    exec->diagnostics.total_allocations++;
+    h->slabs = NULL;
+    h->slab_count = 0;
+    h->slab_capacity = 0;
+    h->free_list = NULL;
+    h->live_objects = 0;
+    h->live_bytes = 0;
+    h->bytes_allocated = 0;
+    h->threshold = HEAP_MIN_THRESHOLD;
+    h->interval = 0;
+    h->allocations = 0;
+    h->automatic = TRUE;
+    return h;
+}
+
+static size_t heap_objectSize(const Cell *c)
+{
+    size_t r = sizeof(Cell);
+    if (c->type == cArray && c->array != NULL) {
+        r += sizeof(Array) + c->array->size * sizeof(Cell);
+    }
+    return r;
+}
+
+static TSlab *heap_findSlab(THeap *h, const Cell *c)
+{
+    size_t lo = 0;
+    size_t hi = h->slab_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        TSlab *s = h->slabs[mid];
+        if ((uintptr_t)c < (uintptr_t)s->cells) {
+            hi = mid;
+        } else if ((uintptr_t)c >= (uintptr_t)(s->cells + SLAB_CELLS)) {
+            lo = mid + 1;
+        } else {
+            return s;
+        }
+    }
+    return NULL;
+}
+
+static void heap_addSlab(THeap *h)
+{
+    // The cells follow the slab header in the same allocation.
+    TSlab *s = malloc(sizeof(TSlab) + SLAB_CELLS * sizeof(Cell));
+    if (s == NULL) {
+        fatal_error("Could not allocate heap slab.");
+    }
+    memset(s->allocated, 0, sizeof(s->allocated));
+    memset(s->marked, 0, sizeof(s->marked));
+    s->live = 0;
+    s->cells = (Cell *)(s + 1);
+
+    if (h->slab_count == h->slab_capacity) {
+        h->slab_capacity = h->slab_capacity == 0 ? 8 : h->slab_capacity * 2;
+        h->slabs = realloc(h->slabs, h->slab_capacity * sizeof(TSlab *));
+        if (h->slabs == NULL) {
+            fatal_error("Could not allocate heap slab table.");
+        }
+    }
+    size_t i = h->slab_count;
+    while (i > 0 && (uintptr_t)h->slabs[i-1] > (uintptr_t)s) {
+        h->slabs[i] = h->slabs[i-1];
+        i--;
+    }
+    h->slabs[i] = s;
+    h->slab_count++;
+
+    for (size_t j = SLAB_CELLS; j > 0; j--) {
+        s->cells[j-1].address = h->free_list;
+        h->free_list = &s->cells[j-1];
+    }
+}
+
+Cell *heap_allocObject(TExecutor *exec, size_t fields)
+{
+    THeap *h = exec->heap;
+    if (h->free_list == NULL) {
+        heap_addSlab(h);
+    }
+    Cell *p = h->free_list;
+    h->free_list = p->address;
+
+    TSlab *s = heap_findSlab(h, p);
+    size_t i = p - s->cells;
+    s->allocated[i / 64] |= (uint64_t)1 << (i % 64);
+    s->live++;
 
-    Cell *p = cell_newCell();
-    o->allocNum = exec->diagnostics.total_allocations;
-    o->object = p;
-    o->next = exec->firstObject;
+    cell_initCell(p);
+    p->array = array_createArrayFromSize(fields);
+    p->type = cArray;
 
-    // Push the newly allocated object on the virtual heap.
-    exec->firstObject = o;
+    h->live_objects++;
+    h->bytes_allocated += heap_objectSize(p);
+    h->allocations++;
+    exec->diagnostics.total_allocations++;
     return p;
 }
 
-size_t heap_getObjectCount(TExecutor *exec)
+static void heap_mark(THeap *h, Cell ***todo, size_t *todo_capacity, Cell *root)
+{
+    size_t n = 0;
+    (*todo)[n++] = root;
+    while (n > 0) {
+        Cell *c = (*todo)[--n];
+        TSlab *s = heap_findSlab(h, c);
+        if (s != NULL) {
+            size_t i = c - s->cells;
+            uint64_t bit = (uint64_t)1 << (i % 64);
+            if (s->marked[i / 64] & bit) {
+                continue;
+            }
+            s->marked[i / 64] |= bit;
+        }
+        // Only cells that can lead to heap objects are worth visiting.
+        size_t count = 0;
+        switch (c->type) {
+            case cAddress:
+                count = c->address != NULL;
+                break;
+            case cArray:
+                count = c->array != NULL ? c->array->size : 0;
+                break;
+            case cDictionary:
+                count = c->dictionary != NULL ? (size_t)c->dictionary->len : 0;
+                break;
+            default:
+                break;
+        }
+        if (n + count > *todo_capacity) {
+            while (n + count > *todo_capacity) {
+                *todo_capacity *= 2;
+            }
+            *todo = realloc(*todo, *todo_capacity * sizeof(Cell *));
+            if (*todo == NULL) {
+                fatal_error("Could not allocate garbage collector mark stack.");
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            Cell *x = c->type == cAddress ? c->address
+                    : c->type == cArray ? &c->array->data[i]
+                    : c->dictionary->data[i].value;
+            if (c->type == cAddress || x->type == cAddress || x->type == cArray || x->type == cDictionary) {
+                (*todo)[n++] = x;
+            }
+        }
+    }
+}
+
+void heap_collect(TExecutor *exec)
 {
-    // Count all allocated objects, regardless if they are in use or not.
-    unsigned int ret = 0;
-    TAllocationObject *object = exec->firstObject;
+    THeap *h = exec->heap;
+    for (size_t i = 0; i < h->slab_count; i++) {
+        memset(h->slabs[i]->marked, 0, sizeof(h->slabs[i]->marked));
+    }
+
+    // Mark everything reachable from module globals, frame locals and the operand stack.
+    size_t todo_capacity = 64;
+    Cell **todo = malloc(todo_capacity * sizeof(Cell *));
+    if (todo == NULL) {
+        fatal_error("Could not allocate garbage collector mark stack.");
+    }
+    for (unsigned int m = 0; m < exec->module_count; m++) {
+        TModule *mod = exec->modules[m];
+        if (mod->globals == NULL) {
+            continue;
+        }
+        for (unsigned int i = 0; i < mod->bytecode->global_size; i++) {
+            heap_mark(h, &todo, &todo_capacity, &mod->globals[i]);
+        }
+    }
+    for (int f = 0; f <= exec->framestack->top; f++) {
+        TFrame *frame = exec->framestack->data[f];
+        for (uint32_t i = 0; i < frame->frame_size; i++) {
+            heap_mark(h, &todo, &todo_capacity, &frame->locals[i]);
+        }
+    }
+    for (int i = 0; i <= exec->stack->top; i++) {
+        heap_mark(h, &todo, &todo_capacity, &exec->stack->data[i]);
+    }
+    free(todo);
 
-    while (object != NULL) {
-        ret++;
-        object = object->next;
+    // Sweep the slabs in address order, freeing unmarked objects and
+    // rebuilding the free list so that the lowest free cells are used first.
+    h->free_list = NULL;
+    h->live_bytes = 0;
+    size_t kept = 0;
+    for (size_t n = h->slab_count; n > 0; n--) {
+        TSlab *s = h->slabs[n-1];
+        for (size_t w = 0; w < SLAB_WORDS; w++) {
+            uint64_t dead = s->allocated[w] & ~s->marked[w];
+            for (size_t b = 0; dead != 0; b++, dead >>= 1) {
+                if (dead & 1) {
+                    cell_clearCell(&s->cells[w * 64 + b]);
+                    s->live--;
+                    h->live_objects--;
+                    exec->diagnostics.collected_objects++;
+                }
+            }
+            s->allocated[w] &= s->marked[w];
+        }
+        if (s->live == 0 && (kept > 0 || n > 1)) {
+            // Return empty slabs to the system, keeping at least one.
+            free(s);
+            continue;
+        }
+        for (size_t i = SLAB_CELLS; i > 0; i--) {
+            Cell *c = &s->cells[i-1];
+            if (s->allocated[(i-1) / 64] & ((uint64_t)1 << ((i-1) % 64))) {
+                h->live_bytes += heap_objectSize(c);
+            } else {
+                c->address = h->free_list;
+                h->free_list = c;
+            }
+        }
+        h->slabs[h->slab_count - 1 - kept] = s;
+        kept++;
     }
-    return ret;
+    memmove(h->slabs, &h->slabs[h->slab_count - kept], kept * sizeof(TSlab *));
+    h->slab_count = kept;
+    h->bytes_allocated = 0;
+    h->allocations = 0;
+    h->threshold = h->live_bytes > HEAP_MIN_THRESHOLD ? h->live_bytes : HEAP_MIN_THRESHOLD;
+}
+
+void heap_collectIfNeeded(TExecutor *exec)
+{
+    THeap *h = exec->heap;
+    if (!h->automatic) {
+        return;
+    }
+    if (h->interval > 0 ? h->allocations >= h->interval : h->bytes_allocated >= h->threshold) {
+        heap_collect(exec);
+    }
+}
+
+size_t heap_getObjectCount(TExecutor *exec)
+{
+    // This includes objects that are no longer reachable but have not been collected yet.
+    return exec->heap->live_objects;
+}
+
+void heap_setCollectionInterval(TExecutor *exec, size_t count)
+{
+    exec->heap->interval = count;
+    exec->heap->automatic = count > 0;
 }
 
 void heap_freeHeap(TExecutor *exec)
 {
     // Free ALL objects on the heap, regardless if they are in use or not.
-    // This function is performed on shudown, to free any and all objects 
+    // This function is performed on shudown, to free any and all objects
     // that may still be allocated.
-    TAllocationObject *object = exec->firstObject;
+    THeap *h = exec->heap;
     uint64_t count = 0;
 
-    while (object != NULL) {
-        TAllocationObject *freeObj = object;
-        object = freeObj->next;
-        cell_freeCell(freeObj->object);
-        free(freeObj);
-        freeObj = NULL;
-        count++;
+    for (size_t n = 0; n < h->slab_count; n++) {
+        TSlab *s = h->slabs[n];
+        for (size_t i = 0; i < SLAB_CELLS; i++) {
+            if (s->allocated[i / 64] & ((uint64_t)1 << (i % 64))) {
+                cell_clearCell(&s->cells[i]);
+                count++;
+            }
+        }
+        free(s);
     }
-    exec->firstObject = NULL;
+    free(h->slabs);
+    free(h);
+    exec->heap = NULL;
     if (exec->debug) {
         fprintf(stderr, "Freed %" PRIu64 ", abandoned items.\n", count);
     }
@@ -3,18 +3,49 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "util.h"
+
 struct tagTExecutor;
 struct tagTCell;
 
-typedef struct tagTAllocationObject {
-    uint64_t allocNum;
-    struct tagTCell *object;
-    struct tagTAllocationObject *next;
-} TAllocationObject;
+#define SLAB_CELLS      256
+#define SLAB_WORDS      (SLAB_CELLS / 64)
+
+// Heap objects are allocated from slabs of cells. Which cells are in use,
+// and which were reached by the last mark phase, are kept in bitmaps beside
+// the cells rather than in the cells themselves.
+typedef struct tagTSlab {
+    uint64_t allocated[SLAB_WORDS];
+    uint64_t marked[SLAB_WORDS];
+    unsigned int live;
+    struct tagTCell *cells;
+} TSlab;
+
+typedef struct tagTHeap {
+    // Sorted by address so a cell can be mapped back to its slab.
+    TSlab **slabs;
+    size_t slab_count;
+    size_t slab_capacity;
+    // Free cells, linked through their address member.
+    struct tagTCell *free_list;
+    size_t live_objects;
+    size_t live_bytes;
+    // Collect when bytes_allocated reaches threshold, unless interval is
+    // set, in which case collect every interval allocations.
+    size_t bytes_allocated;
+    size_t threshold;
+    size_t interval;
+    size_t allocations;
+    BOOL automatic;
+} THeap;
 
+THeap *heap_createHeap(void);
 
-struct tagTCell *heap_allocObject(struct tagTExecutor *exec);
+struct tagTCell *heap_allocObject(struct tagTExecutor *exec, size_t fields);
+void heap_collectIfNeeded(struct tagTExecutor *exec);
+void heap_collect(struct tagTExecutor *exec);
 size_t heap_getObjectCount(struct tagTExecutor *exec);
+void heap_setCollectionInterval(struct tagTExecutor *exec, size_t count);
 void heap_freeHeap(struct tagTExecutor *exec);
 
 #endif
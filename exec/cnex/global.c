@@ -265,8 +265,11 @@ TDispatch gfuncDispatch[] = {
     PDFUNC("runtime$assertionsEnabled", runtime_assertionsEnabled),
     PDFUNC("runtime$createObject",      runtime_createObject),
     PDFUNC("runtime$executorName",      runtime_executorName),
+    PDFUNC("runtime$garbageCollect",    runtime_garbageCollect),
+    PDFUNC("runtime$getAllocatedObjectCount", runtime_getAllocatedObjectCount),
     PDFUNC("runtime$isModuleImported",  runtime_isModuleImported),
     PDFUNC("runtime$moduleIsMain",      runtime_moduleIsMain),
+    PDFUNC("runtime$setGarbageCollectionInterval", runtime_setGarbageCollectionInterval),
     PDFUNC("runtime$setRecursionLimit", runtime_setRecursionLimit),
 
     // sqlite - SQLite module database functions
@@ -502,7 +505,7 @@ void neon_num(TExecutor *exec)
         exec->rtl_raise(exec, "ValueRangeException", "num() argument not a number");
         return;
     }
-    push(exec->stack, cell_fromNumber(n));
+    pushNumber(exec->stack, n);
 }
 
 void neon_print(TExecutor *exec)
@@ -588,7 +591,7 @@ void array__find(TExecutor *exec)
 
     pop(exec->stack);
     pop(exec->stack);
-    push(exec->stack, cell_fromNumber(r));
+    pushNumber(exec->stack, r);
 }
 
 void array__range(TExecutor *exec)
@@ -670,7 +673,7 @@ void array__reversed(TExecutor *exec)
 void array__size(TExecutor *exec)
 {
     size_t n = top(exec->stack)->array->size; pop(exec->stack);
-    push(exec->stack, cell_fromNumber(number_from_sint64(n)));
+    pushNumber(exec->stack, number_from_sint64(n));
 }
 
 void array__slice(TExecutor *exec)
@@ -887,7 +890,7 @@ void bytes__index(TExecutor *exec)
 
     unsigned char c = t->string->data[i];
     pop(exec->stack);
-    push(exec->stack, cell_fromNumber(number_from_uint8(c)));
+    pushNumber(exec->stack, number_from_uint8(c));
 }
 
 void bytes__range(TExecutor *exec)
@@ -936,12 +939,7 @@ void bytes__range(TExecutor *exec)
         return;
     }
 
-    sub->string->length = lst + 1 - fst;
-    sub->string->data = malloc(sub->string->length);
-    if (sub->string->data == NULL) {
-        fatal_error("Could not allocate %d bytes for byte array.", sub->string->length);
-    }
-    memcpy(sub->string->data, &t->string->data[fst], lst + 1 - fst);
+    string_appendData(sub->string, &t->string->data[fst], lst + 1 - fst);
     pop(exec->stack);
 
     push(exec->stack, sub);
@@ -952,7 +950,7 @@ void bytes__size(TExecutor *exec)
     /* ToDo: Do not perform unnecessary cell copy here. */
     Cell *self = cell_fromCell(top(exec->stack)); pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_from_uint64(self->string->length)));
+    pushNumber(exec->stack, number_from_uint64(self->string->length));
     cell_freeCell(self);
 }
 
@@ -975,9 +973,7 @@ void bytes__splice(TExecutor *exec)
     }
 
     Cell *sub = cell_newCellType(cBytes);
-    sub->string = string_newString();
-    sub->string->length = t->string->length + (((fst - 1) + s->string->length) - lst);
-    sub->string->data = malloc(sub->string->length);
+    sub->string = string_createString(t->string->length + (((fst - 1) + s->string->length) - lst));
     memcpy(sub->string->data, s->string->data, fst);
     memcpy(&sub->string->data[fst], t->string->data, (t->string->length - fst));
     memcpy(&sub->string->data[t->string->length], &s->string->data[lst + 1], s->string->length - (lst + 1));
@@ -1239,7 +1235,7 @@ void object__isNull(TExecutor *exec)
         r = TRUE;
     }
     pop(exec->stack);
-    push(exec->stack, cell_fromBoolean(r));
+    pushBoolean(exec->stack, r);
 }
 
 void object__setProperty(TExecutor *exec)
@@ -1387,17 +1383,12 @@ void pointer__toString(TExecutor *exec)
 
 void string__append(TExecutor *exec)
 {
-    Cell *b = cell_fromCell(top(exec->stack)); pop(exec->stack);
-    Cell *addr = top(exec->stack)->address; pop(exec->stack);
-
-    addr->string->data = realloc(addr->string->data, addr->string->length + b->string->length);
-    if (addr->string->data == NULL) {
-        fatal_error("Could not allocate %d bytes for string append.",  addr->string->length + b->string->length);
-    }
-    memcpy(&addr->string->data[addr->string->length], b->string->data, b->string->length);
-    addr->string->length += b->string->length;
+    TString *b = top(exec->stack)->string;
+    Cell *addr = peek(exec->stack, 1)->address;
 
-    cell_freeCell(b);
+    string_appendString(addr->string, b);
+    pop(exec->stack);
+    pop(exec->stack);
 }
 
 void string__concat(TExecutor *exec)
@@ -1460,7 +1451,7 @@ void string__index(TExecutor *exec)
 void string__length(TExecutor *exec)
 {
     size_t n = top(exec->stack)->string->length; pop(exec->stack);
-    push(exec->stack, cell_fromNumber(number_from_uint64(n)));
+    pushNumber(exec->stack, number_from_uint64(n));
 }
 
 void string__splice(TExecutor *exec)
@@ -1504,16 +1495,13 @@ void string__splice(TExecutor *exec)
         padding = f - s->string->length;
         new_len += padding;
     }
-    if (new_len > (int64_t)s->string->length) {
-        s->string->data = realloc(s->string->data, new_len);
-    }
-    memmove(&s->string->data[f + padding + t->string->length], &s->string->data[l + 1], (l < (int64_t)s->string->length ? (int64_t)s->string->length - l - 1 : 0));
-    memset(&s->string->data[s->string->length], ' ', padding);
+    const int64_t len = (int64_t)s->string->length;
+    // Resizing first also gives s its own copy of a shared literal before it is changed in place.
+    string_resizeString(s->string, new_len > len ? new_len : len);
+    memmove(&s->string->data[f + padding + t->string->length], &s->string->data[l + 1], (l < len ? len - l - 1 : 0));
+    memset(&s->string->data[len], ' ', padding);
     memcpy(&s->string->data[f], t->string->data, t->string->length);
-    if (new_len < (int64_t)s->string->length) {
-        s->string->data = realloc(s->string->data, new_len);
-    }
-    s->string->length = new_len;
+    string_resizeString(s->string, new_len);
 
     Cell *sub = cell_newCellType(cString);
     sub->string = string_copyString(s->string);
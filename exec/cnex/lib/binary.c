@@ -83,7 +83,7 @@ void binary_and32(TExecutor *exec)
     if (!range_checkU32(exec, y)) {
         return;
     }
-    push(exec->stack, cell_fromNumber(number_from_uint32(number_to_uint32(x) & number_to_uint32(y))));
+    pushNumber(exec->stack, number_from_uint32(number_to_uint32(x) & number_to_uint32(y)));
 }
 
 void binary_extract32(TExecutor *exec)
@@ -104,7 +104,7 @@ void binary_extract32(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 32) {
-        push(exec->stack, cell_fromNumber(BID_ZERO));
+        pushNumber(exec->stack, BID_ZERO);
         return;
     }
     unsigned int v = number_to_uint32(w);
@@ -112,10 +112,10 @@ void binary_extract32(TExecutor *exec)
         v = 32 - b;
     }
     if (v == 32) {
-        push(exec->stack, cell_fromNumber(x));
+        pushNumber(exec->stack, x);
         return;
     }
-    push(exec->stack, cell_fromNumber(number_from_uint32((number_to_uint32(x) >> b) & ((1 << v) - 1))));
+    pushNumber(exec->stack, number_from_uint32((number_to_uint32(x) >> b) & ((1 << v) - 1)));
 }
 
 void binary_get32(TExecutor *exec)
@@ -132,10 +132,10 @@ void binary_get32(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 32) {
-        push(exec->stack, cell_fromBoolean(FALSE));
+        pushBoolean(exec->stack, FALSE);
         return;
     }
-    push(exec->stack, cell_fromBoolean((number_to_uint32(x) & (1 << b)) != 0));
+    pushBoolean(exec->stack, (number_to_uint32(x) & (1 << b)) != 0);
 }
 
 void binary_not32(TExecutor *exec)
@@ -146,7 +146,7 @@ void binary_not32(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_uint32(~number_to_uint32(x))));
+    pushNumber(exec->stack, number_from_uint32(~number_to_uint32(x)));
 }
 
 void binary_or32(TExecutor *exec)
@@ -161,7 +161,7 @@ void binary_or32(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_uint32(number_to_uint32(x) | number_to_uint32(y))));
+    pushNumber(exec->stack, number_from_uint32(number_to_uint32(x) | number_to_uint32(y)));
 }
 
 void binary_replace32(TExecutor *exec)
@@ -186,7 +186,7 @@ void binary_replace32(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 32) {
-        push(exec->stack, cell_fromNumber(x));
+        pushNumber(exec->stack, x);
         return;
     }
     unsigned int v = number_to_uint32(w);
@@ -195,7 +195,7 @@ void binary_replace32(TExecutor *exec)
     }
     uint32_t z      = number_to_uint32(y);
     uint32_t mask   = v < 32 ? (1 << v) - 1 : ~0;
-    push(exec->stack, cell_fromNumber(number_from_uint32((number_to_uint32(x) & ~(mask << b)) | (z << b))));
+    pushNumber(exec->stack, number_from_uint32((number_to_uint32(x) & ~(mask << b)) | (z << b)));
 }
 
 void binary_set32(TExecutor *exec)
@@ -213,13 +213,13 @@ void binary_set32(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 32) {
-        push(exec->stack, cell_fromNumber(x));
+        pushNumber(exec->stack, x);
         return;
     }
     if (v) {
-        push(exec->stack, cell_fromNumber(number_from_uint32(number_to_uint32(x) | (1 << b))));
+        pushNumber(exec->stack, number_from_uint32(number_to_uint32(x) | (1 << b)));
     } else {
-        push(exec->stack, cell_fromNumber(number_from_uint32(number_to_uint32(x) & ~(1 << b))));
+        pushNumber(exec->stack, number_from_uint32(number_to_uint32(x) & ~(1 << b)));
     }
 }
 
@@ -237,10 +237,10 @@ void binary_shift_left32(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 32) {
-        push(exec->stack, cell_fromNumber(BID_ZERO));
+        pushNumber(exec->stack, BID_ZERO);
         return;
     }
-    push(exec->stack, cell_fromNumber(number_from_uint32(number_to_uint32(x) << b)));
+    pushNumber(exec->stack, number_from_uint32(number_to_uint32(x) << b));
 }
 
 void binary_shift_right32(TExecutor *exec)
@@ -257,10 +257,10 @@ void binary_shift_right32(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 32) {
-        push(exec->stack, cell_fromNumber(BID_ZERO));
+        pushNumber(exec->stack, BID_ZERO);
         return;
     }
-    push(exec->stack, cell_fromNumber(number_from_uint32(number_to_uint32(x) >> b)));
+    pushNumber(exec->stack, number_from_uint32(number_to_uint32(x) >> b));
 }
 
 void binary_shift_right_signed32(TExecutor *exec)
@@ -277,10 +277,10 @@ void binary_shift_right_signed32(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 32) {
-        push(exec->stack, cell_fromNumber(BID_ZERO));
+        pushNumber(exec->stack, BID_ZERO);
         return;
     }
-    push(exec->stack, cell_fromNumber(number_from_sint32(number_to_sint32(x) >> b)));
+    pushNumber(exec->stack, number_from_sint32(number_to_sint32(x) >> b));
 }
 
 void binary_xor32(TExecutor *exec)
@@ -295,7 +295,7 @@ void binary_xor32(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_uint32(number_to_uint32(x) ^ number_to_uint32(y))));
+    pushNumber(exec->stack, number_from_uint32(number_to_uint32(x) ^ number_to_uint32(y)));
 }
 
 void binary_and64(TExecutor *exec)
@@ -310,7 +310,7 @@ void binary_and64(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_uint64(number_to_uint64(x) & number_to_uint64(y))));
+    pushNumber(exec->stack, number_from_uint64(number_to_uint64(x) & number_to_uint64(y)));
 }
 
 void binary_extract64(TExecutor *exec)
@@ -331,7 +331,7 @@ void binary_extract64(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 64) {
-        push(exec->stack, cell_fromNumber(BID_ZERO));
+        pushNumber(exec->stack, BID_ZERO);
         return;
     }
     unsigned int v = number_to_uint32(w);
@@ -339,10 +339,10 @@ void binary_extract64(TExecutor *exec)
         v = 64 - b;
     }
     if (v == 64) {
-        push(exec->stack, cell_fromNumber(x));
+        pushNumber(exec->stack, x);
         return;
     }
-    push(exec->stack, cell_fromNumber(number_from_uint64((number_to_uint64(x) >> b) & ((1 << v) - 1))));
+    pushNumber(exec->stack, number_from_uint64((number_to_uint64(x) >> b) & ((1 << v) - 1)));
 }
 
 void binary_get64(TExecutor *exec)
@@ -359,10 +359,10 @@ void binary_get64(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 64) {
-        push(exec->stack, cell_fromBoolean(FALSE));
+        pushBoolean(exec->stack, FALSE);
         return;
     }
-    push(exec->stack, cell_fromBoolean((number_to_uint64(x) & (1ULL << b)) != 0));
+    pushBoolean(exec->stack, (number_to_uint64(x) & (1ULL << b)) != 0);
 }
 
 void binary_not64(TExecutor *exec)
@@ -373,7 +373,7 @@ void binary_not64(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_uint64(~number_to_uint64(x))));
+    pushNumber(exec->stack, number_from_uint64(~number_to_uint64(x)));
 }
 
 void binary_or64(TExecutor *exec)
@@ -388,7 +388,7 @@ void binary_or64(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_uint64(number_to_uint64(x) | number_to_uint64(y))));
+    pushNumber(exec->stack, number_from_uint64(number_to_uint64(x) | number_to_uint64(y)));
 }
 
 void binary_replace64(TExecutor *exec)
@@ -413,7 +413,7 @@ void binary_replace64(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 64) {
-        push(exec->stack, cell_fromNumber(x));
+        pushNumber(exec->stack, x);
         return;
     }
     unsigned int v = number_to_uint32(w);
@@ -422,7 +422,7 @@ void binary_replace64(TExecutor *exec)
     }
     uint64_t z      = number_to_uint64(y);
     uint64_t mask   = v < 64 ? (1 << v) - 1 : ~0;
-    push(exec->stack, cell_fromNumber(number_from_uint64((number_to_uint64(x) & ~(mask << b)) | (z << b))));
+    pushNumber(exec->stack, number_from_uint64((number_to_uint64(x) & ~(mask << b)) | (z << b)));
 }
 
 void binary_set64(TExecutor *exec)
@@ -440,13 +440,13 @@ void binary_set64(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 64) {
-        push(exec->stack, cell_fromNumber(x));
+        pushNumber(exec->stack, x);
         return;
     }
     if (v) {
-        push(exec->stack, cell_fromNumber(number_from_uint64(number_to_uint64(x) | (1ULL << b))));
+        pushNumber(exec->stack, number_from_uint64(number_to_uint64(x) | (1ULL << b)));
     } else {
-        push(exec->stack, cell_fromNumber(number_from_uint64(number_to_uint64(x) & ~(1ULL << b))));
+        pushNumber(exec->stack, number_from_uint64(number_to_uint64(x) & ~(1ULL << b)));
     }
 }
 
@@ -464,10 +464,10 @@ void binary_shift_left64(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 64) {
-        push(exec->stack, cell_fromNumber(BID_ZERO));
+        pushNumber(exec->stack, BID_ZERO);
         return;
     }
-    push(exec->stack, cell_fromNumber(number_from_uint64(number_to_uint64(x) << b)));
+    pushNumber(exec->stack, number_from_uint64(number_to_uint64(x) << b));
 }
 
 void binary_shift_right64(TExecutor *exec)
@@ -484,10 +484,10 @@ void binary_shift_right64(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 64) {
-        push(exec->stack, cell_fromNumber(BID_ZERO));
+        pushNumber(exec->stack, BID_ZERO);
         return;
     }
-    push(exec->stack, cell_fromNumber(number_from_uint64(number_to_uint64(x) >> b)));
+    pushNumber(exec->stack, number_from_uint64(number_to_uint64(x) >> b));
 }
 
 void binary_shift_right_signed64(TExecutor *exec)
@@ -504,10 +504,10 @@ void binary_shift_right_signed64(TExecutor *exec)
 
     unsigned int b = number_to_uint32(n);
     if (b >= 64) {
-        push(exec->stack, cell_fromNumber(BID_ZERO));
+        pushNumber(exec->stack, BID_ZERO);
         return;
     }
-    push(exec->stack, cell_fromNumber(number_from_sint64(number_to_sint64(x) >> b)));
+    pushNumber(exec->stack, number_from_sint64(number_to_sint64(x) >> b));
 }
 
 void binary_xor64(TExecutor *exec)
@@ -522,7 +522,7 @@ void binary_xor64(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_uint64(number_to_uint64(x) ^ number_to_uint64(y))));
+    pushNumber(exec->stack, number_from_uint64(number_to_uint64(x) ^ number_to_uint64(y)));
 }
 
 void binary_andBytes(TExecutor *exec)
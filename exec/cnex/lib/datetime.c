@@ -52,5 +52,5 @@ void datetime_timegm(TExecutor *exec)
     tm.tm_year = number_to_uint32(t->array->data[5].number);
 
     pop(exec->stack);
-    push(exec->stack, cell_fromNumber(number_from_uint64(timegm(&tm))));
+    pushNumber(exec->stack, number_from_uint64(timegm(&tm)));
 }
@@ -241,7 +241,7 @@ void file_exists(TExecutor *exec)
     TString *filename = string_fromString(top(exec->stack)->string); pop(exec->stack);
     string_ensureNullTerminated(filename);
 
-    push(exec->stack, cell_fromBoolean(access(filename->data, F_OK) == 0));
+    pushBoolean(exec->stack, access(filename->data, F_OK) == 0);
     string_freeString(filename);
 }
 
@@ -324,7 +324,7 @@ void file_isDirectory(TExecutor *exec)
     char *path = string_asCString(top(exec->stack)->string); pop(exec->stack);
 
     struct stat st;
-    push(exec->stack, cell_fromBoolean(stat(path, &st) == 0 && S_ISDIR(st.st_mode) != 0));
+    pushBoolean(exec->stack, stat(path, &st) == 0 && S_ISDIR(st.st_mode) != 0);
     free(path);
 }
 
@@ -87,7 +87,7 @@ void file_exists(TExecutor *exec)
 
     int r = _access(filename, 0) == 0;
 
-    push(exec->stack, cell_fromBoolean(r));
+    pushBoolean(exec->stack, r);
     free(filename);
 }
 
@@ -174,7 +174,7 @@ void file_isDirectory(TExecutor *exec)
     char *path = string_asCString(top(exec->stack)->string); pop(exec->stack);
 
     DWORD attr = GetFileAttributes(path);
-    push(exec->stack, cell_fromBoolean(attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY) != 0));
+    pushBoolean(exec->stack, attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY) != 0);
     free(path);
 }
 
@@ -100,7 +100,7 @@ void io_open(TExecutor *exec)
         case ENUM_Mode_write: m = "w+b"; break;
         default:
             free(pszName);
-            push(exec->stack, cell_fromAddress(NULL));
+            pushAddress(exec->stack, NULL);
             return;
     }
 
@@ -169,7 +169,7 @@ void io_tell(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_sint64(ftell(f))));
+    pushNumber(exec->stack, number_from_sint64(ftell(f)));
 }
 
 void io_truncate(TExecutor *exec)
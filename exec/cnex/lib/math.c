@@ -12,49 +12,49 @@ void math_abs(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_abs(x)));
+    pushNumber(exec->stack, number_abs(x));
 }
 
 void math_acos(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_acos(x)));
+    pushNumber(exec->stack, number_acos(x));
 }
 
 void math_acosh(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_acosh(x)));
+    pushNumber(exec->stack, number_acosh(x));
 }
 
 void math_asin(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_asin(x)));
+    pushNumber(exec->stack, number_asin(x));
 }
 
 void math_asinh(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_asinh(x)));
+    pushNumber(exec->stack, number_asinh(x));
 }
 
 void math_atan(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_atan(x)));
+    pushNumber(exec->stack, number_atan(x));
 }
 
 void math_atanh(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_atanh(x)));
+    pushNumber(exec->stack, number_atanh(x));
 }
 
 void math_atan2(TExecutor *exec)
@@ -62,77 +62,77 @@ void math_atan2(TExecutor *exec)
     Number x = top(exec->stack)->number; pop(exec->stack);
     Number y = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_atan2(y, x)));
+    pushNumber(exec->stack, number_atan2(y, x));
 }
 
 void math_cbrt(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_cbrt(x)));
+    pushNumber(exec->stack, number_cbrt(x));
 }
 
 void math_ceil(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_ceil(x)));
+    pushNumber(exec->stack, number_ceil(x));
 }
 
 void math_cos(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_cos(x)));
+    pushNumber(exec->stack, number_cos(x));
 }
 
 void math_cosh(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_cosh(x)));
+    pushNumber(exec->stack, number_cosh(x));
 }
 
 void math_erf(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_erf(x)));
+    pushNumber(exec->stack, number_erf(x));
 }
 
 void math_erfc(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_erfc(x)));
+    pushNumber(exec->stack, number_erfc(x));
 }
 
 void math_exp(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_exp(x)));
+    pushNumber(exec->stack, number_exp(x));
 }
 
 void math_exp2(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_exp2(x)));
+    pushNumber(exec->stack, number_exp2(x));
 }
 
 void math_expm1(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_expm1(x)));
+    pushNumber(exec->stack, number_expm1(x));
 }
 
 void math_floor(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_floor(x)));
+    pushNumber(exec->stack, number_floor(x));
 }
 
 void math_frexp(TExecutor *exec)
@@ -142,8 +142,8 @@ void math_frexp(TExecutor *exec)
     int iexp;
     Number r = number_frexp(x, &iexp);
 
-    push(exec->stack, cell_fromNumber(r));
-    push(exec->stack, cell_fromNumber(number_from_sint32(iexp)));
+    pushNumber(exec->stack, r);
+    pushNumber(exec->stack, number_from_sint32(iexp));
 }
 
 void math_hypot(TExecutor *exec)
@@ -151,7 +151,7 @@ void math_hypot(TExecutor *exec)
     Number x = top(exec->stack)->number; pop(exec->stack);
     Number y = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_hypot(y, x)));
+    pushNumber(exec->stack, number_hypot(y, x));
 }
 
 void math_intdiv(TExecutor *exec)
@@ -159,7 +159,7 @@ void math_intdiv(TExecutor *exec)
     Number y = top(exec->stack)->number; pop(exec->stack);
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_trunc(number_divide(x, y))));
+    pushNumber(exec->stack, number_trunc(number_divide(x, y)));
 }
 
 void math_ldexp(TExecutor *exec)
@@ -173,42 +173,42 @@ void math_ldexp(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_ldexp(x, number_to_sint32(exp))));
+    pushNumber(exec->stack, number_ldexp(x, number_to_sint32(exp)));
 }
 
 void math_lgamma(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_lgamma(x)));
+    pushNumber(exec->stack, number_lgamma(x));
 }
 
 void math_log(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_log(x)));
+    pushNumber(exec->stack, number_log(x));
 }
 
 void math_log10(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_log10(x)));
+    pushNumber(exec->stack, number_log10(x));
 }
 
 void math_log1p(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_log1p(x)));
+    pushNumber(exec->stack, number_log1p(x));
 }
 
 void math_log2(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_log2(x)));
+    pushNumber(exec->stack, number_log2(x));
 }
 
 void math_max(TExecutor *exec)
@@ -217,9 +217,9 @@ void math_max(TExecutor *exec)
     Number a = top(exec->stack)->number; pop(exec->stack);
 
     if (number_is_greater(a, b)) {
-        push(exec->stack, cell_fromNumber(a));
+        pushNumber(exec->stack, a);
     } else {
-        push(exec->stack, cell_fromNumber(b));
+        pushNumber(exec->stack, b);
     }
 }
 
@@ -229,9 +229,9 @@ void math_min(TExecutor *exec)
     Number a = top(exec->stack)->number; pop(exec->stack);
 
     if (number_is_greater(a, b)) {
-        push(exec->stack, cell_fromNumber(b));
+        pushNumber(exec->stack, b);
     } else {
-        push(exec->stack, cell_fromNumber(a));
+        pushNumber(exec->stack, a);
     }
 }
 
@@ -239,7 +239,7 @@ void math_nearbyint(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_nearbyint(x)));
+    pushNumber(exec->stack, number_nearbyint(x));
 }
 
 void math_odd(TExecutor *exec)
@@ -251,7 +251,7 @@ void math_odd(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromBoolean(number_is_odd(n)));
+    pushBoolean(exec->stack, number_is_odd(n));
 }
 
 void math_round(TExecutor *exec)
@@ -263,28 +263,28 @@ void math_round(TExecutor *exec)
     for (int i = number_to_sint32(places); i > 0; i--) {
         scale = number_multiply(scale, number_from_uint32(10));
     }
-    push(exec->stack, cell_fromNumber(number_divide(number_nearbyint(number_multiply(value, scale)), scale)));
+    pushNumber(exec->stack, number_divide(number_nearbyint(number_multiply(value, scale)), scale));
 }
 
 void math_sign(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_sign(x)));
+    pushNumber(exec->stack, number_sign(x));
 }
 
 void math_sin(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_sin(x)));
+    pushNumber(exec->stack, number_sin(x));
 }
 
 void math_sinh(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_sinh(x)));
+    pushNumber(exec->stack, number_sinh(x));
 }
 
 void math_sqrt(TExecutor *exec)
@@ -296,33 +296,33 @@ void math_sqrt(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_sqrt(x)));
+    pushNumber(exec->stack, number_sqrt(x));
 }
 
 void math_tan(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_tan(x)));
+    pushNumber(exec->stack, number_tan(x));
 }
 
 void math_tanh(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_tanh(x)));
+    pushNumber(exec->stack, number_tanh(x));
 }
 
 void math_tgamma(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_tgamma(x)));
+    pushNumber(exec->stack, number_tgamma(x));
 }
 
 void math_trunc(TExecutor *exec)
 {
     Number x = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromNumber(number_trunc(x)));
+    pushNumber(exec->stack, number_trunc(x));
 }
@@ -180,7 +180,7 @@ void mmap_size(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_uint64(f->len)));
+    pushNumber(exec->stack, number_from_uint64(f->len));
 }
 
 void mmap_write(TExecutor *exec)
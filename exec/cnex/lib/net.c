@@ -102,7 +102,7 @@ void net_socket_accept(TExecutor *exec)
     SOCKET r = accept(s, (struct sockaddr *)(&sin), &slen);
     if (r < 0) {
         perror("accept");
-        push(exec->stack, cell_newCell());
+        pushEmpty(exec->stack);
         return;
     }
     push(exec->stack, cell_fromObject(object_createSocketObject(r)));
@@ -255,16 +255,14 @@ void net_socket_recv(TExecutor *exec)
         push(exec->stack, empty);
     }
     if (r == 0) {
-        push(exec->stack, cell_fromBoolean(FALSE));
+        pushBoolean(exec->stack, FALSE);
         push(exec->stack, cell_fromBytes(string_newString()));
         return;
     }
-    TString *ret = string_newString();
-    ret->data = (char*)buf;
-    ret->length = r;
+    TString *ret = string_createStringFromData(buf, r);
+    free(buf);
 
-    // Note that cell_fromBytes() will automatically resize (truncate) the returned buffer to r.
-    push(exec->stack, cell_fromBoolean(TRUE));
+    pushBoolean(exec->stack, TRUE);
     push(exec->stack, cell_fromBytes(ret));
     string_freeString(ret);
 }
@@ -349,7 +347,7 @@ void net_socket_select(TExecutor *exec)
         array_clearArray(read->array);
         array_clearArray(write->array);
         array_clearArray(error->array);
-        push(exec->stack, cell_fromBoolean(FALSE));
+        pushBoolean(exec->stack, FALSE);
         return;
     }
 
@@ -383,5 +381,5 @@ void net_socket_select(TExecutor *exec)
         }
     }
 
-    push(exec->stack, cell_fromBoolean(TRUE));
+    pushBoolean(exec->stack, TRUE);
 }
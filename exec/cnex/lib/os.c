@@ -40,6 +40,6 @@ void os_system(TExecutor *exec)
         p++;
     }
 #endif
-    push(exec->stack, cell_fromNumber(number_from_sint32(system(cmd))));
+    pushNumber(exec->stack, number_from_sint32(system(cmd)));
     free(cmd);
 }
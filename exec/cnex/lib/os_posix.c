@@ -139,7 +139,7 @@ void os_kill(TExecutor *exec)
 
 void os_platform(TExecutor *exec)
 {
-    push(exec->stack, cell_fromNumber(number_from_uint32(ENUM_Platform_posix)));
+    pushNumber(exec->stack, number_from_uint32(ENUM_Platform_posix));
 }
 
 void os_spawn(TExecutor *exec)
@@ -186,9 +186,9 @@ void os_wait(TExecutor *exec)
         }
     }
     if (WIFEXITED(r)) {
-        push(exec->stack, cell_fromNumber(number_from_uint8(WEXITSTATUS(r))));
+        pushNumber(exec->stack, number_from_uint8(WEXITSTATUS(r)));
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_sint8(-1)));
+    pushNumber(exec->stack, number_from_sint8(-1));
 }
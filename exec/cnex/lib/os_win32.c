@@ -93,7 +93,7 @@ void os_kill(TExecutor *exec)
 
 void os_platform(TExecutor *exec)
 {
-    push(exec->stack, cell_fromNumber(number_from_uint32(ENUM_Platform_win32)));
+    pushNumber(exec->stack, number_from_uint32(ENUM_Platform_win32));
 }
 
 void os_spawn(TExecutor *exec)
@@ -149,5 +149,5 @@ void os_wait(TExecutor *exec)
         p->ptr = INVALID_HANDLE_VALUE;
     }
     pop(exec->stack);
-    push(exec->stack, cell_fromNumber(number_from_uint32(r)));
+    pushNumber(exec->stack, number_from_uint32(r));
 }
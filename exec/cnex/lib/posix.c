@@ -234,17 +234,17 @@ void posix_ftruncate(struct tagTExecutor *exec)
 
 void posix_getegid(struct tagTExecutor *exec)
 {
-    push(exec->stack, cell_fromNumber(number_from_sint32(getegid())));
+    pushNumber(exec->stack, number_from_sint32(getegid()));
 }
 
 void posix_geteuid(struct tagTExecutor *exec)
 {
-    push(exec->stack, cell_fromNumber(number_from_sint32(geteuid())));
+    pushNumber(exec->stack, number_from_sint32(geteuid()));
 }
 
 void posix_getgid(struct tagTExecutor *exec)
 {
-    push(exec->stack, cell_fromNumber(number_from_sint32(getgid())));
+    pushNumber(exec->stack, number_from_sint32(getgid()));
 }
 
 void posix_gethostname(struct tagTExecutor *exec)
@@ -271,17 +271,17 @@ void posix_getpgid(struct tagTExecutor *exec)
 
 void posix_getpgrp(struct tagTExecutor *exec)
 {
-    push(exec->stack, cell_fromNumber(number_from_sint32(getpgrp())));
+    pushNumber(exec->stack, number_from_sint32(getpgrp()));
 }
 
 void posix_getpid(struct tagTExecutor *exec)
 {
-    push(exec->stack, cell_fromNumber(number_from_sint32(getpid())));
+    pushNumber(exec->stack, number_from_sint32(getpid()));
 }
 
 void posix_getppid(struct tagTExecutor *exec)
 {
-    push(exec->stack, cell_fromNumber(number_from_sint32(getppid())));
+    pushNumber(exec->stack, number_from_sint32(getppid()));
 }
 
 void posix_getpriority(struct tagTExecutor *exec)
@@ -301,14 +301,14 @@ void posix_getsid(struct tagTExecutor *exec)
 
 void posix_getuid(struct tagTExecutor *exec)
 {
-    push(exec->stack, cell_fromNumber(number_from_sint32(getuid())));
+    pushNumber(exec->stack, number_from_sint32(getuid()));
 }
 
 void posix_isatty(struct tagTExecutor *exec)
 {
     Number fildes = top(exec->stack)->number; pop(exec->stack);
 
-    push(exec->stack, cell_fromBoolean(isatty(number_to_sint32(fildes)) != 0));
+    pushBoolean(exec->stack, isatty(number_to_sint32(fildes)) != 0);
 }
 
 void posix_kill(struct tagTExecutor *exec)
@@ -432,7 +432,7 @@ void posix_pipe(struct tagTExecutor *exec)
     Cell *rfd = cell_fromNumber(number_from_sint32(fds[0]));
     Cell *wfd = cell_fromNumber(number_from_sint32(fds[1]));
 
-    push(exec->stack, cell_fromNumber(number_from_sint32(r)));
+    pushNumber(exec->stack, number_from_sint32(r));
     push(exec->stack, wfd);
     push(exec->stack, rfd);
 }
@@ -109,13 +109,13 @@ void process_call(TExecutor *exec)
     int r = waitpid(child, &stat, 0);
     if (r > 0) {
         if (WIFEXITED(stat)) {
-            push(exec->stack, cell_fromNumber(number_from_uint32(WEXITSTATUS(stat))));
+            pushNumber(exec->stack, number_from_uint32(WEXITSTATUS(stat)));
             push(exec->stack, err);
             push(exec->stack, out);
             return;
         }
         if (WIFSIGNALED(stat)) {
-            push(exec->stack, cell_fromNumber(number_from_uint32(-WTERMSIG(stat))));
+            pushNumber(exec->stack, number_from_uint32(-WTERMSIG(stat)));
             push(exec->stack, err);
             push(exec->stack, out);
             return;
@@ -127,7 +127,7 @@ void process_call(TExecutor *exec)
         return;
     }
 
-    push(exec->stack, cell_fromNumber(number_from_sint32(-1)));
+    pushNumber(exec->stack, number_from_sint32(-1));
     push(exec->stack, err);
     push(exec->stack, out);
 }
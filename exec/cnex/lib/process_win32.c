@@ -116,7 +116,7 @@ void process_call(TExecutor *exec)
     GetExitCodeProcess(pi.hProcess, &r);
     CloseHandle(pi.hProcess);
 
-    push(exec->stack, cell_fromNumber(number_from_uint32(r)));
+    pushNumber(exec->stack, number_from_uint32(r));
     push(exec->stack, stdInfo[1].buffer);
     push(exec->stack, stdInfo[0].buffer);
 }
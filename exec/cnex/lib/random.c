@@ -16,5 +16,5 @@ void random_initModule()
 
 void random_uint32(TExecutor *exec)
 {
-    push(exec->stack, cell_fromNumber(number_from_uint32(rand())));
+    pushNumber(exec->stack, number_from_uint32(rand()));
 }
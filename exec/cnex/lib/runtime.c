@@ -2,13 +2,14 @@
 
 #include "cell.h"
 #include "exec.h"
+#include "gc.h"
 #include "module.h"
 #include "nstring.h"
 #include "stack.h"
 
 void runtime_assertionsEnabled(TExecutor *exec)
 {
-    push(exec->stack, cell_fromBoolean(exec->enable_assert));
+    pushBoolean(exec->stack, exec->enable_assert);
 }
 
 void runtime_executorName(TExecutor *exec)
@@ -16,6 +17,16 @@ void runtime_executorName(TExecutor *exec)
     push(exec->stack, cell_fromCString("cnex"));
 }
 
+void runtime_garbageCollect(TExecutor *exec)
+{
+    heap_collect(exec);
+}
+
+void runtime_getAllocatedObjectCount(TExecutor *exec)
+{
+    pushNumber(exec->stack, number_from_uint64(heap_getObjectCount(exec)));
+}
+
 void runtime_isModuleImported(TExecutor *exec)
 {
     TString *name = top(exec->stack)->string;
@@ -29,12 +40,19 @@ void runtime_isModuleImported(TExecutor *exec)
         }
     }
     pop(exec->stack);
-    push(exec->stack, cell_fromBoolean(r));
+    pushBoolean(exec->stack, r);
 }
 
 void runtime_moduleIsMain(TExecutor *exec)
 {
-    push(exec->stack, cell_fromBoolean(exec->module == exec->modules[0]));
+    pushBoolean(exec->stack, exec->module == exec->modules[0]);
+}
+
+void runtime_setGarbageCollectionInterval(TExecutor *exec)
+{
+    Number n = top(exec->stack)->number; pop(exec->stack);
+
+    heap_setCollectionInterval(exec, number_to_uint64(n));
 }
 
 void runtime_setRecursionLimit(TExecutor *exec)
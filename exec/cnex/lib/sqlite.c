@@ -285,7 +285,7 @@ void sqlite_execOne(TExecutor *exec)
     Retval = TRUE;
 
 done:
-    push(exec->stack, cell_fromBoolean(Retval));
+    pushBoolean(exec->stack, Retval);
     push(exec->stack, result);
 
 cleanup:
@@ -383,7 +383,7 @@ void sqlite_cursorFetch(TExecutor *exec)
     }
     Cell *result = cell_createArrayCell(0);
 
-    push(exec->stack, cell_fromBoolean(fetchCursor(c->other, result)));
+    pushBoolean(exec->stack, fetchCursor(c->other, result));
     push(exec->stack, result);
 
 done:
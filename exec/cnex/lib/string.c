@@ -23,7 +23,7 @@ void string_find(TExecutor *exec)
 
     pop(exec->stack);
     pop(exec->stack);
-    push(exec->stack, cell_fromNumber(number_from_sint64(ret)));
+    pushNumber(exec->stack, number_from_sint64(ret));
 }
 
 void string_fromCodePoint(TExecutor *exec)
@@ -145,7 +145,7 @@ void string_toCodePoint(TExecutor *exec)
     Number r = number_from_uint32((uint32_t)s->string->data[0]);
 
     pop(exec->stack);
-    push(exec->stack, cell_fromNumber(r));
+    pushNumber(exec->stack, r);
 }
 
 void string_trimCharacters(TExecutor *exec)
@@ -43,7 +43,7 @@ void struct_unpackIEEE32(struct tagTExecutor *exec)
     memcpy(&x, b->data, sizeof(x));
 
     pop(exec->stack);
-    push(exec->stack, cell_fromNumber(number_from_float(x)));
+    pushNumber(exec->stack, number_from_float(x));
 }
 
 void struct_unpackIEEE64(struct tagTExecutor *exec)
@@ -54,5 +54,5 @@ void struct_unpackIEEE64(struct tagTExecutor *exec)
     memcpy(&x, b->data, sizeof(x));
 
     pop(exec->stack);
-    push(exec->stack, cell_fromNumber(number_from_double(x)));
+    pushNumber(exec->stack, number_from_double(x));
 }
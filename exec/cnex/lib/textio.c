@@ -66,7 +66,7 @@ void textio_open(TExecutor *exec)
         case ENUM_Mode_write: m = "w+"; break;
         default:
             free(pszName);
-            push(exec->stack, cell_fromAddress(NULL));
+            pushAddress(exec->stack, NULL);
             return;
     }
 
@@ -108,7 +108,7 @@ void textio_readLine(TExecutor *exec)
         }
     }
 
-    push(exec->stack, cell_fromBoolean(ret));
+    pushBoolean(exec->stack, ret);
     push(exec->stack, r);
 }
 
@@ -24,5 +24,5 @@ void time_tick(TExecutor *exec)
     clock_get_time(cclock, &mts);
     mach_port_deallocate(mach_task_self(), cclock);
 
-    push(exec->stack, cell_fromNumber(number_add(number_from_uint64(mts.tv_sec), number_divide(number_from_uint64(mts.tv_nsec), NANOSECONDS_PER_SECOND))));
+    pushNumber(exec->stack, number_add(number_from_uint64(mts.tv_sec), number_divide(number_from_uint64(mts.tv_nsec), NANOSECONDS_PER_SECOND)));
 }
@@ -21,5 +21,5 @@ void time_tick(TExecutor *exec)
 
     clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    push(exec->stack, cell_fromNumber(number_add(number_from_uint64(ts.tv_sec), number_divide(number_from_uint64(ts.tv_nsec), NANOSECONDS_PER_SECOND))));
+    pushNumber(exec->stack, number_add(number_from_uint64(ts.tv_sec), number_divide(number_from_uint64(ts.tv_nsec), NANOSECONDS_PER_SECOND)));
 }
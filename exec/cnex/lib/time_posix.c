@@ -30,8 +30,8 @@ void time_now(TExecutor *exec)
 {
     struct timeval tv;
     if (gettimeofday(&tv, NULL) != 0) {
-        push(exec->stack, cell_fromNumber(number_from_uint32(0)));
+        pushNumber(exec->stack, number_from_uint32(0));
         return;
     }
-    push(exec->stack, cell_fromNumber(number_add(number_from_uint32(tv.tv_sec), number_divide(number_from_uint32(tv.tv_usec), number_from_uint32(1e6)))));
+    pushNumber(exec->stack, number_add(number_from_uint32(tv.tv_sec), number_divide(number_from_uint32(tv.tv_usec), number_from_uint32(1e6))));
 }
@@ -39,7 +39,7 @@ void time_now(TExecutor *exec)
     ULARGE_INTEGER ticks;
     ticks.LowPart = ft.dwLowDateTime;
     ticks.HighPart = ft.dwHighDateTime;
-    push(exec->stack, cell_fromNumber(number_divide(number_from_uint64(ticks.QuadPart - FILETIME_UNIX_EPOCH), number_from_uint32(10000000))));
+    pushNumber(exec->stack, number_divide(number_from_uint64(ticks.QuadPart - FILETIME_UNIX_EPOCH), number_from_uint32(10000000)));
 }
 
 void time_tick(TExecutor *exec)
@@ -47,6 +47,6 @@ void time_tick(TExecutor *exec)
     LARGE_INTEGER now;
     QueryPerformanceCounter(&now);
 
-    push(exec->stack, cell_fromNumber(number_divide(number_from_uint64(now.QuadPart), PERFORMANCE_FREQUENCY)));
+    pushNumber(exec->stack, number_divide(number_from_uint64(now.QuadPart), PERFORMANCE_FREQUENCY));
 }
 
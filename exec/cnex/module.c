@@ -44,6 +44,8 @@ TModule *module_newModule(const char *name)
     r->path_only = NULL;
     r->extension_path = NULL;
     r->codelen = 0;
+    r->loop_steps = NULL;
+    r->loop_step_loaded = NULL;
 
     return r;
 }
@@ -134,6 +136,8 @@ void module_freeModule(TModule *m)
         cell_clearCell(&m->globals[i]);
     }
     free(m->globals);
+    free(m->loop_steps);
+    free(m->loop_step_loaded);
     bytecode_freeBytecode(m->bytecode);
     free(m->source_path);
     free(m->path_only);
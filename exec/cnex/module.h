@@ -2,6 +2,8 @@
 #define MODULE_H
 #include <stdint.h>
 
+#include "number.h"
+
 struct tagTExecutor;
 
 typedef struct tagTModule {
@@ -13,6 +15,9 @@ typedef struct tagTModule {
     unsigned int codelen;
     struct tagTBytecode *bytecode;
     struct tagTCell *globals;
+    // Steps of FORN loops, parsed from the string table on first use.
+    Number *loop_steps;
+    BOOL *loop_step_loaded;
 } TModule;
 
 
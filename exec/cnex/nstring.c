@@ -10,6 +10,41 @@
 
 #include "util.h"
 
+// Make s own at least n bytes of writable storage, keeping its contents.
+static void string_reserve(TString *s, size_t n)
+{
+    if (!s->shared && n <= s->capacity) {
+        return;
+    }
+    if (s->shared && n <= TSTRING_INLINE) {
+        memcpy(s->inline_data, s->data, s->length);
+        s->data = s->inline_data;
+        s->capacity = TSTRING_INLINE;
+        s->shared = FALSE;
+        return;
+    }
+    // Grow geometrically so that repeated appends are amortised O(1).
+    size_t capacity = s->shared ? n : s->capacity * 2;
+    if (capacity < n) {
+        capacity = n;
+    }
+    char *p;
+    if (s->shared || s->data == s->inline_data) {
+        p = malloc(capacity);
+        if (p != NULL) {
+            memcpy(p, s->data, s->length);
+        }
+    } else {
+        p = realloc(s->data, capacity);
+    }
+    if (p == NULL) {
+        fatal_error("Could not allocate %zu bytes for string.", capacity);
+    }
+    s->data = p;
+    s->capacity = capacity;
+    s->shared = FALSE;
+}
+
 TString *string_createCString(const char *s)
 {
     return string_appendCString(string_newString(), s);
@@ -19,28 +54,34 @@ TString *string_createString(size_t length)
 {
     TString *c = string_newString();
 
+    string_reserve(c, length);
     c->length = length;
-    c->data = malloc(c->length);
-    if (c->data == NULL) {
-        fatal_error("Could not allocate %d bytes for requested new string.", length);
-    }
     return c;
 }
 
 TString *string_createStringFromData(void *data, size_t len)
 {
-    TString *c = string_newString();
+    TString *c = string_createString(len);
 
-    c->length = len;
-    c->data = malloc(c->length);
-    if (c->data == NULL) {
-        fatal_error("Could not allocate %d bytes for new data string.", len);
-    }
     memcpy(c->data, data, len);
 
     return c;
 }
 
+TString *string_shareString(TString *literal)
+{
+    // The new string refers to the literal's bytes until it is modified, so
+    // the literal must outlive it. Module string tables do.
+    TString *c = string_newString();
+
+    c->data = literal->data;
+    c->length = literal->length;
+    c->capacity = 0;
+    c->hash = literal->hash;
+    c->shared = TRUE;
+    return c;
+}
+
 TString *string_newString(void)
 {
     TString *c = malloc(sizeof(TString));
@@ -48,17 +89,18 @@ TString *string_newString(void)
         fatal_error("Failed to allocate new TString object.");
     }
 
-    c->data = NULL;
+    c->data = c->inline_data;
     c->length = 0;
+    c->capacity = TSTRING_INLINE;
+    c->hash = 0;
+    c->shared = FALSE;
     return c;
 }
 
 void string_freeString(TString *s)
 {
     if (s) {
-        free(s->data);
-        s->data = NULL;
-        s->length = 0;
+        string_clearString(s);
     }
     free(s);
 }
@@ -66,45 +108,33 @@ void string_freeString(TString *s)
 void string_clearString(TString *s)
 {
     if (s) {
-        if (s->data) {
+        if (!s->shared && s->data != s->inline_data) {
             free(s->data);
-            s->data = NULL;
-            s->length = 0;
         }
+        s->data = s->inline_data;
+        s->length = 0;
+        s->capacity = TSTRING_INLINE;
+        s->hash = 0;
+        s->shared = FALSE;
     }
 }
 
 TString *string_copyString(TString *s)
 {
-    TString *r = string_newString();
-
-    if (s->data) {
-        r->data = malloc(s->length);
-        if (r->data == NULL) {
-            fatal_error("Unable to allocate requested string length of %d bytes to copy string to.", s->length);
-        }
-        memcpy(r->data, s->data, s->length);
-        r->length = s->length;
-    } else {
-        r->data = NULL;
-        r->length = 0;
+    if (s->shared) {
+        return string_shareString(s);
     }
+    TString *r = string_createStringFromData(s->data, s->length);
+    r->hash = s->hash;
     return r;
 }
 
 TString *string_fromString(TString *s)
 {
-    TString *r = string_newString();
-
-    if (s != NULL) {
-        r->length = s->length;
-        r->data = malloc(r->length);
-        if (r->data == NULL) {
-            fatal_error("Unable to allocate new string data.");
-        }
-        memcpy(r->data, s->data, r->length);
+    if (s == NULL) {
+        return string_newString();
     }
-    return r;
+    return string_copyString(s);
 }
 
 int string_compareString(TString *lhs, TString *rhs)
@@ -128,6 +158,23 @@ int string_compareString(TString *lhs, TString *rhs)
     return r;
 }
 
+// FNV-1a, remembered in the string until it is next modified.
+uint32_t string_hashString(TString *s)
+{
+    if (s->hash != 0) {
+        return s->hash;
+    }
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < s->length; i++) {
+        h = (h ^ (uint8_t)s->data[i]) * 16777619u;
+    }
+    if (h == 0) {
+        h = 1;
+    }
+    s->hash = h;
+    return h;
+}
+
 BOOL string_isEmpty(TString *s)
 {
     if (s) {
@@ -140,58 +187,39 @@ BOOL string_isEmpty(TString *s)
 
 TString *string_appendCString(TString *s, const char *ns)
 {
-    s->data = realloc(s->data, s->length + strlen(ns));
-    if (s->data == NULL) {
-        fatal_error("Could not allocate appended C string data.");
-    }
-
-    memcpy(&s->data[s->length], ns, strlen(ns));
-    s->length += strlen(ns);
-    return s;
+    return string_appendData(s, (char *)ns, strlen(ns));
 }
 
 TString *string_appendChar(TString *s, char c)
 {
-    s->data = realloc(s->data, s->length + 1);
-    if (s->data == NULL) {
-        fatal_error("Could not reallocate data for appended character.");
-    }
-
-    s->length++;
-    s->data[s->length-1] =  c;
+    string_reserve(s, s->length + 1);
+    s->data[s->length++] = c;
+    s->hash = 0;
     return s;
 }
 
 TString *string_appendData(TString *s, char *buf, size_t len)
 {
-    s->data = realloc(s->data, s->length + len);
-    if (s->data == NULL) {
-        fatal_error("Could not reallocate string for append data.");
-    }
-
+    string_reserve(s, s->length + len);
     memcpy(&s->data[s->length], buf, len);
     s->length += len;
+    s->hash = 0;
     return s;
 }
 
 void string_resizeString(TString *s, size_t n)
 {
-    s->data = realloc(s->data, n);
-    if (s->data == NULL) {
-        fatal_error("Could not resize string to new count of %ld", n);
-    }
+    string_reserve(s, n);
     s->length = n;
+    s->hash = 0;
 }
 
 TString *string_appendString(TString *s, TString *ns)
 {
-    s->data = realloc(s->data, s->length + ns->length);
-    if (s->data == NULL) {
-        fatal_error("Could not allocate appended TString data.");
-    }
-
+    string_reserve(s, s->length + ns->length);
     memcpy(&s->data[s->length], ns->data, ns->length);
     s->length += ns->length;
+    s->hash = 0;
     return s;
 }
 
@@ -398,11 +426,11 @@ char *to_string(char *dest, size_t len, uint32_t val)
 const char *string_ensureNullTerminated(TString *s)
 {
     // This function ensures that the string is null terminated without adding to actual length of the string.
-    s->data = realloc(s->data, s->length + 1);
-    if (s->data == NULL) {
-        fatal_error("Could not null terminate string with %d bytes.", s->length + 1);
+    // Shared literals already are.
+    if (!s->shared) {
+        string_reserve(s, s->length + 1);
+        s->data[s->length] = '\0';
     }
-    s->data[s->length] = '\0';
     return s->data;
 }
 
@@ -14,9 +14,21 @@
 #define TO_STRING(n)    to_string((char [TSTR_N]){""}, TSTR_N, (n))
 #define NPOS            SIZE_MAX
 
+#define TSTRING_INLINE  24
+
+// data always points at the length bytes of the string. Short strings keep
+// them in inline_data, longer ones in a heap block of capacity bytes, and a
+// shared string points at bytes it does not own (a literal in a module's
+// string table) and is copied before it is first modified. Only the
+// functions below may change where data points. hash caches
+// string_hashString(), with 0 meaning not yet computed.
 typedef struct tagTString {
     size_t length;
     char   *data;
+    size_t capacity;
+    uint32_t hash;
+    BOOL   shared;
+    char   inline_data[TSTRING_INLINE];
 } TString;
 
 char *tprintf(char *dest, TString *s);
@@ -30,8 +42,10 @@ void string_clearString(TString *s);
 TString *string_createCString(const char *s);
 TString *string_createString(size_t length);
 TString *string_createStringFromData(void *data, size_t len);
+TString *string_shareString(TString *literal);
 
 int string_compareString(TString *lhs, TString *rhs);
+uint32_t string_hashString(TString *s);
 BOOL string_isEmpty(TString *s);
 
 TString *string_copyString(TString *s);
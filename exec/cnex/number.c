@@ -7,6 +7,9 @@
 
 #include "cell.h"
 
+// Exception flags for the BID library, which reports through a flags
+// word supplied by the caller. cnex does not inspect them.
+static _IDEC_flags number_flags;
 
 /*
  * Number / string functions
@@ -27,7 +30,7 @@ void number_toString(Number x, char *buf, size_t len)
     assert(len != 0);
 
     char val[50] = { 0 };
-    bid128_to_string(val, x);
+    bid128_to_string(val, x, &number_flags);
 
     char *v, *s = v = &val[1];
 
@@ -204,7 +207,7 @@ Number number_from_string(const char *s)
         return bid128_nan(NULL);
     }
     // Note: bid128_from_string() takes a char*, not a const char*.
-    return bid128_from_string((char*)s);
+    return bid128_from_string((char*)s, &number_flags);
 }
 
 
@@ -214,36 +217,36 @@ Number number_from_string(const char *s)
 
 Number number_add(Number x, Number y)
 {
-    return bid128_add(x, y);
+    return bid128_add(x, y, &number_flags);
 }
 
 Number number_subtract(Number x, Number y)
 {
-    return bid128_sub(x, y);
+    return bid128_sub(x, y, &number_flags);
 }
 
 Number number_divide(Number x, Number y)
 {
-    return bid128_div(x, y);
+    return bid128_div(x, y, &number_flags);
 }
 
 Number number_modulo(Number x, Number y)
 {
     Number m = bid128_abs(y);
     if (bid128_isSigned(x)) {
-        Number q = bid128_round_integral_positive(bid128_div(bid128_abs(x), m));
-        x = bid128_add(x, bid128_mul(m, q));
+        Number q = bid128_round_integral_positive(bid128_div(bid128_abs(x), m, &number_flags), &number_flags);
+        x = bid128_add(x, bid128_mul(m, q, &number_flags), &number_flags);
     }
-    Number r = bid128_fmod(x, m);
+    Number r = bid128_fmod(x, m, &number_flags);
     if (bid128_isSigned(y) && !bid128_isZero(r)) {
-        r = bid128_sub(r, m);
+        r = bid128_sub(r, m, &number_flags);
     }
     return r;
 }
 
 Number number_multiply(Number x, Number y)
 {
-    return bid128_mul(x, y);
+    return bid128_mul(x, y, &number_flags);
 }
 
 Number number_negate(Number x)
@@ -265,7 +268,7 @@ Number number_pow(Number x, Number y)
         }
         return r;
     }
-    return bid128_pow(x, y);
+    return bid128_pow(x, y, &number_flags);
 }
 
 Number number_abs(Number x)
@@ -280,112 +283,112 @@ Number number_sign(Number x)
 
 Number number_ceil(Number x)
 {
-    return bid128_round_integral_positive(x);
+    return bid128_round_integral_positive(x, &number_flags);
 }
 
 Number number_floor(Number x)
 {
-    return bid128_round_integral_negative(x);
+    return bid128_round_integral_negative(x, &number_flags);
 }
 
 Number number_trunc(Number x)
 {
-    return bid128_round_integral_zero(x);
+    return bid128_round_integral_zero(x, &number_flags);
 }
 
 Number number_exp(Number x)
 {
-    return bid128_exp(x);
+    return bid128_exp(x, &number_flags);
 }
 
 Number number_log(Number x)
 {
-    return bid128_log(x);
+    return bid128_log(x, &number_flags);
 }
 
 Number number_sqrt(Number x)
 {
-    return bid128_sqrt(x);
+    return bid128_sqrt(x, &number_flags);
 }
 
 Number number_acos(Number x)
 {
-    return bid128_acos(x);
+    return bid128_acos(x, &number_flags);
 }
 
 Number number_asin(Number x)
 {
-    return bid128_asin(x);
+    return bid128_asin(x, &number_flags);
 }
 
 Number number_atan(Number x)
 {
-    return bid128_atan(x);
+    return bid128_atan(x, &number_flags);
 }
 
 Number number_cos(Number x)
 {
-    return bid128_cos(x);
+    return bid128_cos(x, &number_flags);
 }
 
 Number number_sin(Number x)
 {
-    return bid128_sin(x);
+    return bid128_sin(x, &number_flags);
 }
 
 Number number_tan(Number x)
 {
-    return bid128_tan(x);
+    return bid128_tan(x, &number_flags);
 }
 
 Number number_acosh(Number x)
 {
-    return bid128_acosh(x);
+    return bid128_acosh(x, &number_flags);
 }
 
 Number number_asinh(Number x)
 {
-    return bid128_asinh(x);
+    return bid128_asinh(x, &number_flags);
 }
 
 Number number_atanh(Number x)
 {
-    return bid128_atanh(x);
+    return bid128_atanh(x, &number_flags);
 }
 
 Number number_atan2(Number y, Number x)
 {
-    return bid128_atan2(y, x);
+    return bid128_atan2(y, x, &number_flags);
 }
 
 Number number_cbrt(Number x)
 {
-    return bid128_cbrt(x);
+    return bid128_cbrt(x, &number_flags);
 }
 
 Number number_cosh(Number x)
 {
-    return bid128_cosh(x);
+    return bid128_cosh(x, &number_flags);
 }
 
 Number number_erf(Number x)
 {
-    return bid128_erf(x);
+    return bid128_erf(x, &number_flags);
 }
 
 Number number_erfc(Number x)
 {
-    return bid128_erfc(x);
+    return bid128_erfc(x, &number_flags);
 }
 
 Number number_exp2(Number x)
 {
-    return bid128_exp2(x);
+    return bid128_exp2(x, &number_flags);
 }
 
 Number number_expm1(Number x)
 {
-    return bid128_expm1(x);
+    return bid128_expm1(x, &number_flags);
 }
 
 Number number_frexp(Number x, int *exp)
@@ -395,52 +398,52 @@ Number number_frexp(Number x, int *exp)
 
 Number number_hypot(Number x, Number y)
 {
-    return bid128_hypot(x, y);
+    return bid128_hypot(x, y, &number_flags);
 }
 
 Number number_ldexp(Number x, int exp)
 {
-    return bid128_ldexp(x, exp);
+    return bid128_ldexp(x, exp, &number_flags);
 }
 
 Number number_lgamma(Number x)
 {
-    return bid128_lgamma(x);
+    return bid128_lgamma(x, &number_flags);
 }
 
 Number number_log10(Number x)
 {
-    return bid128_log10(x);
+    return bid128_log10(x, &number_flags);
 }
 
 Number number_log1p(Number x)
 {
-    return bid128_log1p(x);
+    return bid128_log1p(x, &number_flags);
 }
 
 Number number_log2(Number x)
 {
-    return bid128_log2(x);
+    return bid128_log2(x, &number_flags);
 }
 
 Number number_nearbyint(Number x)
 {
-    return bid128_nearbyint(x);
+    return bid128_nearbyint(x, &number_flags);
 }
 
 Number number_sinh(Number x)
 {
-    return bid128_sinh(x);
+    return bid128_sinh(x, &number_flags);
 }
 
 Number number_tanh(Number x)
 {
-    return bid128_tanh(x);
+    return bid128_tanh(x, &number_flags);
 }
 
 Number number_tgamma(Number x)
 {
-    return bid128_tgamma(x);
+    return bid128_tgamma(x, &number_flags);
 }
 
 
@@ -450,8 +453,8 @@ Number number_tgamma(Number x)
 
 BOOL number_is_integer(Number x)
 {
-    Number i = bid128_round_integral_zero(x);
-    return bid128_quiet_equal(x, i) != 0;
+    Number i = bid128_round_integral_zero(x, &number_flags);
+    return bid128_quiet_equal(x, i, &number_flags) != 0;
 }
 
 BOOL number_is_nan(Number x)
@@ -475,32 +478,32 @@ BOOL number_is_zero(Number x)
 
 int32_t number_to_sint32(Number x)
 {
-    return bid128_to_int32_int(x);
+    return bid128_to_int32_int(x, &number_flags);
 }
 
 uint32_t number_to_uint32(Number x)
 {
-    return bid128_to_uint32_int(x);
+    return bid128_to_uint32_int(x, &number_flags);
 }
 
 int64_t number_to_sint64(Number x)
 { 
-    return bid128_to_int64_int(x);
+    return bid128_to_int64_int(x, &number_flags);
 }
 
 uint64_t number_to_uint64(Number x)
 {
-    return bid128_to_uint64_int(x);
+    return bid128_to_uint64_int(x, &number_flags);
 }
 
 float number_to_float(Number x)
 {
-    return bid128_to_binary32(x);
+    return bid128_to_binary32(x, &number_flags);
 }
 
 double number_to_double(Number x)
 {
-    return bid128_to_binary64(x);
+    return bid128_to_binary64(x, &number_flags);
 }
 
 
@@ -540,12 +543,12 @@ Number number_from_sint64(int64_t x)
 
 Number number_from_float(float x)
 {
-    return binary32_to_bid128(x);
+    return binary32_to_bid128(x, &number_flags);
 }
 
 Number number_from_double(double x)
 {
-    return binary64_to_bid128(x);
+    return binary64_to_bid128(x, &number_flags);
 }
 
 
@@ -555,35 +558,35 @@ Number number_from_double(double x)
 
 BOOL number_is_equal(Number x, Number y)
 {
-    return bid128_quiet_equal(x, y);
+    return bid128_quiet_equal(x, y, &number_flags);
 }
 
 BOOL number_is_not_equal(Number x, Number y)
 {
-    return bid128_quiet_not_equal(x, y) != 0;
+    return bid128_quiet_not_equal(x, y, &number_flags) != 0;
 }
 
 BOOL number_is_less(Number x, Number y)
 {
-    return bid128_quiet_less(x, y);
+    return bid128_quiet_less(x, y, &number_flags);
 }
 
 BOOL number_is_greater(Number x, Number y)
 {
-    return bid128_quiet_greater(x, y) != 0;
+    return bid128_quiet_greater(x, y, &number_flags) != 0;
 }
 
 BOOL number_is_less_equal(Number x, Number y)
 {
-    return bid128_quiet_less_equal(x, y) != 0;
+    return bid128_quiet_less_equal(x, y, &number_flags) != 0;
 }
 
 BOOL number_is_greater_equal(Number x, Number y)
 {
-    return bid128_quiet_greater_equal(x, y) != 0;
+    return bid128_quiet_greater_equal(x, y, &number_flags) != 0;
 }
 
 BOOL number_is_odd(Number x)
 {
-    return !bid128_isZero(bid128_fmod(x, bid128_from_uint32(2)));
+    return !bid128_isZero(bid128_fmod(x, bid128_from_uint32(2), &number_flags));
 }
@@ -6,7 +6,7 @@
 #include <stdint.h>
 
 #define DECIMAL_GLOBAL_ROUNDING 1
-#define DECIMAL_GLOBAL_EXCEPTION_FLAGS 1
+#define DECIMAL_GLOBAL_EXCEPTION_FLAGS 0
 
 #include "bid_conf.h"
 #ifdef _MSC_VER
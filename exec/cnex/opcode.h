@@ -102,6 +102,9 @@
     OPCODE(PUSHFP)     /* push function pointer */\
     OPCODE(CALLV)      /* call virtual */\
     OPCODE(PUSHCI)     /* push class info */\
+    OPCODE(FORN)       /* increment loop counter and jump if within bound */\
+    OPCODE(CASEN)      /* jump through sorted number key table */\
+    OPCODE(CASES)      /* jump through sorted string key table */\
 
 #define GENERATE_ENUM(ENUM)     ENUM,
 #define GENERATE_NAME(STRING)   #STRING,
@@ -20,7 +20,7 @@ TStack *createStack(int capacity)
     stack->capacity = capacity;
     stack->top = -1;
     stack->max = -1;
-    stack->data = malloc(stack->capacity * sizeof(Cell *));
+    stack->data = malloc(stack->capacity * sizeof(Cell));
     if (stack->data == NULL) {
         fatal_error("Could not allocate stack memory.");
     }
@@ -38,57 +38,6 @@ void destroyStack(TStack *stack)
     stack->data = NULL;
 }
 
-int isFull(TStack *stack)
-{
-    return stack->top == stack->capacity - 1;
-}
-
-int isEmpty(TStack *stack)
-{
-    return stack->top == -1;
-}
-
-void push(TStack *stack, Cell *item)
-{
-    if (isFull(stack)) {
-        fatal_error("Stack overflow error.");
-    }
-
-    if (stack->max < (stack->top + 1)) {
-        stack->max++;
-    }
-
-    stack->data[++stack->top] = item;
-}
-
-void pop(TStack *stack)
-{
-    if (isEmpty(stack)) {
-        fatal_error("Stack underflow error.");
-    }
-
-    Cell *p = stack->data[stack->top--];
-    cell_freeCell(p);
-}
-
-Cell *top(TStack *stack)
-{
-    if (isEmpty(stack)) {
-        fatal_error("Stack underflow error.");
-    }
-
-    return stack->data[stack->top];
-}
-
-Cell *peek(TStack *stack, int element)
-{
-    if (element > stack->top) {
-        fatal_error("Stack underflow error.");
-    }
-
-    return stack->data[stack->top - element];
-}
-
 void drop(TStack *stack, int element)
 {
     if (element == 0) {
@@ -100,13 +49,12 @@ void drop(TStack *stack, int element)
         fatal_error("Stack underflow error.");
     }
 
-    Cell *p = stack->data[stack->top - element];
+    Cell p = stack->data[stack->top - element];
     for (int i = stack->top - element; i < stack->top; i++) {
         stack->data[i] = stack->data[i+1];
     }
-    // Clear that stack element.  Not critical, but; proper.
-    stack->data[stack->top--] = NULL;
-    cell_freeCell(p);
+    stack->top--;
+    cell_clearCell(&p);
 }
 
 void dump(TStack* stack)
@@ -120,4 +68,3 @@ void dump(TStack* stack)
     }
 
 }
-
@@ -1,24 +1,136 @@
 #ifndef STACK_H
 #define STACK_H
 #include <stddef.h>
+#include <stdlib.h>
 
+#include "cell.h"
+#include "util.h"
+
+// The operand stack holds its cells inline in one array that never moves,
+// so a pointer returned by top() or peek() stays valid until that element
+// is popped. The pushX() functions build the new value directly in its
+// slot and so never allocate.
 typedef struct tagTStack {
     int top;
     int capacity;
     int max;
-    struct tagTCell **data;
+    Cell *data;
 } TStack;
 
 TStack *createStack(int capacity);
 void destroyStack(TStack *stack);
 
-int isFull(TStack *stack);
-int isEmpty(TStack *stack);
-void push(TStack *stack, struct tagTCell *item);
-void pop(TStack *stack);
-struct tagTCell *top(TStack *stack);
-struct tagTCell *peek(TStack *stack, int element);
 void drop(TStack *stack, int element);
 void dump(TStack* stack);
 
+static inline int isFull(const TStack *stack)
+{
+    return stack->top == stack->capacity - 1;
+}
+
+static inline int isEmpty(const TStack *stack)
+{
+    return stack->top == -1;
+}
+
+// Return a new cNothing cell on top of the stack.
+static inline Cell *pushEmpty(TStack *stack)
+{
+    if (isFull(stack)) {
+        fatal_error("Stack overflow error.");
+    }
+
+    if (stack->max < (stack->top + 1)) {
+        stack->max++;
+    }
+
+    Cell *c = &stack->data[++stack->top];
+    cell_initCell(c);
+    return c;
+}
+
+// Move the value of item onto the stack and free item itself.
+static inline void push(TStack *stack, Cell *item)
+{
+    Cell *c = pushEmpty(stack);
+    *c = *item;
+    free(item);
+}
+
+static inline void pushAddress(TStack *stack, Cell *a)
+{
+    Cell *c = pushEmpty(stack);
+    c->type = cAddress;
+    c->address = a;
+}
+
+static inline void pushBoolean(TStack *stack, BOOL b)
+{
+    Cell *c = pushEmpty(stack);
+    c->type = cBoolean;
+    c->boolean = b;
+}
+
+static inline void pushNumber(TStack *stack, Number n)
+{
+    Cell *c = pushEmpty(stack);
+    c->type = cNumber;
+    c->number = n;
+}
+
+static inline void pushCopy(TStack *stack, const Cell *source)
+{
+    cell_copyCell(pushEmpty(stack), source);
+}
+
+static inline void pop(TStack *stack)
+{
+    if (isEmpty(stack)) {
+        fatal_error("Stack underflow error.");
+    }
+
+    Cell *c = &stack->data[stack->top--];
+    switch (c->type) {
+        case cArray:
+        case cBytes:
+        case cDictionary:
+        case cObject:
+        case cString:
+            cell_clearCell(c);
+            break;
+        default:
+            // Nothing to release; the slot is reinitialised by the next push.
+            break;
+    }
+}
+
+// Move the top value into dest, replacing whatever dest held, and pop it.
+static inline void popInto(TStack *stack, Cell *dest)
+{
+    if (isEmpty(stack)) {
+        fatal_error("Stack underflow error.");
+    }
+
+    cell_clearCell(dest);
+    *dest = stack->data[stack->top--];
+}
+
+static inline Cell *top(TStack *stack)
+{
+    if (isEmpty(stack)) {
+        fatal_error("Stack underflow error.");
+    }
+
+    return &stack->data[stack->top];
+}
+
+static inline Cell *peek(TStack *stack, int element)
+{
+    if (element > stack->top) {
+        fatal_error("Stack underflow error.");
+    }
+
+    return &stack->data[stack->top - element];
+}
+
 #endif
@@ -10,6 +10,7 @@
 
 int main()
 {
+    _IDEC_flags flags = 0;
     srand((unsigned int)time(NULL));
 
     for (int i = 0; i < 100000; i++) {
@@ -22,10 +23,10 @@ int main()
             bid128_bytes.bytes[x] = rand() & 0xFF;
         }
         char buf1[50];
-        bid128_to_string(buf1, bid128_bytes.n);
+        bid128_to_string(buf1, bid128_bytes.n, &flags);
         char *buf2 = number_to_string(bid128_bytes.n);
-        Number x = bid128_from_string(buf1);
-        Number y = bid128_from_string(buf2);
+        Number x = bid128_from_string(buf1, &flags);
+        Number y = bid128_from_string(buf2, &flags);
         if (!(number_is_equal(x, y) || (number_is_nan(x) && number_is_nan(y)))) {
             printf("%s %s\n", buf1, buf2);
             assert(FALSE);
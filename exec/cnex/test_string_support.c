@@ -84,6 +84,29 @@ int main()
     assert(string_findCharRev(foobar, '.') == 3);
     assert(string_findCharRev(s2, ' ') == 19);
     assert(string_findCharRev(foobar, '/') == NPOS);
+    // Test storage: short strings are inline, long ones grow on the heap.
+    assert(foo->data == foo->inline_data);
+    assert(s3->data != s3->inline_data);
+    TString *grow = string_newString();
+    for (int i = 0; i < 100; i++) {
+        string_appendChar(grow, 'a' + (i % 26));
+    }
+    assert(grow->length == 100 && grow->data[99] == 'v' && grow->capacity >= 100);
+    // Test shared strings are copied before they are changed.
+    TString *shared = string_shareString(foobar);
+    assert(shared->shared == TRUE && shared->data == foobar->data);
+    TString *copy = string_copyString(shared);
+    assert(copy->data == foobar->data);
+    string_appendChar(shared, '!');
+    assert(shared->shared == FALSE && shared->data != foobar->data);
+    assert(string_compareString(shared, string_createCString("foo.bar!")) == 0);
+    assert(string_compareString(foobar, string_createCString("foo.bar")) == 0);
+    assert(string_compareString(copy, foobar) == 0);
+    // Test the cached hash is dropped when the string changes.
+    uint32_t h = string_hashString(foo);
+    assert(foo->hash == h && string_hashString(string_createCString("foo")) == h);
+    string_appendCString(foo, "bar");
+    assert(string_hashString(foo) == string_hashString(string_createCString("foobar")));
 
     return 0;
 }
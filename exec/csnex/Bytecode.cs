@@ -340,11 +340,14 @@ namespace csnex
             Name = null;
             SourcePath = null;
             Code = null;
+            LoopSteps = new Dictionary<int, Number>();
         }
         public string      Name;
         public string      SourcePath;
         public byte[]      Code;
         public Bytecode    Bytecode;
         public List<Cell>  Globals;
+        // FORN steps, parsed from the string table on first use.
+        public Dictionary<int, Number> LoopSteps;
     }
 }
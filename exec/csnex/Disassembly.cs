@@ -598,6 +598,36 @@ namespace csnex
             stream.AppendFormat("RET");
             index++;
         }
+
+        void FORN()
+        {
+            index++;
+            int val = Bytecode.Get_VInt(bytecode.code, ref index);
+            int addr = Bytecode.Get_VInt(bytecode.code, ref index);
+            stream.AppendFormat("FORN {0},{1}", bytecode.strtable[val], addr);
+        }
+
+        void CASEN()
+        {
+            index++;
+            int val = Bytecode.Get_VInt(bytecode.code, ref index);
+            stream.AppendFormat("CASEN {0}", val);
+            for (int i = 0; i < val; i++) {
+                int k = Bytecode.Get_VInt(bytecode.code, ref index);
+                stream.AppendFormat("{0}{1}", i == 0 ? " " : ",", bytecode.strtable[k]);
+            }
+        }
+
+        void CASES()
+        {
+            index++;
+            int val = Bytecode.Get_VInt(bytecode.code, ref index);
+            stream.AppendFormat("CASES {0}", val);
+            for (int i = 0; i < val; i++) {
+                int k = Bytecode.Get_VInt(bytecode.code, ref index);
+                stream.AppendFormat("{0}\"{1}\"", i == 0 ? " " : ",", bytecode.strtable[k]);
+            }
+        }
         #endregion
 #region Stack Handlers
         void DUP()
@@ -772,6 +802,9 @@ namespace csnex
                 case Opcode.PUSHFP: PUSHFP(); break;
                 case Opcode.CALLV: CALLV(); break;
                 case Opcode.PUSHCI: PUSHCI(); break;
+                case Opcode.FORN: FORN(); break;
+                case Opcode.CASEN: CASEN(); break;
+                case Opcode.CASES: CASES(); break;
                 default:
                     stream.AppendFormat("Unknown opcode: {0}", bytecode.code[index]);
                     index++;
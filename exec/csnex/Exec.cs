@@ -1083,6 +1083,55 @@ namespace csnex
             ip = f.ip;
             module = f.mod;
         }
+
+        void FORN()
+        {
+            ip++;
+            int val = Bytecode.Get_VInt(module.Bytecode.code, ref ip);
+            int target = Bytecode.Get_VInt(module.Bytecode.code, ref ip);
+            Cell bound = stack.Pop().Address;
+            Cell var = stack.Pop().Address;
+            Number step;
+            if (!module.LoopSteps.TryGetValue(val, out step)) {
+                step = Number.FromString(module.Bytecode.strtable[val]);
+                module.LoopSteps[val] = step;
+            }
+            Number n = Number.Add(var.Number, step);
+            Cell.CopyCell(var, Cell.CreateNumberCell(n));
+            if (step.IsNegative() ? !Number.IsLessThan(n, bound.Number) : !Number.IsGreaterThan(n, bound.Number)) {
+                ip = target;
+            }
+        }
+
+        void CASEN()
+        {
+            ip++;
+            int val = Bytecode.Get_VInt(module.Bytecode.code, ref ip);
+            Number n = stack.Pop().Number;
+            int found = val;
+            for (int i = 0; i < val; i++) {
+                int k = Bytecode.Get_VInt(module.Bytecode.code, ref ip);
+                if (found == val && Number.IsEqual(n, Number.FromString(module.Bytecode.strtable[k]))) {
+                    found = i;
+                }
+            }
+            ip += 6 * found;
+        }
+
+        void CASES()
+        {
+            ip++;
+            int val = Bytecode.Get_VInt(module.Bytecode.code, ref ip);
+            string s = stack.Pop().String;
+            int found = val;
+            for (int i = 0; i < val; i++) {
+                int k = Bytecode.Get_VInt(module.Bytecode.code, ref ip);
+                if (found == val && string.Compare(s, module.Bytecode.strtable[k]) == 0) {
+                    found = i;
+                }
+            }
+            ip += 6 * found;
+        }
 #endregion
 #region Stack Handler Opcodes
         void DUP()
@@ -1348,6 +1397,9 @@ namespace csnex
                         case Opcode.PUSHFP: PUSHFP(); break;              // push function pointer
                         case Opcode.CALLV: CALLV(); break;                // call virtual
                         case Opcode.PUSHCI: PUSHCI(); break;              // push class info
+                        case Opcode.FORN: FORN(); break;                  // increment loop counter and jump if within bound
+                        case Opcode.CASEN: CASEN(); break;                // jump through sorted number key table
+                        case Opcode.CASES: CASES(); break;                // jump through sorted string key table
                         default:
                             throw new InvalidOpcodeException(string.Format("Invalid opcode ({0}) in bytecode file.", module.Bytecode.code[ip]));
                     }
@@ -102,5 +102,8 @@
         PUSHFP,     // push function pointer
         CALLV,      // call virtual
         PUSHCI,     // push class info
+        FORN,       // increment loop counter and jump if within bound
+        CASEN,      // jump through sorted number key table
+        CASES,      // jump through sorted string key table
     }
 }
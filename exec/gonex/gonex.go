@@ -123,6 +123,9 @@ const (
 	PUSHFP  = iota // push function pointer
 	CALLV   = iota // call virtual
 	PUSHCI  = iota // push class info
+	FORN    = iota // increment loop counter and jump if within bound
+	CASEN   = iota // jump through sorted number key table
+	CASES   = iota // jump through sorted string key table
 )
 
 func assert(b bool, msg string) {
@@ -977,9 +980,10 @@ type frame struct {
 }
 
 type module struct {
-	name    string
-	object  bytecode
-	globals []cell
+	name      string
+	object    bytecode
+	globals   []cell
+	loopsteps map[int]float64 // FORN steps, parsed on first use
 }
 
 type returnaddress struct {
@@ -1032,9 +1036,10 @@ func (self *executor) importModule(name string, object bytecode) {
 	}
 	m := new(module)
 	*m = module{
-		name:    name,
-		object:  object,
-		globals: make([]cell, object.global_size),
+		name:      name,
+		object:    object,
+		globals:   make([]cell, object.global_size),
+		loopsteps: map[int]float64{},
 	}
 	self.modules[name] = m
 	for _, imp := range object.imports {
@@ -1267,6 +1272,12 @@ func (self *executor) run() {
 			self.op_callv()
 		case PUSHCI:
 			self.op_pushci()
+		case FORN:
+			self.op_forn()
+		case CASEN:
+			self.op_casen()
+		case CASES:
+			self.op_cases()
 		default:
 			panic(fmt.Sprintf("unknown opcode %d", self.module.object.code[self.ip]))
 		}
@@ -3206,6 +3217,61 @@ func (self *executor) op_pushci() {
 	panic("neon: unknown class name")
 }
 
+func (self *executor) op_forn() {
+	self.ip++
+	val := get_vint(self.module.object.code, &self.ip)
+	target := get_vint(self.module.object.code, &self.ip)
+	bound := self.pop().ref
+	ref := self.pop().ref
+	step, found := self.module.loopsteps[val]
+	if !found {
+		var err error
+		step, err = strconv.ParseFloat(string(self.module.object.strtable[val]), 64)
+		if err != nil {
+			panic("number")
+		}
+		self.module.loopsteps[val] = step
+	}
+	n := ref.load().num + step
+	ref.store(make_cell_num(n))
+	b := bound.load().num
+	if (step < 0 && n >= b) || (step >= 0 && n <= b) {
+		self.ip = target
+	}
+}
+
+func (self *executor) op_casen() {
+	self.ip++
+	val := get_vint(self.module.object.code, &self.ip)
+	n := self.pop().num
+	found := val
+	for i := 0; i < val; i++ {
+		k := get_vint(self.module.object.code, &self.ip)
+		key, err := strconv.ParseFloat(string(self.module.object.strtable[k]), 64)
+		if err != nil {
+			panic("number")
+		}
+		if found == val && n == key {
+			found = i
+		}
+	}
+	self.ip += 6 * found
+}
+
+func (self *executor) op_cases() {
+	self.ip++
+	val := get_vint(self.module.object.code, &self.ip)
+	s := self.pop().str
+	found := val
+	for i := 0; i < val; i++ {
+		k := get_vint(self.module.object.code, &self.ip)
+		if found == val && s == string(self.module.object.strtable[k]) {
+			found = i
+		}
+	}
+	self.ip += 6 * found
+}
+
 func (self *executor) raise_literal(exception string, info object) {
 	exceptionvar := make_cell_array([]cell{
 		make_cell_str(exception),
@@ -242,6 +242,9 @@ class Executor {
                     //case PUSHFP
                     case CALLV: doCALLV(); break;
                     case PUSHCI: doPUSHCI(); break;
+                    case FORN: doFORN(); break;
+                    case CASEN: doCASEN(); break;
+                    case CASES: doCASES(); break;
                     default:
                         System.err.println("Unknown opcode: " + opcodes[object.code.get(ip)]);
                         System.exit(1);
@@ -1076,6 +1079,56 @@ class Executor {
         System.exit(1);
     }
 
+    private void doFORN()
+    {
+        ip++;
+        int val = getVint();
+        int target = getVint();
+        Cell bound = stack.removeFirst().getAddress();
+        Cell var = stack.removeFirst().getAddress();
+        BigDecimal step = loopSteps.get(val);
+        if (step == null) {
+            step = new BigDecimal(object.strtable[val]);
+            loopSteps.put(val, step);
+        }
+        BigDecimal n = var.getNumber().add(step);
+        var.set(n);
+        int c = n.compareTo(bound.getNumber());
+        if (step.signum() < 0 ? c >= 0 : c <= 0) {
+            ip = target;
+        }
+    }
+
+    private void doCASEN()
+    {
+        ip++;
+        int val = getVint();
+        BigDecimal n = stack.removeFirst().getNumber();
+        int found = val;
+        for (int i = 0; i < val; i++) {
+            int k = getVint();
+            if (found == val && n.compareTo(new BigDecimal(object.strtable[k])) == 0) {
+                found = i;
+            }
+        }
+        ip += 6 * found;
+    }
+
+    private void doCASES()
+    {
+        ip++;
+        int val = getVint();
+        String s = stack.removeFirst().getString();
+        int found = val;
+        for (int i = 0; i < val; i++) {
+            int k = getVint();
+            if (found == val && s.equals(object.strtable[k])) {
+                found = i;
+            }
+        }
+        ip += 6 * found;
+    }
+
     private void invoke(int index)
     {
         callstack.addFirst(ip);
@@ -1245,6 +1298,9 @@ class Executor {
         PUSHFP,
         CALLV,
         PUSHCI,
+        FORN,
+        CASEN,
+        CASES,
     }
 
     private interface GenericFunction {
@@ -1261,6 +1317,8 @@ class Executor {
     private ArrayDeque<Cell> stack;
     private Cell[] globals;
     private ArrayDeque<ActivationFrame> frames;
+    // FORN steps, parsed from the string table on first use.
+    private Map<Integer, BigDecimal> loopSteps = new HashMap<Integer, BigDecimal>();
     java.util.Random gen = new java.util.Random();
 
     private void array__append()
@@ -495,6 +495,7 @@ class Module:
         self.name = name
         self.object = Bytecode(source_path, bytecode)
         self.globals = [Value(None) for _ in range(self.object.global_size)]
+        self.loop_steps = {}
 
 class Executor:
     def __init__(self, modulefilename, bytecode):
@@ -1249,6 +1250,53 @@ class Executor:
         print("neon: unknown class name {0}".format(self.module.object.strtable[val].decode()), file=sys.stderr)
         sys.exit(1)
 
+    def FORN(self):
+        self.ip += 1
+        val, self.ip = get_vint(self.module.object.code, self.ip)
+        target, self.ip = get_vint(self.module.object.code, self.ip)
+        bound = self.stack.pop()
+        var = self.stack.pop()
+        step = self.module.loop_steps.get(val)
+        if step is None:
+            step = decimal.Decimal(self.module.object.strtable[val].decode())
+            i = int(step)
+            if i == step:
+                step = i
+            self.module.loop_steps[val] = step
+        var.value = var.value + step
+        if (var.value >= bound.value) if step < 0 else (var.value <= bound.value):
+            self.ip = target
+
+    def CASEN(self):
+        self.ip += 1
+        val, self.ip = get_vint(self.module.object.code, self.ip)
+        n = self.stack.pop()
+        self.case_search(val, n, lambda s: decimal.Decimal(s.decode()))
+
+    def CASES(self):
+        self.ip += 1
+        val, self.ip = get_vint(self.module.object.code, self.ip)
+        s = self.stack.pop()
+        self.case_search(val, s, lambda s: s.decode())
+
+    def case_search(self, val, x, convert):
+        keys = self.ip
+        found = val
+        lo = 0
+        hi = val
+        while lo < hi:
+            mid = (lo + hi) // 2
+            k, _ = get_vint(self.module.object.code, keys + 5 * mid)
+            key = convert(self.module.object.strtable[k])
+            if x < key:
+                hi = mid
+            elif x > key:
+                lo = mid + 1
+            else:
+                found = mid
+                break
+        self.ip = keys + 5 * val + 6 * found
+
     def invoke(self, module, index):
         if len(self.callstack) >= self.param_recursion_limit:
             self.raise_literal("StackOverflowException", "")
@@ -1401,6 +1449,9 @@ Dispatch = [
     Executor.PUSHFP,
     Executor.CALLV,
     Executor.PUSHCI,
+    Executor.FORN,
+    Executor.CASEN,
+    Executor.CASES,
 ]
 
 def neon_array__append(self):
@@ -105,6 +105,9 @@ enum Opcode {
     PUSHFP,     // push function pointer
     CALLV,      // call virtual
     PUSHCI,     // push class info
+    FORN,       // increment loop counter and jump if within bound
+    CASEN,      // jump through sorted number key table
+    CASES,      // jump through sorted string key table
 }
 
 fn get_vint(bytes: &[u8], i: &mut usize) -> usize {
@@ -373,6 +376,9 @@ impl Executor {
                 x if x == Opcode::PUSHFP as u8 => self.op_pushfp(),
                 x if x == Opcode::CALLV as u8 => self.op_callv(),
                 x if x == Opcode::PUSHCI as u8 => self.op_pushci(),
+                x if x == Opcode::FORN as u8 => self.op_forn(),
+                x if x == Opcode::CASEN as u8 => self.op_casen(),
+                x if x == Opcode::CASES as u8 => self.op_cases(),
                 _ => panic!("invalid opcode")
             }
         }
@@ -806,6 +812,18 @@ impl Executor {
         assert!(false, "unimplemented");
     }
 
+    fn op_forn(&mut self) {
+        assert!(false, "unimplemented");
+    }
+
+    fn op_casen(&mut self) {
+        assert!(false, "unimplemented");
+    }
+
+    fn op_cases(&mut self) {
+        assert!(false, "unimplemented");
+    }
+
 }
 
 fn main() {
@@ -305,7 +305,7 @@ add_library(bid
 )
 target_compile_options(bid
     PRIVATE -DUSE_COMPILER_F128_TYPE=0 -DUSE_COMPILER_F80_TYPE=0
-    PRIVATE -DDECIMAL_GLOBAL_ROUNDING=1 -DDECIMAL_GLOBAL_EXCEPTION_FLAGS=1
+    PRIVATE -DDECIMAL_GLOBAL_ROUNDING=1 -DDECIMAL_GLOBAL_EXCEPTION_FLAGS=0
 )
 if (WIN32)
 else (WIN32)
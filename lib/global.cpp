@@ -1,9 +1,12 @@
 #ifdef _MSC_VER
 #define _CRT_SECURE_NO_WARNINGS
 #endif
+#include <algorithm>
+#include <exception>
 #include <iso646.h>
 #include <iostream>
 #include <sstream>
+#include <thread>
 
 #ifdef _MSC_VER
 #ifndef snprintf
@@ -14,10 +17,74 @@
 #include <utf8.h>
 
 #include "cell.h"
+#include "exec.h"
 #include "intrinsic.h"
 #include "number.h"
 #include "rtl_exec.h"
 
+// Values passed to and from another executor must not refer to either
+// executor's heap or modules, so pointers and function values are refused.
+static void check_shareable(Cell &c)
+{
+    switch (c.get_type()) {
+        case Cell::Type::Address:
+            if (c.address() != nullptr) {
+                throw RtlException(rtl::ne_global::Exception_InvalidValueException, utf8string("pointer cannot be passed to another thread"));
+            }
+            break;
+        case Cell::Type::Other:
+            throw RtlException(rtl::ne_global::Exception_InvalidValueException, utf8string("function cannot be passed to another thread"));
+        case Cell::Type::Array:
+            for (auto x: c.array()) {
+                check_shareable(x);
+            }
+            break;
+        case Cell::Type::Dictionary:
+            for (auto x: c.dictionary()) {
+                check_shareable(x.second);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static size_t parallel_chunk_count(size_t count)
+{
+    return std::min(static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)), count);
+}
+
+// Split count elements into one chunk per processor and call work on each
+// chunk in a thread of its own, with a caller for that thread. If any chunk
+// raises an exception, the one from the earliest chunk is raised again here.
+static void parallel_chunks(const std::function<ExecutorCaller()> &prepare, size_t count, const std::function<void(const ExecutorCaller &call, size_t chunk, size_t first, size_t last)> &work)
+{
+    size_t n = parallel_chunk_count(count);
+    std::vector<std::exception_ptr> errors(n);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < n; i++) {
+        size_t first = count * i / n;
+        size_t last = count * (i + 1) / n;
+        threads.push_back(std::thread([&prepare, &work, &errors, i, first, last] {
+            try {
+                ExecutorCaller call = prepare();
+                work(call, i, first, last);
+            } catch (...) {
+                // Anything left to escape the thread would end the program.
+                errors[i] = std::current_exception();
+            }
+        }));
+    }
+    for (auto &t: threads) {
+        t.join();
+    }
+    for (auto &e: errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
 namespace rtl {
 
 namespace ne_global {
@@ -89,6 +156,81 @@ void array__resize(Cell *self, Number new_size)
     self->array_for_write().resize(number_to_sint64(new_size));
 }
 
+Cell array__parallelFilter(Cell &self, Cell &function)
+{
+    std::vector<Cell> a = self.array();
+    if (a.empty()) {
+        return Cell(a);
+    }
+    for (auto &x: a) {
+        check_shareable(x);
+    }
+    std::vector<char> keep(a.size());
+    parallel_chunks(executor_prepare_call(function), a.size(), [&a, &keep](const ExecutorCaller &call, size_t, size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            keep[i] = call({a[i]}).boolean();
+        }
+    });
+    std::vector<Cell> r;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (keep[i]) {
+            r.push_back(a[i]);
+        }
+    }
+    return Cell(r);
+}
+
+Cell array__parallelMap(Cell &self, Cell &function)
+{
+    std::vector<Cell> a = self.array();
+    if (a.empty()) {
+        return Cell(a);
+    }
+    for (auto &x: a) {
+        check_shareable(x);
+    }
+    std::vector<Cell> r(a.size());
+    parallel_chunks(executor_prepare_call(function), a.size(), [&a, &r](const ExecutorCaller &call, size_t, size_t first, size_t last) {
+        for (size_t i = first; i < last; i++) {
+            r[i] = call({a[i]});
+            check_shareable(r[i]);
+        }
+    });
+    return Cell(r);
+}
+
+Cell array__parallelReduce(Cell &self, Cell &function, Cell &initial)
+{
+    std::vector<Cell> a = self.array();
+    if (a.empty()) {
+        return initial;
+    }
+    for (auto &x: a) {
+        check_shareable(x);
+    }
+    check_shareable(initial);
+    // Each chunk is reduced on its own, starting from its first element,
+    // and then the chunk results are combined in order starting from the
+    // initial value. This gives the same result as a sequential reduction
+    // when the function is associative.
+    auto prepare = executor_prepare_call(function);
+    std::vector<Cell> partial(parallel_chunk_count(a.size()));
+    parallel_chunks(prepare, a.size(), [&a, &partial](const ExecutorCaller &call, size_t chunk, size_t first, size_t last) {
+        Cell acc = a[first];
+        for (size_t i = first + 1; i < last; i++) {
+            acc = call({acc, a[i]});
+        }
+        check_shareable(acc);
+        partial[chunk] = acc;
+    });
+    ExecutorCaller call = prepare();
+    Cell r = initial;
+    for (auto &p: partial) {
+        r = call({r, p});
+    }
+    return r;
+}
+
 Cell array__reversed(Cell &self)
 {
     std::vector<Cell> r;
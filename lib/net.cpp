@@ -1,16 +1,50 @@
+#include <algorithm>
+#include <chrono>
 #include <errno.h>
+#include <fstream>
 #include <iso646.h>
+#include <map>
+#include <set>
 #include <stdio.h>
+#include <string.h>
+#include <thread>
+#ifdef __linux__
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+#ifndef _WIN32
+#include <limits.h>
+#include <sys/uio.h>
+#endif
+
+#include <utf8.h>
 
 #include "cell.h"
+#include "exec.h"
 #include "rtl_exec.h"
 #include "socketx.h"
 
+class PollerObject;
+
 class SocketObject: public Object {
 public:
     SOCKET handle;
+    // Bytes of the current send already sent when it stopped to wait for
+    // room and let another fiber run. The send is made again from the
+    // start once the socket is writable, and carries on from here.
+    uint64_t sent;
+    // Counts the receives and sends that found the socket not ready.
+    // Without epoll, an edge triggered poller reports a socket again only
+    // once one of these has changed.
+    unsigned long reads_blocked;
+    unsigned long writes_blocked;
+    // The pollers the socket has been added to, which drop it when it is
+    // closed, since its handle may then be reused for another socket.
+    std::set<PollerObject *> pollers;
 public:
-    explicit SocketObject(SOCKET handle): handle(handle) {}
+    explicit SocketObject(SOCKET handle): handle(handle), sent(0), reads_blocked(0), writes_blocked(0), pollers() {}
     SocketObject(const SocketObject &) = delete;
     SocketObject &operator=(const SocketObject &) = delete;
     ~SocketObject() {
@@ -30,6 +64,348 @@ static SocketObject *check_socket(const std::shared_ptr<Object> &ps)
     return so;
 }
 
+static int socket_error()
+{
+#ifdef _WIN32
+    return WSAGetLastError();
+#else
+    return errno;
+#endif
+}
+
+static bool would_block(int error)
+{
+#ifdef _WIN32
+    return error == WSAEWOULDBLOCK;
+#else
+    return error == EAGAIN || error == EWOULDBLOCK;
+#endif
+}
+
+// Sending on a connection that the other end has closed raises SIGPIPE,
+// which ends the program, unless the send or the socket asks for EPIPE.
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+// Sends that wait for room do so in wait_socket, even on a blocking
+// socket, so that other fibers can run meanwhile.
+#ifdef MSG_DONTWAIT
+static const int SEND_NOWAIT_FLAGS = SEND_FLAGS | MSG_DONTWAIT;
+#else
+static const int SEND_NOWAIT_FLAGS = SEND_FLAGS;
+#endif
+
+static SOCKET no_sigpipe(SOCKET s)
+{
+#ifdef SO_NOSIGPIPE
+    if (s != INVALID_SOCKET) {
+        int on = 1;
+        setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    }
+#endif
+    return s;
+}
+
+#ifdef __linux__
+// sendfile has no flag like MSG_NOSIGNAL, so SIGPIPE is blocked on this
+// thread while it runs, and one that it raised is taken before unblocking.
+class SigpipeBlocked {
+public:
+    SigpipeBlocked(): set(), old(), pending(false) {
+        sigemptyset(&set);
+        sigaddset(&set, SIGPIPE);
+        sigset_t p;
+        sigpending(&p);
+        pending = sigismember(&p, SIGPIPE) == 1;
+        pthread_sigmask(SIG_BLOCK, &set, &old);
+    }
+    SigpipeBlocked(const SigpipeBlocked &) = delete;
+    SigpipeBlocked &operator=(const SigpipeBlocked &) = delete;
+    ~SigpipeBlocked() {
+        if (not pending) {
+            struct timespec zero = {0, 0};
+            sigtimedwait(&set, nullptr, &zero);
+        }
+        pthread_sigmask(SIG_SETMASK, &old, nullptr);
+    }
+private:
+    sigset_t set;
+    sigset_t old;
+    bool pending;
+};
+#endif
+
+// Waits until a socket has data to receive, or room to send. Another fiber
+// may run meanwhile, in which case the library function is called again
+// from the start, so a send keeps what it has sent in SocketObject::sent.
+static void wait_socket(SOCKET s, bool write)
+{
+    executor_wait_fd(static_cast<int>(s), write);
+    struct pollfd pfd;
+    pfd.fd = s;
+    pfd.events = write ? POLLOUT : POLLIN;
+    pfd.revents = 0;
+    poll(&pfd, 1, -1);
+}
+
+// Accepts a connection, or returns nullptr if a non-blocking socket has
+// none waiting.
+static std::shared_ptr<Object> accept_connection(SocketObject *so)
+{
+    sockaddr_in sin;
+    socklen_t slen = sizeof(sin);
+    SOCKET r;
+    do {
+        r = accept(so->handle, reinterpret_cast<sockaddr *>(&sin), &slen);
+    } while (r == INVALID_SOCKET && socket_error() == EINTR);
+    if (r == INVALID_SOCKET) {
+        int e = socket_error();
+        if (would_block(e)) {
+            so->reads_blocked++;
+            return nullptr;
+        }
+        throw RtlException(rtl::ne_net::Exception_SocketException, utf8string(std::to_string(e)));
+    }
+    return std::make_shared<SocketObject>(no_sigpipe(r));
+}
+
+// Sends all of the data, carrying on after partial writes and waiting for
+// room if the socket is non-blocking. Each part sent is added to so->sent.
+static void send_all(SocketObject *so, const char *data, size_t size)
+{
+    size_t done = 0;
+    while (done < size) {
+        int r = send(so->handle, data + done, static_cast<int>(size - done), SEND_NOWAIT_FLAGS);
+        if (r < 0) {
+            int e = socket_error();
+            if (e == EINTR) {
+                continue;
+            }
+            if (not would_block(e)) {
+                so->sent = 0;
+                throw RtlException(rtl::ne_net::Exception_SocketException, utf8string(std::to_string(e)));
+            }
+            wait_socket(so->handle, true);
+            continue;
+        }
+        done += r;
+        so->sent += r;
+    }
+}
+
+// A socket with a receive buffer. Protocol framing (lines, delimiters and
+// fixed lengths) is found by scanning the buffer here rather than by
+// slicing Bytes values in Neon code. Unread data is buffer[start, end).
+// Nothing is taken from the buffer until a read has all it needs, so a
+// read can be made again from the start after a fiber switch. The buffer
+// grows as a read needs, up to max_buffer bytes.
+class StreamObject: public Object {
+public:
+    StreamObject(const std::shared_ptr<Object> &socket, size_t max_buffer): socket(socket), max_buffer(max_buffer), buffer(std::min<size_t>(65536, max_buffer)), start(0), end(0), eof(false) {}
+    StreamObject(const StreamObject &) = delete;
+    StreamObject &operator=(const StreamObject &) = delete;
+    virtual utf8string toString() const override { return utf8string("<SocketStream>"); }
+    size_t available() const { return end - start; }
+    const unsigned char *data() const { return buffer.data() + start; }
+    std::vector<unsigned char> take(size_t count, size_t skip) {
+        std::vector<unsigned char> r(buffer.begin() + start, buffer.begin() + start + count);
+        start += count + skip;
+        if (start == end) {
+            start = 0;
+            end = 0;
+        }
+        return r;
+    }
+    bool fill();
+    const std::shared_ptr<Object> socket;
+    const size_t max_buffer;
+    std::vector<unsigned char> buffer;
+    size_t start;
+    size_t end;
+    bool eof;
+};
+
+// Wait for and receive more data into the buffer. Returns false at the end of the stream.
+bool StreamObject::fill()
+{
+    if (eof) {
+        return false;
+    }
+    SOCKET s = check_socket(socket)->handle;
+    if (start > 0) {
+        memmove(buffer.data(), buffer.data() + start, end - start);
+        end -= start;
+        start = 0;
+    }
+    if (end == buffer.size()) {
+        if (buffer.size() >= max_buffer) {
+            throw RtlException(rtl::ne_net::Exception_SocketException, utf8string("stream buffer full"));
+        }
+        buffer.resize(std::min(buffer.size() * 2, max_buffer));
+    }
+    executor_wait_fd(static_cast<int>(s), false);
+    for (;;) {
+        int r = recv(s, reinterpret_cast<char *>(buffer.data() + end), static_cast<int>(buffer.size() - end), 0);
+        if (r < 0) {
+            int e = socket_error();
+            if (e == EINTR) {
+                continue;
+            }
+            if (would_block(e)) {
+                wait_socket(s, false);
+                continue;
+            }
+            throw RtlException(rtl::ne_net::Exception_SocketException, utf8string(std::to_string(e)));
+        }
+        if (r == 0) {
+            eof = true;
+            return false;
+        }
+        end += r;
+        return true;
+    }
+}
+
+static StreamObject *check_stream(const std::shared_ptr<Object> &ps)
+{
+    StreamObject *so = dynamic_cast<StreamObject *>(ps.get());
+    if (so == nullptr) {
+        throw RtlException(rtl::ne_net::Exception_SocketException, utf8string("not a stream"));
+    }
+    return so;
+}
+
+// Returns the offset of delimiter in the stream's unread data, reading
+// more until it is found, or SIZE_MAX if the stream ends first.
+static size_t stream_find(StreamObject *st, const unsigned char *delimiter, size_t size)
+{
+    size_t checked = 0;
+    for (;;) {
+        const unsigned char *p = st->data() + checked;
+        const unsigned char *last = st->data() + st->available();
+        while (static_cast<size_t>(last - p) >= size) {
+            p = static_cast<const unsigned char *>(memchr(p, delimiter[0], (last - p) - (size - 1)));
+            if (p == nullptr) {
+                break;
+            }
+            if (memcmp(p, delimiter, size) == 0) {
+                return p - st->data();
+            }
+            p++;
+        }
+        // A delimiter may start in the last few bytes and finish in the next data.
+        checked = st->available() >= size ? st->available() - (size - 1) : 0;
+        if (not st->fill()) {
+            return SIZE_MAX;
+        }
+    }
+}
+
+// Waits for readiness on many sockets at once. On Linux this uses epoll,
+// which costs nothing per idle socket and supports edge triggering.
+// Elsewhere it uses poll, and edge triggered pollers report readiness
+// the same way as level triggered ones.
+class PollerObject: public Object {
+public:
+    explicit PollerObject(bool edge_triggered): edge_triggered(edge_triggered), handle(-1), sockets() {
+#ifdef __linux__
+        handle = epoll_create1(EPOLL_CLOEXEC);
+        if (handle < 0) {
+            throw RtlException(rtl::ne_net::Exception_SocketException, utf8string(std::to_string(errno)));
+        }
+#else
+        handle = 0;
+#endif
+    }
+    PollerObject(const PollerObject &) = delete;
+    PollerObject &operator=(const PollerObject &) = delete;
+    ~PollerObject() {
+        close_poller();
+    }
+    virtual utf8string toString() const override { return utf8string("<Poller>"); }
+    void close_poller() {
+#ifdef __linux__
+        if (handle >= 0) {
+            close(handle);
+        }
+#endif
+        handle = -1;
+        for (auto &s: sockets) {
+            static_cast<SocketObject *>(s.second.socket.get())->pollers.erase(this);
+        }
+        sockets.clear();
+    }
+    const bool edge_triggered;
+    int handle;
+    // A registered socket, kept so that wait can return the same Socket
+    // value, and the events (POLLIN and POLLOUT) wanted from it.
+    struct Registration {
+        std::shared_ptr<Object> socket;
+        short events;
+        // Without epoll, the events an edge triggered poller has reported
+        // and the socket's blocked counts when it last checked them.
+        short reported;
+        unsigned long reads_blocked;
+        unsigned long writes_blocked;
+    };
+    std::map<SOCKET, Registration> sockets;
+};
+
+static PollerObject *check_poller(const std::shared_ptr<Object> &pp)
+{
+    PollerObject *po = dynamic_cast<PollerObject *>(pp.get());
+    if (po == nullptr || po->handle < 0) {
+        throw RtlException(rtl::ne_net::Exception_SocketException, utf8string("not a poller"));
+    }
+    return po;
+}
+
+static short poll_events(bool read, bool write)
+{
+    return static_cast<short>((read ? POLLIN : 0) | (write ? POLLOUT : 0));
+}
+
+// Removes a socket from a poller that is no longer to report it.
+static void poller_forget(PollerObject *p, SOCKET s)
+{
+    auto i = p->sockets.find(s);
+    if (i == p->sockets.end()) {
+        return;
+    }
+#ifdef __linux__
+    // Fails if the socket is already closed, which removes it anyway.
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    epoll_ctl(p->handle, EPOLL_CTL_DEL, s, &ev);
+#endif
+    static_cast<SocketObject *>(i->second.socket.get())->pollers.erase(p);
+    p->sockets.erase(i);
+}
+
+#ifdef __linux__
+static void poller_control(PollerObject *p, int op, SOCKET s, short events)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    if (events & POLLIN) {
+        ev.events |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (events & POLLOUT) {
+        ev.events |= EPOLLOUT;
+    }
+    if (p->edge_triggered) {
+        ev.events |= EPOLLET;
+    }
+    ev.data.fd = s;
+    if (epoll_ctl(p->handle, op, s, &ev) != 0) {
+        throw RtlException(rtl::ne_net::Exception_SocketException, utf8string(std::to_string(errno)));
+    }
+}
+#endif
+
 namespace rtl {
 
 namespace ne_net {
@@ -40,19 +416,301 @@ void initWinsock()
     static bool initialized = false;
     if (!initialized) {
         WSADATA wsa;
-        WSAStartup(MAKEWORD(1, 1), &wsa);
+        WSAStartup(MAKEWORD(2, 2), &wsa);
         initialized = true;
     }
 }
 #endif
 
+void poller_add(const std::shared_ptr<Object> &poller, const std::shared_ptr<Object> &socket, bool read, bool write)
+{
+    PollerObject *p = check_poller(poller);
+    SocketObject *so = check_socket(socket);
+    SOCKET s = so->handle;
+    short events = poll_events(read, write);
+#ifdef __linux__
+    poller_control(p, EPOLL_CTL_ADD, s, events);
+#endif
+    p->sockets[s] = PollerObject::Registration {socket, events, 0, 0, 0};
+    so->pollers.insert(p);
+}
+
+void poller_close(const std::shared_ptr<Object> &poller)
+{
+    check_poller(poller)->close_poller();
+}
+
+std::shared_ptr<Object> poller_make(bool edge_triggered)
+{
+    return std::make_shared<PollerObject>(edge_triggered);
+}
+
+void poller_modify(const std::shared_ptr<Object> &poller, const std::shared_ptr<Object> &socket, bool read, bool write)
+{
+    PollerObject *p = check_poller(poller);
+    SOCKET s = check_socket(socket)->handle;
+    auto i = p->sockets.find(s);
+    if (i == p->sockets.end() || i->second.socket != socket) {
+        throw RtlException(Exception_SocketException, utf8string("socket not added to poller"));
+    }
+    short events = poll_events(read, write);
+#ifdef __linux__
+    poller_control(p, EPOLL_CTL_MOD, s, events);
+#endif
+    i->second.events = events;
+    i->second.reported = 0;
+}
+
+void poller_remove(const std::shared_ptr<Object> &poller, const std::shared_ptr<Object> &socket)
+{
+    PollerObject *p = check_poller(poller);
+    SOCKET s = check_socket(socket)->handle;
+    auto i = p->sockets.find(s);
+    if (i == p->sockets.end() || i->second.socket != socket) {
+        throw RtlException(Exception_SocketException, utf8string("socket not added to poller"));
+    }
+    poller_forget(p, s);
+}
+
+void poller_wait(const std::shared_ptr<Object> &poller, Number timeout_seconds, Cell *events)
+{
+    PollerObject *p = check_poller(poller);
+    int timeout = number_is_negative(timeout_seconds) ? -1 : number_to_sint32(number_multiply(timeout_seconds, number_from_uint32(1000)));
+    std::vector<Cell> &r = events->array_for_write();
+    r.clear();
+    auto add_event = [&r](const std::shared_ptr<Object> &socket, bool readable, bool writable, bool hangup) {
+        // The fields here must match the declaration of PollEvent in net.neon.
+        std::vector<Cell> event;
+        event.push_back(Cell(std::vector<Cell> {Cell(socket)}));
+        event.push_back(Cell(readable));
+        event.push_back(Cell(writable));
+        event.push_back(Cell(hangup));
+        r.push_back(Cell(event));
+    };
+#ifdef __linux__
+    std::vector<struct epoll_event> ready(std::max<size_t>(1, std::min<size_t>(p->sockets.size(), 1024)));
+    int n;
+    do {
+        n = epoll_wait(p->handle, ready.data(), static_cast<int>(ready.size()), timeout);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        throw RtlException(Exception_SocketException, utf8string(std::to_string(errno)));
+    }
+    for (int i = 0; i < n; i++) {
+        auto s = p->sockets.find(ready[i].data.fd);
+        if (s == p->sockets.end()) {
+            continue;
+        }
+        uint32_t e = ready[i].events;
+        add_event(s->second.socket, (e & EPOLLIN) != 0, (e & EPOLLOUT) != 0, (e & (EPOLLHUP | EPOLLRDHUP | EPOLLERR)) != 0);
+        // A socket that has failed or is closed both ways would be
+        // reported again on every wait, so it is reported just this once.
+        if (e & (EPOLLHUP | EPOLLERR)) {
+            poller_forget(p, ready[i].data.fd);
+        }
+    }
+#else
+    std::vector<struct pollfd> fds;
+    std::vector<PollerObject::Registration *> sockets;
+    for (auto &s: p->sockets) {
+        PollerObject::Registration &g = s.second;
+        short events = g.events;
+        if (p->edge_triggered) {
+            // Leave out what was reported already, until a receive or send
+            // has found the socket not ready since.
+            SocketObject *so = static_cast<SocketObject *>(g.socket.get());
+            if (so->reads_blocked != g.reads_blocked) {
+                g.reported &= ~POLLIN;
+            }
+            if (so->writes_blocked != g.writes_blocked) {
+                g.reported &= ~POLLOUT;
+            }
+            g.reads_blocked = so->reads_blocked;
+            g.writes_blocked = so->writes_blocked;
+            events &= ~g.reported;
+            if (events == 0) {
+                continue;
+            }
+        }
+        struct pollfd pfd;
+        pfd.fd = s.first;
+        pfd.events = events;
+        pfd.revents = 0;
+        fds.push_back(pfd);
+        sockets.push_back(&g);
+    }
+    if (fds.empty()) {
+        // Nothing to wait for, but the caller still expects the timeout.
+        if (timeout > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+        }
+        return;
+    }
+    int n = poll(fds.data(), static_cast<unsigned int>(fds.size()), timeout);
+    if (n < 0) {
+        if (socket_error() == EINTR) {
+            return;
+        }
+        throw RtlException(Exception_SocketException, utf8string(std::to_string(socket_error())));
+    }
+    for (size_t i = 0; i < fds.size() && n > 0; i++) {
+        short e = fds[i].revents;
+        if (e != 0) {
+            add_event(sockets[i]->socket, (e & POLLIN) != 0, (e & POLLOUT) != 0, (e & (POLLHUP | POLLERR)) != 0);
+            sockets[i]->reported |= e & (POLLIN | POLLOUT);
+            if (e & (POLLHUP | POLLERR)) {
+                poller_forget(p, fds[i].fd);
+            }
+            n--;
+        }
+    }
+#endif
+}
+
+std::shared_ptr<Object> stream_make(const std::shared_ptr<Object> &socket, Number max_buffer)
+{
+    check_socket(socket);
+    if (not number_is_integer(max_buffer) || number_is_negative(max_buffer) || number_is_zero(max_buffer)) {
+        throw RtlException(Exception_SocketException, utf8string("invalid buffer size"));
+    }
+    return std::make_shared<StreamObject>(socket, static_cast<size_t>(std::min<uint64_t>(number_to_uint64(max_buffer), SIZE_MAX)));
+}
+
+std::vector<unsigned char> stream_readAll(const std::shared_ptr<Object> &stream)
+{
+    StreamObject *st = check_stream(stream);
+    while (st->fill()) {
+    }
+    return st->take(st->available(), 0);
+}
+
+bool stream_readExactly(const std::shared_ptr<Object> &stream, Number count, std::vector<unsigned char> *data)
+{
+    StreamObject *st = check_stream(stream);
+    if (not number_is_integer(count) || number_is_negative(count)) {
+        throw RtlException(Exception_SocketException, utf8string("invalid count"));
+    }
+    size_t n = number_to_uint64(count);
+    while (st->available() < n) {
+        if (not st->fill()) {
+            *data = st->take(st->available(), 0);
+            return false;
+        }
+    }
+    *data = st->take(n, 0);
+    return true;
+}
+
+bool stream_readLine(const std::shared_ptr<Object> &stream, utf8string *line)
+{
+    StreamObject *st = check_stream(stream);
+    const unsigned char newline = '\n';
+    size_t n = stream_find(st, &newline, 1);
+    bool found = n != SIZE_MAX;
+    if (not found) {
+        if (st->available() == 0) {
+            *line = utf8string();
+            return false;
+        }
+        // The last line need not end with a newline.
+        n = st->available();
+    }
+    size_t length = n > 0 && st->data()[n-1] == '\r' ? n - 1 : n;
+    std::vector<unsigned char> r = st->take(length, (n - length) + (found ? 1 : 0));
+    auto inv = utf8::find_invalid(r.begin(), r.end());
+    if (inv != r.end()) {
+        throw RtlException(rtl::ne_global::Exception_Utf8DecodingException, utf8string(std::to_string(std::distance(r.begin(), inv))));
+    }
+    *line = utf8string(std::string(r.begin(), r.end()));
+    return true;
+}
+
+bool stream_readUntil(const std::shared_ptr<Object> &stream, const std::vector<unsigned char> &delimiter, std::vector<unsigned char> *data)
+{
+    StreamObject *st = check_stream(stream);
+    if (delimiter.empty()) {
+        throw RtlException(Exception_SocketException, utf8string("empty delimiter"));
+    }
+    size_t n = stream_find(st, delimiter.data(), delimiter.size());
+    if (n == SIZE_MAX) {
+        *data = st->take(st->available(), 0);
+        return false;
+    }
+    *data = st->take(n, delimiter.size());
+    return true;
+}
+
+void stream_write(const std::shared_ptr<Object> &stream, Cell &data)
+{
+    StreamObject *st = check_stream(stream);
+    SocketObject *so = check_socket(st->socket);
+    const std::vector<Cell> &a = data.array();
+    executor_wait_fd(static_cast<int>(so->handle), true);
+#ifdef _WIN32
+    std::vector<unsigned char> all;
+    for (auto &b: a) {
+        const std::vector<unsigned char> &bytes = const_cast<Cell &>(b).bytes();
+        all.insert(all.end(), bytes.begin(), bytes.end());
+    }
+    send_all(so, reinterpret_cast<const char *>(all.data()) + so->sent, static_cast<size_t>(all.size() - so->sent));
+#else
+    // Send all the values with as few system calls as possible, carrying
+    // on from wherever a partial write, or an earlier call that stopped to
+    // let another fiber run, left off.
+    std::vector<struct iovec> iov;
+    for (auto &b: a) {
+        const std::vector<unsigned char> &bytes = const_cast<Cell &>(b).bytes();
+        if (not bytes.empty()) {
+            struct iovec v;
+            v.iov_base = const_cast<unsigned char *>(bytes.data());
+            v.iov_len = bytes.size();
+            iov.push_back(v);
+        }
+    }
+    size_t i = 0;
+    auto skip = [&iov, &i](uint64_t n) {
+        while (i < iov.size() && n >= iov[i].iov_len) {
+            n -= iov[i].iov_len;
+            i++;
+        }
+        if (n > 0) {
+            iov[i].iov_base = static_cast<char *>(iov[i].iov_base) + n;
+            iov[i].iov_len -= n;
+        }
+    };
+    skip(so->sent);
+    while (i < iov.size()) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov.data() + i;
+        msg.msg_iovlen = std::min<size_t>(iov.size() - i, IOV_MAX);
+        ssize_t r = sendmsg(so->handle, &msg, SEND_NOWAIT_FLAGS);
+        if (r < 0) {
+            int e = errno;
+            if (e == EINTR) {
+                continue;
+            }
+            if (not would_block(e)) {
+                so->sent = 0;
+                throw RtlException(Exception_SocketException, utf8string(std::to_string(e)));
+            }
+            wait_socket(so->handle, true);
+            continue;
+        }
+        so->sent += r;
+        skip(r);
+    }
+#endif
+    so->sent = 0;
+}
+
 std::shared_ptr<Object> socket_tcpSocket()
 {
 #ifdef _WIN32
     initWinsock();
 #endif
     SOCKET s = socket(AF_INET, SOCK_STREAM, 0);
-    return std::make_shared<SocketObject>(s);
+    return std::make_shared<SocketObject>(no_sigpipe(s));
 }
 
 std::shared_ptr<Object> socket_udpSocket()
@@ -61,20 +719,25 @@ std::shared_ptr<Object> socket_udpSocket()
     initWinsock();
 #endif
     SOCKET s = socket(AF_INET, SOCK_DGRAM, 0);
-    return std::make_shared<SocketObject>(s);
+    return std::make_shared<SocketObject>(no_sigpipe(s));
 }
 
 std::shared_ptr<Object> socket_accept(const std::shared_ptr<Object> &socket)
 {
-    SOCKET s = check_socket(socket)->handle;
-    sockaddr_in sin;
-    socklen_t slen = sizeof(sin);
-    SOCKET r = accept(s, reinterpret_cast<sockaddr *>(&sin), &slen);
-    if (r < 0) {
-        perror("accept");
-        return nullptr;
+    SocketObject *so = check_socket(socket);
+    for (;;) {
+        wait_socket(so->handle, false);
+        // Another fiber or process may have taken the connection first.
+        std::shared_ptr<Object> r = accept_connection(so);
+        if (r != nullptr) {
+            return r;
+        }
     }
-    return std::make_shared<SocketObject>(r);
+}
+
+std::shared_ptr<Object> socket_acceptSome(const std::shared_ptr<Object> &socket)
+{
+    return accept_connection(check_socket(socket));
 }
 
 void socket_bind(const std::shared_ptr<Object> &socket, const utf8string &address, Number port)
@@ -107,6 +770,9 @@ void socket_bind(const std::shared_ptr<Object> &socket, const utf8string &addres
 void socket_close(const std::shared_ptr<Object> &socket)
 {
     SocketObject *s = check_socket(socket);
+    for (auto p: std::set<PollerObject *>(s->pollers)) {
+        poller_forget(p, s->handle);
+    }
     closesocket(s->handle);
     s->handle = -1;
 }
@@ -149,7 +815,7 @@ void socket_listen(const std::shared_ptr<Object> &socket, Number port)
         perror("bind");
         return;
     }
-    r = listen(s, 5);
+    r = listen(s, SOMAXCONN);
     if (r < 0) {
         perror("listen");
         return;
@@ -159,6 +825,7 @@ void socket_listen(const std::shared_ptr<Object> &socket, Number port)
 bool socket_recv(const std::shared_ptr<Object> &socket, Number count, std::vector<unsigned char> *buffer)
 {
     SOCKET s = check_socket(socket)->handle;
+    executor_wait_fd(static_cast<int>(s), false);
     int n = number_to_sint32(count);
     buffer->resize(n);
     int r = recv(s, reinterpret_cast<char *>(const_cast<unsigned char *>(buffer->data())), n, 0);
@@ -178,6 +845,7 @@ bool socket_recv(const std::shared_ptr<Object> &socket, Number count, std::vecto
 bool socket_recvfrom(const std::shared_ptr<Object> &socket, Number count, utf8string *remote_address, Number *remote_port, std::vector<unsigned char> *buffer)
 {
     SOCKET s = check_socket(socket)->handle;
+    executor_wait_fd(static_cast<int>(s), false);
     int n = number_to_sint32(count);
     buffer->resize(n);
     struct sockaddr_in sin;
@@ -199,9 +867,152 @@ bool socket_recvfrom(const std::shared_ptr<Object> &socket, Number count, utf8st
 }
 
 void socket_send(const std::shared_ptr<Object> &socket, const std::vector<unsigned char> &data)
+{
+    SocketObject *so = check_socket(socket);
+    executor_wait_fd(static_cast<int>(so->handle), true);
+    send_all(so, reinterpret_cast<const char *>(data.data()) + so->sent, static_cast<size_t>(data.size() - so->sent));
+    so->sent = 0;
+}
+
+Number socket_sendFile(const std::shared_ptr<Object> &socket, const utf8string &path, Number offset, Number count)
+{
+    SocketObject *so = check_socket(socket);
+    SOCKET s = so->handle;
+    if (not number_is_integer(offset) || number_is_negative(offset) || not number_is_integer(count)) {
+        throw RtlException(Exception_SocketException, utf8string("invalid file range"));
+    }
+    const uint64_t start = number_to_uint64(offset);
+    uint64_t remaining = number_is_negative(count) ? UINT64_MAX : number_to_uint64(count);
+    executor_wait_fd(static_cast<int>(s), true);
+    // Carry on after whatever an earlier call that let another fiber run sent.
+    remaining -= std::min(remaining, so->sent);
+#ifdef __linux__
+    // The kernel copies straight from the page cache to the socket.
+    bool copy = false;
+    while (remaining > 0) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            so->sent = 0;
+            throw RtlException(Exception_SocketException, utf8string(path.str() + ": " + strerror(errno)));
+        }
+        off_t pos = static_cast<off_t>(start + so->sent);
+        int error = 0;
+        {
+            SigpipeBlocked blocked;
+            while (remaining > 0) {
+                ssize_t r = sendfile(s, fd, &pos, static_cast<size_t>(std::min<uint64_t>(remaining, 0x40000000)));
+                if (r < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    error = errno;
+                    break;
+                }
+                if (r == 0) {
+                    remaining = 0;
+                    break;
+                }
+                so->sent += r;
+                remaining -= r;
+            }
+        }
+        close(fd);
+        if (error == 0) {
+            break;
+        }
+        if (would_block(error)) {
+            wait_socket(s, true);
+            continue;
+        }
+        // Some files (and older kernels) cannot be sent this way.
+        if ((error == EINVAL || error == ENOSYS) && so->sent == 0) {
+            copy = true;
+            break;
+        }
+        so->sent = 0;
+        throw RtlException(Exception_SocketException, utf8string(std::to_string(error)));
+    }
+    if (not copy) {
+        Number r = number_from_uint64(so->sent);
+        so->sent = 0;
+        return r;
+    }
+#endif
+    std::ifstream f(path.str(), std::ios::binary);
+    if (not f) {
+        so->sent = 0;
+        throw RtlException(Exception_SocketException, utf8string(path.str() + ": " + strerror(errno)));
+    }
+    f.seekg(static_cast<std::streamoff>(start + so->sent));
+    std::vector<char> buf(65536);
+    while (remaining > 0 && f) {
+        f.read(buf.data(), static_cast<std::streamsize>(std::min<uint64_t>(remaining, buf.size())));
+        size_t n = static_cast<size_t>(f.gcount());
+        if (n == 0) {
+            break;
+        }
+        remaining -= n;
+        send_all(so, buf.data(), n);
+    }
+    Number r = number_from_uint64(so->sent);
+    so->sent = 0;
+    return r;
+}
+
+Number socket_sendSome(const std::shared_ptr<Object> &socket, const std::vector<unsigned char> &data)
+{
+    SocketObject *so = check_socket(socket);
+    int r;
+    do {
+        r = send(so->handle, reinterpret_cast<const char *>(data.data()), static_cast<int>(data.size()), SEND_FLAGS);
+    } while (r < 0 && socket_error() == EINTR);
+    if (r < 0) {
+        int e = socket_error();
+        if (would_block(e)) {
+            so->writes_blocked++;
+            return number_from_uint32(0);
+        }
+        throw RtlException(Exception_SocketException, utf8string(std::to_string(e)));
+    }
+    return number_from_uint32(r);
+}
+
+bool socket_recvSome(const std::shared_ptr<Object> &socket, Number count, std::vector<unsigned char> *buffer)
+{
+    SocketObject *so = check_socket(socket);
+    int n = number_to_sint32(count);
+    buffer->resize(n);
+    int r;
+    do {
+        r = recv(so->handle, reinterpret_cast<char *>(buffer->data()), n, 0);
+    } while (r < 0 && socket_error() == EINTR);
+    if (r < 0) {
+        int e = socket_error();
+        buffer->clear();
+        if (would_block(e)) {
+            so->reads_blocked++;
+            return true;
+        }
+        throw RtlException(Exception_SocketException, utf8string(std::to_string(e)));
+    }
+    buffer->resize(r);
+    return r > 0;
+}
+
+void socket_setNonBlocking(const std::shared_ptr<Object> &socket, bool nonblocking)
 {
     SOCKET s = check_socket(socket)->handle;
-    send(s, reinterpret_cast<const char *>(data.data()), static_cast<int>(data.size()), 0);
+#ifdef _WIN32
+    u_long mode = nonblocking ? 1 : 0;
+    if (ioctlsocket(s, FIONBIO, &mode) != 0) {
+        throw RtlException(Exception_SocketException, utf8string(std::to_string(socket_error())));
+    }
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    if (flags < 0 || fcntl(s, F_SETFL, nonblocking ? flags | O_NONBLOCK : flags & ~O_NONBLOCK) < 0) {
+        throw RtlException(Exception_SocketException, utf8string(std::to_string(errno)));
+    }
+#endif
 }
 
 bool socket_select(Cell *read, Cell *write, Cell *error, Number timeout_seconds)
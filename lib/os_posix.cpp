@@ -1,5 +1,6 @@
 #include <algorithm>
 #include <errno.h>
+#include <mutex>
 #include <signal.h>
 #include <stdlib.h>
 #include <string>
@@ -29,10 +30,14 @@ static ProcessObject *check_process(const std::shared_ptr<Object> &pp)
     return po;
 }
 
+// Child processes belong to the process as a whole, whichever executor
+// started them.
 static std::vector<std::shared_ptr<ProcessObject>> g_children;
+static std::mutex g_children_mutex;
 
 void closer()
 {
+    std::lock_guard<std::mutex> lock(g_children_mutex);
     for (auto p: g_children) {
         kill(-p->pid, 9);
     }
@@ -66,6 +71,7 @@ void kill(const std::shared_ptr<Object> &process)
     ProcessObject *p = check_process(process);
     ::kill(-p->pid, SIGTERM);
     p->pid = 0;
+    std::lock_guard<std::mutex> lock(g_children_mutex);
     for (auto pi = g_children.begin(); pi != g_children.end(); ++pi) {
         if (pi->get() == p) {
             g_children.erase(pi);
@@ -77,11 +83,8 @@ void kill(const std::shared_ptr<Object> &process)
 
 std::shared_ptr<Object> spawn(const utf8string &command)
 {
-    static bool init_closer = false;
-    if (not init_closer) {
-        atexit(closer);
-        init_closer = true;
-    }
+    static std::once_flag init_closer;
+    std::call_once(init_closer, [] { atexit(closer); });
 
     pid_t pid = ::fork();
     if (pid == 0) {
@@ -94,6 +97,7 @@ std::shared_ptr<Object> spawn(const utf8string &command)
         _exit(127);
     }
     std::shared_ptr<ProcessObject> p = std::shared_ptr<ProcessObject> { new ProcessObject(pid) };
+    std::lock_guard<std::mutex> lock(g_children_mutex);
     g_children.push_back(p);
     return p;
 }
@@ -115,6 +119,7 @@ Number wait(const std::shared_ptr<Object> &process)
         ProcessObject *p = check_process(process);
         waitpid(p->pid, &r, 0);
         p->pid = 0;
+        std::lock_guard<std::mutex> lock(g_children_mutex);
         for (auto pi = g_children.begin(); pi != g_children.end(); ++pi) {
             if (pi->get() == p) {
                 g_children.erase(pi);
@@ -0,0 +1,309 @@
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iso646.h>
+#include <mutex>
+#include <thread>
+
+#include "cell.h"
+#include "exec.h"
+#include "rtl_exec.h"
+
+class ChannelObject: public Object {
+public:
+    explicit ChannelObject(size_t capacity): mutex(), changed(), values(), capacity(capacity), closed(false) {}
+    ChannelObject(const ChannelObject &) = delete;
+    ChannelObject &operator=(const ChannelObject &) = delete;
+    virtual utf8string toString() const override { return utf8string("<Channel>"); }
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::shared_ptr<Object>> values;
+    const size_t capacity;
+    bool closed;
+};
+
+class TaskObject: public Object {
+public:
+    TaskObject(): mutex(), changed(), done(false), failed(false), result() {}
+    TaskObject(const TaskObject &) = delete;
+    TaskObject &operator=(const TaskObject &) = delete;
+    virtual utf8string toString() const override { return utf8string("<Task>"); }
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool done;
+    bool failed;
+    std::shared_ptr<Object> result;
+};
+
+// Worker threads that run one task per processor at a time. A task that
+// waits for a channel or another task does not count, and another worker
+// is started in its place if there is work queued, since the task being
+// waited for may be the one in the queue. Workers beyond the limit finish
+// once the tasks they were waiting for have let them go on. The pool is
+// never destroyed: a program may finish while tasks are still running, and
+// joining them at exit would wait for them.
+class ThreadPool {
+public:
+    static ThreadPool &get() {
+        static ThreadPool *pool = new ThreadPool();
+        return *pool;
+    }
+    void submit(std::function<void()> work) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(work);
+            grow();
+        }
+        available.notify_one();
+    }
+
+    // Marks the worker running on this thread, if it is one, as waiting
+    // for as long as the object exists.
+    class Blocked {
+    public:
+        Blocked(): pool(t_worker ? &ThreadPool::get() : nullptr) {
+            if (pool != nullptr) {
+                std::lock_guard<std::mutex> lock(pool->mutex);
+                pool->blocked++;
+                pool->grow();
+            }
+        }
+        Blocked(const Blocked &) = delete;
+        Blocked &operator=(const Blocked &) = delete;
+        ~Blocked() {
+            if (pool != nullptr) {
+                std::lock_guard<std::mutex> lock(pool->mutex);
+                pool->blocked--;
+            }
+        }
+    private:
+        ThreadPool *pool;
+    };
+
+private:
+    ThreadPool(): mutex(), available(), queue(), limit(std::thread::hardware_concurrency()), workers(0), idle(0), blocked(0) {
+        if (limit == 0) {
+            limit = 1;
+        }
+    }
+    // Called with the mutex held.
+    void grow() {
+        if (queue.size() > idle && workers - blocked < limit) {
+            workers++;
+            std::thread(&ThreadPool::worker, this).detach();
+        }
+    }
+    void worker() {
+        t_worker = true;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            idle++;
+            available.wait(lock, [this] { return not queue.empty(); });
+            idle--;
+            std::function<void()> work = queue.front();
+            queue.pop_front();
+            lock.unlock();
+            work();
+            work = nullptr;
+            lock.lock();
+            if (workers - blocked > limit) {
+                workers--;
+                return;
+            }
+        }
+    }
+    static thread_local bool t_worker;
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<std::function<void()>> queue;
+    size_t limit;
+    size_t workers;
+    size_t idle;
+    size_t blocked;
+};
+
+thread_local bool ThreadPool::t_worker = false;
+
+// Waits on a channel's or task's condition until ready() holds.
+template <typename Ready> static void wait_until(std::unique_lock<std::mutex> &lock, std::condition_variable &changed, Ready ready)
+{
+    if (not ready()) {
+        ThreadPool::Blocked blocked;
+        changed.wait(lock, ready);
+    }
+}
+
+static ChannelObject *check_channel(const std::shared_ptr<Object> &pc)
+{
+    ChannelObject *co = dynamic_cast<ChannelObject *>(pc.get());
+    if (co == nullptr) {
+        throw RtlException(rtl::ne_parallel::Exception_ParallelException, utf8string("not a channel"));
+    }
+    return co;
+}
+
+static TaskObject *check_task(const std::shared_ptr<Object> &pt)
+{
+    TaskObject *to = dynamic_cast<TaskObject *>(pt.get());
+    if (to == nullptr) {
+        throw RtlException(rtl::ne_parallel::Exception_ParallelException, utf8string("not a task"));
+    }
+    return to;
+}
+
+// Objects are shared between threads, not copied. Values cannot change and
+// channels and tasks lock themselves, but the objects that hold files,
+// sockets and the like have no locking, so they are refused.
+static void check_shareable(const std::shared_ptr<Object> &p)
+{
+    if (p == nullptr
+     || dynamic_cast<const ObjectBoolean *>(p.get()) != nullptr
+     || dynamic_cast<const ObjectNumber *>(p.get()) != nullptr
+     || dynamic_cast<const ObjectString *>(p.get()) != nullptr
+     || dynamic_cast<const ObjectBytes *>(p.get()) != nullptr
+     || dynamic_cast<const ChannelObject *>(p.get()) != nullptr
+     || dynamic_cast<const TaskObject *>(p.get()) != nullptr) {
+        return;
+    }
+    if (dynamic_cast<const ObjectArray *>(p.get()) != nullptr) {
+        std::vector<std::shared_ptr<Object>> a;
+        p->getArray(a);
+        for (auto &x: a) {
+            check_shareable(x);
+        }
+        return;
+    }
+    if (dynamic_cast<const ObjectDictionary *>(p.get()) != nullptr) {
+        std::map<utf8string, std::shared_ptr<Object>> d;
+        p->getDictionary(d);
+        for (auto &x: d) {
+            check_shareable(x.second);
+        }
+        return;
+    }
+    throw RtlException(rtl::ne_global::Exception_InvalidValueException, utf8string("native object cannot be passed to another thread"));
+}
+
+namespace rtl {
+
+namespace ne_parallel {
+
+void channel_check(const std::shared_ptr<Object> &channel)
+{
+    check_channel(channel);
+}
+
+void channel_close(const std::shared_ptr<Object> &channel)
+{
+    ChannelObject *c = check_channel(channel);
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        c->closed = true;
+    }
+    c->changed.notify_all();
+    executor_notify();
+}
+
+std::shared_ptr<Object> channel_make(Number capacity)
+{
+    if (not number_is_integer(capacity) || number_is_negative(capacity) || number_is_zero(capacity)) {
+        throw RtlException(Exception_ParallelException, utf8string("capacity must be a positive integer"));
+    }
+    return std::make_shared<ChannelObject>(number_to_uint64(capacity));
+}
+
+std::shared_ptr<Object> channel_receive(const std::shared_ptr<Object> &channel)
+{
+    ChannelObject *c = check_channel(channel);
+    std::shared_ptr<Object> keep = channel;
+    executor_wait_for([c, keep] {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        return not c->values.empty() || c->closed;
+    });
+    std::unique_lock<std::mutex> lock(c->mutex);
+    wait_until(lock, c->changed, [c] { return not c->values.empty() || c->closed; });
+    if (c->values.empty()) {
+        throw RtlException(Exception_ParallelException_ChannelClosed, utf8string(""));
+    }
+    std::shared_ptr<Object> r = c->values.front();
+    c->values.pop_front();
+    lock.unlock();
+    c->changed.notify_all();
+    executor_notify();
+    return r;
+}
+
+void channel_send(const std::shared_ptr<Object> &channel, const std::shared_ptr<Object> &value)
+{
+    ChannelObject *c = check_channel(channel);
+    check_shareable(value);
+    std::shared_ptr<Object> keep = channel;
+    executor_wait_for([c, keep] {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        return c->values.size() < c->capacity || c->closed;
+    });
+    std::unique_lock<std::mutex> lock(c->mutex);
+    wait_until(lock, c->changed, [c] { return c->values.size() < c->capacity || c->closed; });
+    if (c->closed) {
+        throw RtlException(Exception_ParallelException_ChannelClosed, utf8string(""));
+    }
+    c->values.push_back(value);
+    lock.unlock();
+    c->changed.notify_all();
+    executor_notify();
+}
+
+bool task_isDone(const std::shared_ptr<Object> &task)
+{
+    TaskObject *t = check_task(task);
+    std::lock_guard<std::mutex> lock(t->mutex);
+    return t->done;
+}
+
+std::shared_ptr<Object> task_spawn(const utf8string &function, const std::shared_ptr<Object> &arg)
+{
+    check_shareable(arg);
+    ExecutorTask call = executor_prepare_task(function.str());
+    auto task = std::make_shared<TaskObject>();
+    ThreadPool::get().submit([call, arg, task] {
+        std::shared_ptr<Object> result;
+        bool ok = call(arg, result);
+        if (ok) {
+            try {
+                check_shareable(result);
+            } catch (RtlException &) {
+                ok = false;
+                result = nullptr;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(task->mutex);
+            task->done = true;
+            task->failed = not ok;
+            task->result = result;
+        }
+        task->changed.notify_all();
+        executor_notify();
+    });
+    return task;
+}
+
+std::shared_ptr<Object> task_wait(const std::shared_ptr<Object> &task)
+{
+    TaskObject *t = check_task(task);
+    std::shared_ptr<Object> keep = task;
+    executor_wait_for([t, keep] {
+        std::lock_guard<std::mutex> lock(t->mutex);
+        return t->done;
+    });
+    std::unique_lock<std::mutex> lock(t->mutex);
+    wait_until(lock, t->changed, [t] { return t->done; });
+    if (t->failed) {
+        throw RtlException(Exception_ParallelException_TaskFailed, utf8string(""));
+    }
+    return t->result;
+}
+
+} // namespace ne_parallel
+
+} // namespace rtl
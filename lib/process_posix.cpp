@@ -4,25 +4,31 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include "exec.h"
 #include "rtl_exec.h"
 
-namespace rtl {
+namespace {
 
-namespace ne_process {
+struct CallResult {
+    CallResult(): status(), out(), err() {}
+    Number status;
+    std::vector<unsigned char> out;
+    std::vector<unsigned char> err;
+};
 
-Number call(const utf8string &command, std::vector<unsigned char> *out, std::vector<unsigned char> *err)
+Number run_process(const utf8string &command, std::vector<unsigned char> *out, std::vector<unsigned char> *err)
 {
     int pout[2];
     int perr[2];
     if (pipe(pout) != 0) {
-        throw RtlException(Exception_ProcessException, utf8string(std::to_string(errno)));
+        throw RtlException(rtl::ne_process::Exception_ProcessException, utf8string(std::to_string(errno)));
     }
     if (pipe(perr) != 0) {
-        throw RtlException(Exception_ProcessException, utf8string(std::to_string(errno)));
+        throw RtlException(rtl::ne_process::Exception_ProcessException, utf8string(std::to_string(errno)));
     }
     pid_t child = fork();
     if (child < 0) {
-        throw RtlException(Exception_ProcessException, utf8string(std::to_string(errno)));
+        throw RtlException(rtl::ne_process::Exception_ProcessException, utf8string(std::to_string(errno)));
     }
     if (child == 0) {
         close(pout[0]);
@@ -61,7 +67,7 @@ Number call(const utf8string &command, std::vector<unsigned char> *out, std::vec
         tv.tv_usec = 0;
         int r = select(nfds, &fds, NULL, NULL, &tv);
         if (r < 0) {
-            throw RtlException(Exception_ProcessException, utf8string(std::to_string(errno)));
+            throw RtlException(rtl::ne_process::Exception_ProcessException, utf8string(std::to_string(errno)));
         }
         if (pout[0] >= 0 && FD_ISSET(pout[0], &fds)) {
             char buf[1024];
@@ -94,11 +100,31 @@ Number call(const utf8string &command, std::vector<unsigned char> *out, std::vec
             return number_from_sint32(-WTERMSIG(stat));
         }
     } else if (r < 0) {
-        throw RtlException(Exception_ProcessException, utf8string(std::to_string(errno)));
+        throw RtlException(rtl::ne_process::Exception_ProcessException, utf8string(std::to_string(errno)));
     }
     return number_from_sint32(-1);
 }
 
+} // namespace
+
+namespace rtl {
+
+namespace ne_process {
+
+Number call(const utf8string &command, std::vector<unsigned char> *out, std::vector<unsigned char> *err)
+{
+    // The process runs on another thread so that other fibers can run
+    // while it does.
+    std::shared_ptr<CallResult> r = std::static_pointer_cast<CallResult>(executor_run_blocking([command] {
+        auto r = std::make_shared<CallResult>();
+        r->status = run_process(command, &r->out, &r->err);
+        return r;
+    }));
+    *out = r->out;
+    *err = r->err;
+    return r->status;
+}
+
 } // namespace ne_process
 
 } // namespace rtl
@@ -2,8 +2,9 @@
 
 #include <random>
 
-static std::random_device g_rd;
-static std::mt19937 g_gen(g_rd());
+// Each thread has its own generator so executors on different threads
+// do not share (and race on) its state.
+static thread_local std::mt19937 g_gen(std::random_device{}());
 
 namespace rtl {
 
@@ -1,3 +1,4 @@
+#include "cell.h"
 #include "exec.h"
 #include "number.h"
 #include "utf8string.h"
@@ -46,6 +47,16 @@ void setRecursionLimit(Number depth)
     executor_set_recursion_limit(number_to_uint64(depth));
 }
 
+void spawn(Cell &function)
+{
+    executor_spawn_fiber(function);
+}
+
+void yield()
+{
+    executor_yield();
+}
+
 } // namespace ne_runtime
 
 } // namespace rtl
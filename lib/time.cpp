@@ -1,5 +1,6 @@
-#include <thread>
+#include <chrono>
 
+#include "exec.h"
 #include "number.h"
 #include "rtl_platform.h"
 
@@ -10,7 +11,7 @@ namespace ne_time {
 void sleep(Number seconds)
 {
     std::chrono::microseconds us(number_to_uint64(number_multiply(seconds, number_from_uint32(1000000))));
-    std::this_thread::sleep_for(us);
+    executor_sleep(us);
 }
 
 } // namespace ne_time
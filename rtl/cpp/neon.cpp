@@ -1,21 +1,606 @@
 #include "neon.h"
 
-#include <iostream>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 namespace neon {
 
+namespace {
+
+class NullObject: public Object {
+public:
+    virtual std::string toString() const override { return "null"; }
+};
+
+class BooleanObject: public Object {
+public:
+    explicit BooleanObject(bool b): b(b) {}
+    virtual std::string toString() const override { return global::boolean__toString(b); }
+    const bool b;
+};
+
+class NumberObject: public Object {
+public:
+    explicit NumberObject(const std::string &s): s(s) {}
+    virtual std::string toString() const override { return s; }
+    const std::string s;
+};
+
+class StringObject: public Object {
+public:
+    explicit StringObject(const std::string &s): s(s) {}
+    virtual std::string toString() const override { return s; }
+    const std::string s;
+};
+
+// Return the byte offset of code point i in s, or s.size() if s has
+// fewer than i code points.
+size_t utf8_offset(const std::string &s, int64_t i)
+{
+    size_t p = 0;
+    while (i > 0 && p < s.size()) {
+        p++;
+        while (p < s.size() && (s[p] & 0xC0) == 0x80) {
+            p++;
+        }
+        i--;
+    }
+    return p;
+}
+
+// Raises the Neon exception for any error the decimal library reported
+// during the operation it is constructed around.
+class DecimalErrorCheck {
+public:
+    explicit DecimalErrorCheck(const char *what): what(what) {
+        number_clear_flags();
+    }
+    DecimalErrorCheck(const DecimalErrorCheck &) = delete;
+    DecimalErrorCheck &operator=(const DecimalErrorCheck &) = delete;
+    Number result(const ::Number &r) const {
+        const _IDEC_flags flags = number_get_flags();
+        if (flags & BID_OVERFLOW_EXCEPTION) {
+            raise("NumberException.Overflow", what);
+        }
+        if (flags & BID_ZERO_DIVIDE_EXCEPTION) {
+            raise("NumberException.DivideByZero", what);
+        }
+        if (flags & BID_INVALID_EXCEPTION) {
+            raise("NumberException.Invalid", what);
+        }
+        return Number(r);
+    }
+private:
+    const char *what;
+};
+
+} // namespace
+
+bool NeonException::is(const char *exception) const
+{
+    size_t n = strlen(exception);
+    return name.compare(0, n, exception) == 0 && (name.size() == n || name[n] == '.');
+}
+
+std::string NeonException::info_text() const
+{
+    return info != nullptr ? info->toString() : "";
+}
+
+void raise(const char *name, const std::string &info)
+{
+    throw NeonException(name, global::object__makeString(info));
+}
+
+Number::Number(::Number x): i(0), big()
+{
+    // Integers that fit are kept inline so that they take the fast paths.
+    if (x.rep == Rep::MPZ && x.get_mpz().fits_slong_p()) {
+        i = x.get_mpz().get_si();
+        return;
+    }
+    big = std::make_shared<const ::Number>(x);
+}
+
+Number Number::literal(const char *s)
+{
+    return Number(number_from_string(s));
+}
+
+Number add_general(const Number &a, const Number &b)
+{
+    DecimalErrorCheck errors("add");
+    return errors.result(number_add(a.value(), b.value()));
+}
+
+Number subtract_general(const Number &a, const Number &b)
+{
+    DecimalErrorCheck errors("subtract");
+    return errors.result(number_subtract(a.value(), b.value()));
+}
+
+Number multiply_general(const Number &a, const Number &b)
+{
+    DecimalErrorCheck errors("multiply");
+    return errors.result(number_multiply(a.value(), b.value()));
+}
+
+Number negate_general(const Number &a)
+{
+    DecimalErrorCheck errors("negate");
+    return errors.result(number_negate(a.value()));
+}
+
+int compare_general(const Number &a, const Number &b)
+{
+    const ::Number x = a.value();
+    const ::Number y = b.value();
+    return number_is_less(x, y) ? -1 : number_is_greater(x, y) ? 1 : 0;
+}
+
+bool equal_general(const Number &a, const Number &b)
+{
+    return number_is_equal(a.value(), b.value());
+}
+
+Number modulo(Number a, Number b)
+{
+    if (a.is_small() && b.is_small()) {
+        return modulo(a.i, b.i);
+    }
+    DecimalErrorCheck errors("modulo");
+    return errors.result(number_modulo(a.value(), b.value()));
+}
+
+Number divide(Number a, Number b)
+{
+    DecimalErrorCheck errors("divide");
+    return errors.result(number_divide(a.value(), b.value()));
+}
+
+Number power(Number a, Number b)
+{
+    DecimalErrorCheck errors("exponentiation");
+    return errors.result(number_pow(a.value(), b.value()));
+}
+
+int64_t index_value(int64_t index)
+{
+    return index;
+}
+
+int64_t index_value(Number index)
+{
+    if (index.is_small()) {
+        return index.i;
+    }
+    const ::Number n = index.value();
+    if (not number_is_integer(n) || number_is_less(n, number_from_sint64(INT64_MIN)) || number_is_greater(n, number_from_sint64(INT64_MAX))) {
+        raise("ArrayIndexException", number_to_string(n));
+    }
+    return number_to_sint64(n);
+}
+
 namespace global {
 
+std::string boolean__toString(bool self)
+{
+    return self ? "TRUE" : "FALSE";
+}
+
+int64_t bytes__size(const Bytes &self)
+{
+    return static_cast<int64_t>(self.size());
+}
+
+std::string number__toString(int64_t self)
+{
+    return std::to_string(self);
+}
+
+std::string number__toString(Number self)
+{
+    return self.is_small() ? std::to_string(self.i) : number_to_string(*self.big);
+}
+
+Number num(const std::string &s)
+{
+    ::Number n = number_from_string(s);
+    if (number_is_nan(n)) {
+        raise("ValueRangeException", "num() argument not a number");
+    }
+    return Number(n);
+}
+
+std::shared_ptr<Object> object__makeBoolean(bool b)
+{
+    return std::make_shared<BooleanObject>(b);
+}
+
+std::shared_ptr<Object> object__makeNull()
+{
+    return std::make_shared<NullObject>();
+}
+
+std::shared_ptr<Object> object__makeNumber(int64_t n)
+{
+    return std::make_shared<NumberObject>(number__toString(n));
+}
+
+std::shared_ptr<Object> object__makeNumber(Number n)
+{
+    return std::make_shared<NumberObject>(number__toString(n));
+}
+
 std::shared_ptr<Object> object__makeString(const std::string &s)
 {
     return std::make_shared<StringObject>(s);
 }
 
+std::string object__toString(std::shared_ptr<Object> obj)
+{
+    return obj != nullptr ? obj->toString() : "null";
+}
+
 void print(std::shared_ptr<Object> x)
 {
-    std::cout << x->toString() << "\n";
+    print(object__toString(x));
+}
+
+void print(const std::string &s)
+{
+    std::cout << s << "\n";
+}
+
+std::string str(int64_t x)
+{
+    return number__toString(x);
+}
+
+std::string str(Number x)
+{
+    return number__toString(x);
+}
+
+void string__append(std::string &self, const std::string &t)
+{
+    self.append(t);
+}
+
+std::string string__concat(const std::string &a, const std::string &b)
+{
+    return a + b;
+}
+
+std::string string__index(const std::string &s, Number index)
+{
+    int64_t i = index_value(index);
+    if (i < 0) {
+        raise("StringIndexException", std::to_string(i));
+    }
+    size_t p = utf8_offset(s, i);
+    if (p >= s.size()) {
+        raise("StringIndexException", std::to_string(i));
+    }
+    return s.substr(p, utf8_offset(s, i + 1) - p);
+}
+
+int64_t string__length(const std::string &self)
+{
+    int64_t r = 0;
+    for (auto c: self) {
+        if ((c & 0xC0) != 0x80) {
+            r++;
+        }
+    }
+    return r;
+}
+
+std::string string__substring(const std::string &s, Number first, bool first_from_end, Number last, bool last_from_end)
+{
+    int64_t f = index_value(first);
+    int64_t l = index_value(last);
+    const int64_t size = string__length(s);
+    if (first_from_end) {
+        f += size - 1;
+    }
+    if (last_from_end) {
+        l += size - 1;
+    }
+    if (f < 0) {
+        f = 0;
+    }
+    if (l >= size) {
+        l = size - 1;
+    }
+    if (f > l) {
+        return "";
+    }
+    size_t start = utf8_offset(s, f);
+    return s.substr(start, utf8_offset(s, l + 1) - start);
+}
+
+std::string string__toString(const std::string &self)
+{
+    return self;
 }
 
 } // namespace global
 
+namespace math {
+
+Number abs(Number x)
+{
+    return x < 0 ? -x : x;
+}
+
+Number ceil(Number x)
+{
+    return x.is_small() ? x : Number(number_ceil(*x.big));
+}
+
+Number cos(Number x)
+{
+    return Number(number_cos(x.value()));
+}
+
+Number exp(Number x)
+{
+    DecimalErrorCheck errors("exp");
+    return errors.result(number_exp(x.value()));
+}
+
+Number floor(Number x)
+{
+    return x.is_small() ? x : Number(number_floor(*x.big));
+}
+
+Number intdiv(Number x, Number y)
+{
+    if (x.is_small() && y.is_small() && y.i != 0 && not (x.i == INT64_MIN && y.i == -1)) {
+        return x.i / y.i;
+    }
+    return trunc(divide(x, y));
+}
+
+Number log(Number x)
+{
+    DecimalErrorCheck errors("log");
+    return errors.result(number_log(x.value()));
+}
+
+Number log10(Number x)
+{
+    DecimalErrorCheck errors("log10");
+    return errors.result(number_log10(x.value()));
+}
+
+Number max(Number a, Number b)
+{
+    return a > b ? a : b;
+}
+
+Number min(Number a, Number b)
+{
+    return a < b ? a : b;
+}
+
+bool odd(Number x)
+{
+    if (x.is_small()) {
+        return (x.i & 1) != 0;
+    }
+    if (not number_is_integer(*x.big)) {
+        raise("ValueRangeException", "odd() requires integer");
+    }
+    return number_is_odd(*x.big);
+}
+
+Number round(Number places, Number value)
+{
+    ::Number scale = number_from_uint32(1);
+    for (int64_t i = index_value(places); i > 0; i--) {
+        scale = number_multiply(scale, number_from_uint32(10));
+    }
+    return Number(number_divide(number_nearbyint(number_multiply(value.value(), scale)), scale));
+}
+
+Number sign(Number x)
+{
+    return x > 0 ? 1 : x < 0 ? -1 : 0;
+}
+
+Number sin(Number x)
+{
+    return Number(number_sin(x.value()));
+}
+
+Number sqrt(Number x)
+{
+    DecimalErrorCheck errors("sqrt");
+    return errors.result(number_sqrt(x.value()));
+}
+
+Number tan(Number x)
+{
+    return Number(number_tan(x.value()));
+}
+
+Number trunc(Number x)
+{
+    return x.is_small() ? x : Number(number_trunc(*x.big));
+}
+
+} // namespace math
+
+namespace string {
+
+Number find(const std::string &s, const std::string &t)
+{
+    std::string::size_type i = s.find(t);
+    if (i == std::string::npos) {
+        return -1;
+    }
+    return static_cast<int64_t>(i);
+}
+
+std::string fromCodePoint(Number code)
+{
+    if (not code.is_small() && not number_is_integer(*code.big)) {
+        raise("ValueRangeException", "fromCodePoint() argument not an integer");
+    }
+    if (code < 0 || code > 0x10ffff) {
+        raise("ValueRangeException", "fromCodePoint() argument out of range 0-0x10ffff");
+    }
+    uint32_t c = static_cast<uint32_t>(code.i);
+    std::string r;
+    if (c < 0x80) {
+        r.push_back(static_cast<char>(c));
+    } else if (c < 0x800) {
+        r.push_back(static_cast<char>(0xC0 | (c >> 6)));
+        r.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+        r.push_back(static_cast<char>(0xE0 | (c >> 12)));
+        r.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        r.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    } else {
+        r.push_back(static_cast<char>(0xF0 | (c >> 18)));
+        r.push_back(static_cast<char>(0x80 | ((c >> 12) & 0x3F)));
+        r.push_back(static_cast<char>(0x80 | ((c >> 6) & 0x3F)));
+        r.push_back(static_cast<char>(0x80 | (c & 0x3F)));
+    }
+    return r;
+}
+
+std::string lower(const std::string &s)
+{
+    std::string r;
+    for (auto c: s) {
+        r.push_back(static_cast<char>(::tolower(c)));
+    }
+    return r;
+}
+
+std::string quoted(const std::string &s)
+{
+    std::string r = "\"";
+    size_t i = 0;
+    while (i < s.size()) {
+        const size_t next = utf8_offset(s.substr(i), 1) + i;
+        uint32_t c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x80) {
+            // Decode the rest of the sequence.
+            int n = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+            c &= 0x3F >> n;
+            for (size_t j = i + 1; j < next; j++) {
+                c = (c << 6) | (static_cast<unsigned char>(s[j]) & 0x3F);
+            }
+        }
+        switch (c) {
+            case '\b': r.append("\\b"); break;
+            case '\f': r.append("\\f"); break;
+            case '\n': r.append("\\n"); break;
+            case '\r': r.append("\\r"); break;
+            case '\t': r.append("\\t"); break;
+            case '"':
+            case '\\':
+                r.push_back('\\');
+                r.push_back(static_cast<char>(c));
+                break;
+            default:
+                if (c >= ' ' && c < 0x7f) {
+                    r.push_back(static_cast<char>(c));
+                } else if (c < 0x10000) {
+                    char buf[7];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    r.append(buf);
+                } else {
+                    char buf[11];
+                    snprintf(buf, sizeof(buf), "\\U%08x", c);
+                    r.append(buf);
+                }
+                break;
+        }
+        i = next;
+    }
+    r.push_back('"');
+    return r;
+}
+
+std::vector<std::string> split(const std::string &s, const std::string &d)
+{
+    std::vector<std::string> r;
+    std::string::size_type i = 0;
+    while (i < s.length()) {
+        std::string::size_type nd = s.find(d, i);
+        if (nd == std::string::npos) {
+            r.push_back(s.substr(i));
+            break;
+        } else if (nd > i) {
+            r.push_back(s.substr(i, nd-i));
+        }
+        i = nd + d.length();
+    }
+    return r;
+}
+
+std::vector<std::string> splitLines(const std::string &s)
+{
+    std::vector<std::string> r;
+    std::string::size_type i = 0;
+    while (i < s.length()) {
+        std::string::size_type nl = s.find_first_of("\r\n", i);
+        if (nl == std::string::npos) {
+            r.push_back(s.substr(i));
+            break;
+        }
+        r.push_back(s.substr(i, nl-i));
+        if (s[nl] == '\r' && nl+1 < s.length() && s[nl+1] == '\n') {
+            i = nl + 2;
+        } else {
+            i = nl + 1;
+        }
+    }
+    return r;
+}
+
+Number toCodePoint(const std::string &s)
+{
+    if (global::string__length(s) != 1) {
+        raise("StringIndexException", "toCodePoint() requires string of length 1");
+    }
+    uint32_t c = static_cast<unsigned char>(s[0]);
+    if (c >= 0x80) {
+        int n = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+        c &= 0x3F >> n;
+        for (size_t j = 1; j < s.size(); j++) {
+            c = (c << 6) | (static_cast<unsigned char>(s[j]) & 0x3F);
+        }
+    }
+    return static_cast<int64_t>(c);
+}
+
+std::string trimCharacters(const std::string &s, const std::string &trimLeadingChars, const std::string &trimTrailingChars)
+{
+    std::string::size_type first = s.find_first_not_of(trimLeadingChars);
+    std::string::size_type last = s.find_last_not_of(trimTrailingChars);
+    if (first == std::string::npos || last == std::string::npos) {
+        return "";
+    }
+    return s.substr(first, last-first+1);
+}
+
+std::string upper(const std::string &s)
+{
+    std::string r;
+    for (auto c: s) {
+        r.push_back(static_cast<char>(::toupper(c)));
+    }
+    return r;
+}
+
+} // namespace string
+
 } // namespace neon
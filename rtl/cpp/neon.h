@@ -1,32 +1,409 @@
+#ifndef NEON_H
+#define NEON_H
+
+#include <stdint.h>
+
+#include <algorithm>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+
+#include "number.h"
+
+// Runtime support for programs translated to C++ by neonc -t cpp.
+//
+// The translator uses native C++ types wherever it can: Boolean is bool,
+// String is a UTF-8 std::string, Array is std::vector and Dictionary is
+// std::map. A Number that the translator can prove always fits in an
+// int64_t is one; any other Number is a neon::Number, which has the same
+// decimal semantics as in the bytecode executors.
 
 namespace neon {
 
+typedef std::vector<unsigned char> Bytes;
+
 class Object {
 public:
-    virtual std::string toString() = 0;
+    virtual ~Object() {}
+    virtual std::string toString() const = 0;
 };
 
-class StringObject: public Object {
+class NeonException {
 public:
-    std::string s;
+    NeonException(const std::string &name, std::shared_ptr<Object> info): name(name), info(info) {}
+    // True if this exception is the named exception or one of its subexceptions.
+    bool is(const char *exception) const;
+    std::string info_text() const;
+    std::string name;
+    std::shared_ptr<Object> info;
+};
+
+[[noreturn]] void raise(const char *name, const std::string &info);
+
+// Machine integer arithmetic that reports whether the result fits.
+inline bool checked_add(int64_t a, int64_t b, int64_t &r)
+{
+#if defined(__GNUC__)
+    return not __builtin_add_overflow(a, b, &r);
+#else
+    if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) {
+        return false;
+    }
+    r = a + b;
+    return true;
+#endif
+}
+
+inline bool checked_subtract(int64_t a, int64_t b, int64_t &r)
+{
+#if defined(__GNUC__)
+    return not __builtin_sub_overflow(a, b, &r);
+#else
+    if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b)) {
+        return false;
+    }
+    r = a - b;
+    return true;
+#endif
+}
+
+inline bool checked_multiply(int64_t a, int64_t b, int64_t &r)
+{
+#if defined(__GNUC__)
+    return not __builtin_mul_overflow(a, b, &r);
+#else
+    if (a > 0 ? (b > 0 ? a > INT64_MAX / b : b < INT64_MIN / a) : (b > 0 ? a < INT64_MIN / b : (a != 0 && b < INT64_MAX / a))) {
+        return false;
+    }
+    r = a * b;
+    return true;
+#endif
+}
+
+// A general Number. An integer that fits in an int64_t is held inline
+// and uses machine arithmetic; any other value, including the result of
+// machine arithmetic that would overflow, is the same arbitrary precision
+// integer or decimal (::Number) that the bytecode executors use.
+class Number {
 public:
-    explicit StringObject(const std::string &s): s(s) {}
-    virtual std::string toString() override { return s; }
+    Number(): i(0), big() {}
+    Number(int x): i(x), big() {}
+    Number(int64_t x): i(x), big() {}
+    explicit Number(::Number x);
+    // Parse a literal written by the translator.
+    static Number literal(const char *s);
+    bool is_small() const { return big == nullptr; }
+    ::Number value() const { return big != nullptr ? *big : number_from_sint64(i); }
+    Number &operator+=(const Number &x);
+    int64_t i;
+    std::shared_ptr<const ::Number> big;
 };
 
+// A Number literal that is not an int64_t, parsed the first time it is used.
+#define NEON_NUMBER(s) ([]() -> const neon::Number & { static const neon::Number n = neon::Number::literal(s); return n; }())
+
+Number add_general(const Number &a, const Number &b);
+Number subtract_general(const Number &a, const Number &b);
+Number multiply_general(const Number &a, const Number &b);
+Number negate_general(const Number &a);
+int compare_general(const Number &a, const Number &b);
+bool equal_general(const Number &a, const Number &b);
+
+inline Number operator+(const Number &a, const Number &b)
+{
+    int64_t r;
+    if (a.is_small() && b.is_small() && checked_add(a.i, b.i, r)) {
+        return r;
+    }
+    return add_general(a, b);
+}
+
+inline Number operator-(const Number &a, const Number &b)
+{
+    int64_t r;
+    if (a.is_small() && b.is_small() && checked_subtract(a.i, b.i, r)) {
+        return r;
+    }
+    return subtract_general(a, b);
+}
+
+inline Number operator*(const Number &a, const Number &b)
+{
+    int64_t r;
+    if (a.is_small() && b.is_small() && checked_multiply(a.i, b.i, r)) {
+        return r;
+    }
+    return multiply_general(a, b);
+}
+
+inline Number operator-(const Number &a)
+{
+    if (a.is_small() && a.i != INT64_MIN) {
+        return -a.i;
+    }
+    return negate_general(a);
+}
+
+inline Number &Number::operator+=(const Number &x)
+{
+    return *this = *this + x;
+}
+
+inline bool operator==(const Number &a, const Number &b)
+{
+    return a.is_small() && b.is_small() ? a.i == b.i : equal_general(a, b);
+}
+
+inline bool operator!=(const Number &a, const Number &b)
+{
+    return not (a == b);
+}
+
+inline bool operator<(const Number &a, const Number &b)
+{
+    return a.is_small() && b.is_small() ? a.i < b.i : compare_general(a, b) < 0;
+}
+
+inline bool operator>(const Number &a, const Number &b)
+{
+    return b < a;
+}
+
+inline bool operator<=(const Number &a, const Number &b)
+{
+    return not (b < a);
+}
+
+inline bool operator>=(const Number &a, const Number &b)
+{
+    return not (a < b);
+}
+
+// Arithmetic on two values that the translator knows are int64_t. The
+// result is a general Number, so it keeps its full value on overflow.
+inline Number add(int64_t a, int64_t b)
+{
+    return Number(a) + Number(b);
+}
+
+inline Number subtract(int64_t a, int64_t b)
+{
+    return Number(a) - Number(b);
+}
+
+inline Number multiply(int64_t a, int64_t b)
+{
+    return Number(a) * Number(b);
+}
+
+inline Number negate(int64_t a)
+{
+    return -Number(a);
+}
+
+// MOD takes the sign of the divisor, like the other executors.
+inline int64_t modulo(int64_t a, int64_t b)
+{
+    if (b == 0) {
+        raise("NumberException.DivideByZero", "");
+    }
+    if (b == -1) {
+        return 0;
+    }
+    int64_t r = a % b;
+    if (r != 0 && (r < 0) != (b < 0)) {
+        r += b;
+    }
+    return r;
+}
+
+Number modulo(Number a, Number b);
+Number divide(Number a, Number b);
+Number power(Number a, Number b);
+
+int64_t index_value(int64_t index);
+int64_t index_value(Number index);
+
+template <typename T, typename I> const T &array_index(const std::vector<T> &a, I index)
+{
+    int64_t i = index_value(index);
+    if (i < 0 || static_cast<uint64_t>(i) >= a.size()) {
+        raise("ArrayIndexException", std::to_string(i));
+    }
+    return a[i];
+}
+
+// Writing past the end of an array extends it, as in the other executors.
+template <typename T, typename I> T &array_index_for_write(std::vector<T> &a, I index)
+{
+    int64_t i = index_value(index);
+    if (i < 0) {
+        raise("ArrayIndexException", std::to_string(i));
+    }
+    if (static_cast<uint64_t>(i) >= a.size()) {
+        a.resize(i + 1);
+    }
+    return a[i];
+}
+
+template <typename T, typename U> bool array_contains(const std::vector<T> &a, const U &x)
+{
+    return std::find(a.begin(), a.end(), x) != a.end();
+}
+
+template <typename T> const T &dictionary_index(const std::map<std::string, T> &d, const std::string &key)
+{
+    auto i = d.find(key);
+    if (i == d.end()) {
+        raise("DictionaryIndexException", key);
+    }
+    return i->second;
+}
+
+template <typename T> bool dictionary_contains(const std::map<std::string, T> &d, const std::string &key)
+{
+    return d.find(key) != d.end();
+}
+
 namespace global {
 
+template <typename T, typename U> void array__append(std::vector<T> &self, const U &element)
+{
+    self.push_back(element);
+}
+
+template <typename T> std::vector<T> array__concat(const std::vector<T> &left, const std::vector<T> &right)
+{
+    std::vector<T> r = left;
+    r.insert(r.end(), right.begin(), right.end());
+    return r;
+}
+
+template <typename T> void array__extend(std::vector<T> &self, const std::vector<T> &elements)
+{
+    self.insert(self.end(), elements.begin(), elements.end());
+}
+
+template <typename T, typename U> int64_t array__find(const std::vector<T> &self, const U &element)
+{
+    auto i = std::find(self.begin(), self.end(), element);
+    if (i == self.end()) {
+        raise("ArrayIndexException", "value not found in array");
+    }
+    return i - self.begin();
+}
+
+template <typename T, typename I> void array__remove(std::vector<T> &self, I index)
+{
+    int64_t i = index_value(index);
+    if (i < 0 || static_cast<uint64_t>(i) >= self.size()) {
+        raise("ArrayIndexException", std::to_string(i));
+    }
+    self.erase(self.begin() + i);
+}
+
+template <typename T, typename I> void array__resize(std::vector<T> &self, I new_size)
+{
+    int64_t n = index_value(new_size);
+    if (n < 0) {
+        raise("ArrayIndexException", std::to_string(n));
+    }
+    self.resize(n);
+}
+
+template <typename T> std::vector<T> array__reversed(const std::vector<T> &self)
+{
+    return std::vector<T>(self.rbegin(), self.rend());
+}
+
+template <typename T> int64_t array__size(const std::vector<T> &self)
+{
+    return static_cast<int64_t>(self.size());
+}
+
+template <typename T> std::vector<std::string> dictionary__keys(const std::map<std::string, T> &self)
+{
+    std::vector<std::string> r;
+    r.reserve(self.size());
+    for (auto &x: self) {
+        r.push_back(x.first);
+    }
+    return r;
+}
+
+template <typename T> void dictionary__remove(std::map<std::string, T> &self, const std::string &key)
+{
+    self.erase(key);
+}
+
+template <typename T> int64_t dictionary__size(const std::map<std::string, T> &self)
+{
+    return static_cast<int64_t>(self.size());
+}
+
+std::string boolean__toString(bool self);
+int64_t bytes__size(const Bytes &self);
+std::string number__toString(int64_t self);
+std::string number__toString(Number self);
+Number num(const std::string &s);
+std::shared_ptr<Object> object__makeBoolean(bool b);
+std::shared_ptr<Object> object__makeNull();
+std::shared_ptr<Object> object__makeNumber(int64_t n);
+std::shared_ptr<Object> object__makeNumber(Number n);
 std::shared_ptr<Object> object__makeString(const std::string &s);
+std::string object__toString(std::shared_ptr<Object> obj);
 void print(std::shared_ptr<Object> x);
+void print(const std::string &s);
+std::string str(int64_t x);
+std::string str(Number x);
+void string__append(std::string &self, const std::string &t);
+std::string string__concat(const std::string &a, const std::string &b);
+std::string string__index(const std::string &s, Number index);
+int64_t string__length(const std::string &self);
+std::string string__substring(const std::string &s, Number first, bool first_from_end, Number last, bool last_from_end);
+std::string string__toString(const std::string &self);
 
 } // namespace global
 
-class NeonException {
-public:
-    std::string name;
-};
+namespace math {
+
+Number abs(Number x);
+Number ceil(Number x);
+Number cos(Number x);
+Number exp(Number x);
+Number floor(Number x);
+Number intdiv(Number x, Number y);
+Number log(Number x);
+Number log10(Number x);
+Number max(Number a, Number b);
+Number min(Number a, Number b);
+bool odd(Number x);
+Number round(Number places, Number value);
+Number sign(Number x);
+Number sin(Number x);
+Number sqrt(Number x);
+Number tan(Number x);
+Number trunc(Number x);
+
+} // namespace math
+
+namespace string {
+
+Number find(const std::string &s, const std::string &t);
+std::string fromCodePoint(Number code);
+std::string lower(const std::string &s);
+std::string quoted(const std::string &s);
+std::vector<std::string> split(const std::string &s, const std::string &d);
+std::vector<std::string> splitLines(const std::string &s);
+Number toCodePoint(const std::string &s);
+std::string trimCharacters(const std::string &s, const std::string &trimLeadingChars, const std::string &trimTrailingChars);
+std::string upper(const std::string &s);
+
+} // namespace string
 
 } // namespace neon
+
+#endif
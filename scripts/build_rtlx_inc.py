@@ -4,19 +4,20 @@ import os
 import sys
 
 with open("gen/rtlx.inc", "w") as f:
+    modules = []
     for fn in sys.argv[1:]:
+        modname = os.path.basename(fn).replace(".neonx", "")
         bytecode = open(fn, "rb").read()
-        print("static const unsigned char bytecode_{}[] = {{{}}};".format(
-            os.path.basename(fn).replace(".neonx", ""),
-            ",".join("0x{:02x}".format(ord(x)) for x in bytecode)
-        ), file=f)
-    print("static struct {", file=f)
+        print("static const unsigned char bytecode_{}[] = {{".format(modname), file=f)
+        for i in range(0, len(bytecode), 16):
+            print("    " + ",".join("0x{:02x}".format(x) for x in bytecode[i:i+16]) + ",", file=f)
+        print("};", file=f)
+        modules.append((modname, len(bytecode)))
+    print("static const struct {", file=f)
     print("    const char *name;", file=f)
     print("    size_t length;", file=f)
     print("    const unsigned char *bytecode;", file=f)
     print("} rtl_bytecode[] = {", file=f)
-    for fn in sys.argv[1:]:
-        modname = os.path.basename(fn).replace(".neonx", "")
-        bytecode = open(fn, "rb").read()
-        print("    {{\"{}\", {}, bytecode_{}}},".format(modname, len(bytecode), modname), file=f)
+    for modname, length in modules:
+        print("    {{\"{}\", {}, bytecode_{}}},".format(modname, length, modname), file=f)
     print("};", file=f)
@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+
+# Generate tests/analyzer-scale.neon, a large synthetic module used by
+# perf_analyzer. It has a few hundred imported names, many globals, and
+# functions whose bodies are nested deeply enough that most identifiers
+# are resolved several scopes away from where they were declared.
+
+import sys
+
+IMPORTS = 10
+CONSTANTS = 500
+GLOBALS = 200
+FUNCTIONS = 200
+DEPTH = 8
+
+MATH = ["abs", "cbrt", "ceil", "floor", "nearbyint", "sign", "sqrt", "trunc"]
+STRING = ["lower", "trim", "upper"]
+
+def main():
+    out = sys.stdout
+    print("-- Generated by scripts/make_analyzer_scale.py. Do not edit.", file=out)
+    print("", file=out)
+    for k in range(IMPORTS):
+        for f in MATH:
+            print("IMPORT math.{0} ALIAS math_{0}_{1}".format(f, k), file=out)
+        for f in STRING:
+            print("IMPORT string.{0} ALIAS string_{0}_{1}".format(f, k), file=out)
+    print("", file=out)
+    for i in range(CONSTANTS):
+        print("CONSTANT C{0}: Number := {0}".format(i), file=out)
+    print("", file=out)
+    for i in range(GLOBALS):
+        print("VAR g{}: Number := {}".format(i, i % 7), file=out)
+    print("", file=out)
+    for i in range(FUNCTIONS):
+        print("FUNCTION f{}(a: Number): Number".format(i), file=out)
+        print("    VAR x0: Number := a + C{}".format(i % CONSTANTS), file=out)
+        indent = "    "
+        for d in range(1, DEPTH + 1):
+            if d % 2 == 1:
+                print("{}IF x{} >= 0 THEN".format(indent, d - 1), file=out)
+            else:
+                print("{}FOR i{} := 1 TO 2 DO".format(indent, d), file=out)
+            indent += "    "
+            m = MATH[(i + d) % len(MATH)]
+            s = STRING[(i + d) % len(STRING)]
+            print("{}VAR x{}: Number := math_{}_{}(x{}) + g{} + C{}".format(indent, d, m, (i + d) // len(MATH) % IMPORTS, d - 1, (i * 7 + d) % GLOBALS, (i * 13 + d) % CONSTANTS), file=out)
+            print("{}IF string_{}_{}(\"x{}\") = \"\" THEN".format(indent, s, (i + d) // len(STRING) % IMPORTS, d), file=out)
+            print("{}    x{} := x{} + 1".format(indent, d, d), file=out)
+            print("{}END IF".format(indent), file=out)
+        print("{}x0 := x0 + {}".format(indent, " + ".join("x{}".format(d) for d in range(1, DEPTH + 1))), file=out)
+        for d in range(DEPTH, 0, -1):
+            indent = indent[4:]
+            print("{}{}".format(indent, "END IF" if d % 2 == 1 else "END FOR"), file=out)
+        if i > 0:
+            print("    RETURN x0 + f{}(a - 1)".format(i - 1), file=out)
+        else:
+            print("    RETURN x0", file=out)
+        print("END FUNCTION", file=out)
+        print("", file=out)
+    print("BEGIN MAIN", file=out)
+    print("    print(str(f{}(0)))".format(FUNCTIONS - 1), file=out)
+    print("END MAIN", file=out)
+
+main()
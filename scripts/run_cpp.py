@@ -5,21 +5,31 @@ import subprocess
 import sys
 
 neonc = os.path.join("bin", "neonc")
+rtl = os.path.join("bin", "neon_rtl_cpp.cmake")
 
 i = 1
 while i < len(sys.argv):
     if sys.argv[i] == "--neonc":
         i += 1
         neonc = sys.argv[i]
+    elif sys.argv[i] == "--rtl":
+        i += 1
+        rtl = sys.argv[i]
     else:
         break
     i += 1
 
 fullname = sys.argv[i]
 
+# neonc writes a CMake project for the program next to the source. The
+# build tree is kept between runs, so only the modules that changed are
+# compiled again.
 subprocess.check_call([neonc, "-q", "-t", "cpp", fullname])
+project = fullname.replace(".neon", "-cpp")
+build = os.path.join(project, "build")
+subprocess.check_call(["cmake", "-S", project, "-B", build, "-DNEON_RTL=" + os.path.abspath(rtl)], stdout=subprocess.DEVNULL)
+subprocess.check_call(["cmake", "--build", build, "--parallel"], stdout=subprocess.DEVNULL)
+exe = os.path.join(build, os.path.basename(fullname).replace(".neon", ""))
 if sys.platform == "win32":
-    subprocess.check_call(["cl", "/Fe{}".format(fullname.replace(".neon", "")), "/EHsc", "/Irtl/cpp", fullname.replace(".neon", ".cpp"), "rtl/cpp/neon.cpp"], stdout=subprocess.PIPE, stderr=subprocess.PIPE)
-else:
-    subprocess.check_call(["c++", "-std=c++11", "-o", fullname.replace(".neon", ""), "-Irtl/cpp", fullname.replace(".neon", ".cpp"), "rtl/cpp/neon.cpp"])
-subprocess.check_call([fullname.replace(".neon", "")] + sys.argv[i+1:])
+    exe += ".exe"
+subprocess.check_call([exe] + sys.argv[i+1:])
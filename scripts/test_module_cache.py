@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+
+import os
+import shutil
+import subprocess
+import sys
+
+neonc = sys.argv[1]
+executor = sys.argv[2:]
+
+cache = "tmp/module-cache"
+shutil.rmtree(cache, ignore_errors=True)
+env = dict(os.environ, NEONCACHE=cache)
+
+modules = ["t/module-import-diamond-{}.neonx".format(x) for x in "abc"]
+
+def clean():
+    for m in modules:
+        if os.path.exists(m):
+            os.remove(m)
+
+clean()
+subprocess.check_call([neonc, "-o", "tmp/module-import-diamond.neonx", "t/module-import-diamond.neon"], env=env)
+entries = [f for d, _, files in os.walk(cache) for f in files if f.endswith(".neonx")]
+if len(entries) != len(modules):
+    print("{}: Failed: expected {} cache entries, found {}".format(sys.argv[0], len(modules), len(entries)), file=sys.stderr)
+    sys.exit(1)
+
+# With the local compiled modules gone, they must be restored from the cache.
+clean()
+subprocess.check_call([neonc, "-o", "tmp/module-import-diamond.neonx", "t/module-import-diamond.neon"], env=env)
+for m in modules:
+    if not os.path.exists(m):
+        print("{}: Failed: expected {} to be restored from cache".format(sys.argv[0], m), file=sys.stderr)
+        sys.exit(1)
+subprocess.check_call(executor + ["--neonpath", "t", "tmp/module-import-diamond.neonx"])
+
+# A module must be compiled again when something it imports changes, even
+# though its own source has not, because imported constants are inlined.
+src = "tmp/module-cache-src"
+shutil.rmtree(src, ignore_errors=True)
+os.makedirs(src)
+for x in ["", "-a", "-b", "-c"]:
+    shutil.copy("t/module-import-diamond{}.neon".format(x), src)
+main = os.path.join(src, "module-import-diamond.neon")
+
+def build_and_run():
+    for f in os.listdir(src):
+        if f.endswith(".neonx"):
+            os.remove(os.path.join(src, f))
+    subprocess.check_call([neonc, main], env=env)
+    return subprocess.check_output(executor + [main + "x"]).decode().split()
+
+build_and_run()
+with open(os.path.join(src, "module-import-diamond-c.neon"), "w") as f:
+    f.write('EXPORT CONSTANT Base: String := "changed"\n')
+output = build_and_run()
+if output.count("changed") != 3:
+    print("{}: Failed: stale module restored from cache: {}".format(sys.argv[0], output), file=sys.stderr)
+    sys.exit(1)
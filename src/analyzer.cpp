@@ -6,6 +6,7 @@
 #include <list>
 #include <sstream>
 #include <stack>
+#include <unordered_map>
 
 #include "ast.h"
 #include "bytecode.h"
@@ -28,15 +29,19 @@ public:
     const pt::Program *program;
     std::map<std::string, ast::ExternalGlobalInfo> *const external_globals;
     const std::string module_name;
-    std::map<std::string, ast::Module *> modules;
+    std::unordered_map<std::string, ast::Module *> modules;
     ast::Scope *global_scope;
     std::stack<ast::Frame *> frame;
     std::stack<ast::Scope *> scope;
     std::map<std::string, Token> exports;
 
     std::stack<std::pair<const ast::Type *, const ast::TypeFunction *>> functiontypes;
+    std::stack<ast::Function *> functions;
     std::stack<std::list<std::pair<std::string, unsigned int>>> loops;
     std::stack<std::set<std::string>> imported_checked_stack;
+    // Functions passed to the parallel array methods, which are checked
+    // once every function body has been analyzed.
+    std::vector<std::pair<Token, const ast::Function *>> parallel_functions;
 
     const ast::Type *analyze(const pt::Type *type, AllowClass allow_class, const std::string &name = std::string());
     const ast::Type *analyze(const pt::TypeSimple *type, const std::string &name);
@@ -149,6 +154,9 @@ private:
     void process_into_results(const pt::ExecStatement *statement, const std::string &sql, const ast::Variable *function, std::vector<const ast::Expression *> args, std::vector<const ast::Statement *> &statements);
     std::vector<ast::TypeRecord::Field> analyze_fields(const pt::TypeRecord *type, std::string tname, bool for_class);
     const ast::Expression *analyze_comparison(const Token &token, const ast::Expression *left, ast::ComparisonExpression::Comparison comp, const ast::Expression *right);
+    const ast::Expression *analyze_variable(const ast::Variable *var);
+    void check_parallel_function(const Token &token, const ast::Expression *expr);
+    void check_parallel_functions();
 };
 
 class TypeAnalyzer: public pt::IParseTreeVisitor {
@@ -740,14 +748,14 @@ static const ast::Expression *make_object_conversion_from_record(Analyzer *analy
                 {new ast::DictionaryReferenceIndexExpression(
                     ast::TYPE_OBJECT,
                     new ast::VariableExpression(result),
-                    new ast::ConstantStringExpression(utf8string(f.name.text))
+                    new ast::ConstantStringExpression(utf8string(f.name.text()))
                 )},
                 converter(
                     analyzer,
                     new ast::RecordValueFieldExpression(
                         f.type,
                         e,
-                        f.name.text,
+                        f.name.text(),
                         false
                     )
                 )
@@ -777,14 +785,14 @@ static const ast::Expression *make_record_conversion_from_object(Analyzer *analy
                     {new ast::RecordReferenceFieldExpression(
                         f.type,
                         new ast::VariableExpression(result),
-                        f.name.text,
+                        f.name.text(),
                         true
                     )},
                     converter(
                         analyzer,
                         new ast::ObjectSubscriptExpression(
                             e,
-                            ast::TYPE_OBJECT->make_converter(ast::TYPE_STRING)(analyzer, new ast::ConstantStringExpression(utf8string(f.name.text)))
+                            ast::TYPE_OBJECT->make_converter(ast::TYPE_STRING)(analyzer, new ast::ConstantStringExpression(utf8string(f.name.text())))
                         )
                     )
                 )},
@@ -1109,8 +1117,10 @@ Analyzer::Analyzer(ICompilerSupport *support, const pt::Program *program, std::m
     scope(),
     exports(),
     functiontypes(),
+    functions(),
     loops(),
-    imported_checked_stack()
+    imported_checked_stack(),
+    parallel_functions()
 {
 }
 
@@ -1394,7 +1404,9 @@ std::string Analyzer::extract_module_name(const pt::Program *program)
 
 ast::Module *Analyzer::import_module(const Token &token, const std::string &name, bool optional)
 {
-    static std::vector<std::string> s_importing;
+    // Nested module compiles run on the thread that requested them, so the
+    // chain of modules being imported is tracked per thread.
+    static thread_local std::vector<std::string> s_importing;
 
     auto m = modules.find(name);
     if (m != modules.end()) {
@@ -1535,7 +1547,7 @@ const ast::Type *Analyzer::analyze_enum(const pt::TypeEnum *type, const std::str
     std::map<std::string, int> names;
     int index = 0;
     for (auto x: type->names) {
-        std::string enumname = x.first.text;
+        std::string enumname = x.first.text();
         auto t = names.find(enumname);
         if (t != names.end()) {
             error2(3010, x.first, "duplicate enum: " + enumname, type->names[t->second].first, "first declaration here");
@@ -1554,10 +1566,10 @@ std::vector<ast::TypeRecord::Field> Analyzer::analyze_fields(const pt::TypeRecor
     }
     std::map<std::string, Token> field_names;
     for (auto &x: type->fields) {
-        std::string name = x->name.text;
+        std::string name = x->name.text();
         auto prev = field_names.find(name);
         if (prev != field_names.end()) {
-            error2(3009, x->name, "duplicate field: " + x->name.text, prev->second, "first declaration here");
+            error2(3009, x->name, "duplicate field: " + x->name.text(), prev->second, "first declaration here");
         }
         const ast::Type *t;
         const pt::TypeRecord *tr = dynamic_cast<const pt::TypeRecord *>(x->type.get());
@@ -1593,14 +1605,14 @@ const ast::Type *Analyzer::analyze_class(const pt::TypeClass *type, const std::s
     for (auto i: type->interfaces) {
         ast::Scope *s = scope.top();
         if (i.first.type != NONE) {
-            const ast::Name *modname = scope.top()->lookupName(i.first.text);
+            const ast::Name *modname = scope.top()->lookupName(i.first.text());
             const ast::Module *mod = dynamic_cast<const ast::Module *>(modname);
             if (mod == nullptr) {
                 error(3257, i.first, "module not found");
             }
             s = mod->scope;
         }
-        const ast::Name *interfacename = s->lookupName(i.second.text);
+        const ast::Name *interfacename = s->lookupName(i.second.text());
         if (interfacename == nullptr) {
             error(3248, i.second, "interface name not found");
         }
@@ -1632,9 +1644,9 @@ const ast::Type *Analyzer::analyze(const pt::TypePointer *type, const std::strin
             }
             const pt::TypeQualified *import = dynamic_cast<const pt::TypeQualified *>(type->reftype.get());
             if (import != nullptr) {
-                ast::Module *module = dynamic_cast<ast::Module *>(scope.top()->lookupName(import->names[0].text));
+                ast::Module *module = dynamic_cast<ast::Module *>(scope.top()->lookupName(import->names[0].text()));
                 if (module != nullptr) {
-                    ast::Interface *interface = dynamic_cast<ast::Interface *>(module->scope->lookupName(import->names[1].text));
+                    ast::Interface *interface = dynamic_cast<ast::Interface *>(module->scope->lookupName(import->names[1].text()));
                     if (interface != nullptr) {
                         return new ast::TypeInterfacePointer(type->token, interface);
                     }
@@ -1728,14 +1740,14 @@ const ast::Type *Analyzer::analyze(const pt::TypeFunctionPointer *type, const st
 
 const ast::Type *Analyzer::analyze(const pt::TypeParameterised *type, const std::string &)
 {
-    if (type->name.text == "Array") {
+    if (type->name.text() == "Array") {
         const ast::Type *elementtype = analyze(type->elementtype.get(), AllowClass::no);
         if (dynamic_cast<const ast::TypeValidPointer *>(elementtype) != nullptr) {
             error(3222, type->elementtype->token, "valid pointer type not permitted as array element type");
         }
         return new ast::TypeArray(type->name, elementtype);
     }
-    if (type->name.text == "Dictionary") {
+    if (type->name.text() == "Dictionary") {
         const ast::Type *elementtype = analyze(type->elementtype.get(), AllowClass::no);
         return new ast::TypeDictionary(type->name, elementtype);
     }
@@ -1744,7 +1756,7 @@ const ast::Type *Analyzer::analyze(const pt::TypeParameterised *type, const std:
 
 const ast::Type *Analyzer::analyze(const pt::TypeQualified *type, const std::string &)
 {
-    ast::Name *modname = scope.top()->lookupName(type->names[0].text);
+    ast::Name *modname = scope.top()->lookupName(type->names[0].text());
     if (modname == nullptr) {
         error(3153, type->names[0], "name not found");
     }
@@ -1752,7 +1764,7 @@ const ast::Type *Analyzer::analyze(const pt::TypeQualified *type, const std::str
     if (module == nullptr) {
         error(3154, type->names[0], "module name expected");
     }
-    ast::Name *name = module->scope->lookupName(type->names[1].text);
+    ast::Name *name = module->scope->lookupName(type->names[1].text());
     if (name == nullptr) {
         error(3155, type->names[1], "name not found in module");
     }
@@ -1935,11 +1947,24 @@ const ast::Expression *Analyzer::analyze(const pt::IdentifierExpression *expr)
     }
     const ast::Variable *var = dynamic_cast<const ast::Variable *>(name);
     if (var != nullptr) {
-        return new ast::VariableExpression(var);
+        return analyze_variable(var);
     }
     error(3040, expr->token, "name is not a constant or variable: " + expr->name);
 }
 
+const ast::Expression *Analyzer::analyze_variable(const ast::Variable *var)
+{
+    if (not functions.empty()) {
+        const ast::LocalVariable *local = dynamic_cast<const ast::LocalVariable *>(var);
+        if (dynamic_cast<const ast::GlobalVariable *>(var) != nullptr
+         || dynamic_cast<const ast::ExternalGlobalVariable *>(var) != nullptr
+         || (local != nullptr && local->nesting_depth < functions.top()->nesting_depth)) {
+            functions.top()->uses_outer_variables = true;
+        }
+    }
+    return new ast::VariableExpression(var);
+}
+
 const ast::Name *Analyzer::analyze_qualified_name(const pt::Expression *expr)
 {
     const pt::IdentifierExpression *ident = dynamic_cast<const pt::IdentifierExpression *>(expr);
@@ -1960,9 +1985,9 @@ const ast::Name *Analyzer::analyze_qualified_name(const pt::Expression *expr)
     const ast::Name *base = analyze_qualified_name(dotted->base.get());
     const ast::Module *module = dynamic_cast<const ast::Module *>(base);
     if (module != nullptr) {
-        const ast::Name *name = module->scope->lookupName(dotted->name.text);
+        const ast::Name *name = module->scope->lookupName(dotted->name.text());
         if (name == nullptr) {
-            error(3134, dotted->name, "name not found: " + dotted->name.text);
+            error(3134, dotted->name, "name not found: " + dotted->name.text());
         }
         return name;
     }
@@ -1979,7 +2004,7 @@ const ast::Expression *Analyzer::analyze(const pt::DotExpression *expr)
         }
         const ast::Variable *var = dynamic_cast<const ast::Variable *>(name);
         if (var != nullptr) {
-            return new ast::VariableExpression(var);
+            return analyze_variable(var);
         }
         error(3291, expr->token, "expected constant or variable");
     }
@@ -1987,16 +2012,16 @@ const ast::Expression *Analyzer::analyze(const pt::DotExpression *expr)
     if (name != nullptr) {
         const ast::TypeEnum *enumtype = dynamic_cast<const ast::TypeEnum *>(name);
         if (enumtype != nullptr) {
-            auto enumname = enumtype->names.find(expr->name.text);
+            auto enumname = enumtype->names.find(expr->name.text());
             if (enumname == enumtype->names.end()) {
-                error2(3023, expr->name, "identifier not member of enum: " + expr->name.text, enumtype->declaration, "enum declared here");
+                error2(3023, expr->name, "identifier not member of enum: " + expr->name.text(), enumtype->declaration, "enum declared here");
             }
             return new ast::ConstantEnumExpression(enumtype, enumname->second);
         }
     }
     const ast::Expression *base = analyze(expr->base.get());
     if (base->type == ast::TYPE_OBJECT) {
-        return new ast::ObjectSubscriptExpression(base, convert(ast::TYPE_OBJECT, new ast::ConstantStringExpression(utf8string(expr->name.text))));
+        return new ast::ObjectSubscriptExpression(base, convert(ast::TYPE_OBJECT, new ast::ConstantStringExpression(utf8string(expr->name.text()))));
     }
     const ast::TypeRecord *recordtype = dynamic_cast<const ast::TypeRecord *>(base->type);
     if (recordtype == nullptr) {
@@ -2005,7 +2030,7 @@ const ast::Expression *Analyzer::analyze(const pt::DotExpression *expr)
     if (dynamic_cast<const ast::TypeForwardClass *>(recordtype) != nullptr) {
         internal_error("class not defined yet");
     }
-    auto f = recordtype->field_names.find(expr->name.text);
+    auto f = recordtype->field_names.find(expr->name.text());
     if (f == recordtype->field_names.end()) {
         error2(3045, expr->name, "field not found", recordtype->declaration, "record declared here");
     }
@@ -2015,9 +2040,9 @@ const ast::Expression *Analyzer::analyze(const pt::DotExpression *expr)
     const ast::Type *type = recordtype->fields[f->second].type;
     const ast::ReferenceExpression *ref = dynamic_cast<const ast::ReferenceExpression *>(base);
     if (ref != nullptr) {
-        return new ast::RecordReferenceFieldExpression(type, ref, expr->name.text, true);
+        return new ast::RecordReferenceFieldExpression(type, ref, expr->name.text(), true);
     } else {
-        return new ast::RecordValueFieldExpression(type, base, expr->name.text, true);
+        return new ast::RecordValueFieldExpression(type, base, expr->name.text(), true);
     }
 }
 
@@ -2038,7 +2063,7 @@ const ast::Expression *Analyzer::analyze(const pt::ArrowExpression *expr)
     if (dynamic_cast<const ast::TypeForwardClass *>(recordtype) != nullptr) {
         error2(3104, expr->base->token, "class not defined yet", recordtype->declaration, "forward declaration here");
     }
-    auto f = recordtype->field_names.find(expr->name.text);
+    auto f = recordtype->field_names.find(expr->name.text());
     if (f == recordtype->field_names.end()) {
         error2(3111, expr->name, "field not found", recordtype->declaration, "record declared here");
     }
@@ -2047,7 +2072,7 @@ const ast::Expression *Analyzer::analyze(const pt::ArrowExpression *expr)
     }
     const ast::Type *type = recordtype->fields[f->second].type;
     const ast::PointerDereferenceExpression *ref = new ast::PointerDereferenceExpression(recordtype, base);
-    return new ast::RecordReferenceFieldExpression(type, ref, expr->name.text, false);
+    return new ast::RecordReferenceFieldExpression(type, ref, expr->name.text(), false);
 }
 
 const ast::Expression *Analyzer::analyze(const pt::SubscriptExpression *expr)
@@ -2179,7 +2204,7 @@ const ast::Expression *Analyzer::analyze(const pt::InterpolatedStringExpression
     const ast::Expression *r = nullptr;
     for (auto &x: expr->parts) {
         const ast::Expression *e = analyze(x.first.get());
-        std::string fmt = x.second.text;
+        std::string fmt = x.second.text();
         const ast::Expression *str = convert(ast::TYPE_STRING, e);
         if (str != nullptr && e->type != ast::TYPE_OBJECT) {
             // No action required.
@@ -2247,11 +2272,11 @@ const ast::Expression *Analyzer::analyze(const pt::FunctionCallExpression *expr)
                     internal_error("could not find object__invokeMethod");
                 }
                 self = base;
-                initial_args.push_back(new ast::ConstantStringExpression(utf8string(dotmethod->name.text)));
+                initial_args.push_back(new ast::ConstantStringExpression(utf8string(dotmethod->name.text())));
                 func = new ast::VariableExpression(invoke);
                 allow_ignore_result = true;
             } else {
-                auto m = base->type->methods.find(dotmethod->name.text);
+                auto m = base->type->methods.find(dotmethod->name.text());
                 if (m == base->type->methods.end()) {
                     error(3137, dotmethod->name, "method not found");
                 } else {
@@ -2276,7 +2301,7 @@ const ast::Expression *Analyzer::analyze(const pt::FunctionCallExpression *expr)
             if (dynamic_cast<const ast::TypeValidPointer *>(ptype) == nullptr) {
                 error(3219, arrowmethod->base->token, "valid pointer required");
             }
-            auto m = ptype->reftype->methods.find(arrowmethod->name.text);
+            auto m = ptype->reftype->methods.find(arrowmethod->name.text());
             if (m == ptype->reftype->methods.end()) {
                 error(3220, arrowmethod->name, "method not found");
             }
@@ -2285,7 +2310,7 @@ const ast::Expression *Analyzer::analyze(const pt::FunctionCallExpression *expr)
         } else if (iptype != nullptr) {
             size_t i = 0;
             while (i < iptype->interface->methods.size()) {
-                if (arrowmethod->name.text == iptype->interface->methods[i].first.text) {
+                if (arrowmethod->name.text() == iptype->interface->methods[i].first.text()) {
                     break;
                 }
                 i++;
@@ -2306,7 +2331,7 @@ const ast::Expression *Analyzer::analyze(const pt::FunctionCallExpression *expr)
     if (recordtype != nullptr) {
         std::vector<const ast::Expression *> elements(recordtype->fields.size());
         for (auto &x: expr->args) {
-            if (x->name.text.empty()) {
+            if (x->name.text().empty()) {
                 error(3208, x->expr->token, "field name must be specified using WITH");
             }
             auto f = recordtype->fields.begin();
@@ -2314,7 +2339,7 @@ const ast::Expression *Analyzer::analyze(const pt::FunctionCallExpression *expr)
                 if (f == recordtype->fields.end()) {
                     error(3209, x->name, "field name not found");
                 }
-                if (x->name.text == f->name.text) {
+                if (x->name.text() == f->name.text()) {
                     break;
                 }
                 ++f;
@@ -2389,7 +2414,7 @@ const ast::Expression *Analyzer::analyze(const pt::FunctionCallExpression *expr)
             error(3096, a->expr->token, "too many parameters");
         }
         int p;
-        if (param_index >= 0 && a->name.text.empty()) {
+        if (param_index >= 0 && a->name.text().empty()) {
             if (in_varargs) {
                 p = param_index;
             } else {
@@ -2399,12 +2424,12 @@ const ast::Expression *Analyzer::analyze(const pt::FunctionCallExpression *expr)
         } else {
             // Now in named argument mode.
             param_index = -1;
-            if (a->name.text.empty()) {
+            if (a->name.text().empty()) {
                 error(3145, a->expr->token, "parameter name must be specified");
             }
             auto fp = ftype->params.begin();
             for (;;) {
-                if (a->name.text == (*fp)->declaration.text) {
+                if (a->name.text() == (*fp)->declaration.text()) {
                     break;
                 }
                 ++fp;
@@ -2487,14 +2512,51 @@ const ast::Expression *Analyzer::analyze(const pt::FunctionCallExpression *expr)
             if (ftype->params[p]->default_value != nullptr) {
                 args[p] = ftype->params[p]->default_value;
             } else {
-                error(3020, expr->rparen, "argument not specified for: " + ftype->params[p]->declaration.text);
+                error(3020, expr->rparen, "argument not specified for: " + ftype->params[p]->declaration.text());
             }
         }
         p++;
     }
+    if (self != nullptr && dynamic_cast<const ast::TypeArray *>(self->type) != nullptr) {
+        const ast::VariableExpression *ve = dynamic_cast<const ast::VariableExpression *>(func);
+        const ast::PredefinedFunction *pf = ve != nullptr ? dynamic_cast<const ast::PredefinedFunction *>(ve->var) : nullptr;
+        if (pf != nullptr && pf->name.compare(0, 15, "array__parallel") == 0) {
+            check_parallel_function(dotmethod->name, args[1]);
+        }
+    }
     return new ast::FunctionCall(func, args, dispatch, allow_ignore_result);
 }
 
+void Analyzer::check_parallel_function(const Token &token, const ast::Expression *expr)
+{
+    const ast::TypeConversionExpression *conv = dynamic_cast<const ast::TypeConversionExpression *>(expr);
+    const ast::VariableExpression *ve = dynamic_cast<const ast::VariableExpression *>(conv != nullptr ? conv->expr : expr);
+    const ast::Function *function = ve != nullptr ? dynamic_cast<const ast::Function *>(ve->var) : nullptr;
+    if (function == nullptr) {
+        error(3301, token, "function name expected for parallel call");
+    }
+    // The function (or one it calls) may be declared after this call, and
+    // its body not analyzed yet.
+    parallel_functions.push_back(std::make_pair(token, function));
+}
+
+void Analyzer::check_parallel_functions()
+{
+    // Each function is called in other executors, which share no variables
+    // with this one and do not run the main program's top level code.
+    for (auto &pf: parallel_functions) {
+        std::set<const ast::Function *> context;
+        if (not pf.second->is_pure(context)) {
+            error2(3302, pf.first, "pure function expected for parallel call", pf.second->declaration, "function declared here");
+        }
+        for (auto f: context) {
+            if (f->uses_outer_variables) {
+                error2(3303, pf.first, "function called in parallel must not use global variables", f->declaration, "function declared here");
+            }
+        }
+    }
+}
+
 const ast::Expression *Analyzer::analyze(const pt::UnaryPlusExpression *expr)
 {
     const ast::Expression *atom = analyze(expr->expr.get());
@@ -3141,7 +3203,7 @@ ast::Type *Analyzer::deserialize_type(ast::Scope *s, const std::string &descript
                 i++;
                 const ast::Type *type = deserialize_type(s, descriptor, i);
                 Token token;
-                token.text = name;
+                token.set_text(name);
                 fields.push_back(ast::TypeRecord::Field(token, type, is_private));
                 if (descriptor.at(i) == ',') {
                     i++;
@@ -3241,7 +3303,7 @@ ast::Type *Analyzer::deserialize_type(ast::Scope *s, const std::string &descript
                     i += j;
                 }
                 Token token;
-                token.text = name;
+                token.set_text(name);
                 params.push_back(new ast::ParameterType(token, mode, type, default_value));
                 if (descriptor.at(i) == ',') {
                     i++;
@@ -3349,21 +3411,21 @@ bool Analyzer::convert2(const ast::Type *target, const ast::Expression *&left, c
 const ast::Statement *Analyzer::analyze(const pt::ImportDeclaration *declaration)
 {
     if (declaration->alias.type == NONE && declaration->name.type == NONE) {
-        if (scope.top()->lookupName(declaration->module.text) != nullptr && modules.find(declaration->module.text) != modules.end()) {
+        if (scope.top()->lookupName(declaration->module.text()) != nullptr && modules.find(declaration->module.text()) != modules.end()) {
             return new ast::NullStatement(declaration->token);
         }
     }
     const Token &localname = declaration->alias.type != NONE ? declaration->alias : declaration->name.type != NONE ? declaration->name : declaration->module;
-    if (not scope.top()->allocateName(localname, localname.text)) {
-        error2(3114, localname, "duplicate definition of name", scope.top()->getDeclaration(localname.text), "first declaration here");
+    if (not scope.top()->allocateName(localname, localname.text())) {
+        error2(3114, localname, "duplicate definition of name", scope.top()->getDeclaration(localname.text()), "first declaration here");
     }
-    ast::Module *module = import_module(declaration->module, declaration->module.text, declaration->optional);
+    ast::Module *module = import_module(declaration->module, declaration->module.text(), declaration->optional);
     if (declaration->name.type == NONE) {
-        scope.top()->addName(declaration->token, localname.text, module);
+        scope.top()->addName(declaration->token, localname.text(), module);
     } else if (module != ast::MODULE_MISSING) {
-        const ast::Name *name = module->scope->lookupName(declaration->name.text);
+        const ast::Name *name = module->scope->lookupName(declaration->name.text());
         if (name != nullptr) {
-            scope.top()->addName(declaration->token, localname.text, module->scope->lookupName(declaration->name.text));
+            scope.top()->addName(declaration->token, localname.text(), module->scope->lookupName(declaration->name.text()));
         } else {
             error(3176, declaration->name, "name not found in module");
         }
@@ -3373,7 +3435,7 @@ const ast::Statement *Analyzer::analyze(const pt::ImportDeclaration *declaration
 
 const ast::Statement *Analyzer::analyze(const pt::TypeDeclaration *declaration)
 {
-    std::string name = declaration->token.text;
+    std::string name = declaration->token.text();
     if (not scope.top()->allocateName(declaration->token, name)) {
         error2(3013, declaration->token, "duplicate identifier", scope.top()->getDeclaration(name), "first declaration here");
     }
@@ -3420,16 +3482,16 @@ const ast::Statement *Analyzer::analyze(const pt::TypeDeclaration *declaration)
 
 const ast::Statement *Analyzer::analyze_decl(const pt::ConstantDeclaration *declaration)
 {
-    std::string name = declaration->name.text;
+    std::string name = declaration->name.text();
     if (not scope.top()->allocateName(declaration->name, name)) {
-        error2(3014, declaration->token, "duplicate identifier", scope.top()->getDeclaration(declaration->name.text), "first declaration here");
+        error2(3014, declaration->token, "duplicate identifier", scope.top()->getDeclaration(declaration->name.text()), "first declaration here");
     }
     return new ast::NullStatement(declaration->token);
 }
 
 const ast::Statement *Analyzer::analyze_body(const pt::ConstantDeclaration *declaration)
 {
-    std::string name = declaration->name.text;
+    std::string name = declaration->name.text();
     const ast::Type *type = nullptr;
     if (declaration->type != nullptr) {
         type = analyze(declaration->type.get(), AllowClass::no);
@@ -3456,7 +3518,7 @@ const ast::Statement *Analyzer::analyze_body(const pt::ConstantDeclaration *decl
     } else if (type == ast::TYPE_STRING) {
         value = new ast::ConstantStringExpression(value->eval_string(declaration->value->token));
     } else {
-        ast::Variable *v = new ast::GlobalVariable(declaration->name, declaration->name.text, type, true);
+        ast::Variable *v = new ast::GlobalVariable(declaration->name, declaration->name.text(), type, true);
         scope.top()->addName(v->declaration, v->name, v, true);
         return new ast::AssignmentStatement(declaration->token, {new ast::VariableExpression(v)}, value);
     }
@@ -3466,16 +3528,16 @@ const ast::Statement *Analyzer::analyze_body(const pt::ConstantDeclaration *decl
 
 const ast::Statement *Analyzer::analyze_decl(const pt::NativeConstantDeclaration *declaration)
 {
-    std::string name = declaration->name.text;
+    std::string name = declaration->name.text();
     if (not scope.top()->allocateName(declaration->name, name)) {
-        error2(3206, declaration->name, "duplicate identifier", scope.top()->getDeclaration(declaration->name.text), "first declaration here");
+        error2(3206, declaration->name, "duplicate identifier", scope.top()->getDeclaration(declaration->name.text()), "first declaration here");
     }
     return new ast::NullStatement(declaration->token);
 }
 
 const ast::Statement *Analyzer::analyze_body(const pt::NativeConstantDeclaration *declaration)
 {
-    std::string name = declaration->name.text;
+    std::string name = declaration->name.text();
     const ast::Type *type = analyze(declaration->type.get(), AllowClass::no);
     ast::Variable *v = frame.top()->createVariable(declaration->name, name, type, true);
     scope.top()->addName(v->declaration, v->name, v, true);
@@ -3498,9 +3560,9 @@ const ast::Statement *Analyzer::analyze_body(const pt::NativeConstantDeclaration
 
 const ast::Statement *Analyzer::analyze_decl(const pt::ExtensionConstantDeclaration *declaration)
 {
-    std::string name = declaration->name.text;
+    std::string name = declaration->name.text();
     if (not scope.top()->allocateName(declaration->name, name)) {
-        error2(3245, declaration->name, "duplicate identifier", scope.top()->getDeclaration(declaration->name.text), "first declaration here");
+        error2(3245, declaration->name, "duplicate identifier", scope.top()->getDeclaration(declaration->name.text()), "first declaration here");
     }
     return new ast::NullStatement(declaration->token);
 }
@@ -3508,7 +3570,7 @@ const ast::Statement *Analyzer::analyze_decl(const pt::ExtensionConstantDeclarat
 const ast::Statement *Analyzer::analyze_body(const pt::ExtensionConstantDeclaration *declaration)
 {
     const ast::Type *type = analyze(declaration->type.get(), AllowClass::no);
-    ast::Variable *v = frame.top()->createVariable(declaration->name, declaration->name.text, type, true);
+    ast::Variable *v = frame.top()->createVariable(declaration->name, declaration->name.text(), type, true);
     scope.top()->addName(v->declaration, v->name, v, true);
     return new ast::AssignmentStatement(
         declaration->token,
@@ -3520,7 +3582,7 @@ const ast::Statement *Analyzer::analyze_body(const pt::ExtensionConstantDeclarat
                 new ast::ExtensionFunction(
                     Token(),
                     path_stripext(path_basename(program->source_path)),
-                    declaration->name.text,
+                    declaration->name.text(),
                     new ast::TypeFunction(type, {}, false)
                 )
             ),
@@ -3532,8 +3594,8 @@ const ast::Statement *Analyzer::analyze_body(const pt::ExtensionConstantDeclarat
 const ast::Statement *Analyzer::analyze_decl(const pt::VariableDeclaration *declaration)
 {
     for (auto name: declaration->names) {
-        if (not scope.top()->allocateName(name, name.text)) {
-            error2(3038, name, "duplicate identifier", scope.top()->getDeclaration(name.text), "first declaration here");
+        if (not scope.top()->allocateName(name, name.text())) {
+            error2(3038, name, "duplicate identifier", scope.top()->getDeclaration(name.text()), "first declaration here");
         }
     }
     return new ast::NullStatement(declaration->token);
@@ -3566,7 +3628,7 @@ const ast::Statement *Analyzer::analyze_body(const pt::VariableDeclaration *decl
     }
     std::vector<ast::Variable *> variables;
     for (auto name: declaration->names) {
-        ast::Variable *v = frame.top()->createVariable(name, name.text, type, false);
+        ast::Variable *v = frame.top()->createVariable(name, name.text(), type, false);
         variables.push_back(v);
     }
     for (auto v: variables) {
@@ -3587,24 +3649,24 @@ const ast::Statement *Analyzer::analyze_body(const pt::VariableDeclaration *decl
 
 const ast::Statement *Analyzer::analyze_decl(const pt::NativeVariableDeclaration *declaration)
 {
-    std::string name = declaration->name.text;
+    std::string name = declaration->name.text();
     if (not scope.top()->allocateName(declaration->name, name)) {
-        error2(3225, declaration->name, "duplicate identifier", scope.top()->getDeclaration(declaration->name.text), "first declaration here");
+        error2(3225, declaration->name, "duplicate identifier", scope.top()->getDeclaration(declaration->name.text()), "first declaration here");
     }
     return new ast::NullStatement(declaration->token);
 }
 
 const ast::Statement *Analyzer::analyze_body(const pt::NativeVariableDeclaration *declaration)
 {
-    //std::string name = declaration->name.text;
+    //std::string name = declaration->name.text();
     //scope.top()->addName(declaration->name, name, new Constant(declaration->name, name, get_native_constant_value(module_name + "$" + name)));
     return new ast::NullStatement(declaration->token);
 }
 
 const ast::Statement *Analyzer::analyze_decl(const pt::LetDeclaration *declaration)
 {
-    if (not scope.top()->allocateName(declaration->name, declaration->name.text)) {
-        error2(3139, declaration->name, "duplicate identifier", scope.top()->getDeclaration(declaration->name.text), "first declaration here");
+    if (not scope.top()->allocateName(declaration->name, declaration->name.text())) {
+        error2(3139, declaration->name, "duplicate identifier", scope.top()->getDeclaration(declaration->name.text()), "first declaration here");
     }
     return new ast::NullStatement(declaration->token);
 }
@@ -3631,7 +3693,7 @@ const ast::Statement *Analyzer::analyze_body(const pt::LetDeclaration *declarati
     if (ptype != nullptr && dynamic_cast<const ast::NewClassExpression *>(expr) != nullptr) {
         type = new ast::TypeValidPointer(Token(), ptype->reftype);
     }
-    ast::Variable *v = frame.top()->createVariable(declaration->name, declaration->name.text, type, true);
+    ast::Variable *v = frame.top()->createVariable(declaration->name, declaration->name.text(), type, true);
     scope.top()->addName(v->declaration, v->name, v, true);
     std::vector<const ast::ReferenceExpression *> refs;
     refs.push_back(new ast::VariableExpression(v));
@@ -3640,7 +3702,7 @@ const ast::Statement *Analyzer::analyze_body(const pt::LetDeclaration *declarati
 
 const ast::Statement *Analyzer::analyze_decl(const pt::FunctionDeclaration *declaration)
 {
-    const std::string classtype = declaration->type.text;
+    const std::string classtype = declaration->type.text();
     ast::Type *type = nullptr;
     if (not classtype.empty()) {
         ast::Name *tname = scope.top()->lookupName(classtype);
@@ -3657,7 +3719,7 @@ const ast::Statement *Analyzer::analyze_decl(const pt::FunctionDeclaration *decl
             error2(3138, declaration->type, "type name is not a type", tname->declaration, "declaration here");
         }
     }
-    std::string name = declaration->name.text;
+    std::string name = declaration->name.text();
     if (type == nullptr && not scope.top()->allocateName(declaration->name, name)) {
         error2(3047, declaration->name, "duplicate definition of name", scope.top()->getDeclaration(name), "first declaration here");
     }
@@ -3721,10 +3783,10 @@ const ast::Statement *Analyzer::analyze_decl(const pt::FunctionDeclaration *decl
             error(3150, x->token, "default value must be specified for this parameter");
         }
         for (auto argname: x->names) {
-            if (scope.top()->lookupName(argname.text)) {
+            if (scope.top()->lookupName(argname.text())) {
                 error(3174, argname, "duplicate identifier");
             }
-            ast::FunctionParameter *fp = new ast::FunctionParameter(argname, argname.text, ptype, frame.top()->get_depth()+1, mode, def);
+            ast::FunctionParameter *fp = new ast::FunctionParameter(argname, argname.text(), ptype, frame.top()->get_depth()+1, mode, def);
             args.push_back(fp);
         }
     }
@@ -3736,7 +3798,7 @@ const ast::Statement *Analyzer::analyze_decl(const pt::FunctionDeclaration *decl
         if (ctype != nullptr) {
             for (auto i: ctype->interfaces) {
                 for (auto m: i->methods) {
-                    if (name == m.first.text) {
+                    if (name == m.first.text()) {
                         if (declaration->args.size() != m.second->params.size()) {
                             error(3255, declaration->rparen, "wrong number of arguments");
                         }
@@ -3792,7 +3854,7 @@ const ast::Statement *Analyzer::analyze_decl(const pt::FunctionDeclaration *decl
 
 const ast::Statement *Analyzer::analyze_body(const pt::FunctionDeclaration *declaration)
 {
-    const std::string classtype = declaration->type.text;
+    const std::string classtype = declaration->type.text();
     ast::Type *type = nullptr;
     if (not classtype.empty()) {
         ast::Name *tname = scope.top()->lookupName(classtype);
@@ -3806,14 +3868,14 @@ const ast::Statement *Analyzer::analyze_body(const pt::FunctionDeclaration *decl
     }
     ast::Function *function;
     if (type != nullptr) {
-        auto f = type->methods.find(declaration->name.text);
+        auto f = type->methods.find(declaration->name.text());
         function = dynamic_cast<ast::Function *>(f->second);
     } else {
-        function = dynamic_cast<ast::Function *>(scope.top()->lookupName(declaration->name.text));
+        function = dynamic_cast<ast::Function *>(scope.top()->lookupName(declaration->name.text()));
     }
     for (auto &x: declaration->args) {
         for (auto name: x->names) {
-            Token decl = scope.top()->getDeclaration(name.text);
+            Token decl = scope.top()->getDeclaration(name.text());
             if (decl.type != NONE) {
                 error2(3179, name, "duplicate identifier", decl, "first declaration here");
             }
@@ -3822,6 +3884,7 @@ const ast::Statement *Analyzer::analyze_body(const pt::FunctionDeclaration *decl
     frame.push(function->frame);
     scope.push(function->scope);
     functiontypes.push(std::make_pair(type, dynamic_cast<const ast::TypeFunction *>(function->type)));
+    functions.push(function);
     loops.push(std::list<std::pair<std::string, unsigned int>>());
     function->statements = analyze(declaration->body);
     const ast::Type *returntype = dynamic_cast<const ast::TypeFunction *>(function->type)->returntype;
@@ -3831,6 +3894,7 @@ const ast::Statement *Analyzer::analyze_body(const pt::FunctionDeclaration *decl
         }
     }
     loops.pop();
+    functions.pop();
     functiontypes.pop();
     scope.top()->checkForward();
     scope.pop();
@@ -3840,7 +3904,7 @@ const ast::Statement *Analyzer::analyze_body(const pt::FunctionDeclaration *decl
 
 const ast::Statement *Analyzer::analyze(const pt::NativeFunctionDeclaration *declaration)
 {
-    std::string name = declaration->name.text;
+    std::string name = declaration->name.text();
     if (not scope.top()->allocateName(declaration->name, name)) {
         error2(3166, declaration->name, "duplicate identifier", scope.top()->getDeclaration(name), "first declaration here");
     }
@@ -3852,7 +3916,7 @@ const ast::Statement *Analyzer::analyze(const pt::NativeFunctionDeclaration *dec
 
 const ast::Statement *Analyzer::analyze(const pt::ExtensionFunctionDeclaration *declaration)
 {
-    std::string name = declaration->name.text;
+    std::string name = declaration->name.text();
     if (not scope.top()->allocateName(declaration->name, name)) {
         error2(3242, declaration->name, "duplicate identifier", scope.top()->getDeclaration(name), "first declaration here");
     }
@@ -3864,7 +3928,7 @@ const ast::Statement *Analyzer::analyze(const pt::ExtensionFunctionDeclaration *
 
 const ast::Statement *Analyzer::analyze(const pt::ExceptionDeclaration *declaration)
 {
-    std::string name = declaration->name[0].text;
+    std::string name = declaration->name[0].text();
     if (declaration->name.size() == 1) {
         if (not scope.top()->allocateName(declaration->token, name)) {
             error2(3115, declaration->token, "duplicate definition of name", scope.top()->getDeclaration(name), "first declaration here");
@@ -3885,19 +3949,19 @@ const ast::Statement *Analyzer::analyze(const pt::ExceptionDeclaration *declarat
         std::string fullname = name;
         ast::Exception *s = e;
         for (size_t i = 1; i < declaration->name.size()-1; i++) {
-            auto t = s->subexceptions.find(declaration->name[i].text);
+            auto t = s->subexceptions.find(declaration->name[i].text());
             if (t == s->subexceptions.end()) {
                 error(3237, declaration->name[i], "subexception not found");
             }
-            fullname += "." + declaration->name[i].text;
+            fullname += "." + declaration->name[i].text();
             s = t->second;
         }
-        std::string lastname = declaration->name[declaration->name.size()-1].text;
+        std::string lastname = declaration->name[declaration->name.size()-1].text();
         auto t = s->subexceptions.find(lastname);
         if (t != s->subexceptions.end()) {
             error(3238, declaration->name[declaration->name.size()-1], "subexception already declared");
         }
-        fullname += "." + declaration->name[declaration->name.size()-1].text;
+        fullname += "." + declaration->name[declaration->name.size()-1].text();
         ast::Exception *se = new ast::Exception(declaration->token, fullname);
         s->subexceptions[lastname] = se;
     }
@@ -3906,7 +3970,7 @@ const ast::Statement *Analyzer::analyze(const pt::ExceptionDeclaration *declarat
 
 const ast::Statement *Analyzer::analyze(const pt::InterfaceDeclaration *declaration)
 {
-    std::string name = declaration->names[0].text;
+    std::string name = declaration->names[0].text();
     if (not scope.top()->allocateName(declaration->token, name)) {
         error2(3251, declaration->token, "duplicate definition of name", scope.top()->getDeclaration(name), "first declaration here");
     }
@@ -3915,10 +3979,10 @@ const ast::Statement *Analyzer::analyze(const pt::InterfaceDeclaration *declarat
     std::vector<std::pair<Token, const ast::TypeFunction *>> methods;
     std::map<std::string, Token> method_names;
     for (auto &x: declaration->methods) {
-        std::string methodname = x.first.text;
+        std::string methodname = x.first.text();
         auto prev = method_names.find(methodname);
         if (prev != method_names.end()) {
-            error2(3247, x.first, "duplicate method: " + x.first.text, prev->second, "first declaration here");
+            error2(3247, x.first, "duplicate method: " + x.first.text(), prev->second, "first declaration here");
         }
         const ast::Type *t = analyze(x.second.get(), AllowClass::no);
         const ast::TypeFunctionPointer *fp = dynamic_cast<const ast::TypeFunctionPointer *>(t);
@@ -3955,10 +4019,10 @@ const ast::Statement *Analyzer::analyze_decl(const pt::ExportDeclaration *declar
 const ast::Statement *Analyzer::analyze_body(const pt::ExportDeclaration *declaration)
 {
     for (auto &name: declaration->names) {
-        if (scope.top()->getDeclaration(name.text).type == NONE) {
+        if (scope.top()->getDeclaration(name.text()).type == NONE) {
             error(3152, name, "export name not declared");
         }
-        exports[name.text] = name;
+        exports[name.text()] = name;
     }
     if (declaration->declaration != nullptr) {
         std::vector<const ast::Statement *> statements;
@@ -4125,13 +4189,13 @@ const ast::Statement *Analyzer::analyze(const pt::AssertStatement *statement)
         const Token &end = part->get_end_token();
         std::string str;
         if (start.line == end.line) {
-            str = start.source_line().substr(start.column-1, end.column + end.text.length() - start.column);
+            str = start.source_line().substr(start.column-1, end.column + end.text().length() - start.column);
         } else {
             str = start.source_line().substr(start.column-1);
             for (int line = start.line + 1; line < end.line; line++) {
                 str += start.source->source_line(line);
             }
-            str += end.source_line().substr(0, end.column + end.text.length());
+            str += end.source_line().substr(0, end.column + end.text().length());
         }
         if (seen.find(str) != seen.end()) {
             continue;
@@ -4529,8 +4593,8 @@ const ast::Statement *Analyzer::analyze(const pt::CheckStatement *statement)
     const pt::ValidPointerExpression *valid = dynamic_cast<const pt::ValidPointerExpression *>(statement->cond.get());
     if (valid != nullptr) {
         for (auto &v: valid->tests) {
-            if (not v->shorthand and scope.top()->lookupName(v->name.text) != nullptr) {
-                error2(3274, v->name, "duplicate identifier", scope.top()->getDeclaration(v->name.text), "first declaration here");
+            if (not v->shorthand and scope.top()->lookupName(v->name.text()) != nullptr) {
+                error2(3274, v->name, "duplicate identifier", scope.top()->getDeclaration(v->name.text()), "first declaration here");
             }
             const ast::Expression *ptr = analyze(v->expr.get());
             const ast::TypePointer *ptrtype = dynamic_cast<const ast::TypePointer *>(ptr->type);
@@ -4541,12 +4605,12 @@ const ast::Statement *Analyzer::analyze(const pt::CheckStatement *statement)
             ast::Variable *var;
             // TODO: Try to make this a local variable always (give the global scope a local space).
             if (functiontypes.empty()) {
-                var = new ast::GlobalVariable(v->name, v->name.text, vtype, true);
+                var = new ast::GlobalVariable(v->name, v->name.text(), vtype, true);
             } else {
                 // TODO: probably use frame.top()->get_depth() (add IF VALID to repl tests)
-                var = new ast::LocalVariable(v->name, v->name.text, vtype, frame.size()-1, true);
+                var = new ast::LocalVariable(v->name, v->name.text(), vtype, frame.size()-1, true);
             }
-            scope.top()->parent->replaceName(v->name, v->name.text, var);
+            scope.top()->parent->replaceName(v->name, v->name.text(), var);
             const ast::Expression *ve = new ast::ValidPointerExpression(var, ptr);
             if (cond == nullptr) {
                 cond = ve;
@@ -4607,7 +4671,7 @@ void Analyzer::process_into_results(const pt::ExecStatement *statement, const st
     }
     std::vector<const ast::VariableExpression *> out_bindings;
     for (auto name: statement->info->assignments) {
-        const ast::Variable *var = dynamic_cast<const ast::Variable *>(scope.top()->lookupName(name.text));
+        const ast::Variable *var = dynamic_cast<const ast::Variable *>(scope.top()->lookupName(name.text()));
         if (var == nullptr) {
             error(4306, name, "variable not found");
         }
@@ -4754,10 +4818,10 @@ void Analyzer::process_into_results(const pt::ExecStatement *statement, const st
         case SqlWheneverActionType::DoRaiseException: {
             auto &info = scope.top()->sql_whenever[NotFound].info;
             Token token = info[0];
-            const ast::Exception *exception = dynamic_cast<const ast::Exception *>(scope.top()->lookupName(info[0].text));
+            const ast::Exception *exception = dynamic_cast<const ast::Exception *>(scope.top()->lookupName(info[0].text()));
             if (exception != nullptr) {
                 for (size_t i = 1; i < info.size(); i++) {
-                    auto s = exception->subexceptions.find(info[i].text);
+                    auto s = exception->subexceptions.find(info[i].text());
                     if (s == exception->subexceptions.end()) {
                         token = info[i];
                         exception = nullptr;
@@ -4837,8 +4901,8 @@ const ast::Statement *Analyzer::analyze(const pt::ExecStatement *statement)
         if (target_literal != nullptr) {
             target = new ast::ConstantStringExpression(utf8string(target_literal->value));
         } else if (target_variable != nullptr) {
-            const ast::Variable *var = dynamic_cast<ast::Variable *>(scope.top()->lookupName(target_variable->variable.text));
-            const ast::Constant *constant = dynamic_cast<ast::Constant *>(scope.top()->lookupName(target_variable->variable.text));
+            const ast::Variable *var = dynamic_cast<ast::Variable *>(scope.top()->lookupName(target_variable->variable.text()));
+            const ast::Constant *constant = dynamic_cast<ast::Constant *>(scope.top()->lookupName(target_variable->variable.text()));
             if (var != nullptr) {
                 target = new ast::VariableExpression(var);
             } else if (constant != nullptr) {
@@ -4854,7 +4918,7 @@ const ast::Statement *Analyzer::analyze(const pt::ExecStatement *statement)
         if (name_symbol != nullptr) {
             internal_error("todo");
         } else if (name_variable != nullptr) {
-            const ast::Variable *name = dynamic_cast<const ast::Variable *>(scope.top()->lookupName(name_variable->variable.text));
+            const ast::Variable *name = dynamic_cast<const ast::Variable *>(scope.top()->lookupName(name_variable->variable.text()));
             if (name == nullptr) {
                 error(4304, name_variable->variable, "variable not found");
             }
@@ -4904,7 +4968,7 @@ const ast::Statement *Analyzer::analyze(const pt::ExecStatement *statement)
         if (name_symbol != nullptr) {
             internal_error("todo");
         } else if (name_variable != nullptr) {
-            const ast::Variable *name = dynamic_cast<const ast::Variable *>(scope.top()->lookupName(name_variable->variable.text));
+            const ast::Variable *name = dynamic_cast<const ast::Variable *>(scope.top()->lookupName(name_variable->variable.text()));
             statements.push_back(new ast::ExpressionStatement(
                 statement->token,
                 new ast::FunctionCall(
@@ -4935,7 +4999,7 @@ const ast::Statement *Analyzer::analyze(const pt::ExecStatement *statement)
         if (statement_literal != nullptr) {
             sqlstatement = new ast::ConstantStringExpression(utf8string(statement_literal->value));
         } else if (statement_variable != nullptr) {
-            const ast::Variable *var = dynamic_cast<ast::Variable *>(scope.top()->lookupName(statement_variable->variable.text));
+            const ast::Variable *var = dynamic_cast<ast::Variable *>(scope.top()->lookupName(statement_variable->variable.text()));
             if (var == nullptr) {
                 error(4303, statement_variable->variable, "variable not found");
             }
@@ -4979,15 +5043,15 @@ const ast::Statement *Analyzer::analyze(const pt::ExecStatement *statement)
     } else if (query != nullptr) {
         std::vector<std::pair<utf8string, const ast::Expression *>> binding_vars;
         for (auto p: statement->info->parameters) {
-            const ast::Variable *var = dynamic_cast<const ast::Variable *>(scope.top()->lookupName(p.text.substr(1)));
+            const ast::Variable *var = dynamic_cast<const ast::Variable *>(scope.top()->lookupName(p.text().substr(1)));
             if (var == nullptr) {
                 error(4305, p, "variable not found");
             }
             // TODO: Call toString() on the parameter to convert it into a string.
             if (var->type != ast::TYPE_STRING) {
-                error(4308, p, "query parameter "+p.text+" must be of type String (current implementation limitation)");
+                error(4308, p, "query parameter "+p.text()+" must be of type String (current implementation limitation)");
             }
-            binding_vars.push_back(std::make_pair(utf8string(p.text), new ast::VariableExpression(var)));
+            binding_vars.push_back(std::make_pair(utf8string(p.text()), new ast::VariableExpression(var)));
         }
         process_into_results(
             statement,
@@ -5018,7 +5082,7 @@ const ast::Statement *Analyzer::analyze(const pt::ExitStatement *statement)
         }
         return new ast::ReturnStatement(statement->token, nullptr);
     }
-    std::string type = statement->type.text;
+    std::string type = statement->type.text();
     if (not loops.empty()) {
         for (auto j = loops.top().rbegin(); j != loops.top().rend(); ++j) {
             if (j->first == type) {
@@ -5048,10 +5112,10 @@ const ast::Statement *Analyzer::analyze(const pt::ForStatement *statement)
 {
     scope.push(new ast::Scope(scope.top(), frame.top()));
     Token name = statement->var;
-    if (scope.top()->lookupName(name.text) != nullptr) {
-        error2(3118, name, "duplicate identifier", scope.top()->getDeclaration(name.text), "first declaration here");
+    if (scope.top()->lookupName(name.text()) != nullptr) {
+        error2(3118, name, "duplicate identifier", scope.top()->getDeclaration(name.text()), "first declaration here");
     }
-    ast::Variable *var = frame.top()->createVariable(name, name.text, ast::TYPE_NUMBER, false);
+    ast::Variable *var = frame.top()->createVariable(name, name.text(), ast::TYPE_NUMBER, false);
     scope.top()->addName(var->declaration, var->name, var, true);
     var->is_readonly = true;
     ast::Variable *bound = scope.top()->makeTemporary(ast::TYPE_NUMBER);
@@ -5083,13 +5147,13 @@ const ast::Statement *Analyzer::analyze(const pt::ForStatement *statement)
     // TODO: make loop_id a void*
     unsigned int loop_id = static_cast<unsigned int>(reinterpret_cast<intptr_t>(statement));
     if (statement->label.type == IDENTIFIER) {
-        Token label = scope.top()->getDeclaration(statement->label.text);
+        Token label = scope.top()->getDeclaration(statement->label.text());
         if (label.type != NONE) {
             error2(3213, statement->label, "loop label already defined", label, "declaration here");
         }
-        scope.top()->addName(statement->label, statement->label.text, new ast::LoopLabel(statement->label));
+        scope.top()->addName(statement->label, statement->label.text(), new ast::LoopLabel(statement->label));
     }
-    loops.top().push_back(std::make_pair(statement->label.text, loop_id));
+    loops.top().push_back(std::make_pair(statement->label.text(), loop_id));
     std::vector<const ast::ReferenceExpression *> vars { new ast::VariableExpression(var) };
     std::vector<const ast::Statement *> init_statements {
         new ast::AssignmentStatement(statement->token, vars, start),
@@ -5119,15 +5183,15 @@ const ast::Statement *Analyzer::analyze(const pt::ForStatement *statement)
     scope.pop();
     loops.top().pop_back();
     var->is_readonly = false;
-    return new ast::BaseLoopStatement(statement->token, loop_id, init_statements, statements, tail_statements, false);
+    return new ast::ForStatement(statement->token, loop_id, var, bound, step->eval_number(statement->step ? statement->step->token : Token()), init_statements, statements, body, tail_statements);
 }
 
 const ast::Statement *Analyzer::analyze(const pt::ForeachStatement *statement)
 {
     scope.push(new ast::Scope(scope.top(), frame.top()));
     Token var_name = statement->var;
-    if (scope.top()->lookupName(var_name.text) != nullptr) {
-        error2(3169, var_name, "duplicate identifier", scope.top()->getDeclaration(var_name.text), "first declaration here");
+    if (scope.top()->lookupName(var_name.text()) != nullptr) {
+        error2(3169, var_name, "duplicate identifier", scope.top()->getDeclaration(var_name.text()), "first declaration here");
     }
     const ast::Expression *array = analyze(statement->array.get());
     const ast::TypeArray *arrtype = dynamic_cast<const ast::TypeArray *>(array->type);
@@ -5159,17 +5223,17 @@ const ast::Statement *Analyzer::analyze(const pt::ForeachStatement *statement)
     }
     ast::Variable *array_copy = scope.top()->makeTemporary(atype);
 
-    ast::Variable *var = frame.top()->createVariable(var_name, var_name.text, elementtype, false);
+    ast::Variable *var = frame.top()->createVariable(var_name, var_name.text(), elementtype, false);
     scope.top()->addName(var->declaration, var->name, var, true);
     var->is_readonly = true;
 
     Token index_name = statement->index;
     ast::Variable *index;
     if (index_name.type == IDENTIFIER) {
-        if (scope.top()->lookupName(index_name.text) != nullptr) {
-            error2(3171, index_name, "duplicate identifier", scope.top()->getDeclaration(index_name.text), "first declaration here");
+        if (scope.top()->lookupName(index_name.text()) != nullptr) {
+            error2(3171, index_name, "duplicate identifier", scope.top()->getDeclaration(index_name.text()), "first declaration here");
         }
-        index = frame.top()->createVariable(index_name, index_name.text, ast::TYPE_NUMBER, false);
+        index = frame.top()->createVariable(index_name, index_name.text(), ast::TYPE_NUMBER, false);
         scope.top()->addName(index->declaration, index->name, index, true);
     } else {
         index = scope.top()->makeTemporary(ast::TYPE_NUMBER);
@@ -5180,13 +5244,13 @@ const ast::Statement *Analyzer::analyze(const pt::ForeachStatement *statement)
     // TODO: make loop_id a void*
     unsigned int loop_id = static_cast<unsigned int>(reinterpret_cast<intptr_t>(statement));
     if (statement->label.type == IDENTIFIER) {
-        Token label = scope.top()->getDeclaration(statement->label.text);
+        Token label = scope.top()->getDeclaration(statement->label.text());
         if (label.type != NONE) {
             error2(3214, statement->label, "loop label already defined", label, "declaration here");
         }
-        scope.top()->addName(statement->label, statement->label.text, new ast::LoopLabel(statement->label));
+        scope.top()->addName(statement->label, statement->label.text(), new ast::LoopLabel(statement->label));
     }
-    loops.top().push_back(std::make_pair(statement->label.text, loop_id));
+    loops.top().push_back(std::make_pair(statement->label.text(), loop_id));
     std::vector<const ast::Statement *> init_statements {
         new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(index) }, new ast::ConstantNumberExpression(number_from_uint32(0))),
         new ast::AssignmentStatement(statement->token, { new ast::VariableExpression(array_copy) }, array),
@@ -5236,8 +5300,8 @@ const ast::Statement *Analyzer::analyze(const pt::IfStatement *statement)
         const pt::ImportedModuleExpression *imported = dynamic_cast<const pt::ImportedModuleExpression *>(c.first.get());
         if (valid != nullptr) {
             for (auto &v: valid->tests) {
-                if (not v->shorthand and scope.top()->lookupName(v->name.text) != nullptr) {
-                    error2(3102, v->name, "duplicate identifier", scope.top()->getDeclaration(v->name.text), "first declaration here");
+                if (not v->shorthand and scope.top()->lookupName(v->name.text()) != nullptr) {
+                    error2(3102, v->name, "duplicate identifier", scope.top()->getDeclaration(v->name.text()), "first declaration here");
                 }
                 const ast::Expression *ptr = analyze(v->expr.get());
                 const ast::TypePointer *ptrtype = dynamic_cast<const ast::TypePointer *>(ptr->type);
@@ -5248,12 +5312,12 @@ const ast::Statement *Analyzer::analyze(const pt::IfStatement *statement)
                 ast::Variable *var;
                 // TODO: Try to make this a local variable always (give the global scope a local space).
                 if (functiontypes.empty()) {
-                    var = new ast::GlobalVariable(v->name, v->name.text, vtype, true);
+                    var = new ast::GlobalVariable(v->name, v->name.text(), vtype, true);
                 } else {
                     // TODO: probably use frame.top()->get_depth() (add IF VALID to repl tests)
-                    var = new ast::LocalVariable(v->name, v->name.text, vtype, frame.size()-1, true);
+                    var = new ast::LocalVariable(v->name, v->name.text(), vtype, frame.size()-1, true);
                 }
-                scope.top()->addName(v->name, v->name.text, var, true, v->shorthand);
+                scope.top()->addName(v->name, v->name.text(), var, true, v->shorthand);
                 const ast::Expression *ve = new ast::ValidPointerExpression(var, ptr);
                 if (cond == nullptr) {
                     cond = ve;
@@ -5262,7 +5326,7 @@ const ast::Statement *Analyzer::analyze(const pt::IfStatement *statement)
                 }
             }
         } else if (imported != nullptr) {
-            const ast::Name *name = scope.top()->lookupName(imported->module.text);
+            const ast::Name *name = scope.top()->lookupName(imported->module.text());
             if (name == nullptr) {
                 error(3279, imported->module, "unknown identifier");
             }
@@ -5277,14 +5341,14 @@ const ast::Statement *Analyzer::analyze(const pt::IfStatement *statement)
                 }
                 cond = new ast::FunctionCall(
                     new ast::VariableExpression(dynamic_cast<const ast::PredefinedFunction *>(runtime->scope->lookupName("isModuleImported"))),
-                    { new ast::ConstantStringExpression(utf8string(imported->module.text)) }
+                    { new ast::ConstantStringExpression(utf8string(imported->module.text())) }
                 );
                 if (imported_checked_stack.empty()) {
                     imported_checked_stack.push({});
                 } else {
                     imported_checked_stack.push(imported_checked_stack.top());
                 }
-                imported_checked_stack.top().insert(imported->module.text);
+                imported_checked_stack.top().insert(imported->module.text());
                 imported_checked = true;
             } else {
                 cond = new ast::ConstantBooleanExpression(false);
@@ -5332,13 +5396,13 @@ const ast::Statement *Analyzer::analyze(const pt::LoopStatement *statement)
     scope.push(new ast::Scope(scope.top(), frame.top()));
     unsigned int loop_id = static_cast<unsigned int>(reinterpret_cast<intptr_t>(statement));
     if (statement->label.type == IDENTIFIER) {
-        Token label = scope.top()->getDeclaration(statement->label.text);
+        Token label = scope.top()->getDeclaration(statement->label.text());
         if (label.type != NONE) {
             error2(3215, statement->label, "loop label already defined", label, "declaration here");
         }
-        scope.top()->addName(statement->label, statement->label.text, new ast::LoopLabel(statement->label));
+        scope.top()->addName(statement->label, statement->label.text(), new ast::LoopLabel(statement->label));
     }
-    loops.top().push_back(std::make_pair(statement->label.text, loop_id));
+    loops.top().push_back(std::make_pair(statement->label.text(), loop_id));
     std::vector<const ast::Statement *> statements = analyze(statement->body);
     scope.pop();
     loops.top().pop_back();
@@ -5347,7 +5411,7 @@ const ast::Statement *Analyzer::analyze(const pt::LoopStatement *statement)
 
 const ast::Statement *Analyzer::analyze(const pt::NextStatement *statement)
 {
-    std::string type = statement->type.text;
+    std::string type = statement->type.text();
     if (not loops.empty()) {
         for (auto j = loops.top().rbegin(); j != loops.top().rend(); ++j) {
             if (j->first == type) {
@@ -5362,15 +5426,15 @@ const ast::Statement *Analyzer::analyze(const pt::RaiseStatement *statement)
 {
     ast::Scope *s = scope.top();
     size_t i = 0;
-    const ast::Name *modname = scope.top()->lookupName(statement->name[i].text);
+    const ast::Name *modname = scope.top()->lookupName(statement->name[i].text());
     const ast::Module *mod = dynamic_cast<const ast::Module *>(modname);
     if (mod != nullptr) {
         s = mod->scope;
         i++;
     }
-    const ast::Name *name = s->lookupName(statement->name[i].text);
+    const ast::Name *name = s->lookupName(statement->name[i].text());
     if (name == nullptr) {
-        error(3089, statement->name[i], "exception not found: " + statement->name[i].text);
+        error(3089, statement->name[i], "exception not found: " + statement->name[i].text());
     }
     const ast::Exception *exception = dynamic_cast<const ast::Exception *>(name);
     if (exception == nullptr) {
@@ -5379,7 +5443,7 @@ const ast::Statement *Analyzer::analyze(const pt::RaiseStatement *statement)
     i++;
     const ast::Exception *sn = exception;
     while (i < statement->name.size()) {
-        auto t = sn->subexceptions.find(statement->name[i].text);
+        auto t = sn->subexceptions.find(statement->name[i].text());
         if (t == sn->subexceptions.end()) {
             error(3239, statement->name[i], "exception subexception not found");
         }
@@ -5400,13 +5464,13 @@ const ast::Statement *Analyzer::analyze(const pt::RepeatStatement *statement)
     scope.push(new ast::Scope(scope.top(), frame.top()));
     unsigned int loop_id = static_cast<unsigned int>(reinterpret_cast<intptr_t>(statement));
     if (statement->label.type == IDENTIFIER) {
-        Token label = scope.top()->getDeclaration(statement->label.text);
+        Token label = scope.top()->getDeclaration(statement->label.text());
         if (label.type != NONE) {
             error2(3216, statement->label, "loop label already defined", label, "declaration here");
         }
-        scope.top()->addName(statement->label, statement->label.text, new ast::LoopLabel(statement->label));
+        scope.top()->addName(statement->label, statement->label.text(), new ast::LoopLabel(statement->label));
     }
-    loops.top().push_back(std::make_pair(statement->label.text, loop_id));
+    loops.top().push_back(std::make_pair(statement->label.text(), loop_id));
     std::vector<const ast::Statement *> statements = analyze(statement->body);
     const ast::Expression *cond = analyze(statement->cond.get());
     cond = convert(ast::TYPE_BOOLEAN, cond);
@@ -5541,15 +5605,15 @@ const ast::Exception *Analyzer::resolve_exception(const std::vector<Token> &name
 {
     ast::Scope *s = scope.top();
     size_t i = 0;
-    const ast::Name *modname = scope.top()->lookupName(names[i].text);
+    const ast::Name *modname = scope.top()->lookupName(names[i].text());
     const ast::Module *mod = dynamic_cast<const ast::Module *>(modname);
     if (mod != nullptr) {
         s = mod->scope;
         i++;
     }
-    const ast::Name *name = s->lookupName(names[i].text);
+    const ast::Name *name = s->lookupName(names[i].text());
     if (name == nullptr) {
-        error(3087, names[i], "exception not found: " + names[i].text);
+        error(3087, names[i], "exception not found: " + names[i].text());
     }
     const ast::Exception *exception = dynamic_cast<const ast::Exception *>(name);
     if (exception == nullptr) {
@@ -5558,7 +5622,7 @@ const ast::Exception *Analyzer::resolve_exception(const std::vector<Token> &name
     i++;
     const ast::Exception *sn = exception;
     while (i < names.size()) {
-        auto t = sn->subexceptions.find(names[i].text);
+        auto t = sn->subexceptions.find(names[i].text());
         if (t == sn->subexceptions.end()) {
             error(3240, names[i], "exception subexception not found");
         }
@@ -5582,16 +5646,16 @@ std::vector<ast::TryTrap> Analyzer::analyze_catches(const std::vector<std::uniqu
             if (vtype == nullptr) {
                 internal_error("could not find ExceptionType");
             }
-            if (scope.top()->lookupName(x->name.text) != nullptr) {
-                error2(3276, x->name, "duplicate identifier", scope.top()->getDeclaration(x->name.text), "first declaration here");
+            if (scope.top()->lookupName(x->name.text()) != nullptr) {
+                error2(3276, x->name, "duplicate identifier", scope.top()->getDeclaration(x->name.text()), "first declaration here");
             }
             // TODO: Try to make this a local variable always (give the global scope a local space).
             if (functiontypes.empty()) {
-                var = new ast::GlobalVariable(x->name, x->name.text, vtype, true);
+                var = new ast::GlobalVariable(x->name, x->name.text(), vtype, true);
             } else {
-                var = new ast::LocalVariable(x->name, x->name.text, vtype, frame.size()-1, true);
+                var = new ast::LocalVariable(x->name, x->name.text(), vtype, frame.size()-1, true);
             }
-            scope.top()->addName(x->name, x->name.text, var, true);
+            scope.top()->addName(x->name, x->name.text(), var, true);
         }
         const pt::TryHandlerStatement *ths = dynamic_cast<const pt::TryHandlerStatement *>(x->handler.get());
         const pt::Expression *e = dynamic_cast<const pt::Expression *>(x->handler.get());
@@ -5640,8 +5704,8 @@ const ast::Statement *Analyzer::analyze(const pt::WhileStatement *statement)
     const pt::ValidPointerExpression *valid = dynamic_cast<const pt::ValidPointerExpression *>(statement->cond.get());
     if (valid != nullptr) {
         for (auto &v: valid->tests) {
-            if (not v->shorthand and scope.top()->lookupName(v->name.text) != nullptr) {
-                error2(3234, v->name, "duplicate identifier", scope.top()->getDeclaration(v->name.text), "first declaration here");
+            if (not v->shorthand and scope.top()->lookupName(v->name.text()) != nullptr) {
+                error2(3234, v->name, "duplicate identifier", scope.top()->getDeclaration(v->name.text()), "first declaration here");
             }
             const ast::Expression *ptr = analyze(v->expr.get());
             const ast::TypePointer *ptrtype = dynamic_cast<const ast::TypePointer *>(ptr->type);
@@ -5652,12 +5716,12 @@ const ast::Statement *Analyzer::analyze(const pt::WhileStatement *statement)
             ast::Variable *var;
             // TODO: Try to make this a local variable always (give the global scope a local space).
             if (functiontypes.empty()) {
-                var = new ast::GlobalVariable(v->name, v->name.text, vtype, true);
+                var = new ast::GlobalVariable(v->name, v->name.text(), vtype, true);
             } else {
                 // TODO: probably use frame.top()->get_depth() (add IF VALID to repl tests)
-                var = new ast::LocalVariable(v->name, v->name.text, vtype, frame.size()-1, true);
+                var = new ast::LocalVariable(v->name, v->name.text(), vtype, frame.size()-1, true);
             }
-            scope.top()->addName(v->name, v->name.text, var, true, v->shorthand);
+            scope.top()->addName(v->name, v->name.text(), var, true, v->shorthand);
             const ast::Expression *ve = new ast::ValidPointerExpression(var, ptr);
             if (cond == nullptr) {
                 cond = ve;
@@ -5675,13 +5739,13 @@ const ast::Statement *Analyzer::analyze(const pt::WhileStatement *statement)
     scope.push(new ast::Scope(scope.top(), frame.top()));
     unsigned int loop_id = static_cast<unsigned int>(reinterpret_cast<intptr_t>(statement));
     if (statement->label.type == IDENTIFIER) {
-        Token label = scope.top()->getDeclaration(statement->label.text);
+        Token label = scope.top()->getDeclaration(statement->label.text());
         if (label.type != NONE) {
             error2(3217, statement->label, "loop label already defined", label, "declaration here");
         }
-        scope.top()->addName(statement->label, statement->label.text, new ast::LoopLabel(statement->label));
+        scope.top()->addName(statement->label, statement->label.text(), new ast::LoopLabel(statement->label));
     }
-    loops.top().push_back(std::make_pair(statement->label.text, loop_id));
+    loops.top().push_back(std::make_pair(statement->label.text(), loop_id));
     std::vector<const ast::Statement *> statements {
         new ast::IfStatement(
             statement->token,
@@ -5782,6 +5846,7 @@ const ast::Program *Analyzer::analyze()
     r->statements = analyze(program->body);
     loops.pop();
     r->scope->checkForward();
+    check_parallel_functions();
 
     // Check for unimplemented interface methods.
     for (size_t i = 0; i < r->frame->getCount(); i++) {
@@ -5790,7 +5855,7 @@ const ast::Program *Analyzer::analyze()
         if (c != nullptr) {
             for (auto iface: c->interfaces) {
                 for (auto m: iface->methods) {
-                    if (c->methods.find(m.first.text) == c->methods.end()) {
+                    if (c->methods.find(m.first.text()) == c->methods.end()) {
                         error2(3252, c->declaration, "method missing", m.first, "declared here");
                     }
                 }
@@ -5956,7 +6021,7 @@ public:
             if (a->mode == pt::FunctionParameterGroup::Mode::OUT) {
                 for (auto name: a->names) {
                     vc.add_variable(name, false);
-                    vc.out_parameters.push_back(name.text);
+                    vc.out_parameters.push_back(name.text());
                 }
             }
         }
@@ -6050,11 +6115,11 @@ public:
     }
     virtual void visit(const pt::ExecStatement *node) {
         for (auto &var: node->info->assignments) {
-            mark_assigned(var.text, var);
+            mark_assigned(var.text(), var);
         }
         for (auto p: node->info->parameters) {
             for (auto s = scopes.rbegin(); s != scopes.rend(); ++s) {
-                auto i = s->variables.find(p.text.substr(1));
+                auto i = s->variables.find(p.text().substr(1));
                 if (i != s->variables.end()) {
                     i->second.mark_used(p);
                     break;
@@ -6156,7 +6221,7 @@ public:
         for (auto &v: node->vars) {
             bool found = false;
             for (auto s = scopes.rbegin(); s != scopes.rend(); ++s) {
-                auto i = s->variables.find(v.text);
+                auto i = s->variables.find(v.text());
                 if (i != s->variables.end()) {
                     i->second.mark_declared_unused(v);
                     found = true;
@@ -6224,9 +6289,9 @@ private:
     }
     void add_variable(const Token &name, bool initialised)
     {
-        scopes.back().variables[name.text] = VariableInfo(name);
+        scopes.back().variables[name.text()] = VariableInfo(name);
         if (initialised) {
-            scopes.back().assigned.insert(name.text);
+            scopes.back().assigned.insert(name.text());
         }
     }
     void check_unused() {
@@ -6262,7 +6327,7 @@ private:
             for (auto s = scopes.rbegin(); s != scopes.rend(); ++s) {
                 auto i = s->variables.find(p);
                 if (i != s->variables.end()) {
-                    if (s->assigned.find(i->second.token.text) != s->assigned.end()) {
+                    if (s->assigned.find(i->second.token.text()) != s->assigned.end()) {
                         break;
                     } else {
                         error2(3191, token, "Uninitialised OUT parameter: " + p, i->second.token, "Variable declared here");
@@ -0,0 +1,115 @@
+#include "arena.h"
+
+#include <new>
+
+namespace {
+
+const size_t BLOCK_SIZE = 64 * 1024;
+const size_t ALIGNMENT = 16;
+
+thread_local Arena *current_arena = nullptr;
+
+size_t align(size_t size)
+{
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+} // namespace
+
+// Every ArenaObject is preceded by a header. For nodes on the heap the
+// arena is nullptr. For nodes in an arena, the header links all the
+// nodes of that arena together (newest first) so their destructors can
+// be run when the arena goes away; the arena pointer is cleared once a
+// node has been destroyed.
+struct alignas(ALIGNMENT) Arena::Header {
+    Arena *arena;
+    Header *next;
+};
+
+Arena::Arena()
+  : blocks(),
+    next(nullptr),
+    limit(nullptr),
+    allocated(0),
+    objects(nullptr)
+{
+}
+
+Arena::~Arena()
+{
+    // Parse tree nodes are owned by their parents and have already been
+    // deleted by now. AST nodes only refer to each other, so they can be
+    // destroyed in any order.
+    for (Header *h = objects; h != nullptr; h = h->next) {
+        if (h->arena != nullptr) {
+            h->arena = nullptr;
+            reinterpret_cast<ArenaObject *>(h + 1)->~ArenaObject();
+        }
+    }
+    for (auto b: blocks) {
+        ::operator delete(b);
+    }
+}
+
+void *Arena::allocate(size_t size)
+{
+    size = align(size);
+    allocated += size;
+    if (size > BLOCK_SIZE / 4) {
+        // Large requests get a block of their own so the current block
+        // can continue to be used.
+        char *b = static_cast<char *>(::operator new(size));
+        blocks.push_back(b);
+        return b;
+    }
+    if (next == nullptr || size > static_cast<size_t>(limit - next)) {
+        next = static_cast<char *>(::operator new(BLOCK_SIZE));
+        limit = next + BLOCK_SIZE;
+        blocks.push_back(next);
+    }
+    void *r = next;
+    next += size;
+    return r;
+}
+
+ArenaScope::ArenaScope(Arena *arena)
+  : previous(current_arena)
+{
+    current_arena = arena;
+}
+
+ArenaScope::~ArenaScope()
+{
+    current_arena = previous;
+}
+
+void *ArenaObject::operator new(size_t size)
+{
+    Arena *arena = current_arena;
+    Arena::Header *h;
+    if (arena != nullptr) {
+        h = static_cast<Arena::Header *>(arena->allocate(sizeof(Arena::Header) + size));
+        h->arena = arena;
+        h->next = arena->objects;
+        arena->objects = h;
+    } else {
+        h = static_cast<Arena::Header *>(::operator new(sizeof(Arena::Header) + size));
+        h->arena = nullptr;
+        h->next = nullptr;
+    }
+    return h + 1;
+}
+
+void ArenaObject::operator delete(void *p)
+{
+    if (p == nullptr) {
+        return;
+    }
+    Arena::Header *h = static_cast<Arena::Header *>(p) - 1;
+    if (h->arena != nullptr) {
+        // The memory is released along with the rest of the arena.
+        h->arena = nullptr;
+        return;
+    }
+    ::operator delete(h);
+}
@@ -0,0 +1,60 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <vector>
+
+// An Arena holds the parse tree and AST nodes created during one
+// compilation. Nodes are carved out of large blocks by bumping a pointer,
+// and destroying the Arena runs the destructors of any nodes still alive
+// and releases all the blocks at once. Nodes that own other nodes (such
+// as a parse tree held by unique_ptr) must be deleted before the Arena.
+
+class Arena {
+public:
+    Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena();
+
+    void *allocate(size_t size);
+    size_t bytes_allocated() const { return allocated; }
+
+    struct Header;
+private:
+    std::vector<char *> blocks;
+    char *next;
+    char *limit;
+    size_t allocated;
+    Header *objects;
+
+    friend class ArenaObject;
+};
+
+// While an ArenaScope is in effect, nodes created on the current thread
+// are placed in the given arena (or on the heap, if it is nullptr).
+
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena *arena);
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+    ~ArenaScope();
+private:
+    Arena *const previous;
+};
+
+// Base class for node types that may be allocated in an Arena. Deleting
+// a node that lives in an arena runs its destructor but leaves the memory
+// to be released with the arena.
+
+class ArenaObject {
+public:
+    ArenaObject() {}
+    virtual ~ArenaObject() {}
+
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+};
+
+#endif
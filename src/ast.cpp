@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <iso646.h>
+#include <mutex>
 #include <sstream>
 #include <string.h>
 
@@ -178,6 +179,34 @@ TypeArray::TypeArray(const Token &declaration, const Type *elementtype)
         params.push_back(new ParameterType(Token(), ParameterType::Mode::IN, elementtype, nullptr));
         methods["find"] = new PredefinedFunction("array__find", new TypeFunction(TYPE_NUMBER, params, false));
     }
+    {
+        // The parallel methods call the function on other threads, so the
+        // analyzer also checks that it is pure and uses no global variables.
+        std::vector<const ParameterType *> fparams;
+        fparams.push_back(new ParameterType(Token(IDENTIFIER, "element"), ParameterType::Mode::IN, elementtype, nullptr));
+        std::vector<const ParameterType *> params;
+        params.push_back(new ParameterType(Token(), ParameterType::Mode::IN, this, nullptr));
+        params.push_back(new ParameterType(Token(IDENTIFIER, "function"), ParameterType::Mode::IN, new TypeFunctionPointer(Token(), new TypeFunction(TYPE_BOOLEAN, fparams, false)), nullptr));
+        methods["parallelFilter"] = new PredefinedFunction("array__parallelFilter", new TypeFunction(this, params, false));
+    }
+    {
+        std::vector<const ParameterType *> fparams;
+        fparams.push_back(new ParameterType(Token(IDENTIFIER, "element"), ParameterType::Mode::IN, elementtype, nullptr));
+        std::vector<const ParameterType *> params;
+        params.push_back(new ParameterType(Token(), ParameterType::Mode::IN, this, nullptr));
+        params.push_back(new ParameterType(Token(IDENTIFIER, "function"), ParameterType::Mode::IN, new TypeFunctionPointer(Token(), new TypeFunction(elementtype, fparams, false)), nullptr));
+        methods["parallelMap"] = new PredefinedFunction("array__parallelMap", new TypeFunction(this, params, false));
+    }
+    {
+        std::vector<const ParameterType *> fparams;
+        fparams.push_back(new ParameterType(Token(IDENTIFIER, "accumulator"), ParameterType::Mode::IN, elementtype, nullptr));
+        fparams.push_back(new ParameterType(Token(IDENTIFIER, "element"), ParameterType::Mode::IN, elementtype, nullptr));
+        std::vector<const ParameterType *> params;
+        params.push_back(new ParameterType(Token(), ParameterType::Mode::IN, this, nullptr));
+        params.push_back(new ParameterType(Token(IDENTIFIER, "function"), ParameterType::Mode::IN, new TypeFunctionPointer(Token(), new TypeFunction(elementtype, fparams, false)), nullptr));
+        params.push_back(new ParameterType(Token(IDENTIFIER, "initial"), ParameterType::Mode::IN, elementtype, nullptr));
+        methods["parallelReduce"] = new PredefinedFunction("array__parallelReduce", new TypeFunction(elementtype, params, false));
+    }
     {
         std::vector<const ParameterType *> params;
         params.push_back(new ParameterType(Token(), ParameterType::Mode::INOUT, this, nullptr));
@@ -244,7 +273,7 @@ std::function<const Expression *(Analyzer *analyzer, const Expression *e)> TypeF
         return nullptr;
     }
     for (size_t i = 0; i < params.size(); i++) {
-        if (params[i]->declaration.text != f->params[i]->declaration.text) {
+        if (params[i]->declaration.text() != f->params[i]->declaration.text()) {
             return nullptr;
         }
         if (params[i]->mode != f->params[i]->mode) {
@@ -445,7 +474,7 @@ std::string TypeRecord::text() const
             r.append(",");
         }
         first = false;
-        r.append(f.name.text);
+        r.append(f.name.text());
     }
     r.append(")");
     return r;
@@ -471,7 +500,7 @@ std::string TypeClass::text() const
             r.append(",");
         }
         first = false;
-        r.append(f.name.text);
+        r.append(f.name.text());
     }
     r.append(")");
     return r;
@@ -1033,7 +1062,7 @@ int Frame::addSlot(const Token &token, const std::string &name, Name *ref, bool
     return r;
 }
 
-const Frame::Slot Frame::getSlot(size_t slot)
+const Frame::Slot &Frame::getSlot(size_t slot)
 {
     return slots.at(slot);
 }
@@ -1082,6 +1111,19 @@ Variable *LocalFrame::createVariable(const Token &token, const std::string &name
     return new LocalVariable(token, name, type, nesting_depth, is_readonly);
 }
 
+bool Scope::find(const std::string &name, const Scope *&scope, int &slot) const
+{
+    for (const Scope *s = this; s != nullptr; s = s->parent) {
+        auto n = s->names.find(name);
+        if (n != s->names.end()) {
+            scope = s;
+            slot = n->second;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool Scope::allocateName(const Token &token, const std::string &name)
 {
     if (getDeclaration(name).type != NONE) {
@@ -1093,31 +1135,25 @@ bool Scope::allocateName(const Token &token, const std::string &name)
 
 Name *Scope::lookupName(const std::string &name, bool mark_referenced)
 {
-    Scope *s = this;
-    while (s != nullptr) {
-        auto n = s->names.find(name);
-        if (n != s->names.end()) {
-            if (mark_referenced) {
-                s->frame->setReferenced(n->second);
-            }
-            return s->frame->getSlot(n->second).ref;
-        }
-        s = s->parent;
+    const Scope *s;
+    int slot;
+    if (not find(name, s, slot)) {
+        return nullptr;
     }
-    return nullptr;
+    if (mark_referenced) {
+        s->frame->setReferenced(slot);
+    }
+    return s->frame->getSlot(slot).ref;
 }
 
 Token Scope::getDeclaration(const std::string &name) const
 {
-    const Scope *s = this;
-    while (s != nullptr) {
-        auto d = s->names.find(name);
-        if (d != s->names.end()) {
-            return s->frame->getSlot(d->second).token;
-        }
-        s = s->parent;
+    const Scope *s;
+    int slot;
+    if (not find(name, s, slot)) {
+        return Token();
     }
-    return Token();
+    return s->frame->getSlot(slot).token;
 }
 
 void Scope::addName(const Token &token, const std::string &name, Name *ref, bool init_referenced, bool allow_shadow)
@@ -1148,7 +1184,7 @@ void Scope::replaceName(const Token &token, const std::string &name, Name *ref)
 {
     auto a = names.find(name);
     if (a != names.end()) {
-        names.erase(name);
+        names.erase(a);
     }
     addName(token, name, ref, true, true);
 }
@@ -1200,6 +1236,7 @@ Function::Function(const Token &declaration, const std::string &name, const Type
     scope(new Scope(parent, frame)),
     params(params),
     nesting_depth(nesting_depth),
+    uses_outer_variables(false),
     statements()
 {
     for (auto p: params) {
@@ -1240,20 +1277,15 @@ bool PredefinedFunction::is_pure(std::set<const ast::Function *> &) const
     return impure_modules.find(mod) == impure_modules.end();
 }
 
-Program::Program(const std::string &source_path, const std::string &source_hash, const std::string &module_name)
-  : source_path(source_path),
-    source_hash(source_hash),
-    module_name(module_name),
-    frame(new GlobalFrame(nullptr)),
-    scope(new Scope(nullptr, frame)),
-    statements(),
-    exports()
+namespace {
+
+std::once_flag predefined_methods_once;
+
+// The methods of the predefined types are shared by every Program, so
+// they are created once (on the heap, not in any compilation's arena).
+void init_predefined_methods()
 {
-    scope->addName(Token(IDENTIFIER, "Boolean"), "Boolean", TYPE_BOOLEAN);
-    scope->addName(Token(IDENTIFIER, "Number"), "Number", TYPE_NUMBER);
-    scope->addName(Token(IDENTIFIER, "String"), "String", TYPE_STRING);
-    scope->addName(Token(IDENTIFIER, "Bytes"), "Bytes", TYPE_BYTES);
-    scope->addName(Token(IDENTIFIER, "Object"), "Object", TYPE_OBJECT);
+    ArenaScope arena_scope(nullptr);
 
     {
         std::vector<const ParameterType *> params;
@@ -1320,6 +1352,26 @@ Program::Program(const std::string &source_path, const std::string &source_hash,
         params.push_back(new ParameterType(Token(), ParameterType::Mode::IN, TYPE_OBJECT, nullptr));
         TYPE_OBJECT->methods["toString"] = new PredefinedFunction("object__toString", new TypeFunction(TYPE_STRING, params, false));
     }
+}
+
+} // namespace
+
+Program::Program(const std::string &source_path, const std::string &source_hash, const std::string &module_name)
+  : source_path(source_path),
+    source_hash(source_hash),
+    module_name(module_name),
+    frame(new GlobalFrame(nullptr)),
+    scope(new Scope(nullptr, frame)),
+    statements(),
+    exports()
+{
+    scope->addName(Token(IDENTIFIER, "Boolean"), "Boolean", TYPE_BOOLEAN);
+    scope->addName(Token(IDENTIFIER, "Number"), "Number", TYPE_NUMBER);
+    scope->addName(Token(IDENTIFIER, "String"), "String", TYPE_STRING);
+    scope->addName(Token(IDENTIFIER, "Bytes"), "Bytes", TYPE_BYTES);
+    scope->addName(Token(IDENTIFIER, "Object"), "Object", TYPE_OBJECT);
+
+    std::call_once(predefined_methods_once, init_predefined_methods);
 
     for (auto x: rtl::ExceptionNames) {
         Exception *e = new Exception(Token(), x.name);
@@ -7,10 +7,12 @@
 #include <map>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <minijson_writer.hpp>
 
+#include "arena.h"
 #include "bytecode.h"
 #include "number.h"
 #include "sql.h"
@@ -151,7 +153,7 @@ public:
     virtual void visit(const class Program *node) = 0;
 };
 
-class AstNode {
+class AstNode: public ArenaObject {
 public:
     AstNode() {}
     AstNode(const AstNode &) = delete;
@@ -173,7 +175,7 @@ class FunctionParameter;
 class Expression;
 class Statement;
 
-class Frame {
+class Frame: public ArenaObject {
 public:
     explicit Frame(Frame *outer): outer(outer), predeclared(false), slots() {}
     Frame(const Frame &) = delete;
@@ -205,7 +207,7 @@ public:
 
     size_t getCount() const { return slots.size(); }
     virtual int addSlot(const Token &token, const std::string &name, Name *ref, bool init_referenced);
-    const Slot getSlot(size_t slot);
+    const Slot &getSlot(size_t slot);
     virtual void setReferent(int slot, const std::string &name, Name *ref);
     void setReferenced(int slot);
 
@@ -261,7 +263,7 @@ public:
     size_t nesting_depth;
 };
 
-class Scope {
+class Scope: public ArenaObject {
 public:
     Scope(Scope *parent, Frame *frame): parent(parent), frame(frame), names(), forwards() {
         for (int x = 0; x < SqlWheneverConditionCount; x++) {
@@ -286,8 +288,10 @@ public:
     Frame *const frame;
     SqlWheneverAction sql_whenever[SqlWheneverConditionCount];
 private:
-    std::map<std::string, int> names;
+    std::unordered_map<std::string, int> names;
     std::map<std::string, std::vector<TypePointer *>> forwards;
+
+    bool find(const std::string &name, const Scope *&scope, int &slot) const;
 };
 
 class ExternalGlobalScope: public Scope {
@@ -313,12 +317,11 @@ public:
 
 class Type: public Name {
 public:
-    Type(const Token &declaration, const std::string &name): Name(declaration, name, nullptr), methods(), predeclared(false), postdeclared(false) {}
+    Type(const Token &declaration, const std::string &name): Name(declaration, name, nullptr), methods() {}
 
     std::map<std::string, Variable *> methods;
 
     virtual const Expression *make_default_value() const = 0;
-    virtual void reset() override { predeclared = false; postdeclared = false; }
     virtual void predeclare(Emitter &emitter) const override;
     virtual void postdeclare(Emitter &emitter) const override;
     virtual bool is_ambiguous() const { return false; }
@@ -333,9 +336,6 @@ public:
     virtual std::string serialize(const Expression *value) const = 0;
     virtual const Expression *deserialize_value(const Bytecode::Bytes &value, int &i) const = 0;
     virtual void debuginfo(Emitter &emitter, minijson::object_writer &out) const = 0;
-protected:
-    mutable bool predeclared;
-    mutable bool postdeclared;
 };
 
 class TypeNothing: public Type {
@@ -476,7 +476,7 @@ public:
 
 extern TypeObject *TYPE_OBJECT;
 
-class ParameterType {
+class ParameterType: public ArenaObject {
 public:
     enum class Mode {
         IN,
@@ -648,7 +648,7 @@ private:
         std::map<std::string, size_t> r;
         size_t i = 0;
         for (auto f: fields) {
-            r[f.name.text] = i;
+            r[f.name.text()] = i;
             i++;
         }
         return r;
@@ -847,12 +847,12 @@ extern TypeInterface *TYPE_INTERFACE;
 
 class LoopLabel: public Name {
 public:
-    explicit LoopLabel(const Token &declaration): Name(declaration, declaration.text, nullptr) {}
+    explicit LoopLabel(const Token &declaration): Name(declaration, declaration.text(), nullptr) {}
     virtual void accept(IAstVisitor *visitor) const override { visitor->visit(this); }
 
     virtual void generate_export(Emitter &, const std::string &) const override { internal_error("LoopLabel"); }
 
-    virtual std::string text() const override { return "LoopLable(" + declaration.text + ")"; }
+    virtual std::string text() const override { return "LoopLable(" + declaration.text() + ")"; }
 };
 
 class Variable: public Name {
@@ -2716,9 +2716,31 @@ public:
     }
 };
 
+// A counted FOR loop. The inherited prologue, statements and tail
+// describe the loop in general terms (for backends that do not care),
+// while var, bound, step and body allow the bytecode compiler to emit
+// a single increment-compare-jump instruction for the loop tail.
+class ForStatement: public BaseLoopStatement {
+public:
+    ForStatement(const Token &token, unsigned int loop_id, const Variable *var, const Variable *bound, const Number &step, const std::vector<const Statement *> &prologue, const std::vector<const Statement *> &statements, const std::vector<const Statement *> &body, const std::vector<const Statement *> &tail): BaseLoopStatement(token, loop_id, prologue, statements, tail, false), var(var), bound(bound), step(step), body(body) {}
+    ForStatement(const ForStatement &) = delete;
+    ForStatement &operator=(const ForStatement &) = delete;
+
+    const Variable *var;
+    const Variable *bound;
+    const Number step;
+    const std::vector<const Statement *> body;
+
+    virtual void generate_code(Emitter &emitter) const override;
+
+    virtual std::string text() const override {
+        return "ForStatement(" + var->name + ")";
+    }
+};
+
 class CaseStatement: public Statement {
 public:
-    class WhenCondition {
+    class WhenCondition: public ArenaObject {
     public:
         explicit WhenCondition(const Token &token): token(token) {}
         WhenCondition(const WhenCondition &) = delete;
@@ -2907,6 +2929,9 @@ public:
     Scope *scope;
     const std::vector<FunctionParameter *> params;
     size_t nesting_depth;
+    // Set by the analyzer if the body refers to a global variable or to
+    // a local variable of an enclosing function.
+    bool uses_outer_variables;
 
     std::vector<const Statement *> statements;
 
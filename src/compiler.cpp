@@ -49,7 +49,7 @@ public:
         Label entry_label;
     };
 public:
-    Emitter(const std::string &source_hash, DebugInfo *debug): classes(), source_hash(source_hash), object(), globals(), functions({FunctionInfo("", Label())}), function_exit(), current_function_depth(), stack_depth(0), in_jumptbl(false), loop_labels(), exported_types(), debug_info(debug) {}
+    Emitter(const std::string &source_hash, DebugInfo *debug): classes(), source_hash(source_hash), object(), globals(), functions({FunctionInfo("", Label())}), function_exit(), current_function_depth(), stack_depth(0), in_jumptbl(false), loop_labels(), exported_types(), predeclared_types(), postdeclared_types(), debug_info(debug) {}
     Emitter(const Emitter &) = delete;
     Emitter &operator=(const Emitter &) = delete;
     void emit_byte(unsigned char b);
@@ -70,6 +70,7 @@ public:
     FunctionInfo &function_info(int index);
     Label create_label();
     void emit_jump(Opcode b, Label &label);
+    void emit_jump(Opcode b, uint32_t value, Label &label);
     void jump_target(Label &label);
     void add_loop_labels(unsigned int loop_id, Label &exit, Label &next);
     void remove_loop_labels(unsigned int loop_id);
@@ -91,11 +92,18 @@ public:
     void add_export_interface(const std::string &name, const std::vector<std::pair<std::string, std::string>> &method_descriptors);
     void add_import(const ast::Module *module);
     std::string get_type_reference(const ast::Type *type);
+    // Types (including the shared predefined types) are predeclared once
+    // per compilation, so this is tracked here and not in the type itself.
+    bool mark_predeclared(const ast::Type *type) { return predeclared_types.insert(type).second; }
+    bool mark_postdeclared(const ast::Type *type) { return postdeclared_types.insert(type).second; }
+    bool is_predeclared(const ast::Type *type) const { return predeclared_types.find(type) != predeclared_types.end(); }
+    bool is_postdeclared(const ast::Type *type) const { return postdeclared_types.find(type) != postdeclared_types.end(); }
     int get_stack_depth() { return stack_depth; }
     void set_stack_depth(int depth) { stack_depth = depth; }
     void adjust_stack_depth(int delta) { stack_depth += delta; }
     std::vector<std::pair<const ast::TypeClass *, std::vector<std::vector<int>>>> classes;
 private:
+    void emit_jump_target(Opcode b, Label &label);
     const std::string source_hash;
     Bytecode object;
     std::vector<std::string> globals;
@@ -106,6 +114,8 @@ private:
     bool in_jumptbl;
     std::map<size_t, LoopLabels> loop_labels;
     std::set<const ast::Type *> exported_types;
+    std::set<const ast::Type *> predeclared_types;
+    std::set<const ast::Type *> postdeclared_types;
     DebugInfo *debug_info;
 };
 
@@ -225,6 +235,9 @@ void Emitter::emit(Opcode b)
             case Opcode::PUSHFP:    stack_depth += 1; break;
             case Opcode::CALLV:     break;
             case Opcode::PUSHCI:    stack_depth += 1; break;
+            case Opcode::FORN:      stack_depth -= 2; break;
+            case Opcode::CASEN:     stack_depth -= 1; in_jumptbl = true; break;
+            case Opcode::CASES:     stack_depth -= 1; in_jumptbl = true; break;
         }
     }
 }
@@ -338,6 +351,18 @@ Emitter::Label Emitter::create_label()
 void Emitter::emit_jump(Opcode b, Label &label)
 {
     emit(b);
+    emit_jump_target(b, label);
+}
+
+void Emitter::emit_jump(Opcode b, uint32_t value, Label &label)
+{
+    emit(b);
+    emit_uint32(value);
+    emit_jump_target(b, label);
+}
+
+void Emitter::emit_jump_target(Opcode b, Label &label)
+{
     label.reachable = true;
     if (label.target != UINT_MAX) {
         emit_uint32(label.target);
@@ -538,10 +563,9 @@ std::string Emitter::get_type_reference(const ast::Type *type)
 void ast::Type::predeclare(Emitter &emitter) const
 {
     // Avoid unbounded recursion.
-    if (predeclared) {
+    if (not emitter.mark_predeclared(this)) {
         return;
     }
-    predeclared = true;
     for (auto m: methods) {
         m.second->predeclare(emitter);
     }
@@ -550,10 +574,9 @@ void ast::Type::predeclare(Emitter &emitter) const
 void ast::Type::postdeclare(Emitter &emitter) const
 {
     // Avoid unbounded recursion.
-    if (postdeclared) {
+    if (not emitter.mark_postdeclared(this)) {
         return;
     }
-    postdeclared = true;
     for (auto m: methods) {
         m.second->postdeclare(emitter);
     }
@@ -688,7 +711,7 @@ std::string ast::TypeFunction::get_type_descriptor(Emitter &emitter) const
             default:
                 internal_error("invalid parameter mode");
         }
-        r += m + p->declaration.text + ":" + emitter.get_type_reference(p->type);
+        r += m + p->declaration.text() + ":" + emitter.get_type_reference(p->type);
         if (p->default_value != nullptr && dynamic_cast<const ast::DummyExpression *>(p->default_value) == nullptr) {
             r += "=" + p->type->serialize(p->default_value);
         }
@@ -774,7 +797,7 @@ void ast::TypeDictionary::get_type_references(std::set<const Type *> &references
 void ast::TypeRecord::predeclare(Emitter &emitter) const
 {
     // Avoid unbounded recursion.
-    const bool was_predeclared = predeclared;
+    const bool was_predeclared = emitter.is_predeclared(this);
     Type::predeclare(emitter);
     if (was_predeclared) {
         return;
@@ -787,7 +810,7 @@ void ast::TypeRecord::predeclare(Emitter &emitter) const
 void ast::TypeRecord::postdeclare(Emitter &emitter) const
 {
     // Avoid unbounded recursion.
-    const bool was_postdeclared = postdeclared;
+    const bool was_postdeclared = emitter.is_postdeclared(this);
     Type::postdeclare(emitter);
     if (was_postdeclared) {
         return;
@@ -819,7 +842,7 @@ std::string ast::TypeRecord::get_type_descriptor(Emitter &emitter) const
         if (f.is_private) {
             r += "!";
         }
-        r += f.name.text + ":" + emitter.get_type_reference(f.type);
+        r += f.name.text() + ":" + emitter.get_type_reference(f.type);
     }
     r += "]";
     return r;
@@ -1184,7 +1207,7 @@ void ast::Function::postdeclare(Emitter &emitter) const
             if (c.first->name == classname) {
                 for (size_t i = 0; i < c.first->interfaces.size(); i++) {
                     for (size_t m = 0; m < c.first->interfaces[i]->methods.size(); m++) {
-                        if (c.first->interfaces[i]->methods[m].first.text == methodname) {
+                        if (c.first->interfaces[i]->methods[m].first.text() == methodname) {
                             c.second[i][m] = function_index;
                         }
                     }
@@ -1270,7 +1293,7 @@ void ast::Interface::generate_export(Emitter &emitter, const std::string &export
 {
     std::vector<std::pair<std::string, std::string>> method_descriptors;
     for (auto m: methods) {
-        method_descriptors.push_back(std::make_pair(m.first.text, m.second->get_type_descriptor(emitter)));
+        method_descriptors.push_back(std::make_pair(m.first.text(), m.second->get_type_descriptor(emitter)));
     }
     emitter.add_export_interface(export_name, method_descriptors);
 }
@@ -2285,6 +2308,73 @@ void ast::CaseStatement::generate_code(Emitter &emitter) const
         }
     }
 
+    // When every condition is a plain equality test, emit a sorted table
+    // of keys that the executor can binary search, instead of a linear
+    // chain of comparisons.
+    const bool is_string = expr->type == TYPE_STRING;
+    if (is_string || dynamic_cast<const TypeNumber *>(expr->type) != nullptr || dynamic_cast<const TypeEnum *>(expr->type) != nullptr) {
+        struct CaseKey {
+            Number number;
+            std::string string;
+            const std::vector<const Statement *> *statements;
+        };
+        std::vector<CaseKey> keys;
+        std::vector<const Statement *> when_others;
+        bool all_equality = true;
+        for (auto &clause: clauses) {
+            for (auto cond: clause.first) {
+                const ComparisonWhenCondition *comp = dynamic_cast<const ComparisonWhenCondition *>(cond);
+                if (comp != nullptr && comp->comp == ComparisonExpression::Comparison::EQ) {
+                    if (is_string) {
+                        keys.push_back(CaseKey {Number(), comp->expr->eval_string(Token()).str(), &clause.second});
+                    } else {
+                        keys.push_back(CaseKey {comp->expr->eval_number(Token()), std::string(), &clause.second});
+                    }
+                } else {
+                    all_equality = false;
+                }
+            }
+            if (clause.first.empty()) {
+                when_others = clause.second;
+            }
+        }
+        if (all_equality && keys.size() >= 4) {
+            std::stable_sort(keys.begin(), keys.end(), [is_string](const CaseKey &a, const CaseKey &b) {
+                return is_string ? a.string < b.string : number_is_less(a.number, b.number);
+            });
+            std::vector<unsigned char> table;
+            for (auto &k: keys) {
+                // Fixed width entries so the executor can index the table directly.
+                Bytecode::put_vint(table, emitter.str(is_string ? k.string : number_to_string(k.number)), 5);
+            }
+            emitter.emit(is_string ? Opcode::CASES : Opcode::CASEN, static_cast<uint32_t>(keys.size()));
+            emitter.emit(table);
+            std::map<const std::vector<const Statement *> *, Emitter::Label> labels;
+            auto others_label = emitter.create_label();
+            for (auto &k: keys) {
+                auto label = labels.find(k.statements);
+                if (label == labels.end()) {
+                    labels[k.statements] = emitter.create_label();
+                }
+                emitter.emit_jump(Opcode::JUMP, labels[k.statements]);
+            }
+            emitter.emit_jump(Opcode::JUMP, others_label);
+            for (auto &label: labels) {
+                emitter.jump_target(label.second);
+                for (auto stmt: *label.first) {
+                    stmt->generate(emitter);
+                }
+                emitter.emit_jump(Opcode::JUMP, end_label);
+            }
+            emitter.jump_target(others_label);
+            for (auto stmt: when_others) {
+                stmt->generate(emitter);
+            }
+            emitter.jump_target(end_label);
+            return;
+        }
+    }
+
     for (auto clause: clauses) {
         auto &conditions = clause.first;
         auto &statements = clause.second;
@@ -2396,6 +2486,37 @@ void ast::BaseLoopStatement::generate_code(Emitter &emitter) const
     emitter.remove_loop_labels(loop_id);
 }
 
+void ast::ForStatement::generate_code(Emitter &emitter) const
+{
+    if (not number_is_integer(step)) {
+        BaseLoopStatement::generate_code(emitter);
+        return;
+    }
+    for (auto stmt: prologue) {
+        stmt->generate(emitter);
+    }
+    auto skip = emitter.create_label();
+    var->generate_address(emitter);
+    var->generate_load(emitter);
+    bound->generate_address(emitter);
+    bound->generate_load(emitter);
+    emitter.emit(number_is_negative(step) ? Opcode::LTN : Opcode::GTN);
+    emitter.emit_jump(Opcode::JT, skip);
+    auto top = emitter.create_label();
+    emitter.jump_target(top);
+    auto next = emitter.create_label();
+    emitter.add_loop_labels(loop_id, skip, next);
+    for (auto stmt: body) {
+        stmt->generate(emitter);
+    }
+    emitter.jump_target(next);
+    var->generate_address(emitter);
+    bound->generate_address(emitter);
+    emitter.emit_jump(Opcode::FORN, emitter.str(number_to_string(step)), top);
+    emitter.jump_target(skip);
+    emitter.remove_loop_labels(loop_id);
+}
+
 void ast::ExitStatement::generate_code(Emitter &emitter) const
 {
     emitter.emit_jump(Opcode::JUMP, emitter.get_exit_label(loop_id));
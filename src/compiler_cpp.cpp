@@ -1,29 +1,62 @@
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
 #include "ast.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <fstream>
+#include <set>
 #include <sstream>
+#include <typeinfo>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 #include "support.h"
 
+// Translate a program to C++ source that builds against rtl/cpp.
+//
+// Values use native C++ types instead of a boxed cell: Boolean is bool,
+// String is std::string, Array and Dictionary are std::vector and
+// std::map, records and classes are plain structs, and pointers are
+// std::shared_ptr. A Number is an int64_t when the translator can show
+// that it only ever holds a value that fits in one (see
+// Program::infer_integers), and a neon::Number otherwise. Arithmetic
+// results are not assumed to fit, so an overflow gives a general Number
+// rather than an error. The exception is the counter of a FOR loop, which
+// cannot pass its bound.
+//
+// Each module becomes its own translation unit, M.neon.cpp, with a header
+// M.neon.h that declares its records, exported functions and exported
+// variables, all in namespace neon_module_M. Exported Numbers are always
+// neon::Number so that the header does not change with the bodies of the
+// functions. All of these go in one directory with the CMake project for
+// the main program (P-cpp/, or the -o directory), which builds every
+// module it imports along with the runtime, so the native build runs in
+// parallel and recompiles only the units that changed.
+
 namespace cpp {
 
 std::string quoted(const std::string &s)
 {
     std::string r = "\"";
     for (auto c: s) {
+        unsigned char u = static_cast<unsigned char>(c);
         switch (c) {
             case '"':  r.append("\\\""); break;
             case '\\': r.append("\\\\"); break;
+            case '?':  r.append("\\?"); break;
             default:
-                if (c < 0x20) {
-                    static const char hex[] = "0123456789abcdef";
-                    char buf[10];
-                    buf[0] = '\\';
-                    buf[1] = 'x';
-                    buf[2] = hex[(c >> 4) & 0xf];
-                    buf[3] = hex[c & 0xf];
-                    buf[4] = 0;
+                // Octal escapes, unlike \x escapes, cannot run into the
+                // characters that follow them.
+                if (u < 0x20 || u >= 0x7f) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\%03o", u);
                     r.append(buf);
                 } else {
                     r.push_back(c);
@@ -35,6 +68,47 @@ std::string quoted(const std::string &s)
     return r;
 }
 
+// Names that would collide with C++ keywords or with names used by the
+// generated code get a trailing underscore.
+std::string ident(const std::string &name)
+{
+    static const std::set<std::string> reserved = {
+        "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch",
+        "char", "char16_t", "char32_t", "class", "compl", "const", "constexpr", "const_cast", "continue", "decltype",
+        "default", "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+        "float", "for", "friend", "goto", "if", "inline", "int", "int64_t", "long", "main", "mutable", "namespace",
+        "neon", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or", "or_eq", "private", "protected",
+        "public", "register", "reinterpret_cast", "return", "short", "signed", "sizeof", "static", "static_assert",
+        "static_cast", "std", "struct", "switch", "template", "this", "thread_local", "throw", "true", "try",
+        "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t",
+        "while", "xor", "xor_eq",
+    };
+    std::string r;
+    for (auto c: name) {
+        r.push_back(isalnum(static_cast<unsigned char>(c)) || c == '_' ? c : '_');
+    }
+    if (reserved.find(r) != reserved.end() || r.compare(0, 5, "neon_") == 0) {
+        r.push_back('_');
+    }
+    return r;
+}
+
+// Neon allows the same name to be declared again in a nested or later
+// scope, so names are made unique within each C++ scope. Temporaries
+// made by the analyzer have names that differ from run to run, so they
+// are renumbered to keep the output the same when the source is.
+std::string unique_name(std::set<std::string> &names, const std::string &name)
+{
+    const std::string base = name.compare(0, 6, "temp__") == 0 ? "neon_temp" : ident(name);
+    std::string r = base;
+    int n = 2;
+    while (not names.insert(r).second) {
+        r = base + "_" + std::to_string(n);
+        n++;
+    }
+    return r;
+}
+
 class Context {
 public:
     explicit Context(std::ostream &out): out(out) {}
@@ -44,15 +118,61 @@ public:
 };
 
 class Type;
+class TypeRecord;
 class Variable;
 class Expression;
 class Statement;
+class Function;
 
 static std::map<const ast::Type *, Type *> g_type_cache;
 static std::map<const ast::Variable *, Variable *> g_variable_cache;
 static std::map<const ast::Expression *, Expression *> g_expression_cache;
 static std::map<const ast::Statement *, Statement *> g_statement_cache;
 
+// Names at namespace scope, and the declarations that live there.
+static std::set<std::string> g_global_names;
+static std::vector<const Variable *> g_globals;
+static std::vector<const Function *> g_functions;
+static std::vector<const TypeRecord *> g_records;
+
+// Locals of the module's top level code, which are declared in neon_init().
+static std::set<std::string> g_init_names;
+static std::vector<const Variable *> g_init_locals;
+
+// Declarations of this module that other modules can see.
+static std::set<const ast::Name *> g_exported;
+
+// The function whose body is currently being transformed, if any.
+static Function *g_current_function;
+
+// Each entry records that a Number value computed by an expression is
+// stored in a variable (or returned from a function).
+static std::vector<std::pair<Variable *, const Expression *>> g_number_flows;
+
+// Loops whose EXIT or NEXT labels are the target of a goto.
+static std::set<unsigned int> g_exit_labels;
+static std::set<unsigned int> g_next_labels;
+
+// The analyzer's loop ids are addresses, so labels are numbered in the
+// order the loops are first seen instead.
+static std::map<unsigned int, unsigned int> g_loop_numbers;
+
+unsigned int loop_number(unsigned int loop_id)
+{
+    auto i = g_loop_numbers.find(loop_id);
+    if (i != g_loop_numbers.end()) {
+        return i->second;
+    }
+    unsigned int n = static_cast<unsigned int>(g_loop_numbers.size()) + 1;
+    g_loop_numbers[loop_id] = n;
+    return n;
+}
+
+std::string module_namespace(const std::string &module)
+{
+    return "neon_module_" + ident(module);
+}
+
 class Type {
 public:
     explicit Type(const ast::Type *t) {
@@ -61,6 +181,9 @@ public:
     Type(const Type &) = delete;
     Type &operator=(const Type &) = delete;
     virtual ~Type() {}
+    // Scalar types are passed to functions by value rather than by reference.
+    virtual bool is_scalar() const { return false; }
+    virtual void generate_type(Context &context) const = 0;
     virtual void generate_default(Context &context) const = 0;
 };
 
@@ -68,15 +191,23 @@ Type *transform(const ast::Type *t);
 
 class Variable {
 public:
-    explicit Variable(const ast::Variable *v): type(transform(v->type)) {
+    explicit Variable(const ast::Variable *v): type(transform(v->type)), cname(), integral(false) {
         g_variable_cache[v] = this;
     }
     Variable(const Variable &) = delete;
     Variable &operator=(const Variable &) = delete;
     virtual ~Variable() {}
     const Type *type;
-    virtual void generate_decl(Context &context) const = 0;
-    virtual void generate(Context &context) const = 0;
+    std::string cname;
+    // For a Number variable, true while the variable is only known to
+    // hold values that fit in an int64_t. For a function, the same for
+    // its return value.
+    bool integral;
+    virtual void generate(Context &context) const {
+        context.out << cname;
+    }
+    void generate_type(Context &context) const;
+    void generate_decl(Context &context) const;
 };
 
 Variable *transform(const ast::Variable *v);
@@ -90,7 +221,12 @@ public:
     Expression &operator=(const Expression &) = delete;
     virtual ~Expression() {}
     const Type *type;
+    // True if this Number expression always yields an int64_t.
+    virtual bool is_integer() const { return false; }
     virtual void generate(Context &context) const = 0;
+    // Generate an expression that can be assigned to or bound to a
+    // non-const reference.
+    virtual void generate_lvalue(Context &context) const { generate(context); }
 };
 
 Expression *transform(const ast::Expression *e);
@@ -112,6 +248,7 @@ public:
     TypeNothing(const TypeNothing &) = delete;
     TypeNothing &operator=(const TypeNothing &) = delete;
     const ast::TypeNothing *tn;
+    virtual void generate_type(Context &context) const override { context.out << "void"; }
     virtual void generate_default(Context &) const override { internal_error("TypeNothing"); }
 };
 
@@ -121,6 +258,7 @@ public:
     TypeDummy(const TypeDummy &) = delete;
     TypeDummy &operator=(const TypeDummy &) = delete;
     const ast::TypeDummy *td;
+    virtual void generate_type(Context &) const override { internal_error("TypeDummy"); }
     virtual void generate_default(Context &) const override { internal_error("TypeDummy"); }
 };
 
@@ -130,6 +268,10 @@ public:
     TypeBoolean(const TypeBoolean &) = delete;
     TypeBoolean &operator=(const TypeBoolean &) = delete;
     const ast::TypeBoolean *tb;
+    virtual bool is_scalar() const override { return true; }
+    virtual void generate_type(Context &context) const override {
+        context.out << "bool";
+    }
     virtual void generate_default(Context &context) const override {
         context.out << "false";
     }
@@ -141,6 +283,10 @@ public:
     TypeNumber(const TypeNumber &) = delete;
     TypeNumber &operator=(const TypeNumber &) = delete;
     const ast::TypeNumber *tn;
+    virtual bool is_scalar() const override { return true; }
+    virtual void generate_type(Context &context) const override {
+        context.out << "neon::Number";
+    }
     virtual void generate_default(Context &context) const override {
         context.out << "0";
     }
@@ -152,8 +298,11 @@ public:
     TypeString(const TypeString &) = delete;
     TypeString &operator=(const TypeString &) = delete;
     const ast::TypeString *ts;
+    virtual void generate_type(Context &context) const override {
+        context.out << "std::string";
+    }
     virtual void generate_default(Context &context) const override {
-        context.out << "\"\"";
+        context.out << "std::string()";
     }
 };
 
@@ -163,8 +312,11 @@ public:
     TypeBytes(const TypeBytes &) = delete;
     TypeBytes &operator=(const TypeBytes &) = delete;
     const ast::TypeBytes *tb;
+    virtual void generate_type(Context &context) const override {
+        context.out << "neon::Bytes";
+    }
     virtual void generate_default(Context &context) const override {
-        context.out << "\"\"";
+        context.out << "neon::Bytes()";
     }
 };
 
@@ -174,6 +326,9 @@ public:
     TypeObject(const TypeObject &) = delete;
     TypeObject &operator=(const TypeObject &) = delete;
     const ast::TypeObject *to;
+    virtual void generate_type(Context &context) const override {
+        context.out << "std::shared_ptr<neon::Object>";
+    }
     virtual void generate_default(Context &context) const override {
         context.out << "nullptr";
     }
@@ -191,6 +346,7 @@ public:
     const ast::TypeFunction *tf;
     const Type *returntype;
     std::vector<std::pair<ast::ParameterType::Mode, const Type *>> paramtypes;
+    virtual void generate_type(Context &) const override { internal_error("TypeFunction"); }
     virtual void generate_default(Context &) const override { internal_error("TypeFunction"); }
 };
 
@@ -201,8 +357,14 @@ public:
     TypeArray &operator=(const TypeArray &) = delete;
     const ast::TypeArray *ta;
     const Type *elementtype;
+    virtual void generate_type(Context &context) const override {
+        context.out << "std::vector<";
+        elementtype->generate_type(context);
+        context.out << ">";
+    }
     virtual void generate_default(Context &context) const override {
-        context.out << "neon::Array()";
+        generate_type(context);
+        context.out << "()";
     }
 };
 
@@ -213,45 +375,118 @@ public:
     TypeDictionary &operator=(const TypeDictionary &) = delete;
     const ast::TypeDictionary *td;
     const Type *elementtype;
+    virtual void generate_type(Context &context) const override {
+        context.out << "std::map<std::string, ";
+        elementtype->generate_type(context);
+        context.out << ">";
+    }
     virtual void generate_default(Context &context) const override {
-        context.out << "neon::Dictionary()";
+        generate_type(context);
+        context.out << "()";
     }
 };
 
 class TypeRecord: public Type {
 public:
-    explicit TypeRecord(const ast::TypeRecord *tr): Type(tr), tr(tr), field_types() {
+    explicit TypeRecord(const ast::TypeRecord *tr): Type(tr), tr(tr), cname(), module(), field_types() {
+        // A record imported from another module is named M.R and is
+        // defined in the header of module M.
+        auto dot = tr->name.find('.');
+        if (dot != std::string::npos) {
+            module = tr->name.substr(0, dot);
+            cname = module_namespace(module) + "::" + ident(tr->name.substr(dot+1));
+        } else if (tr->name.empty()) {
+            // An anonymous record nested in a field declaration.
+            cname = unique_name(g_global_names, "neon_record");
+        } else {
+            cname = ident(tr->name);
+            g_global_names.insert(cname);
+        }
         for (auto f: tr->fields) {
             field_types.push_back(transform(f.type));
         }
+        // Records are defined in the order they are transformed, which
+        // puts every record after the records it contains by value.
+        if (dot == std::string::npos) {
+            g_records.push_back(this);
+        }
     }
     TypeRecord(const TypeRecord &) = delete;
     TypeRecord &operator=(const TypeRecord &) = delete;
     const ast::TypeRecord *tr;
+    std::string cname;
+    // The module that defines the record, if it is not this one.
+    std::string module;
     std::vector<const Type *> field_types;
 
+    virtual void generate_type(Context &context) const override {
+        context.out << cname;
+    }
     virtual void generate_default(Context &context) const override {
-        context.out << "{";
-        bool first = true;
-        for (size_t i = 0; i < tr->fields.size(); i++) {
-            if (first) {
-                first = false;
-            } else {
-                context.out << ", ";
-            }
-            context.out << quoted(tr->fields[i].name.text) << ":";
+        context.out << cname << "()";
+    }
+    void generate_definition(Context &context) const {
+        context.out << "struct " << cname << " {\n";
+        context.out << "    " << cname << "()";
+        for (size_t i = 0; i < field_types.size(); i++) {
+            context.out << (i == 0 ? ": " : ", ") << ident(tr->fields[i].name.text()) << "(";
             field_types[i]->generate_default(context);
+            context.out << ")";
         }
-        context.out << "}";
+        context.out << " {}\n";
+        if (not field_types.empty()) {
+            context.out << "    explicit " << cname << "(";
+            for (size_t i = 0; i < field_types.size(); i++) {
+                if (i > 0) {
+                    context.out << ", ";
+                }
+                field_types[i]->generate_type(context);
+                context.out << " " << ident(tr->fields[i].name.text());
+            }
+            context.out << ")";
+            for (size_t i = 0; i < field_types.size(); i++) {
+                const std::string name = ident(tr->fields[i].name.text());
+                context.out << (i == 0 ? ": " : ", ") << name << "(std::move(" << name << "))";
+            }
+            context.out << " {}\n";
+        }
+        for (size_t i = 0; i < field_types.size(); i++) {
+            context.out << "    ";
+            field_types[i]->generate_type(context);
+            context.out << " " << ident(tr->fields[i].name.text()) << ";\n";
+        }
+        context.out << "};\n";
+        if (field_types.empty()) {
+            context.out << "inline bool operator==(const " << cname << " &, const " << cname << " &) { return true; }\n";
+        } else {
+            context.out << "inline bool operator==(const " << cname << " &a, const " << cname << " &b) { return ";
+            for (size_t i = 0; i < field_types.size(); i++) {
+                const std::string name = ident(tr->fields[i].name.text());
+                context.out << (i == 0 ? "" : " && ") << "a." << name << " == b." << name;
+            }
+            context.out << "; }\n";
+        }
+        context.out << "inline bool operator!=(const " << cname << " &a, const " << cname << " &b) { return !(a == b); }\n";
     }
 };
 
 class TypePointer: public Type {
 public:
-    explicit TypePointer(const ast::TypePointer *tp): Type(tp), tp(tp) {}
+    explicit TypePointer(const ast::TypePointer *tp): Type(tp), tp(tp), reftype(dynamic_cast<const TypeRecord *>(transform(tp->reftype))) {}
     TypePointer(const TypePointer &) = delete;
     TypePointer &operator=(const TypePointer &) = delete;
     const ast::TypePointer *tp;
+    const TypeRecord *reftype;
+    virtual bool is_scalar() const override { return true; }
+    virtual void generate_type(Context &context) const override {
+        // A pointer with no class, such as the hidden __classtype field
+        // of every class, is never dereferenced.
+        if (reftype == nullptr) {
+            context.out << "std::shared_ptr<void>";
+        } else {
+            context.out << "std::shared_ptr<" << reftype->cname << ">";
+        }
+    }
     virtual void generate_default(Context &context) const override {
         context.out << "nullptr";
     }
@@ -263,6 +498,7 @@ public:
     TypeInterfacePointer(const TypeInterfacePointer &) = delete;
     TypeInterfacePointer &operator=(const TypeInterfacePointer &) = delete;
     const ast::TypeInterfacePointer *tip;
+    virtual void generate_type(Context &) const override { internal_error("TypeInterfacePointer"); }
     virtual void generate_default(Context &context) const override {
         context.out << "nullptr";
     }
@@ -275,6 +511,7 @@ public:
     TypeFunctionPointer &operator=(const TypeFunctionPointer &) = delete;
     const ast::TypeFunctionPointer *fp;
     const TypeFunction *functype;
+    virtual void generate_type(Context &) const override { internal_error("TypeFunctionPointer"); }
     virtual void generate_default(Context &context) const override {
         context.out << "nullptr";
     }
@@ -286,79 +523,99 @@ public:
     TypeEnum(const TypeEnum &) = delete;
     TypeEnum &operator=(const TypeEnum &) = delete;
     const ast::TypeEnum *te;
-
+    virtual bool is_scalar() const override { return true; }
+    virtual void generate_type(Context &context) const override {
+        context.out << "int";
+    }
     virtual void generate_default(Context &context) const override {
-        context.out << "nullptr";
+        context.out << "0";
     }
 };
 
+void Variable::generate_type(Context &context) const
+{
+    if (integral) {
+        context.out << "int64_t";
+    } else {
+        type->generate_type(context);
+    }
+}
+
+void Variable::generate_decl(Context &context) const
+{
+    generate_type(context);
+    context.out << " " << cname << " = ";
+    type->generate_default(context);
+    context.out << ";\n";
+}
+
 class PredefinedVariable: public Variable {
 public:
-    explicit PredefinedVariable(const ast::PredefinedVariable *pv): Variable(pv), pv(pv) {}
+    explicit PredefinedVariable(const ast::PredefinedVariable *pv): Variable(pv), pv(pv) {
+        cname = pv->name;
+    }
     PredefinedVariable(const PredefinedVariable &) = delete;
     PredefinedVariable &operator=(const PredefinedVariable &) = delete;
     const ast::PredefinedVariable *pv;
-
-    virtual void generate_decl(Context &) const override { internal_error("PredefinedVariable"); }
-    virtual void generate(Context &context) const override {
-        context.out << pv->name;
-    }
 };
 
 class ModuleVariable: public Variable {
 public:
-    explicit ModuleVariable(const ast::ModuleVariable *mv): Variable(mv), mv(mv) {}
+    explicit ModuleVariable(const ast::ModuleVariable *mv): Variable(mv), mv(mv) {
+        cname = module_namespace(mv->module->name) + "::" + ident(mv->name);
+    }
     ModuleVariable(const ModuleVariable &) = delete;
     ModuleVariable &operator=(const ModuleVariable &) = delete;
     const ast::ModuleVariable *mv;
-
-    virtual void generate_decl(Context &) const override { internal_error("ModuleVariable"); }
-    virtual void generate(Context &context) const override {
-        context.out << mv->name;
-    }
 };
 
 class GlobalVariable: public Variable {
 public:
-    explicit GlobalVariable(const ast::GlobalVariable *gv): Variable(gv), gv(gv) {}
+    explicit GlobalVariable(const ast::GlobalVariable *gv): Variable(gv), gv(gv), exported(g_exported.find(gv) != g_exported.end()) {
+        // Exported names were reserved by Program so that other modules
+        // can refer to them without knowing about the rest of this one.
+        cname = exported ? ident(gv->name) : unique_name(g_global_names, gv->name);
+        integral = not exported && dynamic_cast<const TypeNumber *>(type) != nullptr;
+        g_globals.push_back(this);
+    }
     GlobalVariable(const GlobalVariable &) = delete;
     GlobalVariable &operator=(const GlobalVariable &) = delete;
     const ast::GlobalVariable *gv;
-
-    virtual void generate_decl(Context &) const override {
-        internal_error("GlobalVariable");
-    }
-    virtual void generate(Context &context) const override {
-        context.out << gv->name;
-    }
+    const bool exported;
 };
 
 class LocalVariable: public Variable {
 public:
-    explicit LocalVariable(const ast::LocalVariable *lv): Variable(lv), lv(lv) {}
+    explicit LocalVariable(const ast::LocalVariable *lv);
     LocalVariable(const LocalVariable &) = delete;
     LocalVariable &operator=(const LocalVariable &) = delete;
     const ast::LocalVariable *lv;
-
-    virtual void generate_decl(Context &) const override {
-        internal_error("LocalVariable");
-    }
-    virtual void generate(Context &context) const override {
-        context.out << lv->name;
-    }
 };
 
 class FunctionParameter: public Variable {
 public:
-    explicit FunctionParameter(const ast::FunctionParameter *fp, int index): Variable(fp), fp(fp), index(index) {}
+    explicit FunctionParameter(const ast::FunctionParameter *fp, int index, std::set<std::string> &names): Variable(fp), fp(fp), index(index) {
+        cname = unique_name(names, fp->name);
+        integral = dynamic_cast<const TypeNumber *>(type) != nullptr && fp->mode == ast::ParameterType::Mode::IN;
+    }
     FunctionParameter(const FunctionParameter &) = delete;
     FunctionParameter &operator=(const FunctionParameter &) = delete;
     const ast::FunctionParameter *fp;
     const int index;
 
-    virtual void generate_decl(Context &) const override { internal_error("FunctionParameter"); }
-    virtual void generate(Context &context) const override {
-        context.out << fp->name;
+    void generate_param(Context &context) const {
+        if (fp->mode != ast::ParameterType::Mode::IN) {
+            type->generate_type(context);
+            context.out << " &";
+        } else if (type->is_scalar()) {
+            generate_type(context);
+            context.out << " ";
+        } else {
+            context.out << "const ";
+            type->generate_type(context);
+            context.out << " &";
+        }
+        context.out << cname;
     }
 };
 
@@ -376,13 +633,26 @@ public:
 
 class ConstantNumberExpression: public Expression {
 public:
-    explicit ConstantNumberExpression(const ast::ConstantNumberExpression *cne): Expression(cne), cne(cne) {}
+    explicit ConstantNumberExpression(const ast::ConstantNumberExpression *cne): Expression(cne), cne(cne), integer(false) {
+        if (number_is_integer(cne->value)) {
+            Number lo = number_from_sint64(INT64_MIN);
+            Number hi = number_from_sint64(INT64_MAX);
+            integer = number_is_greater_equal(cne->value, lo) && number_is_less_equal(cne->value, hi);
+        }
+    }
     ConstantNumberExpression(const ConstantNumberExpression &) = delete;
     ConstantNumberExpression &operator=(const ConstantNumberExpression &) = delete;
     const ast::ConstantNumberExpression *cne;
+    bool integer;
 
+    virtual bool is_integer() const override { return integer; }
     virtual void generate(Context &context) const override {
-        context.out << number_to_string(cne->value);
+        const std::string s = number_to_string(cne->value);
+        if (integer) {
+            context.out << "INT64_C(" << s << ")";
+        } else {
+            context.out << "NEON_NUMBER(" << quoted(s) << ")";
+        }
     }
 };
 
@@ -394,7 +664,12 @@ public:
     const ast::ConstantStringExpression *cse;
 
     virtual void generate(Context &context) const override {
-        context.out << quoted(cse->value.str());
+        const std::string &s = cse->value.str();
+        context.out << "std::string(" << quoted(s);
+        if (s.find('\0') != std::string::npos) {
+            context.out << ", " << s.size();
+        }
+        context.out << ")";
     }
 };
 
@@ -406,7 +681,17 @@ public:
     const ast::ConstantBytesExpression *cbe;
 
     virtual void generate(Context &context) const override {
-        context.out << "TODO";
+        context.out << "neon::Bytes{";
+        bool first = true;
+        for (auto b: cbe->contents) {
+            if (first) {
+                first = false;
+            } else {
+                context.out << ", ";
+            }
+            context.out << static_cast<unsigned int>(b);
+        }
+        context.out << "}";
     }
 };
 
@@ -419,7 +704,7 @@ public:
     const TypeEnum *type;
 
     virtual void generate(Context &context) const override {
-        context.out << "nullptr"; // TODO
+        context.out << cee->value;
     }
 };
 
@@ -455,11 +740,28 @@ public:
     const ast::TypeConversionExpression *tce;
     const Expression *expr;
 
+    virtual bool is_integer() const override {
+        return dynamic_cast<const TypeNumber *>(type) != nullptr && expr->is_integer();
+    }
     virtual void generate(Context &context) const override {
         expr->generate(context);
     }
 };
 
+// Generate expr as a value of type t. Brace initialisation does not
+// allow the narrowing conversion from int64_t to a general Number, so
+// elements of array and dictionary literals are converted explicitly.
+void generate_converted(Context &context, const Type *t, const Expression *expr)
+{
+    if (dynamic_cast<const TypeNumber *>(t) != nullptr && expr->is_integer()) {
+        context.out << "static_cast<neon::Number>(";
+        expr->generate(context);
+        context.out << ")";
+    } else {
+        expr->generate(context);
+    }
+}
+
 class ArrayLiteralExpression: public Expression {
 public:
     explicit ArrayLiteralExpression(const ast::ArrayLiteralExpression *ale): Expression(ale), ale(ale), elements() {
@@ -473,10 +775,22 @@ public:
     std::vector<const Expression *> elements;
 
     virtual void generate(Context &context) const override {
+        if (elements.empty()) {
+            // The element type of an empty literal is not known here.
+            context.out << "{}";
+            return;
+        }
+        const TypeArray *ta = dynamic_cast<const TypeArray *>(type);
+        ta->generate_type(context);
         context.out << "{";
+        bool first = true;
         for (auto e: elements) {
-            e->generate(context);
-            context.out << ","; // TODO: omit last comma
+            if (first) {
+                first = false;
+            } else {
+                context.out << ", ";
+            }
+            generate_converted(context, ta->elementtype, e);
         }
         context.out << "}";
     }
@@ -486,15 +800,21 @@ class DictionaryLiteralExpression: public Expression {
 public:
     explicit DictionaryLiteralExpression(const ast::DictionaryLiteralExpression *dle): Expression(dle), dle(dle), dict() {
         for (auto d: dle->dict) {
-            dict[d.first.str()] = transform(d.second); // TODO: utf8
+            dict.push_back(std::make_pair(d.first.str(), transform(d.second)));
         }
     }
     DictionaryLiteralExpression(const DictionaryLiteralExpression &) = delete;
     DictionaryLiteralExpression &operator=(const DictionaryLiteralExpression &) = delete;
     const ast::DictionaryLiteralExpression *dle;
-    std::map<std::string, const Expression *> dict;
+    std::vector<std::pair<std::string, const Expression *>> dict;
 
     virtual void generate(Context &context) const override {
+        if (dict.empty()) {
+            context.out << "{}";
+            return;
+        }
+        const TypeDictionary *td = dynamic_cast<const TypeDictionary *>(type);
+        td->generate_type(context);
         context.out << "{";
         bool first = true;
         for (auto d: dict) {
@@ -503,9 +823,9 @@ public:
             } else {
                 context.out << ", ";
             }
-            context.out << quoted(d.first);
-            context.out << ':';
-            d.second->generate(context);
+            context.out << "{" << quoted(d.first) << ", ";
+            generate_converted(context, td->elementtype, d.second);
+            context.out << "}";
         }
         context.out << "}";
     }
@@ -525,21 +845,20 @@ public:
     std::vector<const Expression *> values;
 
     virtual void generate(Context &context) const override {
-        context.out << "{";
-        int i = 0;
-        bool first = true;
-        for (auto v: values) {
-            if (first) {
-                first = false;
-            } else {
+        context.out << type->cname << "(";
+        for (size_t i = 0; i < values.size(); i++) {
+            if (i > 0) {
                 context.out << ", ";
             }
-            context.out << quoted(type->tr->fields[i].name.text);
-            context.out << ':';
-            v->generate(context);
-            i++;
+            // The default value of a record field is an untyped array
+            // literal, which is the record's default constructor here.
+            if (dynamic_cast<const TypeRecord *>(type->field_types[i]) != nullptr && dynamic_cast<const ArrayLiteralExpression *>(values[i]) != nullptr) {
+                type->field_types[i]->generate_default(context);
+            } else {
+                values[i]->generate(context);
+            }
         }
-        context.out << "}";
+        context.out << ")";
     }
 };
 
@@ -561,11 +880,11 @@ public:
     const TypeRecord *type;
 
     virtual void generate(Context &context) const override {
+        context.out << "std::make_shared<" << type->cname << ">(";
         if (value != nullptr) {
             value->generate(context);
-        } else {
-            type->generate_default(context);
         }
+        context.out << ")";
     }
 };
 
@@ -578,9 +897,15 @@ public:
     const Expression *value;
 
     virtual void generate(Context &context) const override {
-        context.out << "(-";
-        value->generate(context);
-        context.out << ")";
+        if (value->is_integer()) {
+            context.out << "neon::negate(";
+            value->generate(context);
+            context.out << ")";
+        } else {
+            context.out << "(-";
+            value->generate(context);
+            context.out << ")";
+        }
     }
 };
 
@@ -609,6 +934,7 @@ public:
     const Expression *left;
     const Expression *right;
 
+    virtual bool is_integer() const override { return left->is_integer() && right->is_integer(); }
     virtual void generate(Context &context) const override {
         context.out << "(";
         condition->generate(context);
@@ -701,8 +1027,12 @@ public:
     const Expression *left;
     const Expression *right;
 
-    virtual void generate(Context &) const override {
-        internal_error("ArrayInExpression");
+    virtual void generate(Context &context) const override {
+        context.out << "neon::array_contains(";
+        right->generate(context);
+        context.out << ", ";
+        left->generate(context);
+        context.out << ")";
     }
 };
 
@@ -715,8 +1045,12 @@ public:
     const Expression *left;
     const Expression *right;
 
-    virtual void generate(Context &) const override {
-        internal_error("DictionaryInExpression");
+    virtual void generate(Context &context) const override {
+        context.out << "neon::dictionary_contains(";
+        right->generate(context);
+        context.out << ", ";
+        left->generate(context);
+        context.out << ")";
     }
 };
 
@@ -736,7 +1070,16 @@ public:
         right->generate(context);
         context.out << ")";
     }
-    virtual void generate_comparison(Context &context) const = 0;
+    virtual void generate_comparison(Context &context) const {
+        switch (ce->comp) {
+            case ast::ComparisonExpression::Comparison::EQ: context.out << " == "; break;
+            case ast::ComparisonExpression::Comparison::NE: context.out << " != "; break;
+            case ast::ComparisonExpression::Comparison::LT: context.out << " < "; break;
+            case ast::ComparisonExpression::Comparison::GT: context.out << " > "; break;
+            case ast::ComparisonExpression::Comparison::LE: context.out << " <= "; break;
+            case ast::ComparisonExpression::Comparison::GE: context.out << " >= "; break;
+        }
+    }
 };
 
 class ChainedComparisonExpression: public Expression {
@@ -756,6 +1099,7 @@ public:
     std::vector<const ComparisonExpression *> comps;
 
     virtual void generate(Context &context) const override {
+        context.out << "(";
         bool first = true;
         for (auto c: comps) {
             if (first) {
@@ -765,6 +1109,7 @@ public:
             }
             c->generate(context);
         }
+        context.out << ")";
     }
 };
 
@@ -774,15 +1119,6 @@ public:
     BooleanComparisonExpression(const BooleanComparisonExpression &) = delete;
     BooleanComparisonExpression &operator=(const BooleanComparisonExpression &) = delete;
     const ast::BooleanComparisonExpression *bce;
-
-    virtual void generate_comparison(Context &context) const override {
-        switch (bce->comp) {
-            case ast::ComparisonExpression::Comparison::EQ: context.out << " == "; break;
-            case ast::ComparisonExpression::Comparison::NE: context.out << " != "; break;
-            default:
-                internal_error("unexpected comparison type");
-        }
-    }
 };
 
 class NumericComparisonExpression: public ComparisonExpression {
@@ -791,17 +1127,6 @@ public:
     NumericComparisonExpression(const NumericComparisonExpression &) = delete;
     NumericComparisonExpression &operator=(const NumericComparisonExpression &) = delete;
     const ast::NumericComparisonExpression *nce;
-
-    virtual void generate_comparison(Context &context) const override {
-        switch (nce->comp) {
-            case ast::ComparisonExpression::Comparison::EQ: context.out << " == "; break;
-            case ast::ComparisonExpression::Comparison::NE: context.out << " != "; break;
-            case ast::ComparisonExpression::Comparison::LT: context.out << " < "; break;
-            case ast::ComparisonExpression::Comparison::GT: context.out << " > "; break;
-            case ast::ComparisonExpression::Comparison::LE: context.out << " <= "; break;
-            case ast::ComparisonExpression::Comparison::GE: context.out << " >= "; break;
-        }
-    }
 };
 
 class EnumComparisonExpression: public ComparisonExpression {
@@ -810,15 +1135,6 @@ public:
     EnumComparisonExpression(const EnumComparisonExpression &) = delete;
     EnumComparisonExpression &operator=(const EnumComparisonExpression &) = delete;
     const ast::EnumComparisonExpression *ece;
-
-    virtual void generate_comparison(Context &context) const override {
-        switch (ece->comp) {
-            case ast::ComparisonExpression::Comparison::EQ: context.out << " == "; break;
-            case ast::ComparisonExpression::Comparison::NE: context.out << " != "; break;
-            default:
-                internal_error("unexpected comparison type");
-        }
-    }
 };
 
 class StringComparisonExpression: public ComparisonExpression {
@@ -827,17 +1143,6 @@ public:
     StringComparisonExpression(const StringComparisonExpression &) = delete;
     StringComparisonExpression &operator=(const StringComparisonExpression &) = delete;
     const ast::StringComparisonExpression *sce;
-
-    virtual void generate_comparison(Context &context) const override {
-        switch (sce->comp) {
-            case ast::ComparisonExpression::Comparison::EQ: context.out << " == "; break;
-            case ast::ComparisonExpression::Comparison::NE: context.out << " != "; break;
-            case ast::ComparisonExpression::Comparison::LT: context.out << " < "; break;
-            case ast::ComparisonExpression::Comparison::GT: context.out << " > "; break;
-            case ast::ComparisonExpression::Comparison::LE: context.out << " <= "; break;
-            case ast::ComparisonExpression::Comparison::GE: context.out << " >= "; break;
-        }
-    }
 };
 
 class BytesComparisonExpression: public ComparisonExpression {
@@ -846,17 +1151,6 @@ public:
     BytesComparisonExpression(const BytesComparisonExpression &) = delete;
     BytesComparisonExpression &operator=(const BytesComparisonExpression &) = delete;
     const ast::BytesComparisonExpression *bce;
-
-    virtual void generate_comparison(Context &context) const override {
-        switch (bce->comp) {
-            case ast::ComparisonExpression::Comparison::EQ: context.out << " == "; break;
-            case ast::ComparisonExpression::Comparison::NE: context.out << " != "; break;
-            case ast::ComparisonExpression::Comparison::LT: context.out << " < "; break;
-            case ast::ComparisonExpression::Comparison::GT: context.out << " > "; break;
-            case ast::ComparisonExpression::Comparison::LE: context.out << " <= "; break;
-            case ast::ComparisonExpression::Comparison::GE: context.out << " >= "; break;
-        }
-    }
 };
 
 class ArrayComparisonExpression: public ComparisonExpression {
@@ -865,10 +1159,6 @@ public:
     ArrayComparisonExpression(const ArrayComparisonExpression &) = delete;
     ArrayComparisonExpression &operator=(const ArrayComparisonExpression &) = delete;
     const ast::ArrayComparisonExpression *ace;
-
-    virtual void generate_comparison(Context &context) const override {
-        context.out << "==";
-    }
 };
 
 class DictionaryComparisonExpression: public ComparisonExpression {
@@ -877,10 +1167,6 @@ public:
     DictionaryComparisonExpression(const DictionaryComparisonExpression &) = delete;
     DictionaryComparisonExpression &operator=(const DictionaryComparisonExpression &) = delete;
     const ast::DictionaryComparisonExpression *dce;
-
-    virtual void generate_comparison(Context &) const override {
-        internal_error("DictionaryComparisonExpression");
-    }
 };
 
 class RecordComparisonExpression: public ComparisonExpression {
@@ -889,10 +1175,6 @@ public:
     RecordComparisonExpression(const RecordComparisonExpression &) = delete;
     RecordComparisonExpression &operator=(const RecordComparisonExpression &) = delete;
     const ast::RecordComparisonExpression *rce;
-
-    virtual void generate_comparison(Context &) const override {
-        internal_error("RecordComparisonExpression");
-    }
 };
 
 class PointerComparisonExpression: public ComparisonExpression {
@@ -901,10 +1183,6 @@ public:
     PointerComparisonExpression(const PointerComparisonExpression &) = delete;
     PointerComparisonExpression &operator=(const PointerComparisonExpression &) = delete;
     const ast::PointerComparisonExpression *pce;
-
-    virtual void generate_comparison(Context &context) const override {
-        context.out << " == ";
-    }
 };
 
 class ValidPointerExpression: public PointerComparisonExpression {
@@ -916,13 +1194,11 @@ public:
     const Variable *var;
 
     virtual void generate(Context &context) const override {
-        context.out << "(";
+        context.out << "((";
         var->generate(context);
-        context.out << "=";
+        context.out << " = ";
         left->generate(context);
-        context.out << ")";
-        context.out << "!=";
-        right->generate(context);
+        context.out << ") != nullptr)";
     }
 };
 
@@ -932,69 +1208,68 @@ public:
     FunctionPointerComparisonExpression(const FunctionPointerComparisonExpression &) = delete;
     FunctionPointerComparisonExpression &operator=(const FunctionPointerComparisonExpression &) = delete;
     const ast::FunctionPointerComparisonExpression *fpce;
+};
 
-    virtual void generate_comparison(Context &context) const override {
-        switch (fpce->comp) {
-            case ast::ComparisonExpression::Comparison::EQ: context.out << " == "; break;
-            case ast::ComparisonExpression::Comparison::NE: context.out << " != "; break;
-            default:
-                internal_error("unexpected comparison type");
+// Arithmetic on two int64_t operands goes through the helpers in the
+// runtime, which give a general Number so that an overflowing result
+// keeps its full value. Anything else uses the operators of neon::Number.
+class ArithmeticExpression: public Expression {
+public:
+    ArithmeticExpression(const ast::Expression *node, const ast::Expression *left, const ast::Expression *right, const char *op, const char *function): Expression(node), left(transform(left)), right(transform(right)), op(op), function(function), bound(nullptr) {}
+    ArithmeticExpression(const ArithmeticExpression &) = delete;
+    ArithmeticExpression &operator=(const ArithmeticExpression &) = delete;
+    const Expression *left;
+    const Expression *right;
+    const char *op;
+    const char *function;
+    // For the step at the end of a FOR loop whose step fits in an
+    // int64_t, the loop's bound. The loop exits before its counter passes
+    // the bound, so the counter fits in an int64_t whenever its start and
+    // bound do, and ForStatement generates the step itself.
+    const Variable *bound;
+
+    virtual bool is_integer() const override {
+        return bound != nullptr && bound->integral && left->is_integer();
+    }
+    virtual void generate(Context &context) const override {
+        if (left->is_integer() && right->is_integer()) {
+            context.out << "neon::" << function << "(";
+            left->generate(context);
+            context.out << ", ";
+            right->generate(context);
+            context.out << ")";
+        } else {
+            context.out << "(";
+            left->generate(context);
+            context.out << " " << op << " ";
+            right->generate(context);
+            context.out << ")";
         }
     }
 };
 
-class AdditionExpression: public Expression {
+class AdditionExpression: public ArithmeticExpression {
 public:
-    explicit AdditionExpression(const ast::AdditionExpression *ae): Expression(ae), ae(ae), left(transform(ae->left)), right(transform(ae->right)) {}
+    explicit AdditionExpression(const ast::AdditionExpression *ae): ArithmeticExpression(ae, ae->left, ae->right, "+", "add"), ae(ae) {}
     AdditionExpression(const AdditionExpression &) = delete;
     AdditionExpression &operator=(const AdditionExpression &) = delete;
     const ast::AdditionExpression *ae;
-    const Expression *left;
-    const Expression *right;
-
-    virtual void generate(Context &context) const override {
-        context.out << "(";
-        left->generate(context);
-        context.out << "+";
-        right->generate(context);
-        context.out << ")";
-    }
 };
 
-class SubtractionExpression: public Expression {
+class SubtractionExpression: public ArithmeticExpression {
 public:
-    explicit SubtractionExpression(const ast::SubtractionExpression *se): Expression(se), se(se), left(transform(se->left)), right(transform(se->right)) {}
+    explicit SubtractionExpression(const ast::SubtractionExpression *se): ArithmeticExpression(se, se->left, se->right, "-", "subtract"), se(se) {}
     SubtractionExpression(const SubtractionExpression &) = delete;
     SubtractionExpression &operator=(const SubtractionExpression &) = delete;
     const ast::SubtractionExpression *se;
-    const Expression *left;
-    const Expression *right;
-
-    virtual void generate(Context &context) const override {
-        context.out << "(";
-        left->generate(context);
-        context.out << "-";
-        right->generate(context);
-        context.out << ")";
-    }
 };
 
-class MultiplicationExpression: public Expression {
+class MultiplicationExpression: public ArithmeticExpression {
 public:
-    explicit MultiplicationExpression(const ast::MultiplicationExpression *me): Expression(me), me(me), left(transform(me->left)), right(transform(me->right)) {}
+    explicit MultiplicationExpression(const ast::MultiplicationExpression *me): ArithmeticExpression(me, me->left, me->right, "*", "multiply"), me(me) {}
     MultiplicationExpression(const MultiplicationExpression &) = delete;
     MultiplicationExpression &operator=(const MultiplicationExpression &) = delete;
     const ast::MultiplicationExpression *me;
-    const Expression *left;
-    const Expression *right;
-
-    virtual void generate(Context &context) const override {
-        context.out << "(";
-        left->generate(context);
-        context.out << "*";
-        right->generate(context);
-        context.out << ")";
-    }
 };
 
 class DivisionExpression: public Expression {
@@ -1007,7 +1282,7 @@ public:
     const Expression *right;
 
     virtual void generate(Context &context) const override {
-        context.out << "neon.global.divide(";
+        context.out << "neon::divide(";
         left->generate(context);
         context.out << ", ";
         right->generate(context);
@@ -1024,11 +1299,13 @@ public:
     const Expression *left;
     const Expression *right;
 
+    virtual bool is_integer() const override { return left->is_integer() && right->is_integer(); }
     virtual void generate(Context &context) const override {
-        context.out << "(";
-        left->generate(context);
-        context.out << "%";
-        right->generate(context);
+        // Mixed operands must be converted so that the call is not ambiguous.
+        context.out << "neon::modulo(";
+        generate_converted(context, is_integer() ? nullptr : type, left);
+        context.out << ", ";
+        generate_converted(context, is_integer() ? nullptr : type, right);
         context.out << ")";
     }
 };
@@ -1043,9 +1320,9 @@ public:
     const Expression *right;
 
     virtual void generate(Context &context) const override {
-        context.out << "neon::math.pow(";
+        context.out << "neon::power(";
         left->generate(context);
-        context.out << ",";
+        context.out << ", ";
         right->generate(context);
         context.out << ")";
     }
@@ -1071,10 +1348,18 @@ public:
     const Expression *index;
 
     virtual void generate(Context &context) const override {
+        context.out << "neon::array_index(";
         array->generate(context);
-        context.out << "[";
+        context.out << ", ";
         index->generate(context);
-        context.out << "]";
+        context.out << ")";
+    }
+    virtual void generate_lvalue(Context &context) const override {
+        context.out << "neon::array_index_for_write(";
+        array->generate_lvalue(context);
+        context.out << ", ";
+        index->generate(context);
+        context.out << ")";
     }
 };
 
@@ -1088,10 +1373,11 @@ public:
     const Expression *index;
 
     virtual void generate(Context &context) const override {
+        context.out << "neon::array_index(";
         array->generate(context);
-        context.out << "[";
+        context.out << ", ";
         index->generate(context);
-        context.out << "]";
+        context.out << ")";
     }
 };
 
@@ -1105,7 +1391,14 @@ public:
     const Expression *index;
 
     virtual void generate(Context &context) const override {
+        context.out << "neon::dictionary_index(";
         dictionary->generate(context);
+        context.out << ", ";
+        index->generate(context);
+        context.out << ")";
+    }
+    virtual void generate_lvalue(Context &context) const override {
+        dictionary->generate_lvalue(context);
         context.out << "[";
         index->generate(context);
         context.out << "]";
@@ -1121,66 +1414,80 @@ public:
     const Expression *dictionary;
     const Expression *index;
 
-    virtual void generate(Context &) const override {
-        internal_error("DictionaryValueIndexExpression");
+    virtual void generate(Context &context) const override {
+        context.out << "neon::dictionary_index(";
+        dictionary->generate(context);
+        context.out << ", ";
+        index->generate(context);
+        context.out << ")";
     }
 };
 
 class StringReferenceIndexExpression: public Expression {
 public:
-    explicit StringReferenceIndexExpression(const ast::StringReferenceIndexExpression *srie): Expression(srie), srie(srie), ref(transform(srie->ref)), index(transform(srie->index)) {}
+    explicit StringReferenceIndexExpression(const ast::StringReferenceIndexExpression *srie): Expression(srie), srie(srie), ref(transform(srie->ref)), index(transform(srie->index)), load(transform(srie->load)) {}
     StringReferenceIndexExpression(const StringReferenceIndexExpression &) = delete;
     StringReferenceIndexExpression &operator=(const StringReferenceIndexExpression &) = delete;
     const ast::StringReferenceIndexExpression *srie;
     const Expression *ref;
     const Expression *index;
+    const Expression *load;
 
-    virtual void generate(Context &) const override {
+    virtual void generate(Context &context) const override {
+        load->generate(context);
+    }
+    virtual void generate_lvalue(Context &) const override {
         internal_error("StringReferenceIndexExpression");
     }
 };
 
 class StringValueIndexExpression: public Expression {
 public:
-    explicit StringValueIndexExpression(const ast::StringValueIndexExpression *svie): Expression(svie), svie(svie), str(transform(svie->str)), index(transform(svie->index)) {}
+    explicit StringValueIndexExpression(const ast::StringValueIndexExpression *svie): Expression(svie), svie(svie), str(transform(svie->str)), index(transform(svie->index)), load(transform(svie->load)) {}
     StringValueIndexExpression(const StringValueIndexExpression &) = delete;
     StringValueIndexExpression &operator=(const StringValueIndexExpression &) = delete;
     const ast::StringValueIndexExpression *svie;
     const Expression *str;
     const Expression *index;
+    const Expression *load;
 
-    virtual void generate(Context &) const override {
-        internal_error("StringValueIndexExpression");
+    virtual void generate(Context &context) const override {
+        load->generate(context);
     }
 };
 
 class StringReferenceRangeIndexExpression: public Expression {
 public:
-    explicit StringReferenceRangeIndexExpression(const ast::StringReferenceRangeIndexExpression *srie): Expression(srie), srie(srie), ref(transform(srie->ref)), first(transform(srie->first)), last(transform(srie->last)) {}
+    explicit StringReferenceRangeIndexExpression(const ast::StringReferenceRangeIndexExpression *srie): Expression(srie), srie(srie), ref(transform(srie->ref)), first(transform(srie->first)), last(transform(srie->last)), load(transform(srie->load)) {}
     StringReferenceRangeIndexExpression(const StringReferenceRangeIndexExpression &) = delete;
     StringReferenceRangeIndexExpression &operator=(const StringReferenceRangeIndexExpression &) = delete;
     const ast::StringReferenceRangeIndexExpression *srie;
     const Expression *ref;
     const Expression *first;
     const Expression *last;
+    const Expression *load;
 
-    virtual void generate(Context &) const override {
+    virtual void generate(Context &context) const override {
+        load->generate(context);
+    }
+    virtual void generate_lvalue(Context &) const override {
         internal_error("StringReferenceRangeIndexExpression");
     }
 };
 
 class StringValueRangeIndexExpression: public Expression {
 public:
-    explicit StringValueRangeIndexExpression(const ast::StringValueRangeIndexExpression *svie): Expression(svie), svie(svie), str(transform(svie->str)), first(transform(svie->first)), last(transform(svie->last)) {}
+    explicit StringValueRangeIndexExpression(const ast::StringValueRangeIndexExpression *svie): Expression(svie), svie(svie), str(transform(svie->str)), first(transform(svie->first)), last(transform(svie->last)), load(transform(svie->load)) {}
     StringValueRangeIndexExpression(const StringValueRangeIndexExpression &) = delete;
     StringValueRangeIndexExpression &operator=(const StringValueRangeIndexExpression &) = delete;
     const ast::StringValueRangeIndexExpression *svie;
     const Expression *str;
     const Expression *first;
     const Expression *last;
+    const Expression *load;
 
-    virtual void generate(Context &) const override {
-        internal_error("StringValueRangeIndexExpression");
+    virtual void generate(Context &context) const override {
+        load->generate(context);
     }
 };
 
@@ -1254,7 +1561,11 @@ public:
 
     virtual void generate(Context &context) const override {
         ref->generate(context);
-        context.out << "." << rrfe->field;
+        context.out << "." << ident(rrfe->field);
+    }
+    virtual void generate_lvalue(Context &context) const override {
+        ref->generate_lvalue(context);
+        context.out << "." << ident(rrfe->field);
     }
 };
 
@@ -1270,37 +1581,42 @@ public:
 
     virtual void generate(Context &context) const override {
         rec->generate(context);
-        context.out << "." << rvfe->field;
+        context.out << "." << ident(rvfe->field);
     }
 };
 
 class ArrayReferenceRangeExpression: public Expression {
 public:
-    explicit ArrayReferenceRangeExpression(const ast::ArrayReferenceRangeExpression *arre): Expression(arre), arre(arre), ref(transform(arre->ref)), first(transform(arre->first)), last(transform(arre->last)) {}
+    explicit ArrayReferenceRangeExpression(const ast::ArrayReferenceRangeExpression *arre): Expression(arre), arre(arre), ref(transform(arre->ref)), first(transform(arre->first)), last(transform(arre->last)), load(transform(arre->load)) {}
     ArrayReferenceRangeExpression(const ArrayReferenceRangeExpression &) = delete;
     ArrayReferenceRangeExpression &operator=(const ArrayReferenceRangeExpression &) = delete;
     const ast::ArrayReferenceRangeExpression *arre;
     const Expression *ref;
     const Expression *first;
     const Expression *last;
+    const Expression *load;
 
-    virtual void generate(Context &) const override {
+    virtual void generate(Context &context) const override {
+        load->generate(context);
+    }
+    virtual void generate_lvalue(Context &) const override {
         internal_error("ArrayReferenceRangeExpression");
     }
 };
 
 class ArrayValueRangeExpression: public Expression {
 public:
-    explicit ArrayValueRangeExpression(const ast::ArrayValueRangeExpression *avre): Expression(avre), avre(avre), array(transform(avre->array)), first(transform(avre->first)), last(transform(avre->last)) {}
+    explicit ArrayValueRangeExpression(const ast::ArrayValueRangeExpression *avre): Expression(avre), avre(avre), array(transform(avre->array)), first(transform(avre->first)), last(transform(avre->last)), load(transform(avre->load)) {}
     ArrayValueRangeExpression(const ArrayValueRangeExpression &) = delete;
     ArrayValueRangeExpression &operator=(const ArrayValueRangeExpression &) = delete;
     const ast::ArrayValueRangeExpression *avre;
     const Expression *array;
     const Expression *first;
     const Expression *last;
+    const Expression *load;
 
-    virtual void generate(Context &) const override {
-        internal_error("ArrayValueRangeExpression");
+    virtual void generate(Context &context) const override {
+        load->generate(context);
     }
 };
 
@@ -1313,7 +1629,9 @@ public:
     const Expression *ptr;
 
     virtual void generate(Context &context) const override {
+        context.out << "(*";
         ptr->generate(context);
+        context.out << ")";
     }
 };
 
@@ -1323,40 +1641,44 @@ public:
     VariableExpression(const VariableExpression &) = delete;
     VariableExpression &operator=(const VariableExpression &) = delete;
     const ast::VariableExpression *ve;
-    const Variable *var;
+    Variable *var;
 
+    virtual bool is_integer() const override { return var->integral; }
     virtual void generate(Context &context) const override {
         var->generate(context);
     }
 };
 
+// Record that the value of expr is stored in the Number variable named
+// by target, if target is a plain variable.
+void add_number_flow(const Expression *target, const Expression *expr)
+{
+    const VariableExpression *ve = dynamic_cast<const VariableExpression *>(target);
+    if (ve != nullptr && dynamic_cast<const TypeNumber *>(ve->var->type) != nullptr) {
+        g_number_flows.push_back(std::make_pair(ve->var, expr));
+    }
+}
+
 class FunctionCall: public Expression {
 public:
-    explicit FunctionCall(const ast::FunctionCall *fc): Expression(fc), fc(fc), func(transform(fc->func)), args() {
-        for (auto a: fc->args) {
-            args.push_back(transform(a));
-        }
-    }
+    explicit FunctionCall(const ast::FunctionCall *fc);
     FunctionCall(const FunctionCall &) = delete;
     FunctionCall &operator=(const FunctionCall &) = delete;
     const ast::FunctionCall *fc;
     const Expression *func;
     std::vector<const Expression *> args;
+    std::vector<ast::ParameterType::Mode> modes;
 
-    virtual void generate(Context &context) const override {
-        func->generate(context);
-        context.out << "(";
-        bool first = true;
-        for (auto a: args) {
-            if (first) {
-                first = false;
-            } else {
-                context.out << ",";
-            }
-            a->generate(context);
-        }
-        context.out << ")";
+    // The called variable, if this calls a function by name.
+    const Variable *callee() const {
+        const VariableExpression *ve = dynamic_cast<const VariableExpression *>(func);
+        return ve != nullptr ? ve->var : nullptr;
+    }
+    virtual bool is_integer() const override {
+        const Variable *f = callee();
+        return f != nullptr && f->integral;
     }
+    virtual void generate(Context &context) const override;
 };
 
 class NullStatement: public Statement {
@@ -1379,6 +1701,8 @@ public:
     virtual void generate(Context &) const override {}
 };
 
+// Variables and functions are all declared at the top of their C++
+// scope, so a declaration generates no code where it appears.
 class DeclarationStatement: public Statement {
 public:
     explicit DeclarationStatement(const ast::DeclarationStatement *ds): Statement(ds), ds(ds), decl(transform(ds->decl)) {}
@@ -1387,9 +1711,7 @@ public:
     const ast::DeclarationStatement *ds;
     const Variable *decl;
 
-    virtual void generate(Context &context) const override {
-        decl->generate_decl(context);
-    }
+    virtual void generate(Context &) const override {}
 };
 
 class AssertStatement: public Statement {
@@ -1406,13 +1728,13 @@ public:
     const Expression *expr;
 
     virtual void generate(Context &context) const override {
-        context.out << "if (!(";
+        context.out << "if (!";
         expr->generate(context);
-        context.out << ")) {";
+        context.out << ") {\n";
         for (auto s: statements) {
             s->generate(context);
         }
-        context.out << "}";
+        context.out << "}\n";
     }
 };
 
@@ -1420,7 +1742,9 @@ class AssignmentStatement: public Statement {
 public:
     explicit AssignmentStatement(const ast::AssignmentStatement *as): Statement(as), as(as), variables(), expr(transform(as->expr)) {
         for (auto v: as->variables) {
-            variables.push_back(transform(v));
+            const Expression *target = transform(v);
+            variables.push_back(target);
+            add_number_flow(target, expr);
         }
     }
     AssignmentStatement(const AssignmentStatement &) = delete;
@@ -1432,12 +1756,12 @@ public:
     virtual void generate(Context &context) const override {
         for (auto v: variables) {
             if (dynamic_cast<const DummyExpression *>(v) == nullptr) {
-                v->generate(context);
-                context.out << "=";
+                v->generate_lvalue(context);
+                context.out << " = ";
             }
         }
         expr->generate(context);
-        context.out << ";";
+        context.out << ";\n";
     }
 };
 
@@ -1451,7 +1775,7 @@ public:
 
     virtual void generate(Context &context) const override {
         expr->generate(context);
-        context.out << ";";
+        context.out << ";\n";
     }
 };
 
@@ -1490,20 +1814,74 @@ public:
     std::vector<const Statement *> prologue;
     std::vector<const Statement *> tail;
 
-    virtual void generate(Context &) const override {
-        internal_error("BaseLoopStatement");
+    virtual void generate_tail(Context &context) const {
+        for (auto s: tail) {
+            s->generate(context);
+        }
+    }
+
+    // EXIT and NEXT jump to labels, because they may name an outer loop.
+    virtual void generate(Context &context) const override {
+        for (auto s: prologue) {
+            s->generate(context);
+        }
+        context.out << "for (;;) {\n";
+        for (auto s: statements) {
+            s->generate(context);
+        }
+        if (g_next_labels.find(bls->loop_id) != g_next_labels.end()) {
+            context.out << "neon_next_" << loop_number(bls->loop_id) << ":;\n";
+        }
+        generate_tail(context);
+        context.out << "}\n";
+        if (g_exit_labels.find(bls->loop_id) != g_exit_labels.end()) {
+            context.out << "neon_exit_" << loop_number(bls->loop_id) << ":;\n";
+        }
+    }
+};
+
+// A FOR loop whose counter, bound and step are all int64_t steps the
+// counter with a checked addition, and exits if that overflows, since the
+// counter would have passed the bound anyway.
+class ForStatement: public BaseLoopStatement {
+public:
+    explicit ForStatement(const ast::ForStatement *fs): BaseLoopStatement(fs), fs(fs), var(transform(fs->var)), step(nullptr) {
+        if (number_is_integer(fs->step) && number_is_greater_equal(fs->step, number_from_sint64(-INT64_MAX)) && number_is_less_equal(fs->step, number_from_sint64(INT64_MAX))) {
+            const ast::AssignmentStatement *as = dynamic_cast<const ast::AssignmentStatement *>(fs->tail.at(0));
+            step = dynamic_cast<ArithmeticExpression *>(g_expression_cache.at(as->expr));
+            step->bound = transform(fs->bound);
+        }
+    }
+    ForStatement(const ForStatement &) = delete;
+    ForStatement &operator=(const ForStatement &) = delete;
+    const ast::ForStatement *fs;
+    const Variable *var;
+    ArithmeticExpression *step;
+
+    virtual void generate_tail(Context &context) const override {
+        if (step == nullptr || not step->is_integer()) {
+            BaseLoopStatement::generate_tail(context);
+            return;
+        }
+        context.out << "if (not neon::checked_add(";
+        var->generate(context);
+        context.out << ", INT64_C(" << number_to_string(fs->step) << "), ";
+        var->generate(context);
+        context.out << ")) {\nbreak;\n}\n";
     }
 };
 
 class CaseStatement: public Statement {
 public:
+    // The CASE value is evaluated once into neon_case, which the
+    // conditions compare against.
     class WhenCondition {
     public:
         WhenCondition() {}
         WhenCondition(const WhenCondition &) = delete;
         WhenCondition &operator=(const WhenCondition &) = delete;
         virtual ~WhenCondition() {}
-        virtual void generate(Context &context, const Expression *value) const = 0;
+        virtual void generate(Context &context) const = 0;
     };
     class ComparisonWhenCondition: public WhenCondition {
     public:
@@ -1512,8 +1890,8 @@ public:
         ComparisonWhenCondition &operator=(const ComparisonWhenCondition &) = delete;
         ast::ComparisonExpression::Comparison comp;
         const Expression *expr;
-        virtual void generate(Context &context, const Expression *value) const override {
-            value->generate(context);
+        virtual void generate(Context &context) const override {
+            context.out << "neon_case";
             switch (comp) {
                 case ast::ComparisonExpression::Comparison::EQ: context.out << " == "; break;
                 case ast::ComparisonExpression::Comparison::NE: context.out << " != "; break;
@@ -1532,14 +1910,12 @@ public:
         RangeWhenCondition &operator=(const RangeWhenCondition &) = delete;
         const Expression *low_expr;
         const Expression *high_expr;
-        virtual void generate(Context &context, const Expression *value) const override {
-            value->generate(context);
-            context.out << " >= ";
+        virtual void generate(Context &context) const override {
+            context.out << "(neon_case >= ";
             low_expr->generate(context);
-            context.out << " && ";
-            value->generate(context);
-            context.out << " <= ";
+            context.out << " && neon_case <= ";
             high_expr->generate(context);
+            context.out << ")";
         }
     };
     explicit CaseStatement(const ast::CaseStatement *cs): Statement(cs), cs(cs), expr(transform(cs->expr)), clauses() {
@@ -1570,6 +1946,10 @@ public:
     std::vector<std::pair<std::vector<const WhenCondition *>, std::vector<const Statement *>>> clauses;
 
     virtual void generate(Context &context) const override {
+        context.out << "{\n";
+        context.out << "const auto &neon_case = ";
+        expr->generate(context);
+        context.out << ";\n";
         bool first_clause = true;
         for (auto c: clauses) {
             if (first_clause) {
@@ -1586,40 +1966,45 @@ public:
                     } else {
                         context.out << " || ";
                     }
-                    w->generate(context, expr);
+                    w->generate(context);
                 }
-                context.out << ")";
+                context.out << ") ";
             }
-            context.out << "{";
+            context.out << "{\n";
             for (auto s: c.second) {
                 s->generate(context);
             }
             context.out << "}";
         }
+        context.out << "\n}\n";
     }
 };
 
 class ExitStatement: public Statement {
 public:
-    explicit ExitStatement(const ast::ExitStatement *es): Statement(es), es(es) {}
+    explicit ExitStatement(const ast::ExitStatement *es): Statement(es), es(es) {
+        g_exit_labels.insert(es->loop_id);
+    }
     ExitStatement(const ExitStatement &) = delete;
     ExitStatement &operator=(const ExitStatement &) = delete;
     const ast::ExitStatement *es;
 
     void generate(Context &context) const override {
-        context.out << "break;"; // TODO: use label to get correct loop
+        context.out << "goto neon_exit_" << loop_number(es->loop_id) << ";\n";
     }
 };
 
 class NextStatement: public Statement {
 public:
-    explicit NextStatement(const ast::NextStatement *ns): Statement(ns), ns(ns) {}
+    explicit NextStatement(const ast::NextStatement *ns): Statement(ns), ns(ns) {
+        g_next_labels.insert(ns->loop_id);
+    }
     NextStatement(const NextStatement &) = delete;
     NextStatement &operator=(const NextStatement &) = delete;
     const ast::NextStatement *ns;
 
     virtual void generate(Context &context) const override {
-        context.out << "continue;"; // TODO: use label to get correct loop
+        context.out << "goto neon_next_" << loop_number(ns->loop_id) << ";\n";
     }
 };
 
@@ -1654,30 +2039,48 @@ public:
     std::vector<const TryStatementTrap *> catches;
 
     virtual void generate(Context &context) const override {
-        context.out << "try {";
+        context.out << "try {\n";
         for (auto s: statements) {
             s->generate(context);
         }
-        context.out << "}";
+        context.out << "} catch (neon::NeonException &neon_x) {\n";
+        bool first = true;
         for (auto c: catches) {
+            if (first) {
+                first = false;
+            } else {
+                context.out << " else ";
+            }
+            context.out << "if (";
+            bool first_exception = true;
+            for (auto e: c->tt->exceptions) {
+                if (first_exception) {
+                    first_exception = false;
+                } else {
+                    context.out << " || ";
+                }
+                context.out << "neon_x.is(" << quoted(e->name) << ")";
+            }
+            context.out << ") {\n";
             if (c->name != nullptr) {
-                context.out << " catch (";
+                // The trapped exception is described by an ExceptionType record.
                 c->name->generate(context);
-                context.out << ") {";
-            } else {
-                context.out << " catch (__x) {";
+                context.out << " = ";
+                c->name->type->generate_type(context);
+                context.out << "(neon_x.name, neon_x.info_text(), 0, 0);\n";
             }
             for (auto s: c->handler) {
                 s->generate(context);
             }
             context.out << "}";
         }
+        context.out << " else {\nthrow;\n}\n}\n";
     }
 };
 
 class ReturnStatement: public Statement {
 public:
-    explicit ReturnStatement(const ast::ReturnStatement *rs): Statement(rs), rs(rs), expr(transform(rs->expr)) {}
+    explicit ReturnStatement(const ast::ReturnStatement *rs);
     ReturnStatement(const ReturnStatement &) = delete;
     ReturnStatement &operator=(const ReturnStatement &) = delete;
     const ast::ReturnStatement *rs;
@@ -1689,21 +2092,27 @@ public:
             context.out << " ";
             expr->generate(context);
         }
-        context.out << ";";
+        context.out << ";\n";
     }
 };
 
 class IncrementStatement: public Statement {
 public:
-    explicit IncrementStatement(const ast::IncrementStatement *is): Statement(is), is(is), ref(transform(is->ref)) {}
+    explicit IncrementStatement(const ast::IncrementStatement *is): Statement(is), is(is), ref(transform(is->ref)) {
+        // The result may not fit in an int64_t.
+        const VariableExpression *ve = dynamic_cast<const VariableExpression *>(ref);
+        if (ve != nullptr) {
+            ve->var->integral = false;
+        }
+    }
     IncrementStatement(const IncrementStatement &) = delete;
     IncrementStatement &operator=(const IncrementStatement &) = delete;
     const ast::IncrementStatement *is;
     const Expression *ref;
 
     virtual void generate(Context &context) const override {
-        ref->generate(context);
-        context.out << "+=" << is->delta << ";";
+        ref->generate_lvalue(context);
+        context.out << " += " << is->delta << ";\n";
     }
 };
 
@@ -1712,10 +2121,11 @@ public:
     explicit IfStatement(const ast::IfStatement *is): Statement(is), is(is), condition_statements(), else_statements() {
         for (auto cs: is->condition_statements) {
             std::vector<const Statement *> statements;
+            const Expression *condition = transform(cs.first);
             for (auto s: cs.second) {
                 statements.push_back(transform(s));
             }
-            condition_statements.push_back(std::make_pair(transform(cs.first), statements));
+            condition_statements.push_back(std::make_pair(condition, statements));
         }
         for (auto s: is->else_statements) {
             else_statements.push_back(transform(s));
@@ -1733,23 +2143,24 @@ public:
             if (first) {
                 first = false;
             } else {
-                context.out << "else ";
+                context.out << " else ";
             }
             context.out << "if (";
             c.first->generate(context);
-            context.out << ") {";
+            context.out << ") {\n";
             for (auto s: c.second) {
                 s->generate(context);
             }
             context.out << "}";
         }
         if (else_statements.size() > 0) {
-            context.out << " else {";
+            context.out << " else {\n";
             for (auto s: else_statements) {
                 s->generate(context);
             }
             context.out << "}";
         }
+        context.out << "\n";
     }
 };
 
@@ -1764,48 +2175,73 @@ public:
     virtual void generate(Context &context) const override {
         context.out << "throw neon::NeonException(" << quoted(rs->exception->name) << ", ";
         info->generate(context);
-        context.out << ");";
+        context.out << ");\n";
     }
 };
 
 class ResetStatement: public Statement {
 public:
-    explicit ResetStatement(const ast::ResetStatement *rs): Statement(rs), rs(rs) {}
+    explicit ResetStatement(const ast::ResetStatement *rs): Statement(rs), rs(rs), variables() {
+        for (auto v: rs->variables) {
+            variables.push_back(transform(v));
+        }
+    }
     ResetStatement(const ResetStatement &) = delete;
     ResetStatement &operator=(const ResetStatement &) = delete;
     const ast::ResetStatement *rs;
+    std::vector<const Expression *> variables;
 
-    virtual void generate(Context &) const override {}
+    virtual void generate(Context &context) const override {
+        for (auto v: variables) {
+            v->generate_lvalue(context);
+            context.out << " = ";
+            v->type->generate_default(context);
+            context.out << ";\n";
+        }
+    }
 };
 
 class Function: public Variable {
 public:
-    explicit Function(const ast::Function *f): Variable(f), f(f), statements(), params(), out_count(0) {
+    explicit Function(const ast::Function *f): Variable(f), f(f), exported(g_exported.find(f) != g_exported.end()), statements(), params(), locals(), names() {
+        cname = exported ? ident(f->name) : unique_name(g_global_names, f->name);
+        integral = not exported && dynamic_cast<const TypeNumber *>(dynamic_cast<const TypeFunction *>(type)->returntype) != nullptr;
         // Need to transform the function parameters before transforming
         // the code that might use them (statements).
         int i = 0;
         for (auto p: f->params) {
-            FunctionParameter *q = new FunctionParameter(p, i);
+            FunctionParameter *q = new FunctionParameter(p, i, names);
+            if (exported) {
+                q->integral = false;
+            }
             params.push_back(q);
             g_variable_cache[p] = q;
-            if (q->fp->mode == ast::ParameterType::Mode::INOUT || q->fp->mode == ast::ParameterType::Mode::OUT) {
-                out_count++;
-            }
             i++;
         }
+        Function *outer = g_current_function;
+        g_current_function = this;
         for (auto s: f->statements) {
             statements.push_back(transform(s));
         }
+        g_current_function = outer;
+        g_functions.push_back(this);
     }
     Function(const Function &) = delete;
     Function &operator=(const Function &) = delete;
     const ast::Function *f;
+    const bool exported;
     std::vector<const Statement *> statements;
     std::vector<FunctionParameter *> params;
-    int out_count;
+    std::vector<const Variable *> locals;
+    std::set<std::string> names;
 
-    virtual void generate_decl(Context &context) const override {
-        context.out << "void " << f->name << "(";
+    void generate_signature(Context &context) const {
+        if (integral) {
+            context.out << "int64_t";
+        } else {
+            dynamic_cast<const TypeFunction *>(type)->returntype->generate_type(context);
+        }
+        context.out << " " << cname << "(";
         bool first = true;
         for (auto p: params) {
             if (first) {
@@ -1813,74 +2249,213 @@ public:
             } else {
                 context.out << ", ";
             }
-            context.out << p->fp->name;
+            p->generate_param(context);
+        }
+        context.out << ")";
+    }
+    void generate_definition(Context &context) const {
+        generate_signature(context);
+        context.out << "\n{\n";
+        for (auto v: locals) {
+            v->generate_decl(context);
         }
-        context.out << ") {";
         for (auto s: statements) {
             s->generate(context);
         }
-        context.out << "}";
-    }
-    virtual void generate(Context &context) const override {
-        context.out << f->name;
+        context.out << "}\n\n";
     }
 };
 
-class PredefinedFunction: public Variable {
-public:
-    explicit PredefinedFunction(const ast::PredefinedFunction *pf): Variable(pf), pf(pf), out_count(0) {
-        const ast::TypeFunction *tf = dynamic_cast<const ast::TypeFunction *>(pf->type);
-        for (auto p: tf->params) {
-            if (p->mode == ast::ParameterType::Mode::INOUT || p->mode == ast::ParameterType::Mode::OUT) {
-                out_count++;
-            }
-        }
+LocalVariable::LocalVariable(const ast::LocalVariable *lv): Variable(lv), lv(lv)
+{
+    integral = dynamic_cast<const TypeNumber *>(type) != nullptr;
+    if (g_current_function != nullptr) {
+        cname = unique_name(g_current_function->names, lv->name);
+        g_current_function->locals.push_back(this);
+    } else {
+        cname = unique_name(g_init_names, lv->name);
+        g_init_locals.push_back(this);
     }
-    PredefinedFunction(const PredefinedFunction &) = delete;
-    PredefinedFunction &operator=(const PredefinedFunction &) = delete;
-    const ast::PredefinedFunction *pf;
-    int out_count;
+}
 
-    virtual void generate_decl(Context &) const override { internal_error("PredefinedFunction"); }
-    virtual void generate(Context &context) const override {
+ReturnStatement::ReturnStatement(const ast::ReturnStatement *rs): Statement(rs), rs(rs), expr(transform(rs->expr))
+{
+    if (expr != nullptr && g_current_function != nullptr) {
+        g_number_flows.push_back(std::make_pair(g_current_function, expr));
+    }
+}
+
+class PredefinedFunction: public Variable {
+public:
+    explicit PredefinedFunction(const ast::PredefinedFunction *pf): Variable(pf), pf(pf) {
+        // Runtime functions that return an int64_t rather than a Number.
+        static const std::set<std::string> integral_results = {
+            "array__find",
+            "array__size",
+            "bytes__size",
+            "dictionary__size",
+            "string__length",
+        };
+        integral = integral_results.find(pf->name) != integral_results.end();
         auto dollar = pf->name.find('$');
         if (dollar != std::string::npos) {
-            context.out << "neon::" << pf->name.substr(0, dollar) << "." << pf->name.substr(dollar+1);
+            cname = "neon::" + pf->name.substr(0, dollar) + "::" + pf->name.substr(dollar+1);
         } else {
-            context.out << "neon::global::" << pf->name;
+            cname = "neon::global::" + pf->name;
         }
     }
+    PredefinedFunction(const PredefinedFunction &) = delete;
+    PredefinedFunction &operator=(const PredefinedFunction &) = delete;
+    const ast::PredefinedFunction *pf;
 };
 
 class ModuleFunction: public Variable {
 public:
-    explicit ModuleFunction(const ast::ModuleFunction *mf): Variable(mf), mf(mf), out_count(0) {
-        const TypeFunction *functype = dynamic_cast<const TypeFunction *>(transform(mf->type));
-        int i = 0;
-        for (auto p: functype->paramtypes) {
-            if (p.first == ast::ParameterType::Mode::INOUT || p.first == ast::ParameterType::Mode::OUT) {
-                out_count++;
-            }
-            i++;
-        }
+    explicit ModuleFunction(const ast::ModuleFunction *mf): Variable(mf), mf(mf) {
+        cname = module_namespace(mf->module->name) + "::" + ident(mf->name);
     }
     ModuleFunction(const ModuleFunction &) = delete;
     ModuleFunction &operator=(const ModuleFunction &) = delete;
     const ast::ModuleFunction *mf;
-    int out_count;
+};
 
-    virtual void generate_decl(Context &) const override { internal_error("ModuleFunction"); }
-    virtual void generate(Context &context) const override {
-        context.out << mf->name;
+FunctionCall::FunctionCall(const ast::FunctionCall *fc): Expression(fc), fc(fc), func(transform(fc->func)), args(), modes()
+{
+    const TypeFunction *ftype = dynamic_cast<const TypeFunction *>(func->type);
+    if (ftype == nullptr) {
+        const TypeFunctionPointer *fptype = dynamic_cast<const TypeFunctionPointer *>(func->type);
+        if (fptype != nullptr) {
+            ftype = fptype->functype;
+        }
+    }
+    for (auto a: fc->args) {
+        args.push_back(transform(a));
+    }
+    const Variable *f = callee();
+    for (size_t i = 0; i < args.size(); i++) {
+        ast::ParameterType::Mode mode = ftype != nullptr && i < ftype->paramtypes.size() ? ftype->paramtypes[i].first : ast::ParameterType::Mode::IN;
+        modes.push_back(mode);
+        const Function *uf = dynamic_cast<const Function *>(f);
+        if (mode == ast::ParameterType::Mode::IN) {
+            if (uf != nullptr && i < uf->params.size()) {
+                g_number_flows.push_back(std::make_pair(uf->params[i], args[i]));
+            }
+        } else {
+            // A Number passed by reference must be a general Number on
+            // both sides of the call.
+            const VariableExpression *ve = dynamic_cast<const VariableExpression *>(args[i]);
+            if (ve != nullptr) {
+                ve->var->integral = false;
+            }
+        }
     }
+}
+
+void FunctionCall::generate(Context &context) const
+{
+    // print(s) of a String converts s to an Object only to print it.
+    const PredefinedFunction *pf = dynamic_cast<const PredefinedFunction *>(callee());
+    if (pf != nullptr && pf->pf->name == "print" && args.size() == 1) {
+        const FunctionCall *arg = dynamic_cast<const FunctionCall *>(args[0]);
+        const PredefinedFunction *argf = arg != nullptr ? dynamic_cast<const PredefinedFunction *>(arg->callee()) : nullptr;
+        if (argf != nullptr && argf->pf->name == "object__makeString") {
+            context.out << "neon::global::print(";
+            arg->args[0]->generate(context);
+            context.out << ")";
+            return;
+        }
+    }
+    func->generate(context);
+    context.out << "(";
+    for (size_t i = 0; i < args.size(); i++) {
+        if (i > 0) {
+            context.out << ", ";
+        }
+        if (modes[i] == ast::ParameterType::Mode::IN) {
+            args[i]->generate(context);
+        } else {
+            args[i]->generate_lvalue(context);
+        }
+    }
+    context.out << ")";
+}
+
+// Write a generated file, leaving it alone if it already has the same
+// contents so that the native build does not compile it again.
+void write_if_changed(CompilerSupport *support, const std::string &name, const std::string &contents)
+{
+    std::ifstream f(name, std::ios::binary);
+    if (f.good()) {
+        std::stringstream buf;
+        buf << f.rdbuf();
+        if (buf.str() == contents) {
+            return;
+        }
+    }
+    f.close();
+    support->writeOutput(name, std::vector<unsigned char>(contents.begin(), contents.end()));
+}
+
+void make_directory(const std::string &path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0777);
+#endif
+}
+
+// The generated code of every module compiled so far in this run.
+// compile_cpp() is given each imported module before the program that
+// imports it, so by the time the program itself is compiled this holds
+// everything that goes into its project.
+class Generator: public TargetState {
+public:
+    struct Unit {
+        std::string module;
+        std::string header;
+        std::string source;
+    };
+    Generator(): units() {}
+    std::vector<Unit> units;
 };
 
 class Program {
 public:
-    Program(CompilerSupport *support, const ast::Program *program): support(support), program(program), statements() {
+    Program(CompilerSupport *support, const ast::Program *program): support(support), program(program), statements(), modules() {
+        g_global_names.insert("neon_init");
+        for (auto e: program->exports) {
+            g_exported.insert(e.second);
+            g_global_names.insert(ident(e.first));
+        }
         for (auto s: program->statements) {
             statements.push_back(transform(s));
         }
+        // Exported types must be defined in the header even if nothing
+        // in this module uses them.
+        for (auto e: program->exports) {
+            const ast::Type *type = dynamic_cast<const ast::Type *>(e.second);
+            if (type != nullptr && dynamic_cast<const ast::TypeRecord *>(type) != nullptr) {
+                transform(type);
+            }
+        }
+        infer_integers();
+        for (auto &t: g_type_cache) {
+            const TypeRecord *tr = dynamic_cast<const TypeRecord *>(t.second);
+            if (tr != nullptr && not tr->module.empty()) {
+                modules.insert(tr->module);
+            }
+        }
+        for (auto &v: g_variable_cache) {
+            const ModuleVariable *mv = dynamic_cast<const ModuleVariable *>(v.second);
+            if (mv != nullptr) {
+                modules.insert(mv->mv->module->name);
+            }
+            const ModuleFunction *mf = dynamic_cast<const ModuleFunction *>(v.second);
+            if (mf != nullptr) {
+                modules.insert(mf->mf->module->name);
+            }
+        }
     }
     Program(const Program &) = delete;
     Program &operator=(const Program &) = delete;
@@ -1888,25 +2463,172 @@ public:
     CompilerSupport *support;
     const ast::Program *program;
     std::vector<const Statement *> statements;
+    // Other modules that this module refers to.
+    std::set<std::string> modules;
+
+    // Every Number variable, parameter and function result starts out
+    // assumed to fit in an int64_t. Any of them that is given a value not
+    // known to fit becomes a general Number, which can in turn make other
+    // values general, so repeat until nothing changes.
+    static void infer_integers() {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (auto &f: g_number_flows) {
+                if (f.first->integral && not f.second->is_integer()) {
+                    f.first->integral = false;
+                    changed = true;
+                }
+            }
+        }
+    }
 
-    virtual void generate() const {
-        std::string path;
+    std::string directory() const {
         std::string::size_type i = program->source_path.find_last_of("/\\:");
-        if (i != std::string::npos) {
-            path = program->source_path.substr(0, i + 1);
+        return i != std::string::npos ? program->source_path.substr(0, i + 1) : "";
+    }
+
+    std::string generate_header() const {
+        const std::string ns = module_namespace(program->module_name);
+        std::string guard = ns + "_H";
+        std::transform(guard.begin(), guard.end(), guard.begin(), ::toupper);
+        std::stringstream out;
+        Context context(out);
+        context.out << "#ifndef " << guard << "\n";
+        context.out << "#define " << guard << "\n\n";
+        context.out << "#include \"neon.h\"\n";
+        for (auto &m: modules) {
+            context.out << "#include \"" << m << ".neon.h\"\n";
         }
+        context.out << "\nnamespace " << ns << " {\n\n";
+        if (not g_records.empty()) {
+            for (auto r: g_records) {
+                context.out << "struct " << r->cname << ";\n";
+            }
+            context.out << "\n";
+        }
+        for (auto r: g_records) {
+            r->generate_definition(context);
+            context.out << "\n";
+        }
+        for (auto v: g_globals) {
+            const GlobalVariable *gv = dynamic_cast<const GlobalVariable *>(v);
+            if (gv != nullptr && gv->exported) {
+                context.out << "extern ";
+                gv->generate_type(context);
+                context.out << " " << gv->cname << ";\n";
+            }
+        }
+        for (auto f: g_functions) {
+            if (f->exported) {
+                f->generate_signature(context);
+                context.out << ";\n";
+            }
+        }
+        context.out << "void neon_init();\n\n";
+        context.out << "} // namespace " << ns << "\n\n";
+        context.out << "#endif\n";
+        return out.str();
+    }
+
+    std::string generate_unit() const {
+        const std::string ns = module_namespace(program->module_name);
         std::stringstream out;
-        out << "#include \"neon.h\"\n";
         Context context(out);
-        context.out << "int main(int, const char *[]) { try {";
+        context.out << "#include \"" << program->module_name << ".neon.h\"\n\n";
+        context.out << "namespace " << ns << " {\n\n";
+        for (auto v: g_globals) {
+            v->generate_decl(context);
+        }
+        context.out << "\n";
+        for (auto f: g_functions) {
+            f->generate_signature(context);
+            context.out << ";\n";
+        }
+        context.out << "\n";
+        for (auto f: g_functions) {
+            f->generate_definition(context);
+        }
+        // Like the other executors, a module is initialised the first
+        // time a module that uses it is initialised.
+        context.out << "void neon_init()\n{\n";
+        context.out << "static bool neon_initialised = false;\n";
+        context.out << "if (neon_initialised) {\nreturn;\n}\n";
+        context.out << "neon_initialised = true;\n";
+        for (auto &m: modules) {
+            context.out << module_namespace(m) << "::neon_init();\n";
+        }
+        for (auto v: g_init_locals) {
+            v->generate_decl(context);
+        }
         for (auto s: statements) {
             s->generate(context);
         }
-        context.out << "} catch (neon::NeonException &x) { std::cerr << \"Unhandled exception \" << x.name << \"\\n\"; } }";
-        std::vector<unsigned char> src;
-        std::string t = out.str();
-        std::copy(t.begin(), t.end(), std::back_inserter(src));
-        support->writeOutput(path + program->module_name + ".cpp", src);
+        context.out << "}\n\n";
+        context.out << "} // namespace " << ns << "\n";
+        return out.str();
+    }
+
+    // The entry point, build manifest and every module's code for a
+    // program, all in one directory (by default P-cpp/ next to the
+    // source). The runtime is built along with neonc, which writes
+    // bin/neon_rtl_cpp.cmake to describe it. Build with:
+    //   cmake -S P-cpp -B P-cpp/build -DNEON_RTL=<neon>/bin/neon_rtl_cpp.cmake
+    //   cmake --build P-cpp/build --parallel
+    void generate_project(const std::string &output, const std::vector<Generator::Unit> &units) const {
+        std::string dir = output.empty() ? directory() + program->module_name + "-cpp" : output;
+        if (dir.find_last_of("/\\") != dir.length() - 1) {
+            dir += "/";
+        }
+        make_directory(dir);
+        for (auto &u: units) {
+            write_if_changed(support, dir + u.module + ".neon.h", u.header);
+            write_if_changed(support, dir + u.module + ".neon.cpp", u.source);
+        }
+        std::stringstream main;
+        main << "#include \"" << program->module_name << ".neon.h\"\n\n";
+        main << "int main(int, const char *[])\n{\n";
+        main << "try {\n" << module_namespace(program->module_name) << "::neon_init();\n";
+        main << "} catch (neon::NeonException &x) {\n";
+        main << "std::cerr << \"Unhandled exception \" << x.name << \" (\" << x.info_text() << \")\\n\";\n";
+        main << "return 1;\n}\n}\n";
+        write_if_changed(support, dir + "main.cpp", main.str());
+
+        std::stringstream cmake;
+        cmake << "# Generated by neonc from " << program->source_path << ".\n";
+        cmake << "cmake_minimum_required(VERSION 3.5)\n";
+        cmake << "project(" << ident(program->module_name) << " CXX)\n\n";
+        cmake << "set(CMAKE_CXX_STANDARD 11)\n";
+        cmake << "set(NEON_RTL \"\" CACHE FILEPATH \"neon_rtl_cpp.cmake written by the Neon build\")\n";
+        cmake << "if (NOT EXISTS \"${NEON_RTL}\")\n";
+        cmake << "    message(FATAL_ERROR \"Set NEON_RTL to the bin/neon_rtl_cpp.cmake file of a Neon build\")\n";
+        cmake << "endif ()\n";
+        cmake << "include(\"${NEON_RTL}\")\n\n";
+        cmake << "add_executable(" << ident(program->module_name) << "\n";
+        cmake << "    \"${CMAKE_CURRENT_SOURCE_DIR}/main.cpp\"\n";
+        for (auto &u: units) {
+            cmake << "    \"${CMAKE_CURRENT_SOURCE_DIR}/" << u.module << ".neon.cpp\"\n";
+        }
+        cmake << ")\n";
+        cmake << "target_include_directories(" << ident(program->module_name) << " PRIVATE \"${CMAKE_CURRENT_SOURCE_DIR}\")\n";
+        cmake << "target_link_libraries(" << ident(program->module_name) << " neon_rtl)\n";
+        // Keep the executable at the top of the build tree with every generator.
+        cmake << "set_target_properties(" << ident(program->module_name) << " PROPERTIES OUTPUT_NAME \"" << program->module_name << "\" RUNTIME_OUTPUT_DIRECTORY \"$<1:${CMAKE_BINARY_DIR}>\")\n";
+        write_if_changed(support, dir + "CMakeLists.txt", cmake.str());
+    }
+
+    // An imported module's code is kept until the program that imports
+    // it is compiled, and then written into that program's project.
+    virtual void generate(const std::string &output, bool imported) const {
+        Generator *generator = dynamic_cast<Generator *>(support->targetState());
+        if (generator == nullptr) {
+            generator = new Generator();
+            support->setTargetState(generator);
+        }
+        generator->units.push_back(Generator::Unit {program->module_name, generate_header(), generate_unit()});
+        if (not imported) {
+            generate_project(output, generator->units);
+        }
     }
 };
 
@@ -2409,7 +3131,14 @@ public:
     virtual void visit(const ast::ReturnStatement *node) { r = new ReturnStatement(node); }
     virtual void visit(const ast::IncrementStatement *node) { r =  new IncrementStatement(node); }
     virtual void visit(const ast::IfStatement *node) { r = new IfStatement(node); }
-    virtual void visit(const ast::BaseLoopStatement *node) { r = new BaseLoopStatement(node); }
+    virtual void visit(const ast::BaseLoopStatement *node) {
+        const ast::ForStatement *fs = dynamic_cast<const ast::ForStatement *>(node);
+        if (fs != nullptr) {
+            r = new ForStatement(fs);
+        } else {
+            r = new BaseLoopStatement(node);
+        }
+    }
     virtual void visit(const ast::CaseStatement *node) { r = new CaseStatement(node); }
     virtual void visit(const ast::ExitStatement *node) { r = new ExitStatement(node); }
     virtual void visit(const ast::NextStatement *node) { r = new NextStatement(node); }
@@ -2481,6 +3210,11 @@ Statement *transform(const ast::Statement *s)
     if (i != g_statement_cache.end()) {
         return i->second;
     }
+    // CompoundStatement::accept visits each of its statements rather
+    // than the compound statement itself.
+    if (typeid(*s) == typeid(ast::CompoundStatement)) {
+        return new CompoundStatement(dynamic_cast<const ast::CompoundStatement *>(s));
+    }
     StatementTransformer st;
     s->accept(&st);
     return st.retval();
@@ -2488,13 +3222,25 @@ Statement *transform(const ast::Statement *s)
 
 } // namespace cpp
 
-void compile_cpp(CompilerSupport *support, const ast::Program *p, std::string /*output*/, std::map<std::string, std::string> /*options*/)
+void compile_cpp(CompilerSupport *support, const ast::Program *p, std::string output, std::map<std::string, std::string> options)
 {
     cpp::g_type_cache.clear();
     cpp::g_variable_cache.clear();
     cpp::g_expression_cache.clear();
     cpp::g_statement_cache.clear();
+    cpp::g_global_names.clear();
+    cpp::g_globals.clear();
+    cpp::g_functions.clear();
+    cpp::g_records.clear();
+    cpp::g_init_names.clear();
+    cpp::g_init_locals.clear();
+    cpp::g_exported.clear();
+    cpp::g_current_function = nullptr;
+    cpp::g_number_flows.clear();
+    cpp::g_exit_labels.clear();
+    cpp::g_next_labels.clear();
+    cpp::g_loop_numbers.clear();
 
     cpp::Program *ct = new cpp::Program(support, p);
-    ct->generate();
+    ct->generate(output, options.find("imported") != options.end());
 }
@@ -239,7 +239,7 @@ public:
             } else {
                 context.out << ", ";
             }
-            context.out << quoted(tr->fields[i].name.text) << ":";
+            context.out << quoted(tr->fields[i].name.text()) << ":";
             field_types[i]->generate_default(context);
         }
         context.out << "}";
@@ -540,7 +540,7 @@ public:
             } else {
                 context.out << ", ";
             }
-            context.out << quoted(type->tr->fields[i].name.text);
+            context.out << quoted(type->tr->fields[i].name.text());
             context.out << ':';
             v->generate(context);
             i++;
@@ -747,7 +747,7 @@ public:
         for (size_t i = 0; i < tr->fields.size(); i++) {
             field_info f;
             f.access_flags = 0;
-            f.name_index = cf.utf8(tr->fields[i].name.text);
+            f.name_index = cf.utf8(tr->fields[i].name.text());
             f.descriptor_index = cf.utf8(field_types[i]->jtype);
             cf.fields.push_back(f);
         }
@@ -775,7 +775,7 @@ public:
                         } else {
                             ca.code << OP_wide << OP_aload << static_cast<uint16_t>(p);
                         }
-                        ca.code << OP_putfield << cf.Field(classname, tr->fields[i].name.text, field_types[i]->jtype);
+                        ca.code << OP_putfield << cf.Field(classname, tr->fields[i].name.text(), field_types[i]->jtype);
                     }
                     ca.code << OP_return;
                     code.info = ca.serialize();
@@ -122,6 +122,9 @@ private:
     void disasm_PUSHFP();
     void disasm_CALLV();
     void disasm_PUSHCI();
+    void disasm_FORN();
+    void disasm_CASEN();
+    void disasm_CASES();
 };
 
 void InstructionDisassembler::disasm_PUSHB()
@@ -756,6 +759,36 @@ void InstructionDisassembler::disasm_PUSHCI()
     out << "PUSHCI \"" << obj.strtable[val] << "\"";
 }
 
+void InstructionDisassembler::disasm_FORN()
+{
+    index++;
+    uint32_t val = Bytecode::get_vint(obj.code, index);
+    uint32_t addr = Bytecode::get_vint(obj.code, index);
+    out << "FORN " << obj.strtable[val] << "," << addr;
+}
+
+void InstructionDisassembler::disasm_CASEN()
+{
+    index++;
+    uint32_t val = Bytecode::get_vint(obj.code, index);
+    out << "CASEN " << val;
+    for (uint32_t i = 0; i < val; i++) {
+        uint32_t key = Bytecode::get_vint(obj.code, index);
+        out << (i == 0 ? " " : ",") << obj.strtable[key];
+    }
+}
+
+void InstructionDisassembler::disasm_CASES()
+{
+    index++;
+    uint32_t val = Bytecode::get_vint(obj.code, index);
+    out << "CASES " << val;
+    for (uint32_t i = 0; i < val; i++) {
+        uint32_t key = Bytecode::get_vint(obj.code, index);
+        out << (i == 0 ? " " : ",") << "\"" << obj.strtable[key] << "\"";
+    }
+}
+
 void InstructionDisassembler::disassemble()
 {
     switch (static_cast<Opcode>(obj.code[index])) {
@@ -859,6 +892,9 @@ void InstructionDisassembler::disassemble()
         case Opcode::PUSHFP:  disasm_PUSHFP(); break;
         case Opcode::CALLV:   disasm_CALLV(); break;
         case Opcode::PUSHCI:  disasm_PUSHCI(); break;
+        case Opcode::FORN:    disasm_FORN(); break;
+        case Opcode::CASEN:   disasm_CASEN(); break;
+        case Opcode::CASES:   disasm_CASES(); break;
         default:
             out << "Unknown opcode: " << static_cast<uint8_t>(obj.code[index]) << "\n";
             index++;
@@ -2,15 +2,19 @@
 
 #include <algorithm>
 #include <assert.h>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iso646.h>
 #include <iostream>
 #include <list>
 #include <map>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <stdlib.h>
 #include <string.h>
+#include <thread>
 
 #include <minijson_writer.hpp>
 
@@ -28,14 +32,26 @@
 #include "support.h"
 
 #ifdef _WIN32
+#include <winsock2.h>
 #define PATHSEP "\\"
 #define LIBRARY_NAME_PREFIX ""
+#define poll WSAPoll
 #else
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
 #define PATHSEP "/"
 #define LIBRARY_NAME_PREFIX "lib"
 #endif
 
-std::set<std::string> g_ExtensionModules;
+// Extension libraries are loaded once per process, whichever executor
+// first calls into them.
+static std::set<std::string> g_ExtensionModules;
+static std::mutex g_ExtensionModulesMutex;
+
+// The wake pipes of executors whose fibers may wait for other threads.
+static std::set<int> g_WakeFds;
+static std::mutex g_WakeFdsMutex;
 
 void executor_raise_exception(size_t ip, const utf8string &name, const utf8string &info);
 
@@ -73,16 +89,17 @@ class BidExceptionHandler {
     size_t start_ip;
 public:
     BidExceptionHandler(size_t start_ip): start_ip(start_ip) {
-        _IDEC_glbflags = 0;
+        number_clear_flags();
     }
     void check_and_raise(const char *what) {
-        if (_IDEC_glbflags & BID_OVERFLOW_EXCEPTION) {
+        const _IDEC_flags flags = number_get_flags();
+        if (flags & BID_OVERFLOW_EXCEPTION) {
             executor_raise_exception(start_ip, utf8string(rtl::ne_global::Exception_NumberException_Overflow.name), utf8string(what));
         }
-        if (_IDEC_glbflags & BID_ZERO_DIVIDE_EXCEPTION) {
+        if (flags & BID_ZERO_DIVIDE_EXCEPTION) {
             executor_raise_exception(start_ip, utf8string(rtl::ne_global::Exception_NumberException_DivideByZero.name), utf8string(what));
         }
-        if (_IDEC_glbflags & BID_INVALID_EXCEPTION) {
+        if (flags & BID_INVALID_EXCEPTION) {
             executor_raise_exception(start_ip, utf8string(rtl::ne_global::Exception_NumberException_Invalid.name), utf8string(what));
         }
     }
@@ -105,25 +122,69 @@ public:
     size_t opstack_depth;
 };
 
+class Module;
+
+// A call to a blocking function made on another thread for a fiber.
+struct BlockingCall {
+    BlockingCall(): done(false), result(), exception() {}
+    std::atomic<bool> done;
+    std::shared_ptr<void> result;
+    std::exception_ptr exception;
+};
+
+// What a suspended fiber is waiting for. A fiber with none of these set
+// can run as soon as it is chosen.
+struct FiberWait {
+    FiberWait(): fd(-1), write(false), timed(false), deadline(), ready(), call() {}
+    int fd;
+    bool write;
+    bool timed;
+    std::chrono::steady_clock::time_point deadline;
+    std::function<bool()> ready;
+    std::shared_ptr<BlockingCall> call;
+};
+
+// The state of a fiber that is not running. The running fiber's state is
+// kept in the Executor itself, and is swapped with this to switch fibers.
+struct Fiber {
+    Fiber(): module(nullptr), ip(0), stack(), callstack(), frames(), wait(), main(false), blocked(false) {}
+    Module *module;
+    Bytecode::Bytes::size_type ip;
+    opstack<Cell> stack;
+    std::vector<std::pair<Module *, Bytecode::Bytes::size_type>> callstack;
+    std::list<ActivationFrame> frames;
+    FiberWait wait;
+    bool main;
+    // Suspended in the middle of a CALLP that is made again on resuming.
+    bool blocked;
+};
+
 class Executor;
+struct ProgramImage;
 
 class Module {
 public:
-    Module(const std::string &name, const Bytecode &object, const DebugInfo *debuginfo, Executor *executor, ICompilerSupport *support);
+    Module(const std::string &name, std::shared_ptr<const Bytecode> bytecode, const DebugInfo *debuginfo, Executor *executor, ICompilerSupport *support);
     Module(const Module &) = delete;
     Module &operator=(const Module &) = delete;
     const std::string name;
-    Bytecode object;
+    // Nothing changes loaded bytecode, so the executors of tasks started
+    // from this one share it rather than each having a copy.
+    const std::shared_ptr<const Bytecode> bytecode;
+    const Bytecode &object;
     const DebugInfo *debug;
     std::vector<Cell> globals;
     std::vector<size_t> rtl_call_tokens;
     std::vector<std::pair<bool, Number>> number_table;
+    // FORN steps as machine integers, or 0 if the step does not fit in one.
+    std::vector<std::pair<bool, long>> loop_step_table;
     std::map<std::pair<std::string, std::string>, std::pair<Module *, int>> module_functions;
 };
 
 class Executor: public IHttpServerHandler {
 public:
     Executor(const std::string &source_path, const Bytecode::Bytes &bytes, const DebugInfo *debuginfo, ICompilerSupport *support, const ExecOptions *options, unsigned short debug_port, std::map<std::string, Cell *> *external_globals);
+    explicit Executor(const ProgramImage &image);
     Executor(const Executor &) = delete;
     Executor &operator=(const Executor &) = delete;
     virtual ~Executor();
@@ -139,6 +200,21 @@ public:
     bool module_is_main();
     void set_garbage_collection_interval(size_t count);
     void set_recursion_limit(size_t depth);
+    void spawn_fiber(Cell &function);
+    bool can_switch_fiber();
+    bool wait_fiber(FiberWait &&wait);
+    void suspend_fiber();
+    void resume_fiber(std::list<Fiber>::iterator f);
+    void schedule_fiber();
+    void check_waiting_fibers(bool block);
+    int wake_fd();
+
+    // Module: parallel
+    bool find_function(const std::string &name, std::string &module_name, uint32_t &index, std::string &descriptor);
+    std::shared_ptr<const ProgramImage> program_image();
+    std::string find_module_name(const Module *mod);
+    bool init_modules();
+    bool call_function(const std::string &module_name, uint32_t index, const std::vector<Cell> &args, Cell &result);
 
     int exec();
     int exec_loop(size_t min_callstack_depth);
@@ -153,12 +229,35 @@ public:
     std::map<std::string, Module *> modules;
     std::vector<std::string> init_order;
     Module *module;
+    // Made the first time a task or parallel call needs it.
+    std::shared_ptr<const ProgramImage> task_image;
     int exit_code;
+    // The exception that ended execution, if it was not handled. It is not
+    // reported here when report_unhandled is false because whoever called
+    // call_function raises it again.
+    bool report_unhandled;
+    std::string unhandled_exception;
+    utf8string unhandled_info;
     Bytecode::Bytes::size_type ip;
     opstack<Cell> stack;
     std::vector<std::pair<Module *, Bytecode::Bytes::size_type>> callstack;
     std::list<ActivationFrame> frames;
 
+    // The other fibers, in the order they were suspended, split into
+    // those that can run and those waiting for something. The program
+    // ends when the main fiber does, whatever the others are doing.
+    std::list<Fiber> ready_fibers;
+    std::list<Fiber> waiting_fibers;
+    // How many more ready fibers run before the waiting ones are checked.
+    size_t ready_round;
+    // Written by executor_notify() to wake this executor while it waits
+    // for another thread, or -1 before it is needed.
+    int wake_pipe[2];
+    FiberWait wait;
+    bool in_main_fiber;
+    bool fiber_resumed;
+    unsigned int loop_depth;
+
     std::list<Cell> allocs;
     unsigned int allocations;
 
@@ -176,6 +275,8 @@ public:
     std::set<size_t> debugger_breakpoints;
     std::vector<std::string> debugger_log;
 
+    const std::thread::id thread;
+
     void exec_PUSHB();
     void exec_PUSHN();
     void exec_PUSHS();
@@ -276,6 +377,9 @@ public:
     void exec_PUSHFP();
     void exec_CALLV();
     void exec_PUSHCI();
+    void exec_FORN();
+    void exec_CASEN();
+    void exec_CASES();
 
     void invoke(Module *m, uint32_t index);
     void raise_literal(const utf8string &exception, std::shared_ptr<Object> info);
@@ -296,7 +400,79 @@ const char *Executor::DebuggerStateName[] = {
     "quit",
 };
 
-static Executor *g_executor;
+// Everything needed to start another executor for the same program: the
+// loaded bytecode of each module and the order to initialise them in. It is
+// made once, on the parent's thread, and then only read, so every task
+// started from the same executor shares it. A task holds its own reference,
+// so it does not depend on its parent executor still existing.
+struct ProgramImage {
+    explicit ProgramImage(const Executor &executor);
+    std::string source_path;
+    ExecOptions options;
+    std::vector<std::pair<std::string, std::shared_ptr<const Bytecode>>> modules;
+    std::vector<std::string> init_order;
+};
+
+ProgramImage::ProgramImage(const Executor &executor)
+  : source_path(executor.source_path),
+    options(*executor.options),
+    modules(),
+    init_order(executor.init_order)
+{
+    for (auto &m: executor.modules) {
+        modules.push_back(std::make_pair(m.first, m.second->bytecode));
+    }
+    // Tasks are not traced or debugged.
+    options.enable_trace = false;
+}
+
+// The executor running on this thread, if any. Each Executor is an isolate:
+// it owns all of its modules, globals and stacks and runs on one thread only,
+// so separate threads can run separate executors at the same time. Runtime
+// library functions and extension callbacks have no executor parameter and
+// find the one that called them through this.
+static thread_local Executor *g_current_executor;
+
+namespace {
+
+// Makes an executor current on this thread for the lifetime of the object,
+// restoring the previous one (for nested executors) afterwards.
+class CurrentExecutor {
+public:
+    explicit CurrentExecutor(Executor *executor): outer(g_current_executor) {
+        g_current_executor = executor;
+    }
+    CurrentExecutor(const CurrentExecutor &) = delete;
+    CurrentExecutor &operator=(const CurrentExecutor &) = delete;
+    ~CurrentExecutor() {
+        g_current_executor = outer;
+    }
+private:
+    Executor *outer;
+};
+
+// Thrown by a library function through its thunk to suspend the running
+// fiber. The thunk leaves the arguments on the stack, so the call can be
+// made again when the fiber resumes.
+class FiberBlocked {};
+
+// Counts the nested exec_loop calls. Fibers can only be switched in the
+// outermost one, when no native code is waiting for the inner one to end.
+class LoopDepth {
+public:
+    explicit LoopDepth(unsigned int &depth): depth(depth) {
+        depth++;
+    }
+    LoopDepth(const LoopDepth &) = delete;
+    LoopDepth &operator=(const LoopDepth &) = delete;
+    ~LoopDepth() {
+        depth--;
+    }
+private:
+    unsigned int &depth;
+};
+
+} // namespace
 
 extern "C" {
 
@@ -463,32 +639,33 @@ struct Ne_Cell *cell_set_dictionary_cell(struct Ne_Cell *cell, const char *key)
 void exec_callback(const struct Ne_Cell *callback, const struct Ne_ParameterList *params, struct Ne_Cell *retval)
 {
     // TODO: move this into a method in Executor that's called by exec_CALLI too
-    if (g_executor->callstack.size() >= g_executor->param_recursion_limit) {
-        g_executor->raise(rtl::ne_global::Exception_StackOverflowException, std::make_shared<ObjectString>(utf8string("")));
+    Executor *executor = g_current_executor;
+    if (executor->callstack.size() >= executor->param_recursion_limit) {
+        executor->raise(rtl::ne_global::Exception_StackOverflowException, std::make_shared<ObjectString>(utf8string("")));
         return;
     }
     std::vector<Cell> a = reinterpret_cast<Cell *>(const_cast<struct Ne_Cell *>(callback))->array();
     Module *mod = reinterpret_cast<Module *>(a[0].other());
     Number nindex = a[1].number();
     if (mod == nullptr || number_is_zero(nindex) || not number_is_integer(nindex)) {
-        g_executor->raise(rtl::ne_global::Exception_InvalidFunctionException, std::make_shared<ObjectString>(utf8string("")));
+        executor->raise(rtl::ne_global::Exception_InvalidFunctionException, std::make_shared<ObjectString>(utf8string("")));
         return;
     }
     if (params != NULL) {
         auto &ps = reinterpret_cast<Cell *>(const_cast<struct Ne_ParameterList *>(params))->array();
         for (auto i = ps.rbegin(); i != ps.rend(); ++i) {
-            g_executor->stack.push(*i);
+            executor->stack.push(*i);
         }
     }
     uint32_t index = number_to_uint32(nindex);
-    g_executor->invoke(mod, index);
-    int r = g_executor->exec_loop(g_executor->callstack.size() - 1);
+    executor->invoke(mod, index);
+    int r = executor->exec_loop(executor->callstack.size() - 1);
     if (r != 0) {
         exit(r);
     }
     if (retval != NULL) {
-        *reinterpret_cast<Cell *>(retval) = g_executor->stack.top();
-        g_executor->stack.pop();
+        *reinterpret_cast<Cell *>(retval) = executor->stack.top();
+        executor->stack.pop();
     }
 }
 
@@ -547,24 +724,35 @@ Executor::Executor(const std::string &source_path, const Bytecode::Bytes &bytes,
     modules(),
     init_order(),
     module(nullptr),
+    task_image(),
     exit_code(0),
+    report_unhandled(true),
+    unhandled_exception(),
+    unhandled_info(),
     ip(0),
     stack(),
     callstack(),
     frames(),
+    ready_fibers(),
+    waiting_fibers(),
+    ready_round(0),
+    wake_pipe{-1, -1},
+    wait(),
+    in_main_fiber(true),
+    fiber_resumed(false),
+    loop_depth(0),
     allocs(),
     allocations(0),
     debug_server(debug_port ? new HttpServer(debug_port, this) : nullptr),
     debugger_state(DebuggerState::STOPPED),
     debugger_step_source_depth(0),
     debugger_breakpoints(),
-    debugger_log()
+    debugger_log(),
+    thread(std::this_thread::get_id())
 {
-    assert(g_executor == nullptr);
-    g_executor = this;
-    Bytecode b;
+    auto b = std::make_shared<Bytecode>();
     try {
-        b.load(source_path, bytes);
+        b->load(source_path, bytes);
     } catch (BytecodeException &e) {
         fprintf(stderr, "error loading bytecode: %s\n", e.what());
         exit(1);
@@ -573,19 +761,83 @@ Executor::Executor(const std::string &source_path, const Bytecode::Bytes &bytes,
     modules[""] = module;
 }
 
+Executor::Executor(const ProgramImage &image)
+  : source_path(image.source_path),
+    options(&image.options),
+    param_garbage_collection_interval(1000),
+    param_recursion_limit(1000),
+    external_globals(nullptr),
+    modules(),
+    init_order(image.init_order),
+    module(nullptr),
+    task_image(),
+    exit_code(0),
+    report_unhandled(true),
+    unhandled_exception(),
+    unhandled_info(),
+    ip(0),
+    stack(),
+    callstack(),
+    frames(),
+    ready_fibers(),
+    waiting_fibers(),
+    ready_round(0),
+    wake_pipe{-1, -1},
+    wait(),
+    in_main_fiber(true),
+    fiber_resumed(false),
+    loop_depth(0),
+    allocs(),
+    allocations(0),
+    debug_server(nullptr),
+    debugger_state(DebuggerState::STOPPED),
+    debugger_step_source_depth(0),
+    debugger_breakpoints(),
+    debugger_log(),
+    thread(std::this_thread::get_id())
+{
+    // Every module was already loaded by the parent, so enter all the
+    // names first to stop the Module constructor loading any imports.
+    for (auto &m: image.modules) {
+        modules[m.first] = nullptr;
+    }
+    for (auto &m: image.modules) {
+        modules[m.first] = new Module(m.first.empty() ? source_path : m.first, m.second, nullptr, this, nullptr);
+    }
+    module = modules[""];
+}
+
 Executor::~Executor()
 {
     delete debug_server;
-    g_executor = nullptr;
+#ifndef _WIN32
+    if (wake_pipe[0] >= 0) {
+        {
+            std::lock_guard<std::mutex> lock(g_WakeFdsMutex);
+            g_WakeFds.erase(wake_pipe[1]);
+        }
+        close(wake_pipe[0]);
+        close(wake_pipe[1]);
+    }
+#endif
+    // Function values kept in external globals (by the REPL) refer to
+    // their modules after this executor has gone.
+    if (external_globals == nullptr) {
+        for (auto &m: modules) {
+            delete m.second;
+        }
+    }
 }
 
-Module::Module(const std::string &name, const Bytecode &object, const DebugInfo *debuginfo, Executor *executor, ICompilerSupport *support)
+Module::Module(const std::string &name, std::shared_ptr<const Bytecode> bytecode, const DebugInfo *debuginfo, Executor *executor, ICompilerSupport *support)
   : name(name),
-    object(object),
+    bytecode(bytecode),
+    object(*bytecode),
     debug(debuginfo),
     globals(object.global_size),
     rtl_call_tokens(object.strtable.size(), SIZE_MAX),
     number_table(object.strtable.size()),
+    loop_step_table(object.strtable.size()),
     module_functions()
 {
     for (auto i: object.imports) {
@@ -593,9 +845,13 @@ Module::Module(const std::string &name, const Bytecode &object, const DebugInfo
         if (executor->modules.find(importname) != executor->modules.end()) {
             continue;
         }
-        Bytecode code;
+        if (support == nullptr) {
+            // Only an optional import that the parent could not load.
+            continue;
+        }
+        auto code = std::make_shared<Bytecode>();
         try {
-            support->loadBytecode(importname, code);
+            support->loadBytecode(importname, *code);
         } catch (BytecodeException &e) {
             if (i.optional) {
                 continue;
@@ -1333,10 +1589,16 @@ void Executor::exec_CALLP()
     try {
         BidExceptionHandler handler(start_ip);
         rtl_call(stack, func, module->rtl_call_tokens[val]);
+        fiber_resumed = false;
         handler.check_and_raise(func.c_str());
     } catch (RtlException &x) {
+        fiber_resumed = false;
         ip = start_ip;
         raise(x);
+    } catch (FiberBlocked &) {
+        ip = start_ip;
+        suspend_fiber();
+        schedule_fiber();
     }
 }
 
@@ -1454,6 +1716,10 @@ void Executor::exec_RET()
     module = callstack.back().first;
     ip = callstack.back().second;
     callstack.pop_back();
+    if (callstack.empty() && not in_main_fiber) {
+        // A spawned fiber has returned from its function.
+        schedule_fiber();
+    }
 }
 
 void Executor::exec_CONSA()
@@ -1560,6 +1826,7 @@ void Executor::exec_CALLX()
     uint32_t out_param_count = Bytecode::get_vint(module->object.code, ip);
     std::string modname = module->object.strtable[mod];
     std::string modlib = just_path(module->object.source_path) + LIBRARY_NAME_PREFIX + "neon_" + modname;
+    std::unique_lock<std::mutex> lock(g_ExtensionModulesMutex);
     if (g_ExtensionModules.find(modname) == g_ExtensionModules.end()) {
         try {
             void_function_t init = rtl_foreign_function(modlib, "Ne_INIT");
@@ -1576,6 +1843,7 @@ void Executor::exec_CALLX()
         }
         g_ExtensionModules.insert(modname);
     }
+    lock.unlock();
     std::string funcname = module->object.strtable[name];
     void_function_t p;
     try {
@@ -1654,7 +1922,7 @@ void Executor::exec_CALLV()
     Cell *instance = pi[0].address();
     size_t interface_index = number_to_uint32(pi[1].number());
     Module *m = reinterpret_cast<Module *>(instance->array_for_write()[0].array_for_write()[0].other());
-    Bytecode::ClassInfo *classinfo = reinterpret_cast<Bytecode::ClassInfo *>(instance->array_for_write()[0].array_for_write()[1].other());
+    const Bytecode::ClassInfo *classinfo = reinterpret_cast<const Bytecode::ClassInfo *>(instance->array_for_write()[0].array_for_write()[1].other());
     stack.pop();
     invoke(m, classinfo->interfaces[interface_index][val]);
 }
@@ -1669,7 +1937,7 @@ void Executor::exec_PUSHCI()
             if (c.name == val) {
                 Cell ci;
                 ci.array_for_write().push_back(Cell::makeOther(module));
-                ci.array_for_write().push_back(Cell::makeOther(&c));
+                ci.array_for_write().push_back(Cell::makeOther(const_cast<Bytecode::ClassInfo *>(&c)));
                 stack.push(ci);
                 return;
             }
@@ -1684,7 +1952,7 @@ void Executor::exec_PUSHCI()
                 if (m->object.strtable[c.name] == methodname) {
                     Cell ci;
                     ci.array_for_write().push_back(Cell::makeOther(m));
-                    ci.array_for_write().push_back(Cell::makeOther(&c));
+                    ci.array_for_write().push_back(Cell::makeOther(const_cast<Bytecode::ClassInfo *>(&c)));
                     stack.push(ci);
                     return;
                 }
@@ -1695,6 +1963,103 @@ void Executor::exec_PUSHCI()
     exit(1);
 }
 
+void Executor::exec_FORN()
+{
+    BidExceptionHandler handler(ip);
+    ip++;
+    uint32_t val = Bytecode::get_vint(module->object.code, ip);
+    uint32_t target = Bytecode::get_vint(module->object.code, ip);
+    Cell *bound = stack.top().address(); stack.pop();
+    Cell *var = stack.top().address(); stack.pop();
+    if (not module->number_table[val].first) {
+        module->number_table[val] = std::make_pair(true, number_from_string(module->object.strtable[val]));
+    }
+    Number &step = module->number_table[val].second;
+    if (not module->loop_step_table[val].first) {
+        long s = 0;
+        if (step.rep == Rep::MPZ && step.get_mpz().fits_slong_p()) {
+            s = step.get_mpz().get_si();
+        }
+        module->loop_step_table[val] = std::make_pair(true, s);
+    }
+    const long s = module->loop_step_table[val].second;
+    Number &n = var->number();
+    Number &limit = bound->number();
+    if (s != 0 && n.rep == Rep::MPZ && limit.rep == Rep::MPZ) {
+        // Integer counter and bound with a machine integer step: step the
+        // counter in place (no new Number is built each iteration) and
+        // compare it directly.
+        n.add_integer(s);
+        int c = mpz_cmp(n.get_mpz().get_mpz_t(), limit.get_mpz().get_mpz_t());
+        if (s > 0 ? c <= 0 : c >= 0) {
+            ip = target;
+        }
+        return;
+    }
+    n = number_add(n, step);
+    if (number_is_negative(step) ? not number_is_less(n, limit) : not number_is_greater(n, limit)) {
+        ip = target;
+    }
+    handler.check_and_raise("add");
+}
+
+void Executor::exec_CASEN()
+{
+    ip++;
+    uint32_t val = Bytecode::get_vint(module->object.code, ip);
+    Number n = stack.top().number(); stack.pop();
+    // The keys are fixed width string table indexes in ascending numeric
+    // order, followed by one JUMP per key and a final JUMP for no match.
+    const size_t keys = ip;
+    uint32_t found = val;
+    uint32_t lo = 0;
+    uint32_t hi = val;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        size_t p = keys + 5 * mid;
+        uint32_t k = Bytecode::get_vint(module->object.code, p);
+        if (not module->number_table[k].first) {
+            module->number_table[k] = std::make_pair(true, number_from_string(module->object.strtable[k]));
+        }
+        const Number &key = module->number_table[k].second;
+        if (number_is_less(n, key)) {
+            hi = mid;
+        } else if (number_is_greater(n, key)) {
+            lo = mid + 1;
+        } else {
+            found = mid;
+            break;
+        }
+    }
+    ip = keys + 5 * val + 6 * found;
+}
+
+void Executor::exec_CASES()
+{
+    ip++;
+    uint32_t val = Bytecode::get_vint(module->object.code, ip);
+    utf8string s = stack.top().string(); stack.pop();
+    // Same layout as CASEN, with keys in ascending byte order.
+    const size_t keys = ip;
+    uint32_t found = val;
+    uint32_t lo = 0;
+    uint32_t hi = val;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        size_t p = keys + 5 * mid;
+        int c = s.str().compare(module->object.strtable[Bytecode::get_vint(module->object.code, p)]);
+        if (c < 0) {
+            hi = mid;
+        } else if (c > 0) {
+            lo = mid + 1;
+        } else {
+            found = mid;
+            break;
+        }
+    }
+    ip = keys + 5 * val + 6 * found;
+}
+
 void Executor::invoke(Module *m, uint32_t index)
 {
     callstack.push_back(std::make_pair(module, ip));
@@ -1758,6 +2123,12 @@ void Executor::raise_literal(const utf8string &exception, std::shared_ptr<Object
 
     utf8string detail;
     info->getString(detail);
+    unhandled_exception = exception.str();
+    unhandled_info = detail;
+    if (not report_unhandled) {
+        exit_code = 1;
+        return;
+    }
     fprintf(stderr, "Unhandled exception %s (%s)\n", exception.c_str(), detail.c_str());
     while (ip < module->object.code.size()) {
         if (module->debug != nullptr) {
@@ -1875,6 +2246,18 @@ void Executor::garbage_collect()
     for (size_t i = 0; i < stack.depth(); i++) {
         mark(&stack.peek(i));
     }
+    for (auto *list: {&ready_fibers, &waiting_fibers}) {
+        for (auto &fiber: *list) {
+            for (auto &f: fiber.frames) {
+                for (auto &v: f.locals) {
+                    mark(&v);
+                }
+            }
+            for (size_t i = 0; i < fiber.stack.depth(); i++) {
+                mark(&fiber.stack.peek(i));
+            }
+        }
+    }
 
     // Sweep unreachable objects.
     for (auto c = allocs.begin(); c != allocs.end(); ) {
@@ -1915,8 +2298,265 @@ void Executor::set_recursion_limit(size_t depth)
     param_recursion_limit = depth;
 }
 
+void Executor::spawn_fiber(Cell &function)
+{
+    std::vector<Cell> fp = function.array();
+    Module *mod = reinterpret_cast<Module *>(fp[0].other());
+    Number nindex = fp[1].number();
+    if (mod == nullptr || number_is_zero(nindex) || not number_is_integer(nindex)) {
+        throw RtlException(rtl::ne_global::Exception_InvalidFunctionException, utf8string(""));
+    }
+    const Bytecode::FunctionInfo &info = mod->object.functions.at(number_to_uint32(nindex));
+    // A nested function would need the frames of the functions around it.
+    if (info.nest > 1 || info.params > 0) {
+        throw RtlException(rtl::ne_global::Exception_InvalidFunctionException, utf8string("fiber function must be a top level function with no parameters"));
+    }
+    ready_fibers.emplace_back();
+    Fiber &f = ready_fibers.back();
+    f.module = mod;
+    f.ip = info.entry;
+    f.callstack.push_back(std::make_pair(mod, mod->object.code.size()));
+    f.frames.emplace_back(info.nest, nullptr, info.locals, 0);
+}
+
+bool Executor::can_switch_fiber()
+{
+    return loop_depth == 1 && (not ready_fibers.empty() || not waiting_fibers.empty());
+}
+
+bool Executor::wait_fiber(FiberWait &&w)
+{
+    // Returns true if the fiber was suspended for this call already and
+    // has now been resumed, so the wait is over.
+    if (fiber_resumed) {
+        fiber_resumed = false;
+        return true;
+    }
+    if (not can_switch_fiber()) {
+        return false;
+    }
+    wait = std::move(w);
+    throw FiberBlocked();
+}
+
+void Executor::suspend_fiber()
+{
+    std::list<Fiber> &list = wait.fd >= 0 || wait.timed || wait.ready ? waiting_fibers : ready_fibers;
+    list.emplace_back();
+    Fiber &f = list.back();
+    f.module = module;
+    f.ip = ip;
+    std::swap(f.stack, stack);
+    f.callstack.swap(callstack);
+    f.frames.swap(frames);
+    f.wait = std::move(wait);
+    f.main = in_main_fiber;
+    f.blocked = true;
+}
+
+void Executor::resume_fiber(std::list<Fiber>::iterator f)
+{
+    // Whatever fiber was running has been saved already, or has finished.
+    module = f->module;
+    ip = f->ip;
+    std::swap(stack, f->stack);
+    callstack.swap(f->callstack);
+    frames.swap(f->frames);
+    wait = std::move(f->wait);
+    in_main_fiber = f->main;
+    fiber_resumed = f->blocked;
+    ready_fibers.erase(f);
+}
+
+void Executor::schedule_fiber()
+{
+    for (;;) {
+        // Check the waiting fibers when no fiber is ready, and otherwise
+        // once every round of the ready ones, so fibers that keep yielding
+        // do not stop the waiting ones from ever running.
+        if (ready_fibers.empty() || ready_round == 0) {
+            check_waiting_fibers(ready_fibers.empty());
+            ready_round = ready_fibers.size();
+        }
+        if (not ready_fibers.empty()) {
+            ready_round--;
+            resume_fiber(ready_fibers.begin());
+            return;
+        }
+    }
+}
+
+void Executor::check_waiting_fibers(bool block)
+{
+    // Move the waiting fibers that can go on to the ready list, in the
+    // order they were suspended. If block is true and none can, wait until
+    // one might.
+    typedef std::chrono::steady_clock clock;
+    auto now = clock::now();
+    int timeout = -1;
+    bool other_thread = false;
+    std::vector<struct pollfd> fds;
+    std::vector<std::list<Fiber>::iterator> polled;
+    for (auto f = waiting_fibers.begin(); f != waiting_fibers.end(); ) {
+        auto next = std::next(f);
+        const FiberWait &w = f->wait;
+        if (w.fd >= 0) {
+            struct pollfd p;
+            p.fd = w.fd;
+            p.events = w.write ? POLLOUT : POLLIN;
+            p.revents = 0;
+            fds.push_back(p);
+            polled.push_back(f);
+        } else if (w.timed) {
+            if (w.deadline <= now) {
+                ready_fibers.splice(ready_fibers.end(), waiting_fibers, f);
+            } else {
+                int ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(w.deadline - now).count()) + 1;
+                timeout = timeout < 0 ? ms : std::min(timeout, ms);
+            }
+        } else if (w.ready()) {
+            ready_fibers.splice(ready_fibers.end(), waiting_fibers, f);
+        } else {
+            other_thread = true;
+        }
+        f = next;
+    }
+    if (not block || not ready_fibers.empty()) {
+        timeout = 0;
+    }
+#ifdef _WIN32
+    // WSAPoll only takes sockets, so there is nothing another thread can
+    // wake it with. Check again shortly instead.
+    if (other_thread && timeout != 0) {
+        timeout = timeout < 0 ? 10 : std::min(timeout, 10);
+    }
+#else
+    if (other_thread) {
+        struct pollfd p;
+        p.fd = wake_fd();
+        p.events = POLLIN;
+        p.revents = 0;
+        fds.push_back(p);
+    }
+#endif
+    if (fds.empty()) {
+        if (timeout > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+        }
+        return;
+    }
+    if (poll(fds.data(), static_cast<unsigned int>(fds.size()), timeout) <= 0) {
+        return;
+    }
+    for (size_t i = 0; i < polled.size(); i++) {
+        if (fds[i].revents != 0) {
+            ready_fibers.splice(ready_fibers.end(), waiting_fibers, polled[i]);
+        }
+    }
+#ifndef _WIN32
+    if (other_thread && fds.back().revents != 0) {
+        // Whatever the other thread did is checked the next time round.
+        char buf[64];
+        while (read(wake_pipe[0], buf, sizeof(buf)) > 0) {
+        }
+    }
+#endif
+}
+
+int Executor::wake_fd()
+{
+#ifndef _WIN32
+    if (wake_pipe[0] < 0) {
+        if (pipe(wake_pipe) != 0) {
+            perror("pipe");
+            exit(1);
+        }
+        fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+        std::lock_guard<std::mutex> lock(g_WakeFdsMutex);
+        g_WakeFds.insert(wake_pipe[1]);
+    }
+#endif
+    return wake_pipe[0];
+}
+
+bool Executor::find_function(const std::string &name, std::string &module_name, uint32_t &index, std::string &descriptor)
+{
+    // A function in another module is named module.function, otherwise it
+    // is in the main program. Either way it must be exported, because the
+    // bytecode only records the signatures of exported functions, and only
+    // top level functions can be exported.
+    auto dot = name.find('.');
+    module_name = dot != std::string::npos ? name.substr(0, dot) : "";
+    const std::string function = dot != std::string::npos ? name.substr(dot+1) : name;
+    auto m = modules.find(module_name);
+    if (m == modules.end() || m->second == nullptr) {
+        return false;
+    }
+    const Bytecode &object = m->second->object;
+    for (auto &ef: object.export_functions) {
+        if (object.strtable[ef.name] == function) {
+            index = ef.index;
+            descriptor = object.strtable[ef.descriptor];
+            return true;
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<const ProgramImage> Executor::program_image()
+{
+    if (task_image == nullptr) {
+        task_image = std::make_shared<ProgramImage>(*this);
+    }
+    return task_image;
+}
+
+std::string Executor::find_module_name(const Module *mod)
+{
+    for (auto &m: modules) {
+        if (m.second == mod) {
+            return m.first;
+        }
+    }
+    throw RtlException(rtl::ne_global::Exception_InvalidFunctionException, utf8string(""));
+}
+
+bool Executor::init_modules()
+{
+    assert(std::this_thread::get_id() == thread);
+    CurrentExecutor current(this);
+
+    // Initialise the imported modules, but do not run the main program.
+    ip = module->object.code.size();
+    for (auto x = init_order.rbegin(); x != init_order.rend(); ++x) {
+        invoke(modules[*x], 0);
+    }
+    return exec_loop(0) == 0;
+}
+
+bool Executor::call_function(const std::string &module_name, uint32_t index, const std::vector<Cell> &args, Cell &result)
+{
+    assert(std::this_thread::get_id() == thread);
+    CurrentExecutor current(this);
+
+    for (auto &a: args) {
+        stack.push(a);
+    }
+    invoke(modules[module_name], index);
+    if (exec_loop(0) != 0) {
+        return false;
+    }
+    result = stack.top();
+    stack.pop();
+    return true;
+}
+
 int Executor::exec()
 {
+    assert(std::this_thread::get_id() == thread);
+    CurrentExecutor current(this);
+
     ip = module->object.code.size();
     invoke(module, 0);
 
@@ -1936,6 +2576,7 @@ int Executor::exec()
 
 int Executor::exec_loop(size_t min_callstack_depth)
 {
+    LoopDepth depth(loop_depth);
     while (callstack.size() > min_callstack_depth && ip < module->object.code.size() && exit_code == 0) {
         if (options->enable_trace) {
             auto i = ip;
@@ -2080,6 +2721,9 @@ int Executor::exec_loop(size_t min_callstack_depth)
             case Opcode::PUSHFP:  exec_PUSHFP(); break;
             case Opcode::CALLV:   exec_CALLV(); break;
             case Opcode::PUSHCI:  exec_PUSHCI(); break;
+            case Opcode::FORN:    exec_FORN(); break;
+            case Opcode::CASEN:   exec_CASEN(); break;
+            case Opcode::CASES:   exec_CASES(); break;
             default:
                 fprintf(stderr, "exec: Unexpected opcode: %d\n", module->object.code[ip]);
                 abort();
@@ -2282,53 +2926,213 @@ void Executor::handle_POST(const std::string &path, const std::string &data, Htt
 
 void executor_breakpoint()
 {
-    g_executor->breakpoint();
+    g_current_executor->breakpoint();
 }
 
 void executor_log(const std::string &message)
 {
-    g_executor->log(message);
+    g_current_executor->log(message);
 }
 
 bool executor_assertions_enabled()
 {
-    return g_executor->options->enable_assert;
+    return g_current_executor->options->enable_assert;
 }
 
 void executor_garbage_collect()
 {
-    g_executor->garbage_collect();
+    g_current_executor->garbage_collect();
 }
 
 size_t executor_get_allocated_object_count()
 {
-    return g_executor->get_allocated_object_count();
+    return g_current_executor->get_allocated_object_count();
 }
 
 bool executor_is_module_imported(const std::string &module)
 {
-    return g_executor->is_module_imported(module);
+    return g_current_executor->is_module_imported(module);
 }
 
 bool executor_module_is_main()
 {
-    return g_executor->module_is_main();
+    return g_current_executor->module_is_main();
 }
 
 void executor_set_garbage_collection_interval(size_t count)
 {
-    g_executor->set_garbage_collection_interval(count);
+    g_current_executor->set_garbage_collection_interval(count);
 }
 
 void executor_set_recursion_limit(size_t depth)
 {
-    g_executor->set_recursion_limit(depth);
+    g_current_executor->set_recursion_limit(depth);
+}
+
+void executor_spawn_fiber(Cell &function)
+{
+    g_current_executor->spawn_fiber(function);
+}
+
+void executor_yield()
+{
+    g_current_executor->wait_fiber(FiberWait());
+}
+
+void executor_sleep(std::chrono::microseconds duration)
+{
+    FiberWait w;
+    w.timed = true;
+    w.deadline = std::chrono::steady_clock::now() + duration;
+    if (not g_current_executor->wait_fiber(std::move(w))) {
+        std::this_thread::sleep_for(duration);
+    }
+}
+
+void executor_wait_fd(int fd, bool write)
+{
+    struct pollfd p;
+    p.fd = fd;
+    p.events = write ? POLLOUT : POLLIN;
+    p.revents = 0;
+    // Whether or not the fiber was resumed for this wait, the fd decides.
+    // Another fiber waiting on the same fd may have taken what woke this
+    // one, and then it has to be suspended again. Any earlier wait in this
+    // call is over too, so a later one in the same call must not take the
+    // fiber being resumed as its own either.
+    g_current_executor->fiber_resumed = false;
+    if (poll(&p, 1, 0) > 0) {
+        return;
+    }
+    FiberWait w;
+    w.fd = fd;
+    w.write = write;
+    g_current_executor->wait_fiber(std::move(w));
+}
+
+void executor_wait_for(const std::function<bool()> &ready)
+{
+    // As in executor_wait_fd, being resumed is not enough on its own.
+    g_current_executor->fiber_resumed = false;
+    if (ready()) {
+        return;
+    }
+    FiberWait w;
+    w.ready = ready;
+    g_current_executor->wait_fiber(std::move(w));
+}
+
+void executor_notify()
+{
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(g_WakeFdsMutex);
+    for (int fd: g_WakeFds) {
+        // A full pipe wakes its executor anyway.
+        char c = 0;
+        ssize_t n = write(fd, &c, 1);
+        static_cast<void>(n);
+    }
+#endif
+}
+
+std::shared_ptr<void> executor_run_blocking(const std::function<std::shared_ptr<void>()> &call)
+{
+    Executor *executor = g_current_executor;
+    if (executor->fiber_resumed && executor->wait.call != nullptr) {
+        executor->fiber_resumed = false;
+        std::shared_ptr<BlockingCall> done = executor->wait.call;
+        executor->wait.call = nullptr;
+        if (done->exception) {
+            std::rethrow_exception(done->exception);
+        }
+        return done->result;
+    }
+    if (not executor->can_switch_fiber()) {
+        return call();
+    }
+    auto pending = std::make_shared<BlockingCall>();
+    std::thread([pending, call] {
+        try {
+            pending->result = call();
+        } catch (...) {
+            pending->exception = std::current_exception();
+        }
+        pending->done = true;
+        executor_notify();
+    }).detach();
+    FiberWait w;
+    w.ready = [pending] { return pending->done.load(); };
+    w.call = pending;
+    executor->wait_fiber(std::move(w));
+    return nullptr;
+}
+
+// The descriptor of FUNCTION f(arg: Object): Object, whatever the
+// parameter is called.
+static bool is_task_descriptor(const std::string &descriptor)
+{
+    static const std::string prefix = "F[>";
+    static const std::string suffix = ":O]:O";
+    if (descriptor.length() <= prefix.length() + suffix.length()
+     || descriptor.compare(0, prefix.length(), prefix) != 0
+     || descriptor.compare(descriptor.length() - suffix.length(), suffix.length(), suffix) != 0) {
+        return false;
+    }
+    const std::string param = descriptor.substr(prefix.length(), descriptor.length() - prefix.length() - suffix.length());
+    return param.find_first_of(",:=[]") == std::string::npos;
+}
+
+ExecutorTask executor_prepare_task(const std::string &function)
+{
+    std::string module_name;
+    uint32_t index;
+    std::string descriptor;
+    if (not g_current_executor->find_function(function, module_name, index, descriptor)) {
+        throw RtlException(rtl::ne_parallel::Exception_ParallelException_FunctionNotFound, utf8string(function));
+    }
+    if (not is_task_descriptor(descriptor)) {
+        throw RtlException(rtl::ne_parallel::Exception_ParallelException_InvalidFunction, utf8string(function));
+    }
+    auto image = g_current_executor->program_image();
+    return [image, module_name, index](const std::shared_ptr<Object> &arg, std::shared_ptr<Object> &result) {
+        Executor executor(*image);
+        Cell r;
+        if (not executor.init_modules() || not executor.call_function(module_name, index, {Cell(arg)}, r)) {
+            return false;
+        }
+        result = r.object();
+        return true;
+    };
+}
+
+std::function<ExecutorCaller()> executor_prepare_call(Cell &function)
+{
+    std::vector<Cell> fp = function.array();
+    Number nindex = fp[1].number();
+    if (number_is_zero(nindex) || not number_is_integer(nindex)) {
+        throw RtlException(rtl::ne_global::Exception_InvalidFunctionException, utf8string(""));
+    }
+    std::string module_name = g_current_executor->find_module_name(reinterpret_cast<Module *>(fp[0].other()));
+    uint32_t index = number_to_uint32(nindex);
+    auto image = g_current_executor->program_image();
+    return [image, module_name, index]() -> ExecutorCaller {
+        auto executor = std::make_shared<Executor>(*image);
+        executor->report_unhandled = false;
+        bool ready = executor->init_modules();
+        return [image, executor, ready, module_name, index](const std::vector<Cell> &args) {
+            Cell r;
+            if (not ready || not executor->call_function(module_name, index, args, r)) {
+                throw RtlException(executor->unhandled_exception, executor->unhandled_info);
+            }
+            return r;
+        };
+    };
 }
 
 void executor_raise_exception(size_t ip, const utf8string &name, const utf8string &info)
 {
-    g_executor->ip = ip;
-    g_executor->raise_literal(name, std::make_shared<ObjectString>(info));
+    g_current_executor->ip = ip;
+    g_current_executor->raise_literal(name, std::make_shared<ObjectString>(info));
 }
 
 int exec(const std::string &source_path, const Bytecode::Bytes &obj, const DebugInfo *debuginfo, ICompilerSupport *support, const ExecOptions *options, unsigned short debug_port, int argc, char *argv[], std::map<std::string, Cell *> *external_globals)
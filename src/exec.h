@@ -1,13 +1,19 @@
 #ifndef EXEC_H
 #define EXEC_H
 
+#include <chrono>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 class Cell;
 class DebugInfo;
 class ICompilerSupport;
+class Object;
+
+// The executor_ functions act on the executor running on the calling thread.
 
 // Module: debugger
 void executor_breakpoint();
@@ -22,11 +28,47 @@ bool executor_module_is_main();
 void executor_set_garbage_collection_interval(size_t count);
 void executor_set_recursion_limit(size_t depth);
 
+// Fibers are cooperative threads within one executor, started by spawning
+// a function. Only one fiber runs at a time. A library function that would
+// block calls one of the functions below first. When another fiber can run,
+// the calling fiber is suspended, and once the wait is over the library
+// function is called again from the start, so it must not change anything
+// before the wait. When no other fiber can run, these return at once (or
+// block the thread) and the library function goes ahead as usual.
+void executor_spawn_fiber(Cell &function);
+void executor_yield();
+void executor_sleep(std::chrono::microseconds duration);
+void executor_wait_fd(int fd, bool write);
+void executor_wait_for(const std::function<bool()> &ready);
+// Whatever changes a condition given to executor_wait_for on another
+// thread calls this afterwards, so the fibers waiting for it check again.
+void executor_notify();
+// Call a function that may block on another thread while other fibers
+// run, and return its result. Exceptions it throws are thrown again here.
+std::shared_ptr<void> executor_run_blocking(const std::function<std::shared_ptr<void>()> &call);
+
+// Module: parallel
+// A task calls one function of the program in a new executor of its own.
+// It may be run on any thread, and returns false if the function ended
+// with an unhandled exception.
+typedef std::function<bool(const std::shared_ptr<Object> &arg, std::shared_ptr<Object> &result)> ExecutorTask;
+ExecutorTask executor_prepare_task(const std::string &function);
+
+// Module: global
+// The parallel array methods call a function value on worker threads. Each
+// worker makes its own caller, which starts a new executor for the program
+// on that thread. A call that ends with an unhandled exception throws it as
+// an RtlException, so it can be raised again on the calling thread.
+typedef std::function<Cell(const std::vector<Cell> &args)> ExecutorCaller;
+std::function<ExecutorCaller()> executor_prepare_call(Cell &function);
+
 struct ExecOptions {
     bool enable_assert;
     bool enable_trace;
 };
 
+// Run a program in a new executor on the calling thread. Each executor is
+// self-contained, so different threads may call exec() at the same time.
 int exec(const std::string &source_path, const std::vector<unsigned char> &obj, const DebugInfo *debug, ICompilerSupport *support, const ExecOptions *options, unsigned short debug_port, int argc, char *argv[], std::map<std::string, Cell *> *external_globals = nullptr);
 
 #endif
@@ -1,9 +1,23 @@
 #include "lexer.h"
 
 #include <algorithm>
+#include <deque>
 #include <iso646.h>
+#include <mutex>
 #include <sstream>
 #include <string.h>
+#include <unordered_map>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LEXER_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 #include <sha256.h>
 #include <utf8.h>
@@ -20,6 +34,66 @@ std::string TokenizedSource::source_line(int line) const
     return std::string(source_text, source_lines[line].first, source_lines[line].second);
 }
 
+namespace {
+
+// Text of tokens that is not part of any source (see Token::set_text).
+// Each distinct string is stored once, so this stays about as big as the
+// set of names the compiler makes up.
+struct TextPool {
+    TextPool(): mutex(), strings(), index() {}
+    std::mutex mutex;
+    std::deque<std::string> strings;
+    std::unordered_map<std::string, int32_t> index;
+};
+
+TextPool &text_pool()
+{
+    static TextPool pool;
+    return pool;
+}
+
+} // namespace
+
+std::string Token::text() const
+{
+    if (text_index == SOURCE_TEXT) {
+        return source->source_text.substr(offset, length);
+    }
+    if (text_index >= 0) {
+        return source->strings[text_index];
+    }
+    if (text_index == NO_TEXT) {
+        return std::string();
+    }
+    TextPool &pool = text_pool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    return pool.strings[NO_TEXT - 1 - text_index];
+}
+
+Number Token::value() const
+{
+    if (number_index < 0) {
+        return Number();
+    }
+    return source->numbers[number_index];
+}
+
+void Token::set_text(const std::string &text)
+{
+    if (text.empty()) {
+        text_index = NO_TEXT;
+        return;
+    }
+    TextPool &pool = text_pool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    auto i = pool.index.find(text);
+    if (i == pool.index.end()) {
+        i = pool.index.insert(std::make_pair(text, static_cast<int32_t>(pool.strings.size()))).first;
+        pool.strings.push_back(text);
+    }
+    text_index = NO_TEXT - 1 - i->second;
+}
+
 std::string Token::file() const
 {
     return source != nullptr ? source->source_path : std::string();
@@ -40,9 +114,9 @@ std::string Token::tostring() const
     switch (type) {
         case NONE:        s << "NONE"; break;
         case END_OF_FILE: s << "END_OF_FILE"; break;
-        case NUMBER:      s << "NUMBER:" << number_to_string(value); break;
-        case STRING:      s << "STRING:" << text; break;
-        case IDENTIFIER:  s << "IDENTIFIER:" << text; break;
+        case NUMBER:      s << "NUMBER:" << number_to_string(value()); break;
+        case STRING:      s << "STRING:" << text(); break;
+        case IDENTIFIER:  s << "IDENTIFIER:" << text(); break;
         case LPAREN:      s << "LPAREN"; break;
         case RPAREN:      s << "RPAREN"; break;
         case LBRACKET:    s << "LBRACKET"; break;
@@ -205,6 +279,182 @@ inline bool space(uint32_t c)
     return c < 256 && isspace(c);
 }
 
+// The scanners below find the end of a run of bytes that the lexer would
+// otherwise step over one code point at a time. Each set of bytes gives a
+// scalar test and SSE2 (and AVX2, when compiled for it) versions that
+// return 0xff in each lane where the run stops. None of the stopping bytes
+// are UTF-8 continuation bytes, so a run always ends on a code point.
+
+#ifdef LEXER_SSE2
+inline __m128i in_range(__m128i v, char lo, char hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+inline __m128i eq(__m128i v, char c)
+{
+    return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+inline __m128i invert(__m128i v)
+{
+    return _mm_xor_si128(v, _mm_set1_epi8(-1));
+}
+#endif
+
+#ifdef __AVX2__
+inline __m256i in_range(__m256i v, char lo, char hi)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+inline __m256i eq(__m256i v, char c)
+{
+    return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+inline __m256i invert(__m256i v)
+{
+    return _mm256_xor_si256(v, _mm256_set1_epi8(-1));
+}
+#endif
+
+inline int lowest_bit(uint32_t mask)
+{
+#ifdef _MSC_VER
+    unsigned long r;
+    _BitScanForward(&r, mask);
+    return static_cast<int>(r);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+// Spaces (used for indentation); newlines are handled by the caller.
+struct SpaceRun {
+    static bool stop(char c) { return c != ' '; }
+#ifdef LEXER_SSE2
+    static __m128i stop(__m128i v) { return invert(eq(v, ' ')); }
+#endif
+#ifdef __AVX2__
+    static __m256i stop(__m256i v) { return invert(eq(v, ' ')); }
+#endif
+};
+
+// The body of an identifier. Setting bit 0x20 folds upper case letters
+// onto lower case without bringing any other byte into 'a'..'z'.
+struct IdentifierRun {
+    static bool stop(char c) { return not identifier_body(static_cast<unsigned char>(c)); }
+#ifdef LEXER_SSE2
+    static __m128i stop(__m128i v) { return invert(_mm_or_si128(_mm_or_si128(in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'), in_range(v, '0', '9')), eq(v, '_'))); }
+#endif
+#ifdef __AVX2__
+    static __m256i stop(__m256i v) { return invert(_mm256_or_si256(_mm256_or_si256(in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z'), in_range(v, '0', '9')), eq(v, '_'))); }
+#endif
+};
+
+struct DigitRun {
+    static bool stop(char c) { return c < '0' || c > '9'; }
+#ifdef LEXER_SSE2
+    static __m128i stop(__m128i v) { return invert(in_range(v, '0', '9')); }
+#endif
+#ifdef __AVX2__
+    static __m256i stop(__m256i v) { return invert(in_range(v, '0', '9')); }
+#endif
+};
+
+// The rest of a -- comment.
+struct LineRun {
+    static bool stop(char c) { return c == '\n'; }
+#ifdef LEXER_SSE2
+    static __m128i stop(__m128i v) { return eq(v, '\n'); }
+#endif
+#ifdef __AVX2__
+    static __m256i stop(__m256i v) { return eq(v, '\n'); }
+#endif
+};
+
+// The inside of a /* */ comment, which must notice line ends.
+struct BlockCommentRun {
+    static bool stop(char c) { return c == '*' || c == '\n'; }
+#ifdef LEXER_SSE2
+    static __m128i stop(__m128i v) { return _mm_or_si128(eq(v, '*'), eq(v, '\n')); }
+#endif
+#ifdef __AVX2__
+    static __m256i stop(__m256i v) { return _mm256_or_si256(eq(v, '*'), eq(v, '\n')); }
+#endif
+};
+
+// Characters of a string literal that need no processing.
+struct StringRun {
+    static bool stop(char c) { return c == '"' || c == '\\' || c == '\n'; }
+#ifdef LEXER_SSE2
+    static __m128i stop(__m128i v) { return _mm_or_si128(_mm_or_si128(eq(v, '"'), eq(v, '\\')), eq(v, '\n')); }
+#endif
+#ifdef __AVX2__
+    static __m256i stop(__m256i v) { return _mm256_or_si256(_mm256_or_si256(eq(v, '"'), eq(v, '\\')), eq(v, '\n')); }
+#endif
+};
+
+// Characters of a raw string literal @"...".
+struct RawStringRun {
+    static bool stop(char c) { return c == '"' || c == '\n'; }
+#ifdef LEXER_SSE2
+    static __m128i stop(__m128i v) { return _mm_or_si128(eq(v, '"'), eq(v, '\n')); }
+#endif
+#ifdef __AVX2__
+    static __m256i stop(__m256i v) { return _mm256_or_si256(eq(v, '"'), eq(v, '\n')); }
+#endif
+};
+
+// Return the first position at or after i where the run described by
+// Run stops, or end.
+template <typename Run> std::string::const_iterator scan(std::string::const_iterator i, std::string::const_iterator end)
+{
+    if (i == end) {
+        return i;
+    }
+    const char *const start = &*i;
+    const char *const e = start + (end - i);
+    const char *p = start;
+#ifdef __AVX2__
+    while (e - p >= 32) {
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(Run::stop(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)))));
+        if (mask != 0) {
+            return i + ((p + lowest_bit(mask)) - start);
+        }
+        p += 32;
+    }
+#endif
+#ifdef LEXER_SSE2
+    while (e - p >= 16) {
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(Run::stop(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)))));
+        if (mask != 0) {
+            return i + ((p + lowest_bit(mask)) - start);
+        }
+        p += 16;
+    }
+#endif
+    while (p != e && not Run::stop(*p)) {
+        ++p;
+    }
+    return i + (p - start);
+}
+
+// Append the digits (leaving out any '_' separators) at i to n.
+static void scan_decimal(std::string::const_iterator &i, std::string::const_iterator end, std::string &n)
+{
+    for (;;) {
+        auto run = scan<DigitRun>(i, end);
+        n.append(i, run);
+        i = run;
+        if (i == end || *i != '_') {
+            break;
+        }
+        ++i;
+    }
+}
+
 uint32_t unicode_lookup(const Token &t, const std::string &name)
 {
     std::string uname;
@@ -228,7 +478,24 @@ uint32_t unicode_lookup(const Token &t, const std::string &name)
     error(1027, t, "unicode character name not found");
 }
 
-static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std::string &source_path, int &line, size_t column, const std::string &source)
+// Give a string token its processed text from the string table.
+static Token string_token(TokenizedSource *tsource, Token t, const std::string &text)
+{
+    t.text_index = static_cast<int32_t>(tsource->strings.size());
+    tsource->strings.push_back(text);
+    return t;
+}
+
+// Give a token the text of a range of the source.
+static void source_range(Token &t, size_t offset, size_t length)
+{
+    t.text_index = Token::SOURCE_TEXT;
+    t.offset = static_cast<uint32_t>(offset);
+    t.length = static_cast<uint32_t>(length);
+}
+
+// The source is a fragment of tsource->source_text starting at base.
+static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std::string &source_path, int &line, size_t column, const std::string &source, size_t base)
 {
     std::vector<Token> tokens;
     std::string::const_iterator linestart = source.begin();
@@ -245,6 +512,7 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
         t.line = line;
         t.column = column;
         t.type = NONE;
+        std::string text;
              if (c == '(') { t.type = LPAREN; utf8::advance(i, 1, source.end()); }
         else if (c == ')') { t.type = RPAREN; utf8::advance(i, 1, source.end()); }
         else if (c == '[') { t.type = LBRACKET; utf8::advance(i, 1, source.end()); }
@@ -272,9 +540,7 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
         // TODO else if (c == 0x2209 /*'∉'*/) { t.type = NOTIN; utf8::advance(i, 1, source.end()); }
         else if (c == '-') {
             if (i+1 != source.end() && *(i+1) == '-') {
-                while (i != source.end() && *i != '\n') {
-                    utf8::advance(i, 1, source.end());
-                }
+                i = scan<LineRun>(i, source.end());
             } else if (i+1 != source.end() && *(i+1) == '>') {
                 t.type = ARROW;
                 utf8::advance(i, 2, source.end());
@@ -298,7 +564,7 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                         startindex = i;
                         utf8::advance(i, 1, source.end());
                     } else {
-                        utf8::advance(i, 1, source.end());
+                        i = scan<BlockCommentRun>(i + 1, source.end());
                     }
                 }
             } else {
@@ -343,103 +609,102 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
         } else if (identifier_start(c)) {
             t.type = IDENTIFIER;
             auto const start = i;
-            while (i != source.end() && identifier_body(*i)) {
-                utf8::advance(i, 1, source.end());
-            }
-            t.text = std::string(start, i);
-                 if (t.text == "IF") t.type = IF;
-            else if (t.text == "THEN") t.type = THEN;
-            else if (t.text == "ELSE") t.type = ELSE;
-            else if (t.text == "END") t.type = END;
-            else if (t.text == "WHILE") t.type = WHILE;
-            else if (t.text == "DO") t.type = DO;
-            else if (t.text == "VAR") t.type = VAR;
-            else if (t.text == "FUNCTION") t.type = FUNCTION;
-            else if (t.text == "RETURN") t.type = RETURN;
-            else if (t.text == "FALSE") t.type = FALSE;
-            else if (t.text == "TRUE") t.type = TRUE;
-            else if (t.text == "MOD") t.type = MOD;
-            else if (t.text == "AND") t.type = AND;
-            else if (t.text == "OR") t.type = OR;
-            else if (t.text == "NOT") t.type = NOT;
-            else if (t.text == "FOR") t.type = FOR;
-            else if (t.text == "TO") t.type = TO;
-            else if (t.text == "STEP") t.type = STEP;
-            else if (t.text == "Array") t.type = ARRAY;
-            else if (t.text == "Dictionary") t.type = DICTIONARY;
-            else if (t.text == "TYPE") t.type = TYPE;
-            else if (t.text == "RECORD") t.type = RECORD;
-            else if (t.text == "ENUM") t.type = ENUM;
-            else if (t.text == "CONSTANT") t.type = CONSTANT;
-            else if (t.text == "IMPORT") t.type = IMPORT;
-            else if (t.text == "IN") t.type = IN;
-            else if (t.text == "OUT") t.type = OUT;
-            else if (t.text == "INOUT") t.type = INOUT;
-            else if (t.text == "ELSIF") t.type = ELSIF;
-            else if (t.text == "CASE") t.type = CASE;
-            else if (t.text == "WHEN") t.type = WHEN;
-            else if (t.text == "EXIT") t.type = EXIT;
-            else if (t.text == "NEXT") t.type = NEXT;
-            else if (t.text == "LOOP") t.type = LOOP;
-            else if (t.text == "REPEAT") t.type = REPEAT;
-            else if (t.text == "UNTIL") t.type = UNTIL;
-            else if (t.text == "DECLARE") t.type = DECLARE;
-            else if (t.text == "EXCEPTION") t.type = EXCEPTION;
-            else if (t.text == "TRY") t.type = TRY;
-            else if (t.text == "RAISE") t.type = RAISE;
-            else if (t.text == "POINTER") t.type = POINTER;
-            else if (t.text == "NEW") t.type = NEW;
-            else if (t.text == "NIL") t.type = NIL;
-            else if (t.text == "VALID") t.type = VALID;
-            else if (t.text == "LET") t.type = LET;
-            else if (t.text == "FIRST") t.type = FIRST;
-            else if (t.text == "LAST") t.type = LAST;
-            else if (t.text == "AS") t.type = AS;
-            else if (t.text == "DEFAULT") t.type = DEFAULT;
-            else if (t.text == "EXPORT") t.type = EXPORT;
-            else if (t.text == "PRIVATE") t.type = PRIVATE;
-            else if (t.text == "NATIVE") t.type = NATIVE;
-            else if (t.text == "FOREACH") t.type = FOREACH;
-            else if (t.text == "INDEX") t.type = INDEX;
-            else if (t.text == "ASSERT") t.type = ASSERT;
-            else if (t.text == "EMBED") t.type = EMBED;
-            else if (t.text == "ALIAS") t.type = ALIAS;
-            else if (t.text == "IS") t.type = IS;
-            else if (t.text == "BEGIN") t.type = BEGIN;
-            else if (t.text == "MAIN") t.type = MAIN;
-            else if (t.text == "HEXBYTES") t.type = HEXBYTES;
-            else if (t.text == "INC") t.type = INC;
-            else if (t.text == "DEC") t.type = DEC;
-            else if (t.text == "_") t.type = UNDERSCORE;
-            else if (t.text == "OTHERS") t.type = OTHERS;
-            else if (t.text == "WITH") t.type = WITH;
-            else if (t.text == "CHECK") t.type = CHECK;
-            else if (t.text == "GIVES") t.type = GIVES;
-            else if (t.text == "NOWHERE") t.type = NOWHERE;
-            else if (t.text == "INTDIV") t.type = INTDIV;
-            else if (t.text == "EXEC") t.type = EXEC;
-            else if (t.text == "LABEL") t.type = LABEL;
-            else if (t.text == "CLASS") t.type = CLASS;
-            else if (t.text == "TRAP") t.type = TRAP;
-            else if (t.text == "EXTENSION") t.type = EXTENSION;
-            else if (t.text == "INTERFACE") t.type = INTERFACE;
-            else if (t.text == "IMPLEMENTS") t.type = IMPLEMENTS;
-            else if (t.text == "UNUSED") t.type = UNUSED;
-            else if (t.text == "ISA") t.type = ISA;
-            else if (t.text == "OPTIONAL") t.type = OPTIONAL;
-            else if (t.text == "IMPORTED") t.type = IMPORTED;
-            else if (t.text == "TESTCASE") t.type = TESTCASE;
-            else if (t.text == "EXPECT") t.type = EXPECT;
-            else if (all_upper(t.text)) {
+            i = scan<IdentifierRun>(i, source.end());
+            text = std::string(start, i);
+            source_range(t, base + (start - source.begin()), i - start);
+                 if (text == "IF") t.type = IF;
+            else if (text == "THEN") t.type = THEN;
+            else if (text == "ELSE") t.type = ELSE;
+            else if (text == "END") t.type = END;
+            else if (text == "WHILE") t.type = WHILE;
+            else if (text == "DO") t.type = DO;
+            else if (text == "VAR") t.type = VAR;
+            else if (text == "FUNCTION") t.type = FUNCTION;
+            else if (text == "RETURN") t.type = RETURN;
+            else if (text == "FALSE") t.type = FALSE;
+            else if (text == "TRUE") t.type = TRUE;
+            else if (text == "MOD") t.type = MOD;
+            else if (text == "AND") t.type = AND;
+            else if (text == "OR") t.type = OR;
+            else if (text == "NOT") t.type = NOT;
+            else if (text == "FOR") t.type = FOR;
+            else if (text == "TO") t.type = TO;
+            else if (text == "STEP") t.type = STEP;
+            else if (text == "Array") t.type = ARRAY;
+            else if (text == "Dictionary") t.type = DICTIONARY;
+            else if (text == "TYPE") t.type = TYPE;
+            else if (text == "RECORD") t.type = RECORD;
+            else if (text == "ENUM") t.type = ENUM;
+            else if (text == "CONSTANT") t.type = CONSTANT;
+            else if (text == "IMPORT") t.type = IMPORT;
+            else if (text == "IN") t.type = IN;
+            else if (text == "OUT") t.type = OUT;
+            else if (text == "INOUT") t.type = INOUT;
+            else if (text == "ELSIF") t.type = ELSIF;
+            else if (text == "CASE") t.type = CASE;
+            else if (text == "WHEN") t.type = WHEN;
+            else if (text == "EXIT") t.type = EXIT;
+            else if (text == "NEXT") t.type = NEXT;
+            else if (text == "LOOP") t.type = LOOP;
+            else if (text == "REPEAT") t.type = REPEAT;
+            else if (text == "UNTIL") t.type = UNTIL;
+            else if (text == "DECLARE") t.type = DECLARE;
+            else if (text == "EXCEPTION") t.type = EXCEPTION;
+            else if (text == "TRY") t.type = TRY;
+            else if (text == "RAISE") t.type = RAISE;
+            else if (text == "POINTER") t.type = POINTER;
+            else if (text == "NEW") t.type = NEW;
+            else if (text == "NIL") t.type = NIL;
+            else if (text == "VALID") t.type = VALID;
+            else if (text == "LET") t.type = LET;
+            else if (text == "FIRST") t.type = FIRST;
+            else if (text == "LAST") t.type = LAST;
+            else if (text == "AS") t.type = AS;
+            else if (text == "DEFAULT") t.type = DEFAULT;
+            else if (text == "EXPORT") t.type = EXPORT;
+            else if (text == "PRIVATE") t.type = PRIVATE;
+            else if (text == "NATIVE") t.type = NATIVE;
+            else if (text == "FOREACH") t.type = FOREACH;
+            else if (text == "INDEX") t.type = INDEX;
+            else if (text == "ASSERT") t.type = ASSERT;
+            else if (text == "EMBED") t.type = EMBED;
+            else if (text == "ALIAS") t.type = ALIAS;
+            else if (text == "IS") t.type = IS;
+            else if (text == "BEGIN") t.type = BEGIN;
+            else if (text == "MAIN") t.type = MAIN;
+            else if (text == "HEXBYTES") t.type = HEXBYTES;
+            else if (text == "INC") t.type = INC;
+            else if (text == "DEC") t.type = DEC;
+            else if (text == "_") t.type = UNDERSCORE;
+            else if (text == "OTHERS") t.type = OTHERS;
+            else if (text == "WITH") t.type = WITH;
+            else if (text == "CHECK") t.type = CHECK;
+            else if (text == "GIVES") t.type = GIVES;
+            else if (text == "NOWHERE") t.type = NOWHERE;
+            else if (text == "INTDIV") t.type = INTDIV;
+            else if (text == "EXEC") t.type = EXEC;
+            else if (text == "LABEL") t.type = LABEL;
+            else if (text == "CLASS") t.type = CLASS;
+            else if (text == "TRAP") t.type = TRAP;
+            else if (text == "EXTENSION") t.type = EXTENSION;
+            else if (text == "INTERFACE") t.type = INTERFACE;
+            else if (text == "IMPLEMENTS") t.type = IMPLEMENTS;
+            else if (text == "UNUSED") t.type = UNUSED;
+            else if (text == "ISA") t.type = ISA;
+            else if (text == "OPTIONAL") t.type = OPTIONAL;
+            else if (text == "IMPORTED") t.type = IMPORTED;
+            else if (text == "TESTCASE") t.type = TESTCASE;
+            else if (text == "EXPECT") t.type = EXPECT;
+            else if (all_upper(text)) {
                 t.type = UNKNOWN;
-            } else if (t.text.find("__") != std::string::npos) {
+            } else if (text.find("__") != std::string::npos) {
                 error(1024, t, "identifier cannot contain double underscore (reserved)");
-            } else if (t.text.length() >= 2 && t.text[0] == '_') {
+            } else if (text.length() >= 2 && text[0] == '_') {
                 error(1025, t, "identifier cannot start with underscore");
             }
         } else if (number_start(c)) {
             t.type = NUMBER;
-            auto start = i;
+            Number value;
             if (c == '0' && (i+1 != source.end()) && *(i+1) != '.' && tolower(*(i+1)) != 'e' && not number_decimal_body(*(i+1))) {
                 utf8::advance(i, 1, source.end());
                 c = static_cast<char>(tolower(*i));
@@ -457,7 +722,7 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                     } else {
                         error(1003, t, "invalid base character");
                     }
-                    Number value = number_from_uint32(0);
+                    value = number_from_uint32(0);
                     const auto nstart = i;
                     while (i != source.end()) {
                         c = static_cast<char>(tolower(*i));
@@ -479,30 +744,19 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                     if (i == nstart) {
                         error(1008, t, "numeric constants must have at least one digit");
                     }
-                    t.value = value;
                 } else {
-                    t.value = number_from_uint32(0);
+                    value = number_from_uint32(0);
                 }
             } else {
                 std::string n;
-                while (i != source.end() && number_decimal_body(*i)) {
-                    if (*i != '_') {
-                        n.push_back(*i);
-                    }
-                    utf8::advance(i, 1, source.end());
-                }
+                scan_decimal(i, source.end(), n);
                 if (i != source.end() && *i == '.') {
                     n.push_back(*i);
                     utf8::advance(i, 1, source.end());
                     if (i != source.end() && not number_start(*i)) {
                         error(1028, t, "fractional part of number must contain at least one digit");
                     }
-                    while (i != source.end() && number_decimal_body(*i)) {
-                        if (*i != '_') {
-                            n.push_back(*i);
-                        }
-                        utf8::advance(i, 1, source.end());
-                    }
+                    scan_decimal(i, source.end(), n);
                 }
                 if (i != source.end() && tolower(*i) == 'e') {
                     n.push_back(*i);
@@ -511,25 +765,23 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                         n.push_back(*i);
                         utf8::advance(i, 1, source.end());
                     }
-                    while (i != source.end() && number_decimal_body(*i)) {
-                        if (*i != '_') {
-                            n.push_back(*i);
-                        }
-                        utf8::advance(i, 1, source.end());
-                    }
+                    scan_decimal(i, source.end(), n);
                 }
-                t.value = number_from_string(n);
-                if (not number_is_finite(t.value)) {
+                value = number_from_string(n);
+                if (not number_is_finite(value)) {
                     error(1029, t, "floating point number out of range");
                 }
             }
-            t.text = std::string(start, i);
+            t.number_index = static_cast<int32_t>(tsource->numbers.size());
+            tsource->numbers.push_back(value);
         } else if (c == '"') {
             utf8::advance(i, 1, source.end());
             t.type = STRING;
-            t.text = "";
             while (i != source.end()) {
-                c = utf8::next(i, source.end());
+                auto run = scan<StringRun>(i, source.end());
+                text.append(i, run);
+                i = run;
+                c = i != source.end() ? utf8::next(i, source.end()) : 0;
                 if (c == '"') {
                     break;
                 }
@@ -582,7 +834,7 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                             break;
                         }
                         case '(': {
-                            tokens.push_back(t);
+                            tokens.push_back(string_token(tsource, t, text));
                             t.column = column + (i - startindex) - 1;
                             t.type = SUBBEGIN;
                             tokens.push_back(t);
@@ -624,7 +876,7 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                                 end = colon;
                             }
                             size_t col = column + (start - startindex);
-                            auto subtokens = tokenize_fragment(tsource, source_path, line, col, std::string(start, end));
+                            auto subtokens = tokenize_fragment(tsource, source_path, line, col, std::string(start, end), base + (start - source.begin()));
                             std::copy(subtokens.begin(), subtokens.end(), std::back_inserter(tokens));
                             if (colon > start) {
                                 t.column = column + (colon - startindex);
@@ -632,27 +884,25 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                                 tokens.push_back(t);
                                 t.column += 1;
                                 t.type = STRING;
-                                t.text = std::string(colon + 1, i - 1);
-                                tokens.push_back(t);
+                                tokens.push_back(string_token(tsource, t, std::string(colon + 1, i - 1)));
                             }
                             t.column = column + (i - startindex) - 1;
                             t.type = SUBEND;
                             tokens.push_back(t);
                             t.column = column + (i - startindex);
                             t.type = STRING;
-                            t.text = "";
+                            text = "";
                             continue;
                         }
                         default:
                             error(1009, t, "invalid escape character");
                     }
                 }
-                utf8::append(c, std::back_inserter(t.text));
+                utf8::append(c, std::back_inserter(text));
             }
         } else if (c == '@') {
             utf8::advance(i, 1, source.end());
             t.type = STRING;
-            t.text = "";
             if (i == source.end()) {
                 error(1016, t, "unterminated raw string");
             }
@@ -660,7 +910,10 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
             if (c == '"') {
                 utf8::advance(i, 1, source.end());
                 while (i != source.end()) {
-                    c = utf8::next(i, source.end());
+                    auto run = scan<RawStringRun>(i, source.end());
+                    text.append(i, run);
+                    i = run;
+                    c = i != source.end() ? utf8::next(i, source.end()) : 0;
                     if (c == '"') {
                         break;
                     }
@@ -670,7 +923,7 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                     if (c == '\n') {
                         error(1022, t, "unterminated raw string (must be single line)");
                     }
-                    utf8::append(c, std::back_inserter(t.text));
+                    utf8::append(c, std::back_inserter(text));
                 }
             } else {
                 std::string delimiter;
@@ -693,11 +946,11 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                     c = utf8::next(i, source.end());
                     if (c == utf8::next(d, delimiter.end())) {
                         if (d == delimiter.end()) {
-                            auto j = t.text.end();
+                            auto j = text.end();
                             for (std::string::size_type trunc = delimiter.length() - 1; trunc > 0; trunc--) {
-                                utf8::prior(j, t.text.begin());
+                                utf8::prior(j, text.begin());
                             }
-                            t.text = std::string(t.text.begin(), j);
+                            text = std::string(text.begin(), j);
                             break;
                         }
                     } else {
@@ -716,7 +969,7 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                         linestart = i+1;
                         lineend = std::find(i+1, source.end(), '\n');
                     }
-                    utf8::append(c, std::back_inserter(t.text));
+                    utf8::append(c, std::back_inserter(text));
                 }
             }
         } else if (space(c)) {
@@ -729,19 +982,21 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
                     lineend = std::find(i+1, source.end(), '\n');
                 }
                 utf8::advance(i, 1, source.end());
+                i = scan<SpaceRun>(i, source.end());
             }
         } else {
             error(1007, t, "Unexpected character");
         }
         if (t.type == EXEC) {
+            source_range(t, base + (startindex - source.begin()), i - startindex);
             tokens.push_back(t);
             t.type = STRING;
             t.column = column + (i - startindex);
-            t.text = "";
+            text = "";
             while (i != source.end() && *i != ';') {
                 uint32_t e = utf8::peek_next(i, source.end());
                 utf8::advance(i, 1, source.end());
-                utf8::append(e, std::back_inserter(t.text));
+                utf8::append(e, std::back_inserter(text));
                 if (e == '\n' && i != source.end()) {
                     line++;
                     column = 0;
@@ -755,10 +1010,10 @@ static std::vector<Token> tokenize_fragment(TokenizedSource *tsource, const std:
             }
             utf8::advance(i, 1, source.end());
         }
-        if (t.type != NONE) {
-            if (t.text.empty() && t.type != STRING) {
-                t.text = std::string(startindex, i);
-            }
+        if (t.type == STRING) {
+            tokens.push_back(string_token(tsource, t, text));
+        } else if (t.type != NONE) {
+            source_range(t, base + (startindex - source.begin()), i - startindex);
             tokens.push_back(t);
         }
         column += utf8::distance(startindex, i);
@@ -826,7 +1081,7 @@ std::unique_ptr<TokenizedSource> tokenize(const std::string &source_path, const
     r->source_hash = std::string(h, h+sizeof(h));
     r->source_text = std::string(i, source.end());
     r->source_lines.resize(1); // Leave room for nonexistent line 0.
-    r->tokens = tokenize_fragment(r.get(), source_path, line, 1, r->source_text);
+    r->tokens = tokenize_fragment(r.get(), source_path, line, 1, r->source_text, 0);
     Token t(r.get());
     t.line = line;
     t.column = 1;
@@ -8,11 +8,13 @@
 
 class TokenizedSource {
 public:
-    TokenizedSource(): source_path(), source_hash(), source_text(), source_lines(), tokens() {}
+    TokenizedSource(): source_path(), source_hash(), source_text(), source_lines(), strings(), numbers(), tokens() {}
     std::string source_path;
     std::string source_hash;
     std::string source_text;
     std::vector<std::pair<std::string::size_type, std::string::size_type>> source_lines;
+    std::vector<std::string> strings;
+    std::vector<Number> numbers;
     std::vector<Token> tokens;
     std::string source_line(int line) const;
 };
@@ -1,8 +1,10 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <thread>
 
 #include "analyzer.h"
+#include "arena.h"
 #include "ast.h"
 #include "cell.h"
 #include "compiler.h"
@@ -176,6 +178,9 @@ int main(int argc, char *argv[])
         debug.reset(new DebugInfo(name, source.str()));
 
         try {
+            // The parse tree and AST are released before the program runs.
+            Arena arena;
+            ArenaScope arena_scope(&arena);
             auto tokens = tokenize(name, source.str());
             if (dump_tokens) {
                 dump(*tokens);
@@ -186,6 +191,7 @@ int main(int argc, char *argv[])
                 dump(parsetree.get());
             }
 
+            compiler_support.compileImports(parsetree.get(), std::thread::hardware_concurrency());
             auto program = analyze(&compiler_support, parsetree.get());
             if (dump_ast) {
                 dump(program);
@@ -1,6 +1,7 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <thread>
 
 #include "analyzer.h"
 #include "ast.h"
@@ -23,7 +24,7 @@ struct {
     std::string description;
 } Targets[] = {
     {"cli", compile_cli, "CLI (.NET) target. Output file name is a .exe file."},
-    {"cpp", compile_cpp, "C++ target. Output file name is a .cpp source file."},
+    {"cpp", compile_cpp, "C++ target. Output is a directory (default <name>-cpp) with a CMake project and a .neon.cpp and .neon.h for each module."},
     {"js",  compile_js,  "Javascript target. Output file name is a .js source file."},
     {"jvm", compile_jvm, "JVM (Java VM) target. Output file is a .class file."},
 };
@@ -35,6 +36,7 @@ int main(int argc, char *argv[])
     std::string output;
     bool quiet = false;
     bool error_json = false;
+    unsigned int jobs = std::thread::hardware_concurrency();
     std::string target;
     CompileProc target_proc = nullptr;
     std::map<std::string, std::string> options;
@@ -45,6 +47,7 @@ int main(int argc, char *argv[])
         fprintf(stderr, "    Options:\n");
         fprintf(stderr, "        -i          Ignore any errors, compile all named source files\n");
         fprintf(stderr, "        -d          Print disassembly listing\n");
+        fprintf(stderr, "        -j jobs     Number of imported modules to compile in parallel\n");
         fprintf(stderr, "        --json      Print error messages in JSON form\n");
         fprintf(stderr, "        --neonpath  Append given path to library search path\n");
         fprintf(stderr, "        -o filename Output file name\n");
@@ -67,6 +70,13 @@ int main(int argc, char *argv[])
             ignore_errors = true;
         } else if (arg == "-d") {
             listing = true;
+        } else if (arg == "-j") {
+            a++;
+            if (a >= argc) {
+                std::cerr << "Missing number of jobs\n";
+                exit(1);
+            }
+            jobs = std::stoi(argv[a]);
         } else if (arg == "--json") {
             error_json = true;
         } else if (arg == "--neonpath") {
@@ -160,6 +170,7 @@ int main(int argc, char *argv[])
         try {
             auto tokens = tokenize(name, buf.str());
             auto parsetree = parse(*tokens);
+            compiler_support.compileImports(parsetree.get(), jobs);
             auto ast = analyze(&compiler_support, parsetree.get());
             DebugInfo debug(name, buf.str());
             if (target_proc == nullptr) {
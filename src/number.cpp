@@ -3,19 +3,44 @@
 #include <assert.h>
 #include <iso646.h>
 
+// The BID library reports exceptions by setting bits in a flags word
+// supplied by the caller. Each thread has its own, so that arithmetic in
+// one thread can neither raise nor clear an exception in another.
+static thread_local _IDEC_flags number_flags = 0;
+
+void number_clear_flags()
+{
+    number_flags = 0;
+}
+
+_IDEC_flags number_get_flags()
+{
+    return number_flags;
+}
+
 const mpz_class &Number::get_mpz()
 {
     assert(rep == Rep::MPZ);
     return mpz;
 }
 
+void Number::add_integer(long y)
+{
+    assert(rep == Rep::MPZ);
+    if (y >= 0) {
+        mpz_add_ui(mpz.get_mpz_t(), mpz.get_mpz_t(), static_cast<unsigned long>(y));
+    } else {
+        mpz_sub_ui(mpz.get_mpz_t(), mpz.get_mpz_t(), -static_cast<unsigned long>(y));
+    }
+}
+
 BID_UINT128 Number::get_bid()
 {
     if (rep == Rep::BID) {
         return bid;
     }
     assert(rep == Rep::MPZ);
-    return bid128_from_string(const_cast<char *>(mpz.get_str().c_str()));
+    return bid128_from_string(const_cast<char *>(mpz.get_str().c_str()), &number_flags);
 }
 
 Number number_add(Number x, Number y)
@@ -23,7 +48,7 @@ Number number_add(Number x, Number y)
     if (x.rep == Rep::MPZ && y.rep == Rep::MPZ) {
         return mpz_class(x.get_mpz() + y.get_mpz());
     }
-    return bid128_add(x.get_bid(), y.get_bid());
+    return bid128_add(x.get_bid(), y.get_bid(), &number_flags);
 }
 
 Number number_subtract(Number x, Number y)
@@ -31,7 +56,7 @@ Number number_subtract(Number x, Number y)
     if (x.rep == Rep::MPZ && y.rep == Rep::MPZ) {
         return mpz_class(x.get_mpz() - y.get_mpz());
     }
-    return bid128_sub(x.get_bid(), y.get_bid());
+    return bid128_sub(x.get_bid(), y.get_bid(), &number_flags);
 }
 
 Number number_multiply(Number x, Number y)
@@ -39,7 +64,7 @@ Number number_multiply(Number x, Number y)
     if (x.rep == Rep::MPZ && y.rep == Rep::MPZ) {
         return mpz_class(x.get_mpz() * y.get_mpz());
     }
-    return bid128_mul(x.get_bid(), y.get_bid());
+    return bid128_mul(x.get_bid(), y.get_bid(), &number_flags);
 }
 
 Number number_divide(Number x, Number y)
@@ -49,7 +74,7 @@ Number number_divide(Number x, Number y)
             return mpz_class(x.get_mpz() / y.get_mpz());
         }
     }
-    return bid128_div(x.get_bid(), y.get_bid());
+    return bid128_div(x.get_bid(), y.get_bid(), &number_flags);
 }
 
 Number number_modulo(Number x, Number y)
@@ -61,12 +86,12 @@ Number number_modulo(Number x, Number y)
     }
     BID_UINT128 m = bid128_abs(y.get_bid());
     if (bid128_isSigned(x.get_bid())) {
-        Number q = number_ceil(bid128_div(bid128_abs(x.get_bid()), m));
-        x.get_bid() = bid128_add(x.get_bid(), bid128_mul(m, q.get_bid()));
+        Number q = number_ceil(bid128_div(bid128_abs(x.get_bid()), m, &number_flags));
+        x.get_bid() = bid128_add(x.get_bid(), bid128_mul(m, q.get_bid(), &number_flags), &number_flags);
     }
-    BID_UINT128 r = bid128_fmod(x.get_bid(), m);
+    BID_UINT128 r = bid128_fmod(x.get_bid(), m, &number_flags);
     if (bid128_isSigned(y.get_bid()) && not bid128_isZero(r)) {
-        r = bid128_sub(r, m);
+        r = bid128_sub(r, m, &number_flags);
     }
     return r;
 }
@@ -90,7 +115,7 @@ Number number_pow(Number x, Number y)
         }
         return r;
     }
-    return bid128_pow(x.get_bid(), y.get_bid());
+    return bid128_pow(x.get_bid(), y.get_bid(), &number_flags);
 }
 
 Number number_powmod(Number b, Number e, Number m)
@@ -129,7 +154,7 @@ Number number_ceil(Number x)
     if (x.rep == Rep::MPZ) {
         return x;
     }
-    return bid128_round_integral_positive(x.get_bid());
+    return bid128_round_integral_positive(x.get_bid(), &number_flags);
 }
 
 Number number_floor(Number x)
@@ -137,7 +162,7 @@ Number number_floor(Number x)
     if (x.rep == Rep::MPZ) {
         return x;
     }
-    return bid128_round_integral_negative(x.get_bid());
+    return bid128_round_integral_negative(x.get_bid(), &number_flags);
 }
 
 Number number_trunc(Number x)
@@ -145,105 +170,105 @@ Number number_trunc(Number x)
     if (x.rep == Rep::MPZ) {
         return x;
     }
-    return bid128_round_integral_zero(x.get_bid());
+    return bid128_round_integral_zero(x.get_bid(), &number_flags);
 }
 
 Number number_exp(Number x)
 {
-    return bid128_exp(x.get_bid());
+    return bid128_exp(x.get_bid(), &number_flags);
 }
 
 Number number_log(Number x)
 {
-    return bid128_log(x.get_bid());
+    return bid128_log(x.get_bid(), &number_flags);
 }
 
 Number number_sqrt(Number x)
 {
     // TODO: mpz sqrt
-    return bid128_sqrt(x.get_bid());
+    return bid128_sqrt(x.get_bid(), &number_flags);
 }
 
 Number number_acos(Number x)
 {
-    return bid128_acos(x.get_bid());
+    return bid128_acos(x.get_bid(), &number_flags);
 }
 
 Number number_asin(Number x)
 {
-    return bid128_asin(x.get_bid());
+    return bid128_asin(x.get_bid(), &number_flags);
 }
 
 Number number_atan(Number x)
 {
-    return bid128_atan(x.get_bid());
+    return bid128_atan(x.get_bid(), &number_flags);
 }
 
 Number number_cos(Number x)
 {
-    return bid128_cos(x.get_bid());
+    return bid128_cos(x.get_bid(), &number_flags);
 }
 
 Number number_sin(Number x)
 {
-    return bid128_sin(x.get_bid());
+    return bid128_sin(x.get_bid(), &number_flags);
 }
 
 Number number_tan(Number x)
 {
-    return bid128_tan(x.get_bid());
+    return bid128_tan(x.get_bid(), &number_flags);
 }
 
 Number number_acosh(Number x)
 {
-    return bid128_acosh(x.get_bid());
+    return bid128_acosh(x.get_bid(), &number_flags);
 }
 
 Number number_asinh(Number x)
 {
-    return bid128_asinh(x.get_bid());
+    return bid128_asinh(x.get_bid(), &number_flags);
 }
 
 Number number_atanh(Number x)
 {
-    return bid128_atanh(x.get_bid());
+    return bid128_atanh(x.get_bid(), &number_flags);
 }
 
 Number number_atan2(Number y, Number x)
 {
-    return bid128_atan2(y.get_bid(), x.get_bid());
+    return bid128_atan2(y.get_bid(), x.get_bid(), &number_flags);
 }
 
 Number number_cbrt(Number x)
 {
     // TODO: mpz
-    return bid128_cbrt(x.get_bid());
+    return bid128_cbrt(x.get_bid(), &number_flags);
 }
 
 Number number_cosh(Number x)
 {
-    return bid128_cosh(x.get_bid());
+    return bid128_cosh(x.get_bid(), &number_flags);
 }
 
 Number number_erf(Number x)
 {
-    return bid128_erf(x.get_bid());
+    return bid128_erf(x.get_bid(), &number_flags);
 }
 
 Number number_erfc(Number x)
 {
-    return bid128_erfc(x.get_bid());
+    return bid128_erfc(x.get_bid(), &number_flags);
 }
 
 Number number_exp2(Number x)
 {
     // TODO: mpz
-    return bid128_exp2(x.get_bid());
+    return bid128_exp2(x.get_bid(), &number_flags);
 }
 
 Number number_expm1(Number x)
 {
-    return bid128_expm1(x.get_bid());
+    return bid128_expm1(x.get_bid(), &number_flags);
 }
 
 Number number_frexp(Number x, int *exp)
@@ -253,32 +278,32 @@ Number number_frexp(Number x, int *exp)
 
 Number number_hypot(Number x, Number y)
 {
-    return bid128_hypot(x.get_bid(), y.get_bid());
+    return bid128_hypot(x.get_bid(), y.get_bid(), &number_flags);
 }
 
 Number number_ldexp(Number x, int exp)
 {
-    return bid128_ldexp(x.get_bid(), exp);
+    return bid128_ldexp(x.get_bid(), exp, &number_flags);
 }
 
 Number number_lgamma(Number x)
 {
-    return bid128_lgamma(x.get_bid());
+    return bid128_lgamma(x.get_bid(), &number_flags);
 }
 
 Number number_log10(Number x)
 {
-    return bid128_log10(x.get_bid());
+    return bid128_log10(x.get_bid(), &number_flags);
 }
 
 Number number_log1p(Number x)
 {
-    return bid128_log1p(x.get_bid());
+    return bid128_log1p(x.get_bid(), &number_flags);
 }
 
 Number number_log2(Number x)
 {
-    return bid128_log2(x.get_bid());
+    return bid128_log2(x.get_bid(), &number_flags);
 }
 
 Number number_nearbyint(Number x)
@@ -286,22 +311,22 @@ Number number_nearbyint(Number x)
     if (x.rep == Rep::MPZ) {
         return x;
     }
-    return bid128_nearbyint(x.get_bid());
+    return bid128_nearbyint(x.get_bid(), &number_flags);
 }
 
 Number number_sinh(Number x)
 {
-    return bid128_sinh(x.get_bid());
+    return bid128_sinh(x.get_bid(), &number_flags);
 }
 
 Number number_tanh(Number x)
 {
-    return bid128_tanh(x.get_bid());
+    return bid128_tanh(x.get_bid(), &number_flags);
 }
 
 Number number_tgamma(Number x)
 {
-    return bid128_tgamma(x.get_bid());
+    return bid128_tgamma(x.get_bid(), &number_flags);
 }
 
 bool number_is_zero(Number x)
@@ -325,7 +350,7 @@ bool number_is_equal(Number x, Number y)
     if (x.rep == Rep::MPZ && y.rep == Rep::MPZ) {
         return x.get_mpz() == y.get_mpz();
     }
-    return bid128_quiet_equal(x.get_bid(), y.get_bid()) != 0;
+    return bid128_quiet_equal(x.get_bid(), y.get_bid(), &number_flags) != 0;
 }
 
 bool number_is_not_equal(Number x, Number y)
@@ -333,7 +358,7 @@ bool number_is_not_equal(Number x, Number y)
     if (x.rep == Rep::MPZ && y.rep == Rep::MPZ) {
         return x.get_mpz() != y.get_mpz();
     }
-    return bid128_quiet_not_equal(x.get_bid(), y.get_bid()) != 0;
+    return bid128_quiet_not_equal(x.get_bid(), y.get_bid(), &number_flags) != 0;
 }
 
 bool number_is_less(Number x, Number y)
@@ -341,7 +366,7 @@ bool number_is_less(Number x, Number y)
     if (x.rep == Rep::MPZ && y.rep == Rep::MPZ) {
         return x.get_mpz() < y.get_mpz();
     }
-    return bid128_quiet_less(x.get_bid(), y.get_bid()) != 0;
+    return bid128_quiet_less(x.get_bid(), y.get_bid(), &number_flags) != 0;
 }
 
 bool number_is_greater(Number x, Number y)
@@ -349,7 +374,7 @@ bool number_is_greater(Number x, Number y)
     if (x.rep == Rep::MPZ && y.rep == Rep::MPZ) {
         return x.get_mpz() > y.get_mpz();
     }
-    return bid128_quiet_greater(x.get_bid(), y.get_bid()) != 0;
+    return bid128_quiet_greater(x.get_bid(), y.get_bid(), &number_flags) != 0;
 }
 
 bool number_is_less_equal(Number x, Number y)
@@ -357,7 +382,7 @@ bool number_is_less_equal(Number x, Number y)
     if (x.rep == Rep::MPZ && y.rep == Rep::MPZ) {
         return x.get_mpz() <= y.get_mpz();
     }
-    return bid128_quiet_less_equal(x.get_bid(), y.get_bid()) != 0;
+    return bid128_quiet_less_equal(x.get_bid(), y.get_bid(), &number_flags) != 0;
 }
 
 bool number_is_greater_equal(Number x, Number y)
@@ -365,7 +390,7 @@ bool number_is_greater_equal(Number x, Number y)
     if (x.rep == Rep::MPZ && y.rep == Rep::MPZ) {
         return x.get_mpz() >= y.get_mpz();
     }
-    return bid128_quiet_greater_equal(x.get_bid(), y.get_bid()) != 0;
+    return bid128_quiet_greater_equal(x.get_bid(), y.get_bid(), &number_flags) != 0;
 }
 
 bool number_is_integer(Number x)
@@ -373,8 +398,8 @@ bool number_is_integer(Number x)
     if (x.rep == Rep::MPZ) {
         return true;
     }
-    BID_UINT128 i = bid128_round_integral_zero(x.get_bid());
-    return bid128_quiet_equal(x.get_bid(), i) != 0;
+    BID_UINT128 i = bid128_round_integral_zero(x.get_bid(), &number_flags);
+    return bid128_quiet_equal(x.get_bid(), i, &number_flags) != 0;
 }
 
 bool number_is_odd(Number x)
@@ -382,7 +407,7 @@ bool number_is_odd(Number x)
     if (x.rep == Rep::MPZ) {
         return x.get_mpz() % 2 != 0;
     }
-    return not bid128_isZero(bid128_fmod(x.get_bid(), bid128_from_uint32(2)));
+    return not bid128_isZero(bid128_fmod(x.get_bid(), bid128_from_uint32(2), &number_flags));
 }
 
 bool number_is_finite(Number x)
@@ -410,7 +435,7 @@ std::string number_to_string(Number x)
     const int PRECISION = 34;
 
     char buf[50];
-    bid128_to_string(buf, x.get_bid());
+    bid128_to_string(buf, x.get_bid(), &number_flags);
     std::string sbuf(buf);
     const std::string::size_type E = sbuf.find('E');
     if (E == std::string::npos) {
@@ -455,7 +480,7 @@ uint8_t number_to_uint8(Number x)
     if (x.rep == Rep::MPZ) {
         return static_cast<uint8_t>(x.get_mpz().get_ui());
     }
-    return bid128_to_uint8_int(x.get_bid());
+    return bid128_to_uint8_int(x.get_bid(), &number_flags);
 }
 
 int8_t number_to_sint8(Number x)
@@ -463,7 +488,7 @@ int8_t number_to_sint8(Number x)
     if (x.rep == Rep::MPZ) {
         return static_cast<int8_t>(x.get_mpz().get_si());
     }
-    return bid128_to_int8_int(x.get_bid());
+    return bid128_to_int8_int(x.get_bid(), &number_flags);
 }
 
 uint16_t number_to_uint16(Number x)
@@ -471,7 +496,7 @@ uint16_t number_to_uint16(Number x)
     if (x.rep == Rep::MPZ) {
         return static_cast<uint16_t>(x.get_mpz().get_ui());
     }
-    return bid128_to_uint16_int(x.get_bid());
+    return bid128_to_uint16_int(x.get_bid(), &number_flags);
 }
 
 int16_t number_to_sint16(Number x)
@@ -479,7 +504,7 @@ int16_t number_to_sint16(Number x)
     if (x.rep == Rep::MPZ) {
         return static_cast<int16_t>(x.get_mpz().get_si());
     }
-    return bid128_to_int16_int(x.get_bid());
+    return bid128_to_int16_int(x.get_bid(), &number_flags);
 }
 
 uint32_t number_to_uint32(Number x)
@@ -487,7 +512,7 @@ uint32_t number_to_uint32(Number x)
     if (x.rep == Rep::MPZ) {
         return x.get_mpz().get_ui();
     }
-    return bid128_to_uint32_int(x.get_bid());
+    return bid128_to_uint32_int(x.get_bid(), &number_flags);
 }
 
 int32_t number_to_sint32(Number x)
@@ -495,7 +520,7 @@ int32_t number_to_sint32(Number x)
     if (x.rep == Rep::MPZ) {
         return x.get_mpz().get_si();
     }
-    return bid128_to_int32_int(x.get_bid());
+    return bid128_to_int32_int(x.get_bid(), &number_flags);
 }
 
 uint64_t number_to_uint64(Number x)
@@ -508,7 +533,7 @@ uint64_t number_to_uint64(Number x)
             return static_cast<uint64_t>(x.get_mpz().get_ui() & 0xFFFFFFFF) + (static_cast<uint64_t>(mpz_class(x.get_mpz() >> 32).get_ui() & 0xFFFFFFFF) << 32);
         }
     }
-    return bid128_to_uint64_int(x.get_bid());
+    return bid128_to_uint64_int(x.get_bid(), &number_flags);
 }
 
 int64_t number_to_sint64(Number x)
@@ -538,7 +563,7 @@ int64_t number_to_sint64(Number x)
             return sr;
         }
     }
-    return bid128_to_int64_int(x.get_bid());
+    return bid128_to_int64_int(x.get_bid(), &number_flags);
 }
 
 float number_to_float(Number x)
@@ -546,7 +571,7 @@ float number_to_float(Number x)
     if (x.rep == Rep::MPZ) {
         return static_cast<float>(x.get_mpz().get_d());
     }
-    return bid128_to_binary32(x.get_bid());
+    return bid128_to_binary32(x.get_bid(), &number_flags);
 }
 
 double number_to_double(Number x)
@@ -554,7 +579,7 @@ double number_to_double(Number x)
     if (x.rep == Rep::MPZ) {
         return x.get_mpz().get_d();
     }
-    return bid128_to_binary64(x.get_bid());
+    return bid128_to_binary64(x.get_bid(), &number_flags);
 }
 
 Number number_from_string(const std::string &s)
@@ -613,7 +638,7 @@ Number number_from_string(const std::string &s)
     if (next != std::string::npos) {
         return bid128_nan(NULL);
     }
-    return bid128_from_string(const_cast<char *>(s.c_str() + skip));
+    return bid128_from_string(const_cast<char *>(s.c_str() + skip), &number_flags);
 }
 
 Number number_from_uint8(uint8_t x)
@@ -672,10 +697,10 @@ Number number_from_sint64(int64_t x)
 
 Number number_from_float(float x)
 {
-    return binary32_to_bid128(x);
+    return binary32_to_bid128(x, &number_flags);
 }
 
 Number number_from_double(double x)
 {
-    return binary64_to_bid128(x);
+    return binary64_to_bid128(x, &number_flags);
 }
@@ -10,7 +10,7 @@
 // values.
 
 #define DECIMAL_GLOBAL_ROUNDING 1
-#define DECIMAL_GLOBAL_EXCEPTION_FLAGS 1
+#define DECIMAL_GLOBAL_EXCEPTION_FLAGS 0
 
 #ifndef _WCHAR_T_DEFINED
 #define _WCHAR_T_DEFINED
@@ -45,12 +45,19 @@ struct Number {
     Number(BID_UINT128 x): rep(Rep::BID), mpz(), bid(x) {}
     const mpz_class &get_mpz();
     BID_UINT128 get_bid();
+    // Adds y to an integer value in place, reusing its storage.
+    void add_integer(long y);
     Rep rep;
 private:
     mpz_class mpz;
     BID_UINT128 bid;
 };
 
+// BID_*_EXCEPTION bits raised by the number_* functions on the calling
+// thread since it last called number_clear_flags().
+void number_clear_flags();
+_IDEC_flags number_get_flags();
+
 Number number_add(Number x, Number y);
 Number number_subtract(Number x, Number y);
 Number number_multiply(Number x, Number y);
@@ -102,6 +102,9 @@ enum class Opcode {
     PUSHFP,     // push function pointer
     CALLV,      // call virtual
     PUSHCI,     // push class info
+    FORN,       // increment loop counter and jump if within bound
+    CASEN,      // jump through sorted number key table
+    CASES,      // jump through sorted string key table
 };
 
 #endif
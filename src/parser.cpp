@@ -18,8 +18,8 @@ public:
     Parser(const Parser &) = delete;
     Parser &operator=(const Parser &) = delete;
 
-    TokenizedSource source;
-    const std::vector<Token> tokens;
+    const TokenizedSource &source;
+    const std::vector<Token> &tokens;
     std::vector<Token>::size_type i;
     int expression_depth;
     size_t minimum_column;
@@ -341,7 +341,7 @@ std::unique_ptr<Type> Parser::parseType()
         }
         return std::unique_ptr<Type> { new TypeQualified(name, names) };
     } else {
-        return std::unique_ptr<Type> { new TypeSimple(name, name.text) };
+        return std::unique_ptr<Type> { new TypeSimple(name, name.text()) };
     }
 }
 
@@ -492,7 +492,7 @@ std::unique_ptr<DictionaryLiteralExpression> Parser::parseDictionaryLiteral()
 std::unique_ptr<Expression> Parser::parseInterpolatedStringExpression()
 {
     std::vector<std::pair<std::unique_ptr<Expression>, Token>> parts;
-    parts.push_back(std::make_pair(std::unique_ptr<Expression> { new StringLiteralExpression(tokens[i], tokens[i+1], utf8string(tokens[i].text)) }, Token()));
+    parts.push_back(std::make_pair(std::unique_ptr<Expression> { new StringLiteralExpression(tokens[i], tokens[i+1], utf8string(tokens[i].text())) }, Token()));
     for (;;) {
         ++i;
         if (tokens[i].type != SUBBEGIN) {
@@ -517,7 +517,7 @@ std::unique_ptr<Expression> Parser::parseInterpolatedStringExpression()
         if (tokens[i].type != STRING) {
             internal_error("parseInterpolatedStringExpression");
         }
-        e.reset(new StringLiteralExpression(tokens[i], tokens[i], utf8string(tokens[i].text)));
+        e.reset(new StringLiteralExpression(tokens[i], tokens[i], utf8string(tokens[i].text())));
         parts.push_back(std::make_pair(std::move(e), Token()));
     }
     return std::unique_ptr<Expression> { new InterpolatedStringExpression(parts[0].first->token, std::move(parts)) };
@@ -571,7 +571,7 @@ std::unique_ptr<Expression> Parser::parseAtom()
         case NUMBER: {
             auto &tok_number = tokens[i];
             i++;
-            return std::unique_ptr<Expression> { new NumberLiteralExpression(tok_number, tok_number.value) };
+            return std::unique_ptr<Expression> { new NumberLiteralExpression(tok_number, tok_number.value()) };
         }
         case STRING: {
             if (tokens[i+1].type == SUBBEGIN) {
@@ -579,7 +579,7 @@ std::unique_ptr<Expression> Parser::parseAtom()
             } else {
                 auto &tok_string = tokens[i];
                 i++;
-                return std::unique_ptr<Expression> { new StringLiteralExpression(tok_string, tokens[i-1], utf8string(tok_string.text)) };
+                return std::unique_ptr<Expression> { new StringLiteralExpression(tok_string, tokens[i-1], utf8string(tok_string.text())) };
             }
         }
         case EMBED: {
@@ -589,7 +589,7 @@ std::unique_ptr<Expression> Parser::parseAtom()
             if (tok_file.type != STRING) {
                 error(2090, tok_file, "string literal expected");
             }
-            return std::unique_ptr<Expression> { new FileLiteralExpression(tok_file, tokens[i-1], tok_file.text) };
+            return std::unique_ptr<Expression> { new FileLiteralExpression(tok_file, tokens[i-1], tok_file.text()) };
         }
         case HEXBYTES: {
             ++i;
@@ -598,7 +598,7 @@ std::unique_ptr<Expression> Parser::parseAtom()
             if (tok_literal.type != STRING) {
                 error(2094, tok_literal, "string literal expected");
             }
-            return std::unique_ptr<Expression> { new BytesLiteralExpression(tok_literal, tokens[i-1], tok_literal.text) };
+            return std::unique_ptr<Expression> { new BytesLiteralExpression(tok_literal, tokens[i-1], tok_literal.text()) };
         }
         case PLUS: {
             auto &tok_plus = tokens[i];
@@ -624,7 +624,7 @@ std::unique_ptr<Expression> Parser::parseAtom()
             if (tokens[i].type != IDENTIFIER) {
                 error(2110, tokens[i], "identifier expected");
             }
-            std::unique_ptr<Expression> expr { new IdentifierExpression(tokens[i], tokens[i].text) };
+            std::unique_ptr<Expression> expr { new IdentifierExpression(tokens[i], tokens[i].text()) };
             ++i;
             if (tokens[i].type == DOT) {
                 auto &tok_dot = tokens[i];
@@ -657,7 +657,7 @@ std::unique_ptr<Expression> Parser::parseAtom()
             error(2106, tokens[i], "Use parentheses around (TRY ... TRAP ...)");
         }
         case IDENTIFIER: {
-            std::unique_ptr<Expression> expr { new IdentifierExpression(tokens[i], tokens[i].text) };
+            std::unique_ptr<Expression> expr { new IdentifierExpression(tokens[i], tokens[i].text()) };
             ++i;
             return expr;
         }
@@ -1617,7 +1617,6 @@ std::unique_ptr<Statement> Parser::parseCaseStatement()
                     break;
                 }
                 case ISA: {
-                    auto op = tokens[i];
                     ++i;
                     std::unique_ptr<Type> target = parseType();
                     std::unique_ptr<CaseStatement::WhenCondition> cond { new CaseStatement::TypeTestWhenCondition(tok_when, std::move(target)) };
@@ -1977,7 +1976,7 @@ std::unique_ptr<Statement> Parser::parseExecStatement()
         internal_error("not a string");
     }
     auto &tok_text = tokens[i];
-    std::string text = tokens[i].text;
+    std::string text = tokens[i].text();
     ++i;
     std::unique_ptr<SqlStatementInfo> info = parseSqlStatement(tok_text, text);
     return std::unique_ptr<Statement> { new ExecStatement(tok_exec, text, std::move(info)) };
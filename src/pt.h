@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "arena.h"
 #include "number.h"
 #include "sql.h"
 #include "token.h"
@@ -201,7 +202,7 @@ public:
 
 class FunctionParameterGroup;
 
-class ParseTreeNode {
+class ParseTreeNode: public ArenaObject {
 public:
     explicit ParseTreeNode(const Token &token): token(token) {}
     ParseTreeNode(const ParseTreeNode &) = delete;
@@ -420,7 +421,7 @@ public:
 
 class FunctionCallExpression: public Expression {
 public:
-    class Argument {
+    class Argument: public ArenaObject {
     public:
         Argument(const Token &mode, const Token &name, std::unique_ptr<Expression> &&expr, bool spread): mode(mode), name(name), expr(std::move(expr)), spread(spread) {}
         Token mode;
@@ -537,7 +538,7 @@ public:
 
 class ChainedComparisonExpression: public Expression {
 public:
-    class Part {
+    class Part: public ArenaObject {
     public:
         explicit Part(const Token &tok_comp, ComparisonExpression::Comparison comp, std::unique_ptr<Expression> &&right): tok_comp(tok_comp), comp(comp), right(std::move(right)) {}
         const Token tok_comp;
@@ -585,7 +586,7 @@ public:
     std::unique_ptr<Expression> right;
 };
 
-class TryTrap {
+class TryTrap: public ArenaObject {
 public:
     TryTrap(const std::vector<std::vector<Token>> &exceptions, const Token &name, std::unique_ptr<ParseTreeNode> &&handler): exceptions(exceptions), name(name), handler(std::move(handler)) {}
     TryTrap(TryTrap &&rhs): exceptions(rhs.exceptions), name(rhs.name), handler(std::move(rhs.handler)) {}
@@ -629,7 +630,7 @@ public:
     const Token module;
 };
 
-class ArrayRange {
+class ArrayRange: public ArenaObject {
 public:
     explicit ArrayRange(const Token &token, std::unique_ptr<Expression> &&first, bool first_from_end, std::unique_ptr<Expression> &&last, bool last_from_end): token(token), first(std::move(first)), first_from_end(first_from_end), last(std::move(last)), last_from_end(last_from_end) {}
     const Token token;
@@ -647,7 +648,7 @@ public:
     std::unique_ptr<ArrayRange> range;
 };
 
-class FunctionParameterGroup {
+class FunctionParameterGroup: public ArenaObject {
 public:
     enum class Mode {
         IN,
@@ -830,7 +831,7 @@ public:
 
 class CaseStatement: public Statement {
 public:
-    class WhenCondition {
+    class WhenCondition: public ArenaObject {
     public:
         explicit WhenCondition(const Token &token): token(token) {}
         WhenCondition(const WhenCondition &) = delete;
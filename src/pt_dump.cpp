@@ -38,7 +38,7 @@ public:
         child(node->returntype.get());
     }
     virtual void visit(const TypeParameterised *node) override {
-        write("TypeParameterised(" + node->name.text + ")");
+        write("TypeParameterised(" + node->name.text() + ")");
         child(node->elementtype.get());
     }
     virtual void visit(const TypeQualified *node) override {
@@ -98,11 +98,11 @@ public:
         write("IdentifierExpression(" + node->name + ")");
     }
     virtual void visit(const DotExpression *node) override {
-        write("DotExpression(" + node->name.text + ")");
+        write("DotExpression(" + node->name.text() + ")");
         child(node->base.get());
     }
     virtual void visit(const ArrowExpression *node) override {
-        write("ArrowExpression(" + node->name.text + ")");
+        write("ArrowExpression(" + node->name.text() + ")");
         child(node->base.get());
     }
     virtual void visit(const SubscriptExpression *node) override {
@@ -114,7 +114,7 @@ public:
         write("InterpolatedStringExpression");
         depth++;
         for (auto &x: node->parts) {
-            write("FormatString(" + x.second.text + ")");
+            write("FormatString(" + x.second.text() + ")");
             child(x.first.get());
         }
         depth--;
@@ -231,7 +231,7 @@ public:
         }
     }
     virtual void visit(const ImportedModuleExpression *node) override {
-        write("ImportedModuleExpression(" + node->module.text + ")");
+        write("ImportedModuleExpression(" + node->module.text() + ")");
     }
     virtual void visit(const RangeSubscriptExpression *node) override {
         write("RangeSubscriptExpression");
@@ -241,23 +241,23 @@ public:
     }
 
     virtual void visit(const ImportDeclaration *node) override {
-        write("ImportDeclaration(" + node->module.text + "." + node->name.text + ", " + node->alias.text + (node->optional ? ", optional" : "") + ")");
+        write("ImportDeclaration(" + node->module.text() + "." + node->name.text() + ", " + node->alias.text() + (node->optional ? ", optional" : "") + ")");
     }
     virtual void visit(const TypeDeclaration *node) override {
         write("TypeDeclaration");
         child(node->type.get());
     }
     virtual void visit(const ConstantDeclaration *node) override {
-        write("ConstantDeclaration(" + node->name.text + ")");
+        write("ConstantDeclaration(" + node->name.text() + ")");
         child(node->type.get());
         child(node->value.get());
     }
     virtual void visit(const NativeConstantDeclaration *node) override {
-        write("NativeConstantDeclaration(" + node->name.text + ")");
+        write("NativeConstantDeclaration(" + node->name.text() + ")");
         child(node->type.get());
     }
     virtual void visit(const ExtensionConstantDeclaration *node) override {
-        write("ExtensionConstantDeclaration(" + node->name.text + ")");
+        write("ExtensionConstantDeclaration(" + node->name.text() + ")");
         child(node->type.get());
     }
     virtual void visit(const VariableDeclaration *node) override {
@@ -266,21 +266,21 @@ public:
         child(node->value.get());
     }
     virtual void visit(const NativeVariableDeclaration *node) override {
-        write("NativeVariableDeclaration(" + node->name.text + ")");
+        write("NativeVariableDeclaration(" + node->name.text() + ")");
         child(node->type.get());
     }
     virtual void visit(const LetDeclaration *node) override {
-        write("LetDeclaration(" + node->name.text + ")");
+        write("LetDeclaration(" + node->name.text() + ")");
         child(node->type.get());
         child(node->value.get());
     }
     virtual void visit(const FunctionDeclaration *node) override {
-        write("FunctionDeclaration(" + node->name.text + ")");
+        write("FunctionDeclaration(" + node->name.text() + ")");
         child(node->returntype.get());
         depth++;
         for (auto &x: node->args) {
             for (auto name: x->names) {
-                write(FunctionParameterGroup::to_string(x->mode) + " " + name.text);
+                write(FunctionParameterGroup::to_string(x->mode) + " " + name.text());
                 child(x->type.get());
             }
         }
@@ -290,24 +290,24 @@ public:
         }
     }
     virtual void visit(const NativeFunctionDeclaration *node) override {
-        write("NativeFunctionDeclaration(" + node->name.text + ")");
+        write("NativeFunctionDeclaration(" + node->name.text() + ")");
         child(node->returntype.get());
         depth++;
         for (auto &x: node->args) {
             for (auto name: x->names) {
-                write(FunctionParameterGroup::to_string(x->mode) + " " + name.text);
+                write(FunctionParameterGroup::to_string(x->mode) + " " + name.text());
                 child(x->type.get());
             }
         }
         depth--;
     }
     virtual void visit(const ExtensionFunctionDeclaration *node) override {
-        write("ExtensionFunctionDeclaration(" + node->name.text + ")");
+        write("ExtensionFunctionDeclaration(" + node->name.text() + ")");
         child(node->returntype.get());
         depth++;
         for (auto &x: node->args) {
             for (auto name: x->names) {
-                write(FunctionParameterGroup::to_string(x->mode) + " " + name.text);
+                write(FunctionParameterGroup::to_string(x->mode) + " " + name.text());
                 child(x->type.get());
             }
         }
@@ -321,7 +321,7 @@ public:
     }
     virtual void visit(const ExportDeclaration *node) override {
         for (auto &name: node->names) {
-            write("ExportDeclaration(" + name.text + ")");
+            write("ExportDeclaration(" + name.text() + ")");
         }
     }
 
@@ -373,26 +373,26 @@ public:
         write("ExecStatement(" + node->text + ")");
     }
     virtual void visit(const ExitStatement *node) override {
-        write("ExitStatement(" + node->type.text + ")");
+        write("ExitStatement(" + node->type.text() + ")");
     }
     virtual void visit(const ExpressionStatement *node) override {
         write("ExpressionStatement");
         child(node->expr.get());
     }
     virtual void visit(const ForStatement *node) override {
-        write("ForStatement(" + node->var.text + ")");
+        write("ForStatement(" + node->var.text() + ")");
         child(node->start.get());
         child(node->end.get());
         child(node->step.get());
-        write("  " + node->label.text);
+        write("  " + node->label.text());
         for (auto &x: node->body) {
             child(x.get());
         }
     }
     virtual void visit(const ForeachStatement *node) override {
-        write("ForeachStatement(" + node->var.text + ")");
+        write("ForeachStatement(" + node->var.text() + ")");
         child(node->array.get());
-        write("  " + node->label.text);
+        write("  " + node->label.text());
         for (auto &x: node->body) {
             child(x.get());
         }
@@ -415,13 +415,13 @@ public:
     }
     virtual void visit(const LoopStatement *node) override {
         write("LoopStatement");
-        write("  " + node->label.text);
+        write("  " + node->label.text());
         for (auto &x: node->body) {
             child(x.get());
         }
     }
     virtual void visit(const NextStatement *node) override {
-        write("NextStatement(" + node->type.text + ")");
+        write("NextStatement(" + node->type.text() + ")");
     }
     virtual void visit(const RaiseStatement *node) override {
         write("RaiseStatement(" + join(node->name) + ")");
@@ -429,7 +429,7 @@ public:
     }
     virtual void visit(const RepeatStatement *node) override {
         write("RepeatStatement");
-        write("  " + node->label.text);
+        write("  " + node->label.text());
         child(node->cond.get());
         for (auto &x: node->body) {
             child(x.get());
@@ -462,7 +462,7 @@ public:
     virtual void visit(const WhileStatement *node) override {
         write("WhileStatement");
         child(node->cond.get());
-        write("  " + node->label.text);
+        write("  " + node->label.text());
         for (auto &x: node->body) {
             child(x.get());
         }
@@ -508,7 +508,7 @@ private:
             if (not r.empty()) {
                 r += ",";
             }
-            r += x.text;
+            r += x.text();
         }
         return r;
     }
@@ -516,7 +516,7 @@ private:
     static std::string join(const std::vector<std::pair<Token, int>> &a) {
         std::vector<std::string> b;
         for (auto x: a) {
-            b.push_back(x.first.text);
+            b.push_back(x.first.text());
         }
         return join(b);
     }
@@ -524,7 +524,7 @@ private:
     static std::string join(const std::vector<std::pair<Token, const Type *>> &a) {
         std::vector<std::string> b;
         for (auto x: a) {
-            b.push_back(x.first.text);
+            b.push_back(x.first.text());
         }
         return join(b);
     }
@@ -535,7 +535,7 @@ private:
             if (not r.empty()) {
                 r += ",";
             }
-            r += x->name.text;
+            r += x->name.text();
         }
         return r;
     }
@@ -546,7 +546,7 @@ private:
             if (not r.empty()) {
                 r += ",";
             }
-            r += x.first.text;
+            r += x.first.text();
         }
         return r;
     }
@@ -3,6 +3,7 @@
 #include <iostream>
 
 #include "analyzer.h"
+#include "arena.h"
 #include "cell.h"
 #include "compiler.h"
 #include "debuginfo.h"
@@ -22,7 +23,8 @@ Repl::Repl(int argc, char *argv[], bool no_prompt, bool stop_on_any_error, bool
     runtime_support("", {}),
     globals_ast(),
     globals_cells(),
-    input()
+    input(),
+    arenas()
 {
     if (not no_prompt) {
         std::cout << "Neon 0.1 (" << GIT_DESCRIBE << ")\n";
@@ -42,6 +44,11 @@ void Repl::handle(const std::string &s)
     } else {
         CompilerError *first_error = nullptr;
         try {
+            // The nodes for a line that runs successfully are kept, since
+            // later lines refer to the globals it declares. Anything built
+            // for a line with an error is released when the arena goes.
+            std::unique_ptr<Arena> arena { new Arena() };
+            ArenaScope arena_scope(arena.get());
             auto tokens = tokenize("", s);
             const ast::Program *program;
             try {
@@ -101,7 +108,9 @@ void Repl::handle(const std::string &s)
                     "",
                     "00000000000000000000000000000000"
                 )};
-                program = analyze(&compiler_support, parsetree.get(), &globals_ast);
+                auto globals = globals_ast;
+                program = analyze(&compiler_support, parsetree.get(), &globals);
+                globals_ast = globals;
             }
             DebugInfo debug("-", s);
             auto bytecode = compile(program, &debug);
@@ -113,6 +122,7 @@ void Repl::handle(const std::string &s)
                 fprintf(stderr, "exit code %d\n", r);
             }
             input.emplace_back(std::move(tokens));
+            arenas.emplace_back(std::move(arena));
         } catch (CompilerError *error) {
             SourceError *se = dynamic_cast<SourceError *>(error);
             // Error 2015 is "Expression expected", which means the real error
@@ -28,6 +28,7 @@ private:
     std::map<std::string, ast::ExternalGlobalInfo> globals_ast;
     std::map<std::string, Cell *> globals_cells;
     std::vector<std::unique_ptr<TokenizedSource>> input;
+    std::vector<std::unique_ptr<Arena>> arenas;
 };
 
 #endif // REPL_H
@@ -2,6 +2,7 @@
 
 #include "rtl_exec.h"
 
+#include <mutex>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,39 +10,56 @@
 
 typedef void (*Thunk)(opstack<Cell> &stack, void *func);
 
-static std::map<std::string, size_t> FunctionNames;
-static std::map<std::string, size_t> VariableNames;
-
 #include "thunks.inc"
 #include "functions_exec.inc"
 #include "variables_exec.inc"
 
-void rtl_exec_init(int argc, char *argv[])
+// These tables are built on first use and never change afterwards, so
+// executors on different threads can share them without locking.
+static const std::map<std::string, size_t> &FunctionNames()
 {
-    extern void rtl_sys_init(int, char *[]);
-    rtl_sys_init(argc, argv);
-
-    FunctionNames.clear();
-    VariableNames.clear();
+    static const std::map<std::string, size_t> names = [] {
+        std::map<std::string, size_t> r;
+        size_t i = 0;
+        for (auto f: BuiltinFunctions) {
+            r[f.name] = i;
+            i++;
+        }
+        return r;
+    }();
+    return names;
+}
 
-    size_t i = 0;
-    for (auto f: BuiltinFunctions) {
-        FunctionNames[f.name] = i;
-        i++;
-    }
+static const std::map<std::string, size_t> &VariableNames()
+{
+    static const std::map<std::string, size_t> names = [] {
+        std::map<std::string, size_t> r;
+        size_t i = 0;
+        for (auto v: BuiltinVariables) {
+            r[v.name] = i;
+            i++;
+        }
+        return r;
+    }();
+    return names;
+}
 
-    i = 0;
-    for (auto v: BuiltinVariables) {
-        VariableNames[v.name] = i;
-        i++;
-    }
+void rtl_exec_init(int argc, char *argv[])
+{
+    // The builtin variables (such as sys.args) belong to the process, not
+    // to one executor, so only the first program to start sets them.
+    static std::once_flag once;
+    std::call_once(once, [argc, argv] {
+        extern void rtl_sys_init(int, char *[]);
+        rtl_sys_init(argc, argv);
+    });
 }
 
 void rtl_call(opstack<Cell> &stack, const std::string &name, size_t &token)
 {
     if (token == SIZE_MAX) {
-        auto f = FunctionNames.find(name);
-        if (f == FunctionNames.end()) {
+        auto f = FunctionNames().find(name);
+        if (f == FunctionNames().end()) {
             fprintf(stderr, "neon: function not found: %s\n", name.c_str());
             abort();
         }
@@ -53,5 +71,5 @@ void rtl_call(opstack<Cell> &stack, const std::string &name, size_t &token)
 
 Cell *rtl_variable(const std::string &name)
 {
-    return BuiltinVariables[VariableNames[name]].value;
+    return BuiltinVariables[VariableNames().at(name)].value;
 }
@@ -12,6 +12,7 @@ public:
     utf8string info;
 public:
     RtlException(const ExceptionName &name, const utf8string &info): name(name.name), info(info) {}
+    RtlException(const std::string &name, const utf8string &info): name(name), info(info) {}
 };
 
 void rtl_exec_init(int argc, char *argv[]);
@@ -2,6 +2,7 @@
 
 #include <dlfcn.h>
 #include <map>
+#include <mutex>
 
 #include "rtl_exec.h"
 
@@ -12,9 +13,11 @@
 #endif
 
 static std::map<std::string, void *> g_Libraries;
+static std::mutex g_LibrariesMutex;
 
 static void *get_library_handle(const std::string &library)
 {
+    std::lock_guard<std::mutex> lock(g_LibrariesMutex);
     auto i = g_Libraries.find(library);
     if (i == g_Libraries.end()) {
         std::string libname = library + SO_SUFFIX;
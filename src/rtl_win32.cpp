@@ -1,14 +1,17 @@
 #include "rtl_platform.h"
 
 #include <map>
+#include <mutex>
 #include <windows.h>
 
 #include "rtl_exec.h"
 
 static std::map<std::string, HMODULE> g_Libraries;
+static std::mutex g_LibrariesMutex;
 
 static HMODULE get_library_handle(const std::string &library)
 {
+    std::lock_guard<std::mutex> lock(g_LibrariesMutex);
     auto i = g_Libraries.find(library);
     if (i == g_Libraries.end()) {
         HMODULE lib = LoadLibrary(library.c_str());
@@ -1,14 +1,17 @@
 #ifdef _WIN32
 
-#include <winsock.h>
+#include <winsock2.h>
 typedef int socklen_t;
+#define poll WSAPoll
 #pragma warning(disable: 4127) // incompatible with FD_SET()
 
 #else
 
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <unistd.h>
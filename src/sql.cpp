@@ -247,7 +247,7 @@ public:
         this_token = ::Token(token.source);
         this_token.line = token.line;
         this_token.column = token.column + current_index;
-        this_token.text = statement.substr(current_index, index-current_index);
+        this_token.set_text(statement.substr(current_index, index-current_index));
     }
 };
 
@@ -591,7 +591,7 @@ public:
             }
             // Make a temporary token and adjust the string to just the part we want.
             ::Token t = lexer.get_this_token();
-            t.text = lexer.value();
+            t.set_text(lexer.value());
             assignments.push_back(t);
             lexer.next();
             if (lexer.peek() != COMMA) {
@@ -619,7 +619,7 @@ public:
                 } else {
                     ::Token tok = ::Token(lexer.token);
                     tok.column = tok.column + query_offset + i - name.length();
-                    tok.text = name;
+                    tok.set_text(name);
                     parameters.push_back(tok);
                     name = std::string();
                 }
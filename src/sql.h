@@ -81,7 +81,7 @@ public:
     explicit SqlIdentifierVariable(const Token &variable): variable(variable) {}
     SqlIdentifierVariable(const SqlIdentifierVariable &) = delete;
     SqlIdentifierVariable &operator=(const SqlIdentifierVariable &) = delete;
-    virtual std::string text() const override { return ":" + variable.text; }
+    virtual std::string text() const override { return ":" + variable.text(); }
     const Token variable;
 };
 
@@ -3,11 +3,15 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <vector>
 
 class Bytecode;
 class CompilerSupport;
 namespace ast { class Program; }
+namespace pt { class Program; }
 
 typedef void (*CompileProc)(CompilerSupport *support, const ast::Program *, std::string output, std::map<std::string, std::string> options);
 
@@ -26,13 +30,40 @@ private:
     std::vector<std::string> paths;
 };
 
+// Anything a target needs to keep between the modules it is given one at
+// a time during a single run of the compiler.
+class TargetState {
+public:
+    virtual ~TargetState() {}
+};
+
 class CompilerSupport: public PathSupport {
 public:
-    CompilerSupport(const std::string &source_path, const std::vector<std::string> &libpath, CompileProc cproc): PathSupport(source_path, libpath), cproc(cproc) {}
+    CompilerSupport(const std::string &source_path, const std::vector<std::string> &libpath, CompileProc cproc);
     virtual void loadBytecode(const std::string &name, Bytecode &object) override;
     virtual void writeOutput(const std::string &name, const std::vector<unsigned char> &content) override;
+    // Bring the compiled .neonx of every module imported (directly or
+    // indirectly) by program up to date, compiling modules that do not
+    // depend on each other concurrently using up to jobs threads.
+    void compileImports(const pt::Program *program, unsigned int jobs);
+    TargetState *targetState() { return target_state.get(); }
+    void setTargetState(TargetState *state) { target_state.reset(state); }
 private:
+    std::mutex &module_mutex(const std::string &name);
+    std::string cache_key(const std::string &source_text, const std::vector<std::string> &imports);
+    std::string imports_hash(const std::vector<std::string> &imports);
+    std::string module_hash(const std::string &name);
+    bool loadCache(const std::string &source_text, const std::vector<std::string> &imports, std::vector<unsigned char> &bytecode);
+    void storeCache(const std::string &source_text, const std::vector<std::string> &imports, const std::vector<unsigned char> &bytecode);
     CompileProc cproc;
+    std::string cache_dir;
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<std::mutex>> module_mutexes;
+    // Hashes of modules and everything they import, for cache keys.
+    std::map<std::string, std::string> module_hashes;
+    // Modules whose output for the target has been generated in this run.
+    std::set<std::string> target_modules;
+    std::unique_ptr<TargetState> target_state;
 };
 
 class RuntimeSupport: public PathSupport {
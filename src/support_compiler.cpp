@@ -1,41 +1,187 @@
+#ifdef _WIN32
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
 #include "support.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
 #include <fstream>
 #include <iso646.h>
+#include <set>
 #include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include <sha256.h>
 
 #include "analyzer.h"
+#include "arena.h"
 #include "ast.h"
+#include "bytecode.h"
 #include "lexer.h"
 #include "parser.h"
 #include "compiler.h"
+#include "pt.h"
+#include "util.h"
+#include "version.h"
 
+// See the comment in support_exec.cpp about USE_RTLX.
 #ifdef USE_RTLX
-#include "rtl.inc"
+#include "rtlx.inc"
 #endif
 
-void CompilerSupport::loadBytecode(const std::string &name, Bytecode &object)
+namespace {
+
+std::string hash_source(const std::string &source_text)
+{
+    SHA256 sha256;
+    sha256(source_text);
+    unsigned char h[SHA256::HashBytes];
+    sha256.getHash(h);
+    return std::string(h, h+sizeof(h));
+}
+
+std::string hex_from_binary(const std::string &bin)
+{
+    static const char hex[] = "0123456789abcdef";
+    std::string r;
+    for (unsigned char c: bin) {
+        r.push_back(hex[c >> 4]);
+        r.push_back(hex[c & 0xf]);
+    }
+    return r;
+}
+
+void make_directory(const std::string &path)
+{
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0777);
+#endif
+}
+
+// Get the precompiled bytecode of a runtime library module that is
+// embedded in this executable, if there is one.
+bool get_builtin_bytecode(const std::string &name, std::vector<unsigned char> &bytecode)
 {
 #ifdef USE_RTLX
-    for (size_t i = 0; i < sizeof(rtl_sources)/sizeof(rtl_sources[0]); i++) {
-        if (name == rtl_sources[i].name) {
-            auto tokens = tokenize(name, rtl_sources[i].source);
-            auto parsetree = parse(*tokens);
-            auto ast = analyze(this, parsetree.get());
-            auto bytecode = compile(ast, nullptr);
-            object.load("-builtin-", bytecode);
-            return;
+    for (auto &b: rtl_bytecode) {
+        if (name == b.name) {
+            bytecode.assign(b.bytecode, b.bytecode + b.length);
+            return true;
         }
     }
+#else
+    (void)name;
+    (void)bytecode;
 #endif
+    return false;
+}
+
+std::vector<unsigned char> read_file(std::ifstream &f)
+{
+    std::stringstream buf;
+    buf << f.rdbuf();
+    std::vector<unsigned char> r;
+    std::string s = buf.str();
+    std::copy(s.begin(), s.end(), std::back_inserter(r));
+    return r;
+}
+
+// Run f(i) for each i in [0, count) using up to jobs threads.
+template <typename F> void parallel_for(size_t count, unsigned int jobs, F f)
+{
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (;;) {
+            size_t i = next++;
+            if (i >= count) {
+                break;
+            }
+            f(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < std::min(count, static_cast<size_t>(jobs)); t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (auto &t: threads) {
+        t.join();
+    }
+}
+
+struct ModuleBuild {
+    ModuleBuild(const std::string &name): name(name), source_name(), source_text(), arena(new Arena()), tokens(), parsetree(), up_to_date(false), imports(), dependents(), pending(0) {}
+    ModuleBuild(const ModuleBuild &) = delete;
+    ModuleBuild &operator=(const ModuleBuild &) = delete;
+    const std::string name;
+    std::string source_name;
+    std::string source_text;
+    std::unique_ptr<Arena> arena;
+    std::unique_ptr<TokenizedSource> tokens;
+    std::unique_ptr<pt::Program> parsetree;
+    bool up_to_date;
+    std::vector<std::string> imports;
+    std::vector<ModuleBuild *> dependents;
+    int pending;
+};
+
+void get_imports(const pt::Program *program, std::vector<std::string> &imports)
+{
+    for (auto &s: program->body) {
+        const pt::ImportDeclaration *import = dynamic_cast<const pt::ImportDeclaration *>(s.get());
+        if (import != nullptr) {
+            imports.push_back(import->module.text());
+        }
+    }
+}
+
+} // namespace
+
+CompilerSupport::CompilerSupport(const std::string &source_path, const std::vector<std::string> &libpath, CompileProc cproc)
+  : PathSupport(source_path, libpath),
+    cproc(cproc),
+    cache_dir(),
+    mutex(),
+    module_mutexes(),
+    module_hashes(),
+    target_modules(),
+    target_state()
+{
+    const char *neoncache = std::getenv("NEONCACHE");
+    if (neoncache != NULL) {
+        cache_dir = neoncache;
+    }
+}
+
+void CompilerSupport::loadBytecode(const std::string &name, Bytecode &object)
+{
+    std::vector<unsigned char> builtin;
+    if (cproc == nullptr && get_builtin_bytecode(name, builtin)) {
+        object.load("-builtin-", builtin);
+        return;
+    }
 
     std::pair<std::string, std::string> names = findModule(name);
     if (names.first.empty() && names.second.empty()) {
         throw BytecodeException("file not found");
     }
 
+    std::lock_guard<std::mutex> lock(module_mutex(name));
     std::ifstream obj_file(names.second, std::ios::binary);
     std::ifstream src_file(names.first);
 
@@ -46,22 +192,19 @@ void CompilerSupport::loadBytecode(const std::string &name, Bytecode &object)
         source_text = buf.str();
     }
 
+    // Other targets need their own output for every imported module, so
+    // each module is compiled once per run even if its .neonx is current.
+    bool need_target = false;
+    if (cproc != nullptr) {
+        std::lock_guard<std::mutex> target_lock(mutex);
+        need_target = target_modules.insert(name).second;
+    }
+
     if (not source_text.empty()) {
         if (obj_file.good()) {
-            SHA256 sha256;
-            sha256(source_text);
-            unsigned char h[SHA256::HashBytes];
-            sha256.getHash(h);
-            std::string hash = std::string(h, h+sizeof(h));
+            object.load(name, read_file(obj_file));
 
-            std::stringstream buf;
-            buf << obj_file.rdbuf();
-            std::vector<unsigned char> bytecode;
-            std::string s = buf.str();
-            std::copy(s.begin(), s.end(), std::back_inserter(bytecode));
-            object.load(name, bytecode);
-
-            if (object.source_hash == hash) {
+            if (object.source_hash == hash_source(source_text) && not need_target) {
                 return;
             }
             object = Bytecode();
@@ -69,15 +212,30 @@ void CompilerSupport::loadBytecode(const std::string &name, Bytecode &object)
 
         obj_file.close();
         const std::string objname = names.first + "x";
-        remove(objname.c_str());
         {
+            // Everything built while compiling this module is released in
+            // one go at the end. The other targets hold on to pointers into
+            // the AST for the rest of the run, so their nodes stay on the heap.
+            Arena arena;
+            ArenaScope arena_scope(cproc == nullptr ? &arena : nullptr);
             auto tokens = tokenize(names.first, source_text);
             auto parsetree = parse(*tokens);
+            std::vector<std::string> imports;
+            get_imports(parsetree.get(), imports);
+            std::vector<unsigned char> cached;
+            if (not need_target && loadCache(source_text, imports, cached)) {
+                // Also refresh the local copy, which is what the runtime loads.
+                writeOutput(objname, cached);
+                object.load(names.first, cached);
+                return;
+            }
+            remove(objname.c_str());
             auto ast = analyze(this, parsetree.get());
             auto bytecode = compile(ast, nullptr);
             writeOutput(objname, bytecode);
+            storeCache(source_text, imports, bytecode);
             if (cproc != nullptr) {
-                cproc(this, ast, "", {});
+                cproc(this, ast, "", {{"imported", ""}});
             }
         }
         obj_file.open(objname, std::ios::binary);
@@ -86,12 +244,7 @@ void CompilerSupport::loadBytecode(const std::string &name, Bytecode &object)
         }
     }
 
-    std::stringstream buf;
-    buf << obj_file.rdbuf();
-    std::vector<unsigned char> bytecode;
-    std::string s = buf.str();
-    std::copy(s.begin(), s.end(), std::back_inserter(bytecode));
-    object.load(names.first.empty() ? names.second : names.first, bytecode);
+    object.load(names.first.empty() ? names.second : names.first, read_file(obj_file));
 }
 
 void CompilerSupport::writeOutput(const std::string &name, const std::vector<unsigned char> &content)
@@ -99,3 +252,300 @@ void CompilerSupport::writeOutput(const std::string &name, const std::vector<uns
     std::ofstream f(name, std::ios::binary);
     f.write(reinterpret_cast<const char *>(content.data()), content.size());
 }
+
+void CompilerSupport::compileImports(const pt::Program *program, unsigned int jobs)
+{
+    // Other targets generate their own output for each imported module
+    // from within loadBytecode(), so leave those to be done in order.
+    if (cproc != nullptr) {
+        return;
+    }
+    if (jobs == 0) {
+        jobs = 1;
+    }
+
+    // Discover the import graph one level at a time, reading and parsing
+    // the modules at each level concurrently. Modules whose compiled form
+    // is already up to date get their imports from the .neonx file.
+    std::map<std::string, std::unique_ptr<ModuleBuild>> modules;
+    std::vector<std::string> names;
+    get_imports(program, names);
+    while (not names.empty()) {
+        std::vector<ModuleBuild *> level;
+        for (auto &name: names) {
+            if (modules.find(name) == modules.end()) {
+                ModuleBuild *m = new ModuleBuild(name);
+                modules[name].reset(m);
+                level.push_back(m);
+            }
+        }
+        parallel_for(level.size(), jobs, [this, &level](size_t i) {
+            ModuleBuild *m = level[i];
+            std::vector<unsigned char> builtin;
+            if (get_builtin_bytecode(m->name, builtin)) {
+                Bytecode object;
+                object.load("-builtin-", builtin);
+                m->up_to_date = true;
+                for (auto &imp: object.imports) {
+                    m->imports.push_back(object.strtable[imp.name]);
+                }
+                return;
+            }
+            std::pair<std::string, std::string> found = findModule(m->name);
+            std::ifstream src_file(found.first);
+            if (not src_file.good()) {
+                // Precompiled only, or not found (loadBytecode reports that).
+                m->up_to_date = true;
+                return;
+            }
+            m->source_name = found.first;
+            std::stringstream buf;
+            buf << src_file.rdbuf();
+            m->source_text = buf.str();
+            const std::string &source_text = m->source_text;
+            std::ifstream obj_file(found.second, std::ios::binary);
+            if (obj_file.good()) {
+                try {
+                    Bytecode object;
+                    object.load(m->name, read_file(obj_file));
+                    if (object.source_hash == hash_source(source_text)) {
+                        m->up_to_date = true;
+                        for (auto &imp: object.imports) {
+                            m->imports.push_back(object.strtable[imp.name]);
+                        }
+                        return;
+                    }
+                } catch (BytecodeException &) {
+                    // Out of date format, compile it again.
+                }
+            }
+            try {
+                ArenaScope arena_scope(m->arena.get());
+                m->tokens = tokenize(found.first, source_text);
+                m->parsetree = parse(*m->tokens);
+                get_imports(m->parsetree.get(), m->imports);
+            } catch (CompilerError *) {
+                // Leave this module to be compiled by loadBytecode(),
+                // which reports the error in the usual way.
+                m->parsetree.reset();
+                return;
+            }
+            std::vector<unsigned char> cached;
+            if (loadCache(source_text, m->imports, cached)) {
+                writeOutput(m->source_name + "x", cached);
+                m->up_to_date = true;
+                m->parsetree.reset();
+                m->tokens.reset();
+                m->arena.reset();
+            }
+        });
+        names.clear();
+        for (auto m: level) {
+            std::copy(m->imports.begin(), m->imports.end(), std::back_inserter(names));
+        }
+    }
+
+    // Compile each module once everything it imports has been compiled.
+    // Modules in an import cycle never become ready; the cycle is then
+    // reported when the main program is analyzed.
+    std::deque<ModuleBuild *> ready;
+    for (auto &m: modules) {
+        std::set<std::string> deps(m.second->imports.begin(), m.second->imports.end());
+        for (auto &d: deps) {
+            auto i = modules.find(d);
+            if (i != modules.end()) {
+                i->second->dependents.push_back(m.second.get());
+                m.second->pending++;
+            }
+        }
+    }
+    for (auto &m: modules) {
+        if (m.second->pending == 0) {
+            ready.push_back(m.second.get());
+        }
+    }
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    unsigned int active = 0;
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        for (;;) {
+            queue_cv.wait(lock, [&]() { return not ready.empty() || active == 0; });
+            if (ready.empty()) {
+                break;
+            }
+            ModuleBuild *m = ready.front();
+            ready.pop_front();
+            active++;
+            lock.unlock();
+            if (not m->up_to_date && m->parsetree != nullptr) {
+                std::lock_guard<std::mutex> module_lock(module_mutex(m->name));
+                const std::string objname = m->source_name + "x";
+                remove(objname.c_str());
+                try {
+                    ArenaScope arena_scope(m->arena.get());
+                    auto ast = analyze(this, m->parsetree.get());
+                    auto bytecode = compile(ast, nullptr);
+                    writeOutput(objname, bytecode);
+                    storeCache(m->source_text, m->imports, bytecode);
+                } catch (CompilerError *) {
+                    // Reported by loadBytecode() when this module is imported.
+                } catch (BytecodeException &) {
+                    // Likewise for a missing import.
+                }
+                m->parsetree.reset();
+                m->tokens.reset();
+                m->arena.reset();
+            }
+            lock.lock();
+            active--;
+            for (auto d: m->dependents) {
+                d->pending--;
+                if (d->pending == 0) {
+                    ready.push_back(d);
+                }
+            }
+            queue_cv.notify_all();
+        }
+        queue_cv.notify_all();
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < std::min(modules.size(), static_cast<size_t>(jobs)); t++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (auto &t: threads) {
+        t.join();
+    }
+}
+
+// Compiled modules are also kept in a shared cache directory named by the
+// NEONCACHE environment variable, keyed by a hash of the compiler version,
+// the source text and everything the module imports. This lets a module
+// that has already been compiled once (in any location) be reused without
+// compiling it again.
+std::string CompilerSupport::cache_key(const std::string &source_text, const std::vector<std::string> &imports)
+{
+    return hex_from_binary(hash_source(std::string(GIT_DESCRIBE) + "\n" + std::to_string(Bytecode::BYTECODE_VERSION) + "\n" + source_text + imports_hash(imports)));
+}
+
+// The compiled form of a module depends on the modules it imports as well
+// as its own source: imported constants are inlined and the descriptors of
+// imported functions are built in. So the hash of a module covers the hash
+// of each module it imports, directly or indirectly.
+std::string CompilerSupport::imports_hash(const std::vector<std::string> &imports)
+{
+    std::string r;
+    for (auto &name: imports) {
+        r += "\n" + name + "\n" + hex_from_binary(module_hash(name));
+    }
+    return r;
+}
+
+std::string CompilerSupport::module_hash(const std::string &name)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto i = module_hashes.find(name);
+        if (i != module_hashes.end()) {
+            return i->second;
+        }
+        // Stops an import cycle from recursing forever. The cycle itself is
+        // reported when the module is analyzed.
+        module_hashes[name] = std::string();
+    }
+    std::string r;
+    std::vector<unsigned char> builtin;
+    std::pair<std::string, std::string> names;
+    if (get_builtin_bytecode(name, builtin)) {
+        r = hash_source(std::string(builtin.begin(), builtin.end()));
+    } else if (not (names = findModule(name)).first.empty()) {
+        std::ifstream src_file(names.first);
+        std::stringstream buf;
+        buf << src_file.rdbuf();
+        const std::string source_text = buf.str();
+        std::vector<std::string> imports;
+        try {
+            Arena arena;
+            ArenaScope arena_scope(&arena);
+            auto tokens = tokenize(names.first, source_text);
+            auto parsetree = parse(*tokens);
+            get_imports(parsetree.get(), imports);
+        } catch (CompilerError *) {
+            // Reported when the module itself is compiled.
+        }
+        r = hash_source(source_text + imports_hash(imports));
+    } else if (not names.second.empty()) {
+        std::ifstream obj_file(names.second, std::ios::binary);
+        std::vector<unsigned char> bytecode = read_file(obj_file);
+        r = hash_source(std::string(bytecode.begin(), bytecode.end()));
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    module_hashes[name] = r;
+    return r;
+}
+
+bool CompilerSupport::loadCache(const std::string &source_text, const std::vector<std::string> &imports, std::vector<unsigned char> &bytecode)
+{
+    if (cache_dir.empty() || cproc != nullptr) {
+        return false;
+    }
+    const std::string key = cache_key(source_text, imports);
+    std::ifstream f(cache_dir + "/" + key.substr(0, 2) + "/" + key.substr(2) + ".neonx", std::ios::binary);
+    if (not f.good()) {
+        return false;
+    }
+    bytecode = read_file(f);
+    try {
+        Bytecode object;
+        object.load("", bytecode);
+        if (object.source_hash == hash_source(source_text)) {
+            return true;
+        }
+    } catch (BytecodeException &) {
+        // Damaged or incompatible cache entry, ignore it.
+    }
+    bytecode.clear();
+    return false;
+}
+
+void CompilerSupport::storeCache(const std::string &source_text, const std::vector<std::string> &imports, const std::vector<unsigned char> &bytecode)
+{
+    if (cache_dir.empty() || cproc != nullptr) {
+        return;
+    }
+    const std::string key = cache_key(source_text, imports);
+    const std::string dir = cache_dir + "/" + key.substr(0, 2);
+    make_directory(cache_dir);
+    make_directory(dir);
+    const std::string name = dir + "/" + key.substr(2) + ".neonx";
+    // Write to a temporary file and rename it into place so that concurrent
+    // compilers never see a partially written entry.
+    const std::string tmpname = name + ".tmp" + std::to_string(getpid()) + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream f(tmpname, std::ios::binary);
+        if (not f.good()) {
+            return;
+        }
+        f.write(reinterpret_cast<const char *>(bytecode.data()), bytecode.size());
+        if (not f.good()) {
+            f.close();
+            remove(tmpname.c_str());
+            return;
+        }
+    }
+    if (rename(tmpname.c_str(), name.c_str()) != 0) {
+        // On Windows the target may already exist, which is fine.
+        remove(tmpname.c_str());
+    }
+}
+
+std::mutex &CompilerSupport::module_mutex(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto &m = module_mutexes[name];
+    if (m == nullptr) {
+        m.reset(new std::mutex);
+    }
+    return *m;
+}
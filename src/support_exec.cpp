@@ -11,7 +11,8 @@
  * files into the neonx executable. However, doing this in the build
  * first requires building the compiler itself, then running the compiler
  * to build the *.neonx files, before building neonx. This is
- * incompatible with cross-compiled builds so is disabled at this time.
+ * incompatible with cross-compiled builds so is only enabled when
+ * configured with -DNEON_RTLX=ON.
  */
 #ifdef USE_RTLX
 #include "rtlx.inc"
@@ -24,7 +25,7 @@ void RuntimeSupport::loadBytecode(const std::string &name, Bytecode &object)
         if (name == rtl_bytecode[i].name) {
             std::vector<unsigned char> bytecode {rtl_bytecode[i].bytecode, rtl_bytecode[i].bytecode + rtl_bytecode[i].length};
             object.load("-builtin-", bytecode);
-            return true;
+            return;
         }
     }
 #endif
@@ -1,6 +1,7 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <stdint.h>
 #include <string>
 
 #include "number.h"
@@ -127,43 +128,39 @@ enum TokenType {
 
 class TokenizedSource;
 
+// A token is a small record that refers to its text and value instead of
+// holding them. The text of most tokens is a range of the source text.
+// String literals (whose text differs from the source after processing
+// escapes) refer to an entry in the string table of the source, and
+// tokens made or renamed by the compiler refer to an entry in a global
+// string pool. Number tokens refer to their value in the number table
+// of the source.
 class Token {
 public:
-    explicit Token(const TokenizedSource *source = nullptr): source(source), line(0), column(0), type(NONE), text(), value() {}
-    explicit Token(const std::string &text): source(nullptr), line(0), column(0), type(NONE), text(text), value() {}
-    Token(TokenType type, const std::string &text): source(nullptr), line(0), column(0), type(type), text(text), value() {}
+    explicit Token(const TokenizedSource *source = nullptr): source(source), line(0), column(0), type(NONE), offset(0), length(0), text_index(NO_TEXT), number_index(-1) {}
+    explicit Token(const std::string &text): source(nullptr), line(0), column(0), type(NONE), offset(0), length(0), text_index(NO_TEXT), number_index(-1) { set_text(text); }
+    Token(TokenType type, const std::string &text): source(nullptr), line(0), column(0), type(type), offset(0), length(0), text_index(NO_TEXT), number_index(-1) { set_text(text); }
     const TokenizedSource *source;
     int line;
-    size_t column;
+    uint32_t column;
     TokenType type;
-    std::string text;
-    Number value;
+    uint32_t offset;
+    uint32_t length;
+    int32_t text_index;
+    int32_t number_index;
+
+    std::string text() const;
+    Number value() const;
+    void set_text(const std::string &text);
 
     std::string file() const;
     std::string source_line() const;
     std::string tostring() const;
 
-    Token(const Token &rhs)
-      : source(rhs.source),
-        line(rhs.line),
-        column(rhs.column),
-        type(rhs.type),
-        text(rhs.text),
-        value(rhs.value)
-    {}
-
-    Token &operator=(const Token &rhs) {
-        if (this == &rhs) {
-            return *this;
-        }
-        source = rhs.source;
-        line = rhs.line;
-        column = rhs.column;
-        type = rhs.type;
-        text = rhs.text;
-        value = rhs.value;
-        return *this;
-    }
+    // Values of text_index that do not refer to a string table entry.
+    // Indexes below NO_TEXT refer to the global string pool.
+    static const int32_t SOURCE_TEXT = -1;
+    static const int32_t NO_TEXT = -2;
 };
 
 #endif
@@ -26,9 +26,10 @@ public:
 
 class SourceErrorToken {
 public:
-    SourceErrorToken(): token(), file(), source_line(), line(0), column(0), type(NONE) {}
-    explicit SourceErrorToken(const Token &token): token(token), file(token.file()), source_line(token.source_line()), line(token.line), column(token.column), type(token.type) {}
+    SourceErrorToken(): token(), text(), file(), source_line(), line(0), column(0), type(NONE) {}
+    explicit SourceErrorToken(const Token &token): token(token), text(token.text()), file(token.file()), source_line(token.source_line()), line(token.line), column(token.column), type(token.type) {}
     Token token;
+    std::string text;
     std::string file;
     std::string source_line;
     int line;
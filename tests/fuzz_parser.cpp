@@ -10,9 +10,9 @@ std::string reconstitute(const Token &t)
     switch (t.type) {
         case NONE:        exit(1);
         case END_OF_FILE: return "";
-        case NUMBER:      return number_to_string(t.value);
-        case STRING:      return "\"" + t.text + "\"";
-        case IDENTIFIER:  return t.text;
+        case NUMBER:      return number_to_string(t.value());
+        case STRING:      return "\"" + t.text() + "\"";
+        case IDENTIFIER:  return t.text();
         case LPAREN:      return "(";
         case RPAREN:      return ")";
         case LBRACKET:    return "[";
@@ -144,7 +144,7 @@ int main(int argc, char *argv[])
             Token t;
             t.type = static_cast<TokenType>(b);
             if (t.type == IDENTIFIER) {
-                t.text = std::string(1, 'a'+(i%4));
+                t.set_text(std::string(1, 'a'+(i%4)));
             }
             tokens.tokens.push_back(t);
         } else {
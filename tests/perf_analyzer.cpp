@@ -0,0 +1,79 @@
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+#include <vector>
+
+#include "analyzer.h"
+#include "arena.h"
+#include "lexer.h"
+#include "parser.h"
+#include "pt.h"
+#include "support.h"
+#include "util.h"
+
+// Measure analyze() throughput over the files named on the command line
+// (by default tests/analyzer-scale.neon, which is generated by
+// scripts/make_analyzer_scale.py). The perf_analyzer_report build target
+// runs this over that module. Imported modules are compiled before
+// timing starts, so the timed passes only load their bytecode.
+
+int main(int argc, char *argv[])
+{
+    std::vector<std::string> names;
+    for (int a = 1; a < argc; a++) {
+        names.push_back(argv[a]);
+    }
+    if (names.empty()) {
+        names.push_back("tests/analyzer-scale.neon");
+    }
+
+    CompilerSupport compiler_support("", {}, nullptr);
+    std::vector<std::unique_ptr<TokenizedSource>> sources;
+    std::vector<std::unique_ptr<pt::Program>> trees;
+    size_t lines = 0;
+    for (auto &name: names) {
+        std::ifstream inf(name);
+        if (not inf.good()) {
+            fprintf(stderr, "perf_analyzer: could not open %s\n", name.c_str());
+            return 1;
+        }
+        std::stringstream ss;
+        ss << inf.rdbuf();
+        try {
+            auto tokens = tokenize(name, ss.str());
+            auto tree = parse(*tokens);
+            Arena arena;
+            ArenaScope arena_scope(&arena);
+            analyze(&compiler_support, tree.get());
+            lines += tokens->source_lines.size();
+            sources.push_back(std::move(tokens));
+            trees.push_back(std::move(tree));
+        } catch (CompilerError *error) {
+            error->write(std::cerr);
+            return 1;
+        }
+    }
+
+    typedef std::chrono::steady_clock clock;
+    const auto start = clock::now();
+    auto now = start;
+    int count = 0;
+    do {
+        for (auto &t: trees) {
+            Arena arena;
+            ArenaScope arena_scope(&arena);
+            analyze(&compiler_support, t.get());
+        }
+        count++;
+        now = clock::now();
+    } while (now - start < std::chrono::seconds(1));
+    const double seconds = std::chrono::duration<double>(now - start).count();
+
+    printf("files %zu\n", trees.size());
+    printf("lines %zu\n", lines);
+    printf("count %d\n", count);
+    printf("ms/pass %.1f\n", seconds * 1000 / count);
+    printf("lines/s %.0f\n", lines * count / seconds);
+}
@@ -1,54 +1,63 @@
-#include <assert.h>
+#include <chrono>
 #include <fstream>
-#include <iostream>
 #include <sstream>
-#include <string.h>
+#include <stdio.h>
+#include <vector>
 
 #include "lexer.h"
 #include "util.h"
 
-#ifdef _WIN32
+// Measure tokenize() throughput over the files named on the command line
+// (by default tests/lexer-coverage.neon). The perf_lexer_report build
+// target runs this over lib/ and samples/.
 
-#include <windows.h>
-
-time_t get_second()
+int main(int argc, char *argv[])
 {
-    return GetTickCount() / 1000;
-}
-
-#else
-
-#include <sys/time.h>
-
-time_t get_second()
-{
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return tv.tv_sec;
-}
-
-#endif
-
-int main(int, char *[])
-{
-    std::fstream inf("tests/lexer-coverage.neon");
-    std::stringstream ss;
-    ss << inf.rdbuf();
-    std::string source = ss.str();
-
-    time_t start = get_second();
-    time_t now;
-    do {
-        now = get_second();
-    } while (now == start);
-
-    start = now;
+    std::vector<std::string> names;
+    for (int a = 1; a < argc; a++) {
+        names.push_back(argv[a]);
+    }
+    if (names.empty()) {
+        names.push_back("tests/lexer-coverage.neon");
+    }
+
+    std::vector<std::string> sources;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    for (auto &name: names) {
+        std::ifstream inf(name, std::ios::binary);
+        if (not inf.good()) {
+            fprintf(stderr, "perf_lexer: could not open %s\n", name.c_str());
+            return 1;
+        }
+        std::stringstream ss;
+        ss << inf.rdbuf();
+        try {
+            tokens += tokenize(name, ss.str())->tokens.size();
+        } catch (SourceError *) {
+            fprintf(stderr, "perf_lexer: skipping %s (does not tokenize)\n", name.c_str());
+            continue;
+        }
+        sources.push_back(ss.str());
+        bytes += sources.back().size();
+    }
+
+    typedef std::chrono::steady_clock clock;
+    const auto start = clock::now();
+    auto now = start;
     int count = 0;
     do {
-        tokenize("", source);
+        for (auto &s: sources) {
+            tokenize("", s);
+        }
         count++;
-        now = get_second();
-    } while (now - start < 1);
+        now = clock::now();
+    } while (now - start < std::chrono::seconds(1));
+    const double seconds = std::chrono::duration<double>(now - start).count();
 
+    printf("files %zu\n", sources.size());
+    printf("bytes %zu\n", bytes);
     printf("count %d\n", count);
+    printf("MB/s %.1f\n", bytes * count / seconds / 1e6);
+    printf("tokens/s %.0f\n", tokens * count / seconds);
 }
@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "cell.h"
+#include "number.h"
+#include "utf8string.h"
+
+// Microbenchmarks for the value types every executor is built on: Cell,
+// Number and utf8string. Each benchmark is timed in batches sized to run
+// for about 10ms, and the batch is repeated several times; the report
+// gives the best and median time per operation along with the relative
+// spread of the samples. Name a substring on the command line to run
+// only the matching benchmarks. The perf_values_report build target
+// runs all of them.
+
+namespace {
+
+const int SAMPLES = 9;
+const double BATCH_SECONDS = 0.01;
+
+// Results are stored here so the compiler cannot discard the work.
+volatile size_t sink;
+
+struct Benchmark {
+    const char *name;
+    // Called once per sample with the number of operations to perform.
+    std::function<void(size_t)> run;
+};
+
+double time_batch(const Benchmark &b, size_t n)
+{
+    auto start = std::chrono::steady_clock::now();
+    b.run(n);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void measure(const Benchmark &b)
+{
+    size_t n = 1;
+    while (time_batch(b, n) < BATCH_SECONDS && n < (size_t(1) << 30)) {
+        n *= 2;
+    }
+    std::vector<double> ns;
+    for (int i = 0; i < SAMPLES; i++) {
+        ns.push_back(time_batch(b, n) * 1e9 / n);
+    }
+    std::sort(ns.begin(), ns.end());
+    double mean = 0;
+    for (auto x: ns) {
+        mean += x;
+    }
+    mean /= ns.size();
+    double variance = 0;
+    for (auto x: ns) {
+        variance += (x - mean) * (x - mean);
+    }
+    const double stddev = sqrt(variance / (ns.size() - 1));
+    printf("%-32s %10.1f %10.1f %7.1f%%\n", b.name, ns.front(), ns[ns.size() / 2], 100 * stddev / mean);
+    fflush(stdout);
+}
+
+std::vector<Cell> make_array(size_t size)
+{
+    std::vector<Cell> a;
+    for (size_t i = 0; i < size; i++) {
+        a.push_back(Cell(number_from_uint32(static_cast<uint32_t>(i))));
+    }
+    return a;
+}
+
+std::vector<utf8string> make_keys(size_t count)
+{
+    std::vector<utf8string> keys;
+    for (size_t i = 0; i < count; i++) {
+        keys.push_back(utf8string("key" + std::to_string(i * 7919 % count)));
+    }
+    return keys;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const Number mpz_a = number_from_uint32(123456789);
+    const Number mpz_b = number_from_uint32(987);
+    const Number bid_a = number_from_string("12345.6789");
+    const Number bid_b = number_from_string("3.25");
+    const Cell number_cell(mpz_a);
+    const Cell string_cell(utf8string("the quick brown fox jumps over the lazy dog"));
+    const Cell array_cell(make_array(100));
+    const utf8string ascii(std::string(1000, 'x'));
+    std::string mixed_source;
+    for (int i = 0; i < 250; i++) {
+        mixed_source += "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+    }
+    const utf8string mixed(mixed_source);
+    const std::vector<utf8string> keys = make_keys(1000);
+
+    std::vector<Benchmark> benchmarks = {
+        {"cell/construct-none", [](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                Cell c;
+                sink = static_cast<size_t>(c.get_type());
+            }
+        }},
+        {"cell/construct-number", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                Cell c(mpz_a);
+                sink = static_cast<size_t>(c.get_type());
+            }
+        }},
+        {"cell/construct-string", [](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                Cell c("hello world");
+                sink = static_cast<size_t>(c.get_type());
+            }
+        }},
+        {"cell/copy-number", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                Cell c(number_cell);
+                sink = static_cast<size_t>(c.get_type());
+            }
+        }},
+        {"cell/copy-string", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                Cell c(string_cell);
+                sink = static_cast<size_t>(c.get_type());
+            }
+        }},
+        {"cell/copy-array", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                Cell c(array_cell);
+                sink = static_cast<size_t>(c.get_type());
+            }
+        }},
+        {"cell/assign-number", [&](size_t n) {
+            Cell c;
+            for (size_t i = 0; i < n; i++) {
+                c = number_cell;
+            }
+            sink = static_cast<size_t>(c.get_type());
+        }},
+        {"cell/assign-string", [&](size_t n) {
+            Cell c;
+            for (size_t i = 0; i < n; i++) {
+                c = string_cell;
+            }
+            sink = static_cast<size_t>(c.get_type());
+        }},
+        {"cell/array_for_write-unique", [&](size_t n) {
+            Cell c(make_array(100));
+            for (size_t i = 0; i < n; i++) {
+                sink = c.array_for_write().size();
+            }
+        }},
+        {"cell/array_for_write-shared", [&](size_t n) {
+            // Each write to a shared array copies all 100 elements.
+            for (size_t i = 0; i < n; i++) {
+                Cell c(array_cell);
+                sink = c.array_for_write().size();
+            }
+        }},
+        {"cell/array_index_for_write", [](size_t n) {
+            Cell c;
+            for (size_t i = 0; i < n; i++) {
+                c.array_index_for_write(i % 1000) = Cell(true);
+            }
+            sink = c.array().size();
+        }},
+        {"number/add-mpz", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                sink = static_cast<size_t>(number_add(mpz_a, mpz_b).rep);
+            }
+        }},
+        {"number/add-bid", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                sink = static_cast<size_t>(number_add(bid_a, bid_b).rep);
+            }
+        }},
+        {"number/multiply-mpz", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                sink = static_cast<size_t>(number_multiply(mpz_a, mpz_b).rep);
+            }
+        }},
+        {"number/multiply-bid", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                sink = static_cast<size_t>(number_multiply(bid_a, bid_b).rep);
+            }
+        }},
+        {"number/divide-mpz", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                sink = static_cast<size_t>(number_divide(mpz_a, mpz_b).rep);
+            }
+        }},
+        {"number/divide-bid", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                sink = static_cast<size_t>(number_divide(bid_a, bid_b).rep);
+            }
+        }},
+        {"number/to_string-mpz", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                sink = number_to_string(mpz_a).size();
+            }
+        }},
+        {"number/to_string-bid", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                sink = number_to_string(bid_a).size();
+            }
+        }},
+        {"utf8string/length-ascii", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                utf8string s(ascii.str());
+                sink = s.length();
+            }
+        }},
+        {"utf8string/length-mixed", [&](size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                utf8string s(mixed.str());
+                sink = s.length();
+            }
+        }},
+        {"utf8string/index-first", [&](size_t n) {
+            // The first index() call on a string builds its index table.
+            for (size_t i = 0; i < n; i++) {
+                utf8string s(mixed.str());
+                sink = s.index(500);
+            }
+        }},
+        {"utf8string/index-cached", [&](size_t n) {
+            utf8string s(mixed.str());
+            for (size_t i = 0; i < n; i++) {
+                sink = s.index(i % 1000);
+            }
+        }},
+        {"dictionary/insert-1000", [&](size_t n) {
+            // One operation is a single insert; the dictionary is
+            // rebuilt every 1000 inserts.
+            Cell d;
+            for (size_t i = 0; i < n; i++) {
+                if (i % keys.size() == 0) {
+                    d = Cell();
+                }
+                d.dictionary_index_for_write(keys[i % keys.size()]) = Cell(true);
+            }
+            sink = d.dictionary().size();
+        }},
+        {"dictionary/lookup-1000", [&](size_t n) {
+            Cell d;
+            for (auto &k: keys) {
+                d.dictionary_index_for_write(k) = Cell(true);
+            }
+            for (size_t i = 0; i < n; i++) {
+                sink = d.dictionary_index_for_read(keys[i % keys.size()]).boolean();
+            }
+        }},
+    };
+
+    printf("%-32s %10s %10s %8s\n", "benchmark", "best ns/op", "median", "spread");
+    for (auto &b: benchmarks) {
+        bool selected = argc < 2;
+        for (int a = 1; a < argc; a++) {
+            if (strstr(b.name, argv[a]) != nullptr) {
+                selected = true;
+            }
+        }
+        if (selected) {
+            measure(b);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#include <assert.h>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "arena.h"
+
+namespace {
+
+int live = 0;
+
+class Node: public ArenaObject {
+public:
+    explicit Node(Node *child): child(child), payload(100, 'x') { live++; }
+    Node(const Node &) = delete;
+    Node &operator=(const Node &) = delete;
+    virtual ~Node() { live--; }
+    std::unique_ptr<Node> child;
+    std::string payload;
+};
+
+class Big: public ArenaObject {
+public:
+    Big() { live++; }
+    virtual ~Big() { live--; }
+    char data[100000];
+};
+
+} // namespace
+
+int main()
+{
+    // Without an arena, nodes are ordinary heap objects.
+    {
+        Node *n = new Node(new Node(nullptr));
+        assert(live == 2);
+        delete n;
+        assert(live == 0);
+    }
+
+    // Nodes left in an arena are destroyed along with it, and nodes
+    // that were already deleted (like parse tree nodes, which are owned
+    // by their parents) are not destroyed again.
+    {
+        Arena arena;
+        {
+            ArenaScope scope(&arena);
+            for (int i = 0; i < 10000; i++) {
+                Node *n = new Node(new Node(nullptr));
+                assert(reinterpret_cast<uintptr_t>(n) % 16 == 0);
+                if (i % 2 == 0) {
+                    delete n;
+                } else {
+                    // Leave the child to the arena, like an AST node.
+                    n->child.release();
+                }
+            }
+            new Big();
+        }
+        assert(live == 10000 + 1);
+        assert(arena.bytes_allocated() >= 20000 * sizeof(Node) + sizeof(Big));
+
+        // Scopes nest, and a null arena means the heap.
+        ArenaScope scope(nullptr);
+        Node *n = new Node(nullptr);
+        assert(live == 10000 + 2);
+        delete n;
+    }
+    assert(live == 0);
+}